@@ -0,0 +1,828 @@
+// benchmarks/process_manager_bench.cpp
+//
+// Microbenchmarks of the scan path and the pieces around it. Benchmarks
+// named `/live` read the running system; `/synthetic` ones read a fixture of
+// fixed procfs files, or a whole `FakeProcfs` tree, written to a temporary
+// directory, so their numbers are comparable across machines. Set
+// `PROCESS_MANAGER_BENCH_LARGE` to also scan a synthetic system of 100000
+// processes. `cmake --build . --target bench` writes the
+// results to `bench-results.json`; compare two runs with
+// `compare.py benchmarks old.json new.json` from Google Benchmark. The scan
+// benchmarks also report `allocs`, the `operator new` calls per scan, and
+// `syscalls/process`; their `/io_uring` variants use the batched backend.
+
+#include "../include/command_parser.h"
+#include "../include/fake_procfs.h"
+#include "../include/logger.h"
+#include "../include/proc_parsers.h"
+#include "../include/proc_paths.h"
+#include "../include/proc_reader.h"
+#include "../include/process_filter.h"
+#include "../include/process_listing.h"
+#include "../include/self_stats.h"
+#include "../include/thread_pool.h"
+
+#include <benchmark/benchmark.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+namespace {
+std::atomic<uint64_t> heapAllocations{0}; // Calls of the operator new below
+} // namespace
+
+// Counts heap allocations for the `allocs` counters. Every replaceable form
+// that allocates or frees is defined here, so that no pointer crosses between
+// these and the library's versions; the nothrow forms of the library call
+// them.
+//
+// GCC sees the `malloc` in the inlined operator new flow into the `free` of
+// operator delete and reports -Wmismatched-new-delete at every call site,
+// although the two replacements do match.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void *operator new(std::size_t size) {
+  heapAllocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *memory = std::malloc(size != 0 ? size : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  heapAllocations.fetch_add(1, std::memory_order_relaxed);
+  // aligned_alloc takes a multiple of the alignment
+  auto align = static_cast<std::size_t>(alignment);
+  std::size_t rounded =
+      (std::max<std::size_t>(size, 1) + align - 1) & ~(align - 1);
+  if (void *memory = std::aligned_alloc(align, rounded)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+
+void operator delete[](void *memory) noexcept { std::free(memory); }
+
+void operator delete(void *memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void *memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void *memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void *memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void *memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+#pragma GCC diagnostic pop
+
+namespace {
+const int SYNTHETIC_CPUS = 64;              // CPU lines of the synthetic stat
+const int TASKS_PER_BATCH = 1024;           // Tasks enqueued per iteration
+const size_t COMMIT_LENGTH = 64;            // Longest commit id kept
+const unsigned SYNTHETIC_SCAN_CPUS = 16;    // CPUs of the synthetic systems
+const double SYNTHETIC_STEP_SECONDS = 1.0;  // Time between synthetic scans
+const int64_t LARGE_SYSTEM = 100000;        // Processes of the opt-in system
+const char *LARGE_ENVIRONMENT = "PROCESS_MANAGER_BENCH_LARGE"; // Opt-in
+std::filesystem::path fixtureDirectory;     // Synthetic procfs files
+
+/// Columns that read every cheap per-process source
+const std::vector<ProcessColumn> EXTENDED_COLUMNS = {
+    ProcessColumn::Pid,         ProcessColumn::Name,
+    ProcessColumn::Cpu,         ProcessColumn::Memory,
+    ProcessColumn::Rss,         ProcessColumn::Threads,
+    ProcessColumn::MinorFaults, ProcessColumn::VoluntaryCtxSwitches,
+    ProcessColumn::IoRead,      ProcessColumn::OpenFds};
+
+/**
+ * @brief A stream buffer that discards its output, to time formatting only.
+ */
+class NullBuffer : public std::streambuf {
+protected:
+  int overflow(int c) override { return c; }
+  std::streamsize xsputn(const char *, std::streamsize count) override {
+    return count;
+  }
+};
+
+/**
+ * @brief Refreshes a listing and adds the heap allocations it made.
+ */
+void countedRefresh(ProcessListing &listing, const ListOptions &options,
+                    uint64_t &allocations) {
+  uint64_t before = heapAllocations.load(std::memory_order_relaxed);
+  listing.refresh(options);
+  allocations += heapAllocations.load(std::memory_order_relaxed) - before;
+}
+
+/**
+ * @brief Returns the system calls recorded by `SelfStats` so far.
+ */
+uint64_t syscallCount() {
+  for (const auto &[name, value] : SelfStats::snapshot().counters) {
+    if (name == SelfStats::counterName(SelfCounter::Syscalls)) {
+      return value;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Returns the `syscalls/process` counter of a scan benchmark.
+ */
+benchmark::Counter syscallsPerProcess(uint64_t syscalls, size_t processes,
+                                      benchmark::IterationCount iterations) {
+  double scanned = static_cast<double>(processes) *
+                   static_cast<double>(std::max<int64_t>(iterations, 1));
+  return benchmark::Counter(scanned > 0 ? syscalls / scanned : 0.0);
+}
+
+/**
+ * @brief Selects a scan backend for the lifetime of a benchmark.
+ */
+class BackendScope {
+public:
+  explicit BackendScope(ScanBackend backend) {
+    ProcessListing::setScanBackend(backend);
+  }
+  ~BackendScope() { ProcessListing::setScanBackend(ScanBackend::Sync); }
+};
+
+/**
+ * @brief Returns the `allocs` counter: allocations per iteration.
+ */
+benchmark::Counter allocationCounter(uint64_t allocations) {
+  return benchmark::Counter(static_cast<double>(allocations),
+                            benchmark::Counter::kAvgIterations);
+}
+
+/**
+ * @brief Returns a `/proc/<pid>/stat` line with a name that needs care.
+ */
+std::string syntheticStat() {
+  return "48213 (Web Content (x)) S 4012 4012 4012 0 -1 4194560 812345 0 "
+         "1234 0 987654 123456 0 0 20 0 37 0 5234567 4123456789 312456 "
+         "18446744073709551615 94052754087936 94052754112041 140725957052656 "
+         "0 0 0 0 4096 17663 0 0 0 17 3 0 0 0 0 0 94052754127888 "
+         "94052754129504 94053314560000 140725957055791 140725957055815 "
+         "140725957055815 140725957058538 0\n";
+}
+
+/**
+ * @brief Returns a `/proc/<pid>/status` file with every field of a 6.x
+ * kernel, the counters the scan needs at the end.
+ */
+std::string syntheticStatus() {
+  std::string status =
+      "Name:\tWeb Content\nUmask:\t0022\nState:\tS (sleeping)\n"
+      "Tgid:\t48213\nNgid:\t0\nPid:\t48213\nPPid:\t4012\nTracerPid:\t0\n"
+      "Uid:\t1000\t1000\t1000\t1000\nGid:\t1000\t1000\t1000\t1000\n"
+      "FDSize:\t256\nGroups:\t4 24 27 30 46 100 118 1000\n"
+      "NStgid:\t48213\nNSpid:\t48213\nNSpgid:\t4012\nNSsid:\t4012\n"
+      "Kthread:\t0\n";
+  for (const char *field :
+       {"VmPeak", "VmSize", "VmLck", "VmPin", "VmHWM", "VmRSS", "RssAnon",
+        "RssFile", "RssShmem", "VmData", "VmStk", "VmExe", "VmLib", "VmPTE",
+        "VmSwap", "HugetlbPages"}) {
+    status += std::string(field) + ":\t  1249876 kB\n";
+  }
+  status += "CoreDumping:\t0\nTHP_enabled:\t1\n"
+            "untag_mask:\t0xffffffffffffffff\nThreads:\t37\nSigQ:\t0/62811\n";
+  for (const char *field : {"SigPnd", "ShdPnd", "SigBlk", "SigIgn", "SigCgt",
+                            "CapInh", "CapPrm", "CapEff", "CapBnd", "CapAmb"}) {
+    status += std::string(field) + ":\t0000000000000000\n";
+  }
+  status += "NoNewPrivs:\t1\nSeccomp:\t2\nSeccomp_filters:\t2\n"
+            "Speculation_Store_Bypass:\tthread force mitigated\n"
+            "SpeculationIndirectBranch:\tconditional enabled\n"
+            "Cpus_allowed:\tffffffff\nCpus_allowed_list:\t0-31\n"
+            "Mems_allowed:\t00000000,00000001\nMems_allowed_list:\t0\n"
+            "voluntary_ctxt_switches:\t1523467\n"
+            "nonvoluntary_ctxt_switches:\t98234\n";
+  return status;
+}
+
+/**
+ * @brief Returns a `/proc/<pid>/io` file.
+ */
+std::string syntheticIo() {
+  return "rchar: 9876543210\nwchar: 1234567890\nsyscr: 4567890\n"
+         "syscw: 1234567\nread_bytes: 987654144\nwrite_bytes: 123456512\n"
+         "cancelled_write_bytes: 4096\n";
+}
+
+/**
+ * @brief Returns a `/proc/<pid>/smaps_rollup` file.
+ */
+std::string syntheticSmapsRollup() {
+  std::string smaps =
+      "55d0c4a5c000-7ffd8b5f2000 ---p 00000000 00:00 0   [rollup]\n";
+  for (const char *field :
+       {"Rss", "Pss", "Pss_Dirty", "Pss_Anon", "Pss_File", "Pss_Shmem",
+        "Shared_Clean", "Shared_Dirty", "Private_Clean", "Private_Dirty",
+        "Referenced", "Anonymous", "LazyFree", "AnonHugePages",
+        "ShmemPmdMapped", "FilePmdMapped", "Shared_Hugetlb",
+        "Private_Hugetlb", "Swap", "SwapPss", "Locked"}) {
+    smaps += std::string(field) + ":      123456 kB\n";
+  }
+  return smaps;
+}
+
+/**
+ * @brief Returns a `/proc/stat` file of a machine with many CPUs.
+ */
+std::string syntheticCpuStat() {
+  std::string stat = "cpu  98765432 1234 23456789 876543210 123456 0 "
+                     "234567 0 0 0\n";
+  for (int cpu = 0; cpu < SYNTHETIC_CPUS; ++cpu) {
+    stat += "cpu" + std::to_string(cpu) +
+            " 1543210 19 366512 13695987 1929 0 3665 0 0 0\n";
+  }
+  stat += "intr 1234567890 0 9 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n"
+          "ctxt 9876543210\nbtime 1700000000\nprocesses 12345678\n"
+          "procs_running 3\nprocs_blocked 0\n";
+  return stat;
+}
+
+/**
+ * @brief Returns a `/proc/meminfo` file.
+ */
+std::string syntheticMeminfo() {
+  std::string meminfo;
+  for (const char *field :
+       {"MemTotal", "MemFree", "MemAvailable", "Buffers", "Cached",
+        "SwapCached", "Active", "Inactive", "Active(anon)", "Inactive(anon)",
+        "Active(file)", "Inactive(file)", "Unevictable", "Mlocked",
+        "SwapTotal", "SwapFree", "Dirty", "Writeback", "AnonPages", "Mapped",
+        "Shmem", "KReclaimable", "Slab", "SReclaimable", "SUnreclaim",
+        "KernelStack", "PageTables", "CommitLimit", "Committed_AS"}) {
+    meminfo += std::string(field) + ":       65843212 kB\n";
+  }
+  return meminfo;
+}
+
+/**
+ * @brief Writes the synthetic files into a fresh temporary directory.
+ */
+bool writeFixture() {
+  char pattern[] = "/tmp/process_manager_bench.XXXXXX";
+  if (mkdtemp(pattern) == nullptr) {
+    return false;
+  }
+  fixtureDirectory = pattern;
+  const std::pair<const char *, std::string> files[] = {
+      {"stat", syntheticStat()},       {"status", syntheticStatus()},
+      {"io", syntheticIo()},           {"smaps_rollup", syntheticSmapsRollup()},
+      {"cpu_stat", syntheticCpuStat()}, {"meminfo", syntheticMeminfo()}};
+  for (const auto &[name, contents] : files) {
+    std::ofstream file(fixtureDirectory / name);
+    file << contents;
+    if (!file) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Returns the path read by a benchmark: live file or fixture copy.
+ */
+std::string sourcePath(const benchmark::State &state, const char *live,
+                       const char *fixture) {
+  return state.range(0) == 0 ? std::string(live)
+                             : (fixtureDirectory / fixture).string();
+}
+
+/**
+ * @brief Returns the commit being measured, if the sources are a checkout.
+ */
+std::string currentCommit() {
+  std::string command =
+      std::string("git -C '") + BENCH_SOURCE_DIR +
+      "' rev-parse --short HEAD 2>/dev/null";
+  FILE *pipe = popen(command.c_str(), "r");
+  if (pipe == nullptr) {
+    return "unknown";
+  }
+  char commit[COMMIT_LENGTH] = {};
+  bool read = std::fgets(commit, sizeof(commit), pipe) != nullptr;
+  pclose(pipe);
+  std::string result = read ? commit : "unknown";
+  while (!result.empty() && result.back() == '\n') {
+    result.pop_back();
+  }
+  return result.empty() ? "unknown" : result;
+}
+
+// --- Scanning the live system -------------------------------------------
+
+void BM_GetAllPids(benchmark::State &state) {
+  size_t pids = 0;
+  for (auto _ : state) {
+    std::vector<int> all = ProcessListing::getAllPIDs();
+    pids = all.size();
+    benchmark::DoNotOptimize(all.data());
+  }
+  state.counters["pids"] = static_cast<double>(pids);
+}
+BENCHMARK(BM_GetAllPids)->Name("getAllPIDs/live");
+
+/// Times `fetchProcessList` through `refresh`, reusing the warm caches
+template <ScanBackend Backend>
+void BM_FetchProcessList(benchmark::State &state) {
+  BackendScope backend(Backend);
+  ListOptions options;
+  if (state.range(0) != 0) {
+    options.columns = EXTENDED_COLUMNS;
+  }
+  ProcessListing listing;
+  listing.refresh(options);
+  uint64_t allocations = 0;
+  uint64_t syscallsBefore = syscallCount();
+  for (auto _ : state) {
+    countedRefresh(listing, options, allocations);
+  }
+  state.counters["allocs"] = allocationCounter(allocations);
+  state.counters["syscalls/process"] =
+      syscallsPerProcess(syscallCount() - syscallsBefore,
+                         listing.getProcessCount(), state.iterations());
+  state.counters["processes"] =
+      static_cast<double>(listing.getProcessCount());
+  state.counters["processes/s"] = benchmark::Counter(
+      static_cast<double>(listing.getProcessCount()),
+      benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK_TEMPLATE(BM_FetchProcessList, ScanBackend::Sync)
+    ->Name("fetchProcessList/live")
+    ->ArgName("extended")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_FetchProcessList, ScanBackend::IoUring)
+    ->Name("fetchProcessList/live/io_uring")
+    ->ArgName("extended")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// A first scan, with empty metadata caches
+void BM_FetchProcessListCold(benchmark::State &state) {
+  size_t processes = 0;
+  uint64_t allocations = 0;
+  for (auto _ : state) {
+    ProcessListing listing;
+    countedRefresh(listing, ListOptions(), allocations);
+    processes = listing.getProcessCount();
+  }
+  state.counters["allocs"] = allocationCounter(allocations);
+  state.counters["processes"] = static_cast<double>(processes);
+}
+BENCHMARK(BM_FetchProcessListCold)
+    ->Name("fetchProcessList/live/cold")
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// Scans a `FakeProcfs` tree of range(0) processes, replacing range(1)
+/// percent of them between scans; the tree is advanced outside the timing
+template <ScanBackend Backend>
+void BM_FetchProcessListSynthetic(benchmark::State &state) {
+  BackendScope backend(Backend);
+  FakeProcfsOptions options;
+  options.processes = static_cast<size_t>(state.range(0));
+  options.churn = static_cast<double>(state.range(1)) / 100.0;
+  options.load = FakeLoad::Mixed;
+  options.cpus = SYNTHETIC_SCAN_CPUS;
+  std::filesystem::path root =
+      fixtureDirectory / ("proc-" + std::to_string(state.range(0)) + "-" +
+                          std::to_string(state.range(1)));
+  FakeProcfs procfs(options);
+  std::string error;
+  if (!procfs.create(root.string(), error)) {
+    state.SkipWithError(error.c_str());
+    return;
+  }
+  ProcPaths::setProcRoot(root.string());
+
+  ProcessListing listing;
+  listing.refresh(ListOptions());
+  uint64_t allocations = 0;
+  uint64_t syscallsBefore = syscallCount();
+  for (auto _ : state) {
+    state.PauseTiming();
+    bool advanced = procfs.advance(SYNTHETIC_STEP_SECONDS, error);
+    state.ResumeTiming();
+    if (!advanced) {
+      state.SkipWithError(error.c_str());
+      break;
+    }
+    countedRefresh(listing, ListOptions(), allocations);
+  }
+  state.counters["allocs"] = allocationCounter(allocations);
+  state.counters["syscalls/process"] =
+      syscallsPerProcess(syscallCount() - syscallsBefore,
+                         listing.getProcessCount(), state.iterations());
+  state.counters["processes"] =
+      static_cast<double>(listing.getProcessCount());
+  state.counters["processes/s"] = benchmark::Counter(
+      static_cast<double>(listing.getProcessCount()),
+      benchmark::Counter::kIsIterationInvariantRate);
+
+  ProcPaths::setProcRoot("/proc");
+  std::error_code ignored;
+  std::filesystem::remove_all(root, ignored);
+}
+BENCHMARK_TEMPLATE(BM_FetchProcessListSynthetic, ScanBackend::Sync)
+    ->Name("fetchProcessList/synthetic")
+    ->ArgNames({"processes", "churn_pct"})
+    ->Args({1000, 0})
+    ->Args({1000, 5})
+    ->Args({10000, 0})
+    ->Args({10000, 5})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_FetchProcessListSynthetic, ScanBackend::IoUring)
+    ->Name("fetchProcessList/synthetic/io_uring")
+    ->ArgNames({"processes", "churn_pct"})
+    ->Args({1000, 0})
+    ->Args({1000, 5})
+    ->Args({10000, 0})
+    ->Args({10000, 5})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// Filters applied by `fetchProcessList/synthetic/filter`, by range(0): none,
+/// one decided after `stat` and one decided by the PID alone
+const char *const SYNTHETIC_FILTERS[] = {"", "cpu > 50", "pid <= 100"};
+
+/// Scans 10000 synthetic processes for five columns with the range(0)th
+/// filter; rejected processes skip their remaining files
+void BM_FetchFilteredSynthetic(benchmark::State &state) {
+  FakeProcfsOptions options;
+  options.processes = 10000;
+  options.load = FakeLoad::Mixed;
+  options.cpus = SYNTHETIC_SCAN_CPUS;
+  std::filesystem::path root =
+      fixtureDirectory / ("filter-" + std::to_string(state.range(0)));
+  FakeProcfs procfs(options);
+  std::string error;
+  if (!procfs.create(root.string(), error)) {
+    state.SkipWithError(error.c_str());
+    return;
+  }
+  ProcPaths::setProcRoot(root.string());
+
+  ListOptions listOptions;
+  listOptions.columns = {ProcessColumn::Pid, ProcessColumn::Cpu,
+                         ProcessColumn::Rss, ProcessColumn::IoRead,
+                         ProcessColumn::VoluntaryCtxSwitches};
+  const char *text = SYNTHETIC_FILTERS[state.range(0)];
+  if (*text != '\0') {
+    auto filter = std::make_shared<ProcessFilter>();
+    filter->compile(text, error);
+    listOptions.filter = std::move(filter);
+  }
+  ProcessListing listing;
+  listing.refresh(listOptions);
+  uint64_t allocations = 0;
+  uint64_t syscallsBefore = syscallCount();
+  for (auto _ : state) {
+    state.PauseTiming();
+    bool advanced = procfs.advance(SYNTHETIC_STEP_SECONDS, error);
+    state.ResumeTiming();
+    if (!advanced) {
+      state.SkipWithError(error.c_str());
+      break;
+    }
+    countedRefresh(listing, listOptions, allocations);
+  }
+  const ScanReport &report = listing.getScanReport();
+  state.counters["allocs"] = allocationCounter(allocations);
+  state.counters["syscalls/process"] =
+      syscallsPerProcess(syscallCount() - syscallsBefore,
+                         report.processes + report.filtered,
+                         state.iterations());
+  state.counters["matches"] = static_cast<double>(report.processes);
+
+  ProcPaths::setProcRoot("/proc");
+  std::error_code ignored;
+  std::filesystem::remove_all(root, ignored);
+}
+BENCHMARK(BM_FetchFilteredSynthetic)
+    ->Name("fetchProcessList/synthetic/filter")
+    ->ArgName("filter")
+    ->DenseRange(0, 2)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// Lists the range(0) threads of one synthetic process; every task has
+/// its own `stat` and `status`, copied from the process
+template <ScanBackend Backend>
+void BM_FetchThreadsSynthetic(benchmark::State &state) {
+  BackendScope backend(Backend);
+  FakeProcfsOptions options;
+  options.processes = 1;
+  options.cpus = SYNTHETIC_SCAN_CPUS;
+  std::filesystem::path root =
+      fixtureDirectory / ("threads-" + std::to_string(state.range(0)));
+  FakeProcfs procfs(options);
+  std::string error;
+  if (!procfs.create(root.string(), error)) {
+    state.SkipWithError(error.c_str());
+    return;
+  }
+  int pid = procfs.pids().front();
+  std::filesystem::path process = root / std::to_string(pid);
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    std::filesystem::path task =
+        process / "task" / std::to_string(pid + static_cast<int>(i));
+    std::filesystem::create_directories(task);
+    std::filesystem::copy_file(process / "stat", task / "stat");
+    std::filesystem::copy_file(process / "status", task / "status");
+  }
+  ProcPaths::setProcRoot(root.string());
+
+  ListOptions listOptions;
+  listOptions.columns = ProcessColumns::defaultThreadColumns();
+  listOptions.columns.push_back(ProcessColumn::VoluntaryCtxSwitches);
+  listOptions.threads = true;
+  listOptions.pid = pid;
+  ProcessListing listing;
+  listing.refresh(listOptions);
+  uint64_t allocations = 0;
+  uint64_t syscallsBefore = syscallCount();
+  for (auto _ : state) {
+    countedRefresh(listing, listOptions, allocations);
+  }
+  state.counters["allocs"] = allocationCounter(allocations);
+  state.counters["syscalls/thread"] =
+      syscallsPerProcess(syscallCount() - syscallsBefore,
+                         listing.getProcessCount(), state.iterations());
+  state.counters["threads/s"] = benchmark::Counter(
+      static_cast<double>(listing.getProcessCount()),
+      benchmark::Counter::kIsIterationInvariantRate);
+
+  ProcPaths::setProcRoot("/proc");
+  std::error_code ignored;
+  std::filesystem::remove_all(root, ignored);
+}
+BENCHMARK_TEMPLATE(BM_FetchThreadsSynthetic, ScanBackend::Sync)
+    ->Name("fetchThreads/synthetic")
+    ->ArgName("threads")
+    ->Arg(100)
+    ->Arg(5000)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_FetchThreadsSynthetic, ScanBackend::IoUring)
+    ->Name("fetchThreads/synthetic/io_uring")
+    ->ArgName("threads")
+    ->Arg(100)
+    ->Arg(5000)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// Renders the table of `listProcesses` without the terminal write
+void BM_RenderTable(benchmark::State &state) {
+  ListOptions options;
+  ProcessListing listing;
+  listing.refresh(options);
+  NullBuffer buffer;
+  std::ostream out(&buffer);
+  for (auto _ : state) {
+    listing.printTable(out, options.columns);
+  }
+  state.counters["rows"] = static_cast<double>(listing.getProcessCount());
+}
+BENCHMARK(BM_RenderTable)->Name("listProcesses/render/live");
+
+// --- procfs parsers -------------------------------------------------------
+
+/// Reads and parses a stat file: 0 = `/proc/self/stat`, 1 = the fixture
+void BM_ReadParseStat(benchmark::State &state) {
+  std::string path = sourcePath(state, "/proc/self/stat", "stat");
+  std::string contents;
+  ProcStat stat;
+  for (auto _ : state) {
+    ProcReader::readFile(path, contents);
+    benchmark::DoNotOptimize(ProcParsers::parseStat(contents, stat));
+  }
+}
+BENCHMARK(BM_ReadParseStat)->Name("readParseStat")->ArgName("synthetic")
+    ->Arg(0)->Arg(1);
+
+void BM_ReadParseStatus(benchmark::State &state) {
+  std::string path = sourcePath(state, "/proc/self/status", "status");
+  std::string contents;
+  ProcStatus status;
+  for (auto _ : state) {
+    ProcReader::readFile(path, contents);
+    benchmark::DoNotOptimize(ProcParsers::parseStatus(contents, status));
+  }
+}
+BENCHMARK(BM_ReadParseStatus)->Name("readParseStatus")->ArgName("synthetic")
+    ->Arg(0)->Arg(1);
+
+void BM_ReadParseCpuLines(benchmark::State &state) {
+  std::string path = sourcePath(state, "/proc/stat", "cpu_stat");
+  std::string contents;
+  std::vector<CpuTimes> cpus;
+  for (auto _ : state) {
+    ProcReader::readFile(path, contents);
+    benchmark::DoNotOptimize(ProcParsers::parseCpuLines(contents, cpus));
+  }
+  state.counters["cpus"] = static_cast<double>(cpus.size());
+}
+BENCHMARK(BM_ReadParseCpuLines)->Name("readParseCpuLines")
+    ->ArgName("synthetic")->Arg(0)->Arg(1);
+
+void BM_ParseStat(benchmark::State &state) {
+  std::string contents = syntheticStat();
+  ProcStat stat;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ProcParsers::parseStat(contents, stat));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(contents.size()));
+}
+BENCHMARK(BM_ParseStat)->Name("parseStat/synthetic");
+
+void BM_ParseStatm(benchmark::State &state) {
+  std::string contents = "1006723 312456 45123 5 0 498765 0\n";
+  unsigned long long residentPages = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ProcParsers::parseStatm(contents, residentPages));
+  }
+}
+BENCHMARK(BM_ParseStatm)->Name("parseStatm/synthetic");
+
+void BM_ParseStatus(benchmark::State &state) {
+  std::string contents = syntheticStatus();
+  ProcStatus status;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ProcParsers::parseStatus(contents, status));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(contents.size()));
+}
+BENCHMARK(BM_ParseStatus)->Name("parseStatus/synthetic");
+
+void BM_ParseIo(benchmark::State &state) {
+  std::string contents = syntheticIo();
+  ProcIo io;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ProcParsers::parseIo(contents, io));
+  }
+}
+BENCHMARK(BM_ParseIo)->Name("parseIo/synthetic");
+
+void BM_ParseSmapsRollup(benchmark::State &state) {
+  std::string contents = syntheticSmapsRollup();
+  ProcSmaps smaps;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ProcParsers::parseSmapsRollup(contents, smaps));
+  }
+}
+BENCHMARK(BM_ParseSmapsRollup)->Name("parseSmapsRollup/synthetic");
+
+void BM_ParseCpuLines(benchmark::State &state) {
+  std::string contents = syntheticCpuStat();
+  std::vector<CpuTimes> cpus;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ProcParsers::parseCpuLines(contents, cpus));
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(contents.size()));
+}
+BENCHMARK(BM_ParseCpuLines)->Name("parseCpuLines/synthetic");
+
+void BM_ParseMeminfo(benchmark::State &state) {
+  std::string contents = syntheticMeminfo();
+  unsigned long long value = 0;
+  for (auto _ : state) {
+    ProcParsers::parseMemTotal(contents, value);
+    benchmark::DoNotOptimize(
+        ProcParsers::parseKeyedValue(contents, "MemAvailable:", value));
+  }
+}
+BENCHMARK(BM_ParseMeminfo)->Name("parseMeminfo/synthetic");
+
+// --- Infrastructure -------------------------------------------------------
+
+/// Enqueues a batch of trivial tasks and waits for all of them
+void BM_ThreadPoolThroughput(benchmark::State &state) {
+  ThreadPool pool(static_cast<size_t>(state.range(0)));
+  std::atomic<long> executed{0};
+  for (auto _ : state) {
+    for (int i = 0; i < TASKS_PER_BATCH; ++i) {
+      pool.enqueue([&executed] {
+        executed.fetch_add(1, std::memory_order_relaxed);
+      });
+    }
+    pool.waitForAll();
+  }
+  state.SetItemsProcessed(state.iterations() * TASKS_PER_BATCH);
+}
+BENCHMARK(BM_ThreadPoolThroughput)
+    ->Name("ThreadPool/enqueueExecute")
+    ->ArgName("threads")
+    ->Arg(1)
+    ->Arg(4)
+    ->UseRealTime();
+
+/// Logs to `logs/process_manager.log` below the working directory, flushing
+/// every message like the application does
+void BM_LoggerThroughput(benchmark::State &state) {
+  Logger logger;
+  std::string message = "Benchmark message for PID 48213 (Web Content)";
+  for (auto _ : state) {
+    logger.logAction(message);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoggerThroughput)->Name("Logger/logAction");
+
+void BM_CommandParserParse(benchmark::State &state) {
+  CommandParser parser;
+  std::string command = "list --columns pid,name,cpu,mem,rss --sort cpu "
+                        "--top 20";
+  for (auto _ : state) {
+    ParsedCommand parsed = parser.parse(command);
+    benchmark::DoNotOptimize(parsed.args.data());
+  }
+}
+BENCHMARK(BM_CommandParserParse)->Name("CommandParser/parse");
+} // namespace
+
+int main(int argc, char *argv[]) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return EXIT_FAILURE;
+  }
+  if (!writeFixture()) {
+    std::fprintf(stderr, "Cannot write the synthetic fixture\n");
+    return EXIT_FAILURE;
+  }
+
+  if (std::getenv(LARGE_ENVIRONMENT) != nullptr) {
+    benchmark::RegisterBenchmark(
+        "fetchProcessList/synthetic",
+        BM_FetchProcessListSynthetic<ScanBackend::Sync>)
+        ->ArgNames({"processes", "churn_pct"})
+        ->Args({LARGE_SYSTEM, 0})
+        ->Args({LARGE_SYSTEM, 5})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+    benchmark::RegisterBenchmark(
+        "fetchProcessList/synthetic/io_uring",
+        BM_FetchProcessListSynthetic<ScanBackend::IoUring>)
+        ->ArgNames({"processes", "churn_pct"})
+        ->Args({LARGE_SYSTEM, 0})
+        ->Args({LARGE_SYSTEM, 5})
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+  }
+
+  benchmark::AddCustomContext("commit", currentCommit());
+  benchmark::AddCustomContext(
+      "processes", std::to_string(ProcessListing::getAllPIDs().size()));
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+
+  std::error_code ignored;
+  std::filesystem::remove_all(fixtureDirectory, ignored);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,160 @@
+/**
+ * @file cgroup_monitoring.h
+ * @brief Provides aggregated resource usage per cgroup v2 control group.
+ *
+ * This file defines the `CgroupMonitoring` class, which reads the resource
+ * accounting files that the kernel already maintains for every cgroup
+ * (`cpu.stat`, `memory.current`, `memory.stat` and `io.stat`) instead of
+ * summing per-process values. The cgroup hierarchy is walked once and cached;
+ * an inotify watch on every cgroup directory signals when cgroups are created
+ * or removed so the walk is only repeated when needed.
+ */
+
+#ifndef CGROUP_MONITORING_H
+#define CGROUP_MONITORING_H
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct CgroupStats
+ * @brief Holds the resource usage of a single cgroup.
+ *
+ * Rates are computed from the difference between two consecutive samples and
+ * are zero until a second sample is available.
+ */
+struct CgroupStats {
+  std::string path;                     ///< Path relative to the root
+  double cpuUsage = 0.0;                ///< CPU usage, percent of one CPU
+  unsigned long long memoryCurrent = 0; ///< memory.current in bytes
+  unsigned long long memoryAnon = 0;    ///< Anonymous memory in bytes
+  unsigned long long memoryFile = 0;    ///< Page cache in bytes
+  double ioReadRate = 0.0;              ///< Bytes read per second
+  double ioWriteRate = 0.0;             ///< Bytes written per second
+  bool hasMemory = false;               ///< memory controller enabled
+  bool hasIo = false;                   ///< io controller enabled
+  double cpuPressure = 0.0;             ///< cpu.pressure some avg10, percent
+  double memoryPressure = 0.0;          ///< memory.pressure some avg10
+  double ioPressure = 0.0;              ///< io.pressure some avg10
+  bool hasPressure = false;             ///< Set by `readPressure`
+};
+
+/**
+ * @class CgroupMonitoring
+ * @brief A class for sampling resource usage of cgroup v2 control groups.
+ *
+ * The `CgroupMonitoring` class locates the cgroup v2 hierarchy, caches the
+ * list of cgroup directories and samples their accounting files on demand.
+ * Each sample costs a handful of reads per cgroup, independent of the number
+ * of processes running inside them.
+ */
+class CgroupMonitoring {
+public:
+  /**
+   * @brief Constructs a `CgroupMonitoring` object.
+   *
+   * Locates the cgroup v2 mount point and sets up the inotify instance used
+   * to detect hierarchy changes. The hierarchy itself is walked on the first
+   * refresh.
+   */
+  CgroupMonitoring();
+
+  /**
+   * @brief Destroys the `CgroupMonitoring` object.
+   *
+   * Closes the inotify instance and all of its watches.
+   */
+  ~CgroupMonitoring();
+
+  CgroupMonitoring(const CgroupMonitoring &) = delete;
+  CgroupMonitoring &operator=(const CgroupMonitoring &) = delete;
+
+  /**
+   * @brief Checks whether a cgroup v2 hierarchy was found.
+   *
+   * @return `true` if cgroup v2 is mounted, `false` otherwise.
+   */
+  bool isAvailable() const { return !root_.empty(); }
+
+  /**
+   * @brief Samples the accounting files of every cached cgroup.
+   *
+   * The hierarchy is walked again first if cgroups were created or removed
+   * since the previous refresh.
+   */
+  void refresh();
+
+  /**
+   * @brief Returns the statistics of the most recent refresh.
+   *
+   * @return The statistics, in hierarchy order.
+   */
+  const std::vector<CgroupStats> &getCgroups() const { return stats_; }
+
+  /**
+   * @brief Returns the cgroups with the highest CPU usage.
+   *
+   * @param count The maximum number of cgroups to return.
+   * @return Up to `count` statistics, sorted by descending CPU usage.
+   */
+  std::vector<CgroupStats> getTopCgroups(size_t count) const;
+
+  /**
+   * @brief Reads the PSI files of a cgroup into its statistics.
+   *
+   * `refresh` does not read them, so that only the rows on display pay for
+   * the three extra reads.
+   *
+   * @param stats The statistics of a cgroup returned by this object.
+   * @return `true` if the cgroup has PSI files, `false` otherwise.
+   */
+  bool readPressure(CgroupStats &stats) const;
+
+  /**
+   * @brief Lists all cgroups with their resource usage.
+   *
+   * If no previous sample exists, a short priming sample is taken first so
+   * that rates can be displayed.
+   */
+  void listCgroups();
+
+private:
+  /**
+   * @struct CgroupNode
+   * @brief A cached cgroup directory with the counters of its last sample.
+   */
+  struct CgroupNode {
+    std::string path;                    ///< Path relative to the root
+    unsigned long long cpuUsageUsec = 0; ///< usage_usec from cpu.stat
+    unsigned long long ioReadBytes = 0;  ///< Summed rbytes from io.stat
+    unsigned long long ioWriteBytes = 0; ///< Summed wbytes from io.stat
+    bool sampled = false;                ///< Counters hold a sample
+  };
+
+  /**
+   * @brief Walks the hierarchy and rebuilds the list of cgroups.
+   *
+   * Counters of cgroups that still exist are kept so their rates remain
+   * valid across the walk.
+   */
+  void walkHierarchy();
+
+  /**
+   * @brief Drains pending inotify events.
+   *
+   * @return `true` if a cgroup was created or removed, `false` otherwise.
+   */
+  bool hierarchyChanged();
+
+  std::string root_; ///< Mount point of the cgroup v2 hierarchy
+  int inotifyFd_; ///< inotify instance, or -1 if unavailable
+  bool walked_; ///< Whether the hierarchy has been walked
+  std::vector<CgroupNode> nodes_; ///< Cached cgroups in hierarchy order
+  std::vector<CgroupStats> stats_; ///< Statistics of the last refresh
+  std::unordered_map<int, std::string> watches_; ///< inotify watch paths
+  std::chrono::steady_clock::time_point lastRefresh_; ///< Last sample time
+};
+
+#endif // CGROUP_MONITORING_H
@@ -0,0 +1,259 @@
+/**
+ * @file collector_daemon.h
+ * @brief Provides a long-running collector queried over a Unix socket.
+ *
+ * This file defines the `CollectorDaemon` class, which keeps the process
+ * table and the system counters sampled on a fixed interval and answers
+ * `DaemonProtocol` requests from any number of local clients. Because the
+ * daemon always holds the previous sample, every reply carries CPU usage
+ * measured over the last interval instead of the lifetime average that a
+ * cold start produces.
+ */
+
+#ifndef COLLECTOR_DAEMON_H
+#define COLLECTOR_DAEMON_H
+
+#include "daemon_protocol.h"
+#include "data_monitoring.h"
+#include "process_history.h"
+#include "process_listing.h"
+#include "rule_engine.h"
+#include "shm_snapshot.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class CollectorDaemon
+ * @brief Samples on a background thread and serves clients on an epoll loop.
+ *
+ * Each sample is encoded once into an immutable buffer of process records
+ * sorted by CPU usage. Snapshot, top-N and subscription replies are built
+ * from a small per-request header and a slice of that shared buffer, so the
+ * cost of a client is a `sendmsg` call rather than another scan of `/proc`.
+ * Subscribers that fall behind skip samples instead of queueing them.
+ */
+class CollectorDaemon {
+public:
+  /// Memory above which the histories of idle processes are evicted
+  static constexpr size_t HISTORY_MEMORY_BYTES = 64u << 20;
+
+  /**
+   * @brief Constructs a daemon that is not yet listening.
+   *
+   * @param interval The time between two samples.
+   * @param historyLength The number of samples kept per process; the
+   * compressed history is capped at `HISTORY_MEMORY_BYTES`.
+   */
+  CollectorDaemon(std::chrono::milliseconds interval, size_t historyLength);
+
+  /**
+   * @brief Stops sampling and closes every socket.
+   */
+  ~CollectorDaemon();
+
+  CollectorDaemon(const CollectorDaemon &) = delete;
+  CollectorDaemon &operator=(const CollectorDaemon &) = delete;
+
+  /**
+   * @brief Returns the socket path used when none is given.
+   *
+   * @return `$XDG_RUNTIME_DIR/process_manager.sock` if the variable is set,
+   * `/tmp/process_manager-<uid>.sock` otherwise.
+   */
+  static std::string defaultSocketPath();
+
+  /**
+   * @brief Creates the socket, replacing a stale one left by a dead daemon.
+   *
+   * The socket is only accessible to the owner.
+   *
+   * @param path The filesystem path of the socket.
+   * @param[out] error A description of the problem if listening fails.
+   * @return `true` if the daemon is listening, `false` otherwise.
+   */
+  bool listen(const std::string &path, std::string &error);
+
+  /**
+   * @brief Also publishes every sample into a shared-memory segment.
+   *
+   * Local readers can then map the segment with `ShmSnapshotReader` and read
+   * the table without talking to the daemon at all.
+   *
+   * @param name The segment name, e.g. `ShmSnapshotWriter::defaultName()`.
+   * @param capacity The maximum number of processes per snapshot; the
+   * busiest ones are kept.
+   * @param[out] error A description of the problem on failure.
+   * @return `true` if the segment was created, `false` otherwise.
+   */
+  bool publishSharedMemory(const std::string &name, uint32_t capacity,
+                           std::string &error);
+
+  /**
+   * @brief Evaluates threshold rules against every sample.
+   *
+   * Fired rules run their actions on the sampling thread.
+   *
+   * @param rules The compiled rules.
+   * @param dryRun Only log the actions instead of running them.
+   */
+  void enableRules(std::unique_ptr<RuleEngine> rules, bool dryRun);
+
+  /**
+   * @brief Starts sampling and serves clients until `stop` is called.
+   *
+   * @param[out] error A description of the problem if serving fails.
+   * @return `true` once stopped, `false` if waiting for events failed.
+   */
+  bool run(std::string &error);
+
+  /**
+   * @brief Makes `run` return. Safe to call from any thread.
+   */
+  void stop();
+
+private:
+  /**
+   * @struct Published
+   * @brief One encoded sample, shared by every reply built from it.
+   */
+  struct Published {
+    DaemonSystemSample system;                  ///< System-wide values
+    std::shared_ptr<const std::string> records; ///< Encoded process records
+    std::vector<size_t> offsets;                ///< Record starts, then end
+  };
+
+  /**
+   * @struct Chunk
+   * @brief A slice of a shared buffer waiting to be sent.
+   */
+  struct Chunk {
+    std::shared_ptr<const std::string> data; ///< Owning buffer
+    size_t offset = 0;                       ///< First byte not yet sent
+    size_t end = 0;                          ///< One past the last byte
+  };
+
+  /**
+   * @struct Connection
+   * @brief The state of one client connection.
+   */
+  struct Connection {
+    std::string input;         ///< Bytes not yet parsed
+    std::deque<Chunk> output;  ///< Reply slices not yet sent
+    size_t queuedBytes = 0;    ///< Bytes in `output`
+    bool subscribed = false;   ///< Receives every new sample
+    size_t subscribeCount = 0; ///< Records per pushed sample
+    bool writing = false;      ///< Waiting for EPOLLOUT
+  };
+
+  /**
+   * @brief The sampling thread: samples until `stop` is called.
+   */
+  void sampleLoop();
+
+  /**
+   * @brief Takes one sample, publishes it and wakes the event loop.
+   */
+  void sample();
+
+  /**
+   * @brief Copies a sample into the shared-memory segment.
+   */
+  void publishShared(const DaemonSystemSample &system);
+
+  /**
+   * @brief Accepts all pending connections.
+   */
+  void acceptConnections();
+
+  /**
+   * @brief Reads from a connection and answers complete requests.
+   *
+   * @return `false` if the connection must be closed.
+   */
+  bool handleReadable(int fd);
+
+  /**
+   * @brief Answers one request frame.
+   *
+   * @return `false` if the connection must be closed.
+   */
+  bool handleRequest(Connection &connection, DaemonMessage type,
+                     std::string_view payload);
+
+  /**
+   * @brief Queues a `SnapshotReply` with at most `count` records.
+   */
+  void queueSnapshot(Connection &connection, const Published &published,
+                     size_t count);
+
+  /**
+   * @brief Queues a `HistoryReply` for one process.
+   */
+  void queueHistory(Connection &connection, int pid);
+
+  /**
+   * @brief Queues a buffer that is sent whole.
+   */
+  static void queue(Connection &connection,
+                    std::shared_ptr<const std::string> data);
+
+  /**
+   * @brief Sends the newest sample to every subscriber that keeps up.
+   */
+  void publishToSubscribers();
+
+  /**
+   * @brief Sends as much queued output as the socket accepts.
+   *
+   * @return `false` if the connection must be closed.
+   */
+  bool flush(int fd, Connection &connection);
+
+  /**
+   * @brief Closes a connection and forgets its state.
+   */
+  void closeConnection(int fd);
+
+  /**
+   * @brief Returns the most recent sample.
+   */
+  std::shared_ptr<const Published> latest() const;
+
+  std::chrono::milliseconds interval_; ///< Time between samples
+  std::string socketPath_;             ///< Removed on destruction
+
+  int listenFd_;                                    ///< Listening socket
+  int epollFd_;                                     ///< epoll instance
+  int wakeupFd_;                                    ///< eventfd for `stop`
+  int sampleFd_;                                    ///< eventfd per sample
+  std::unordered_map<int, Connection> connections_; ///< Clients by socket
+
+  // Touched by the sampling thread only
+  ProcessListing listing_;                          ///< Reused per sample
+  SystemCounters previous_;                         ///< Last counters
+  std::string readBuffer_;                          ///< Reused for procfs
+  uint32_t generation_ = 0;                         ///< Samples taken
+  std::unique_ptr<ShmSnapshotWriter> sharedWriter_; ///< Optional segment
+  std::unique_ptr<RuleEngine> rules_;               ///< Optional rules
+  bool rulesDryRun_ = false;                        ///< Only log actions
+  std::vector<RuleFiring> firings_;                 ///< Reused per sample
+
+  mutable std::mutex dataMutex_;               ///< Guards the two below
+  std::shared_ptr<const Published> published_; ///< Newest sample
+  ProcessHistory history_;                     ///< Recent samples by PID
+
+  std::mutex stopMutex_;                  ///< Guards `stopping_`
+  std::condition_variable stopCondition_; ///< Wakes the sampling thread
+  bool stopping_ = false;                 ///< Set by `stop`
+  std::thread sampler_;                   ///< Sampling thread
+};
+
+#endif // COLLECTOR_DAEMON_H
@@ -53,7 +53,9 @@ public:
    *
    * This method takes a string, splits it into the command name and its
    * arguments, and returns a `ParsedCommand` structure representing the parsed
-   * command.
+   * command. Words are separated by whitespace; single or double quotes
+   * group words into one argument, e.g. `--filter 'cpu > 5'`, and are
+   * removed.
    *
    * @param[in] input The input string to be parsed.
    * @return A `ParsedCommand` structure containing the command name and a
@@ -0,0 +1,129 @@
+/**
+ * @file daemon_client.h
+ * @brief Provides a blocking client for the collector daemon.
+ *
+ * This file defines the `DaemonClient` class, used by the `query` command
+ * and by the interactive shell to read warm samples from a running
+ * `CollectorDaemon` instead of scanning `/proc` themselves.
+ */
+
+#ifndef DAEMON_CLIENT_H
+#define DAEMON_CLIENT_H
+
+#include "daemon_protocol.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @class DaemonClient
+ * @brief A connection to the collector daemon socket.
+ *
+ * Every call blocks until the reply has arrived. Errors, including those
+ * reported by the daemon, are returned as messages.
+ */
+class DaemonClient {
+public:
+  /**
+   * @brief Constructs a client that is not yet connected.
+   */
+  DaemonClient();
+
+  /**
+   * @brief Closes the connection.
+   */
+  ~DaemonClient();
+
+  DaemonClient(const DaemonClient &) = delete;
+  DaemonClient &operator=(const DaemonClient &) = delete;
+
+  /**
+   * @brief Connects to a daemon.
+   *
+   * @param path The socket path.
+   * @param[out] error A description of the problem if connecting fails.
+   * @return `true` if connected, `false` otherwise.
+   */
+  bool connect(const std::string &path, std::string &error);
+
+  /**
+   * @brief Fetches the newest sample.
+   *
+   * @param top The number of processes to fetch, or 0 for all of them.
+   * @param[out] snapshot The sample, processes sorted by CPU usage.
+   * @param[out] error A description of the problem on failure.
+   * @return `true` on success, `false` otherwise.
+   */
+  bool fetchSnapshot(size_t top, DaemonSnapshot &snapshot, std::string &error);
+
+  /**
+   * @brief Fetches the recent samples of one process.
+   *
+   * @param pid The process ID.
+   * @param[out] samples The samples, oldest first.
+   * @param[out] error A description of the problem on failure.
+   * @return `true` on success, `false` otherwise.
+   */
+  bool fetchHistory(int pid, std::vector<DaemonHistorySample> &samples,
+                    std::string &error);
+
+  /**
+   * @brief Fetches the daemon's own counters and latencies.
+   *
+   * @param[out] stats The daemon's `SelfStats`.
+   * @param[out] error A description of the problem on failure.
+   * @return `true` on success, `false` otherwise.
+   */
+  bool fetchStats(SelfStatsSnapshot &stats, std::string &error);
+
+  /**
+   * @brief Asks the daemon to push every new sample.
+   *
+   * Read the samples with `nextSnapshot`; the first one is the current
+   * sample.
+   *
+   * @param top The number of processes per sample, or 0 for all of them.
+   * @param[out] error A description of the problem on failure.
+   * @return `true` on success, `false` otherwise.
+   */
+  bool subscribe(size_t top, std::string &error);
+
+  /**
+   * @brief Waits for the next pushed sample.
+   *
+   * @param[out] snapshot The sample.
+   * @param[out] error A description of the problem on failure.
+   * @return `true` on success, `false` otherwise.
+   */
+  bool nextSnapshot(DaemonSnapshot &snapshot, std::string &error);
+
+  /**
+   * @brief Prints a sample as a table like the one of `list`.
+   *
+   * @param out The stream to print to.
+   * @param snapshot The sample.
+   */
+  static void printTable(std::ostream &out, const DaemonSnapshot &snapshot);
+
+private:
+  /**
+   * @brief Sends a request frame.
+   */
+  bool sendRequest(DaemonMessage type, int64_t argument, std::string &error);
+
+  /**
+   * @brief Reads one frame, turning `Error` frames into a failure.
+   */
+  bool readFrame(DaemonMessage expected, std::string &payload,
+                 std::string &error);
+
+  /**
+   * @brief Reads exactly `size` bytes.
+   */
+  bool readExactly(char *data, size_t size, std::string &error);
+
+  int fd_; ///< Connected socket, or -1
+};
+
+#endif // DAEMON_CLIENT_H
@@ -0,0 +1,237 @@
+/**
+ * @file daemon_protocol.h
+ * @brief Defines the binary protocol spoken over the collector daemon socket.
+ *
+ * Every message is a frame made of a fixed header followed by a payload:
+ *
+ * | Field   | Type | Description                        |
+ * |---------|------|------------------------------------|
+ * | magic   | u32  | `DaemonProtocol::MAGIC` ("PMD1")   |
+ * | type    | u16  | A `DaemonMessage` value            |
+ * | length  | u32  | Size of the payload in bytes       |
+ *
+ * Integers are little-endian. Percentages travel as hundredths of a percent
+ * in a u32, strings as a u16 length followed by the bytes. Requests:
+ *
+ * - `Snapshot`: empty payload; answered with a `SnapshotReply`
+ * - `Top`: u32 count; a `SnapshotReply` with the busiest processes only
+ * - `History`: i32 pid; answered with a `HistoryReply`
+ * - `Subscribe`: u32 count (0 for all); a `SnapshotReply` after every sample
+ * - `Stats`: empty payload; answered with a `StatsReply` describing the
+ *   daemon's own cost
+ *
+ * A `SnapshotReply` holds the system sample, a u32 record count and the
+ * process records sorted by CPU usage, so a top-N reply is a prefix of the
+ * full one. A `StatsReply` holds u64 uptime (ms), CPU time (us) and peak RSS
+ * (kB), then three lists, each a u16 count followed by named entries: the
+ * counters (u64 value), the gauges (i64 value and peak) and the histograms
+ * (u64 count, sum and max in ns, then a u16 bucket count and u64 buckets).
+ * Failed requests are answered with an `Error` frame.
+ */
+
+#ifndef DAEMON_PROTOCOL_H
+#define DAEMON_PROTOCOL_H
+
+#include "self_stats.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @enum DaemonMessage
+ * @brief The type of a frame.
+ */
+enum class DaemonMessage : uint16_t {
+  Snapshot = 0x01,      ///< Request the whole process table
+  Top = 0x02,           ///< Request the busiest processes
+  History = 0x03,       ///< Request the recent samples of one process
+  Subscribe = 0x04,     ///< Request a snapshot after every sample
+  Stats = 0x05,         ///< Request the daemon's own counters
+  SnapshotReply = 0x81, ///< System sample and process records
+  HistoryReply = 0x83,  ///< Samples of one process, oldest first
+  StatsReply = 0x85,    ///< Counters, gauges and latency histograms
+  Error = 0xff          ///< The request failed; payload is a message
+};
+
+/**
+ * @struct DaemonSystemSample
+ * @brief System-wide values of one daemon sample.
+ */
+struct DaemonSystemSample {
+  uint64_t timestampMs = 0;    ///< Wall-clock time of the sample
+  uint32_t generation = 0;     ///< Number of samples taken so far
+  double cpuUsage = 0.0;       ///< CPU usage since the previous sample
+  double memoryUsage = 0.0;    ///< Memory usage percentage
+  uint64_t memTotalKb = 0;     ///< MemTotal from /proc/meminfo
+  uint64_t memAvailableKb = 0; ///< MemAvailable from /proc/meminfo
+  uint32_t processCount = 0;   ///< Processes in the full table
+};
+
+/**
+ * @struct DaemonProcess
+ * @brief One process record of a snapshot.
+ */
+struct DaemonProcess {
+  int32_t pid = 0;          ///< Process ID
+  double cpuUsage = 0.0;    ///< CPU usage since the previous sample
+  double memoryUsage = 0.0; ///< Memory usage percentage
+  uint64_t rssKb = 0;       ///< Resident set size in kB
+  uint32_t threads = 0;     ///< Number of threads
+  std::string name;         ///< Process name
+};
+
+/**
+ * @struct DaemonSnapshot
+ * @brief A decoded `SnapshotReply`.
+ */
+struct DaemonSnapshot {
+  DaemonSystemSample system;            ///< System-wide values
+  std::vector<DaemonProcess> processes; ///< Sorted by CPU usage, descending
+};
+
+/**
+ * @struct DaemonHistorySample
+ * @brief One sample of a process's history.
+ */
+struct DaemonHistorySample {
+  uint64_t timestampMs = 0; ///< Wall-clock time of the sample
+  double cpuUsage = 0.0;    ///< CPU usage percentage
+  double memoryUsage = 0.0; ///< Memory usage percentage
+  uint64_t rssKb = 0;       ///< Resident set size in kB
+};
+
+/**
+ * @class DaemonProtocol
+ * @brief Encodes and decodes daemon frames.
+ *
+ * Encoders append to a caller-owned string so replies can be assembled from
+ * pieces without intermediate copies. Decoders validate every length and
+ * return `false` on truncated or malformed input.
+ */
+class DaemonProtocol {
+public:
+  static constexpr uint32_t MAGIC = 0x31444d50;      ///< "PMD1"
+  static constexpr size_t HEADER_SIZE = 10;          ///< Bytes per header
+  static constexpr uint32_t MAX_PAYLOAD = 64u << 20; ///< Largest payload
+  static constexpr size_t SYSTEM_SAMPLE_SIZE = 40;   ///< Encoded sample
+  static constexpr size_t HISTORY_SAMPLE_SIZE = 24;  ///< Encoded sample
+
+  /**
+   * @brief Appends a frame header.
+   *
+   * @param out The string to append to.
+   * @param type The frame type.
+   * @param length The size of the payload that follows.
+   */
+  static void appendHeader(std::string &out, DaemonMessage type,
+                           uint32_t length);
+
+  /**
+   * @brief Parses a frame header.
+   *
+   * @param data At least `HEADER_SIZE` bytes.
+   * @param[out] type The frame type.
+   * @param[out] length The payload size.
+   * @return `false` if the magic is wrong or the payload is too large.
+   */
+  static bool parseHeader(std::string_view data, DaemonMessage &type,
+                          uint32_t &length);
+
+  /**
+   * @brief Appends a whole request frame.
+   *
+   * @param out The string to append to.
+   * @param type `Snapshot`, `Top`, `History`, `Subscribe` or `Stats`.
+   * @param argument The count or PID; ignored for `Snapshot` and `Stats`.
+   */
+  static void appendRequest(std::string &out, DaemonMessage type,
+                            int64_t argument);
+
+  /**
+   * @brief Reads the count or PID argument of a request payload.
+   *
+   * @param type The request type.
+   * @param payload The request payload.
+   * @param[out] argument The count or PID, 0 for `Snapshot` and `Stats`.
+   * @return `false` if the payload does not match the type.
+   */
+  static bool parseRequest(DaemonMessage type, std::string_view payload,
+                           int64_t &argument);
+
+  /**
+   * @brief Appends an encoded system sample.
+   */
+  static void appendSystemSample(std::string &out,
+                                 const DaemonSystemSample &sample);
+
+  /**
+   * @brief Appends the header, system sample and record count of a
+   * `SnapshotReply`; the encoded records follow.
+   *
+   * @param out The string to append to.
+   * @param sample The system sample.
+   * @param count The number of records that follow.
+   * @param recordBytes The encoded size of those records.
+   */
+  static void appendSnapshotPrefix(std::string &out,
+                                   const DaemonSystemSample &sample,
+                                   uint32_t count, size_t recordBytes);
+
+  /**
+   * @brief Appends the header, PID and sample count of a `HistoryReply`;
+   * the encoded samples follow.
+   */
+  static void appendHistoryPrefix(std::string &out, int32_t pid,
+                                  uint32_t count);
+
+  /**
+   * @brief Appends an encoded process record.
+   */
+  static void appendProcess(std::string &out, const DaemonProcess &process);
+
+  /**
+   * @brief Appends an encoded history sample.
+   */
+  static void appendHistorySample(std::string &out,
+                                  const DaemonHistorySample &sample);
+
+  /**
+   * @brief Appends a whole `StatsReply` frame.
+   */
+  static void appendStats(std::string &out, const SelfStatsSnapshot &stats);
+
+  /**
+   * @brief Appends a whole `Error` frame.
+   *
+   * @param out The string to append to.
+   * @param message The error message.
+   */
+  static void appendError(std::string &out, std::string_view message);
+
+  /**
+   * @brief Decodes the payload of a `SnapshotReply`.
+   */
+  static bool decodeSnapshot(std::string_view payload,
+                             DaemonSnapshot &snapshot);
+
+  /**
+   * @brief Decodes the payload of a `HistoryReply`.
+   */
+  static bool decodeHistory(std::string_view payload, int32_t &pid,
+                            std::vector<DaemonHistorySample> &samples);
+
+  /**
+   * @brief Decodes the payload of a `StatsReply`.
+   */
+  static bool decodeStats(std::string_view payload, SelfStatsSnapshot &stats);
+
+  /**
+   * @brief Decodes the payload of an `Error` frame.
+   */
+  static bool decodeError(std::string_view payload, std::string &message);
+};
+
+#endif // DAEMON_PROTOCOL_H
@@ -11,9 +11,23 @@
 #ifndef DATA_MONITORING_H
 #define DATA_MONITORING_H
 
+#include "proc_parsers.h"
+
 #include <iostream>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
+
+/**
+ * @struct SystemCounters
+ * @brief Raw system-wide CPU and memory counters at one point in time.
+ */
+struct SystemCounters {
+  std::vector<CpuTimes> cpus;            ///< Aggregate first, then per CPU
+  unsigned long long memTotalKb = 0;     ///< MemTotal from /proc/meminfo
+  unsigned long long memAvailableKb = 0; ///< MemAvailable from /proc/meminfo
+};
 
 /**
  * @class DataMonitoring
@@ -97,6 +111,29 @@ public:
    */
   double getCPUUsage();
 
+  /**
+   * @brief Reads the raw CPU and memory counters without blocking.
+   *
+   * Unlike the update loops, this takes a single sample and leaves the
+   * global usage values untouched, so callers can sample on their own
+   * schedule.
+   *
+   * @param[out] counters The counters read.
+   * @param[in,out] buffer A buffer reused between calls.
+   * @return `true` if both files were read and parsed, `false` otherwise.
+   */
+  static bool readSystemCounters(SystemCounters &counters,
+                                 std::string &buffer);
+
+  /**
+   * @brief Computes the busy percentage of a CPU between two samples.
+   *
+   * @param previous The earlier sample.
+   * @param current The later sample.
+   * @return The share of non-idle time, from 0 to 100.
+   */
+  static double cpuUsage(const CpuTimes &previous, const CpuTimes &current);
+
 private:
   bool monitoring_; /**< Flag to indicate whether monitoring is active. */
 };
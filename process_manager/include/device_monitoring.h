@@ -0,0 +1,123 @@
+/**
+ * @file device_monitoring.h
+ * @brief Computes disk and network throughput from procfs counters.
+ *
+ * This file defines the `DeviceMonitoring` class, which samples
+ * `/proc/diskstats` and `/proc/net/dev` and turns the difference between two
+ * samples into rates: IOPS, throughput, utilization and average wait for
+ * disks, and bytes, packets and drops for network interfaces.
+ */
+
+#ifndef DEVICE_MONITORING_H
+#define DEVICE_MONITORING_H
+
+#include "proc_parsers.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * @struct DiskStats
+ * @brief The rates of one disk between the last two samples.
+ */
+struct DiskStats {
+  std::string name;         ///< Device name, e.g. `nvme0n1`
+  double readIops = 0.0;    ///< Reads completed per second
+  double writeIops = 0.0;   ///< Writes completed per second
+  double readRate = 0.0;    ///< Bytes read per second
+  double writeRate = 0.0;   ///< Bytes written per second
+  double utilization = 0.0; ///< Percent of time with IO in flight
+  double awaitMs = 0.0;     ///< Average time per completed IO
+  bool wholeDisk = false;   ///< Not a partition; listed in /sys/block
+  bool active = false;      ///< Has completed any IO since boot
+};
+
+/**
+ * @struct NetStats
+ * @brief The rates of one network interface between the last two samples.
+ */
+struct NetStats {
+  std::string name;       ///< Interface name, e.g. `eth0`
+  double rxRate = 0.0;    ///< Bytes received per second
+  double txRate = 0.0;    ///< Bytes sent per second
+  double rxPackets = 0.0; ///< Packets received per second
+  double txPackets = 0.0; ///< Packets sent per second
+  double drops = 0.0;     ///< Packets dropped per second, both directions
+};
+
+/**
+ * @class DeviceMonitoring
+ * @brief Samples disk and network counters and keeps per-device rates.
+ *
+ * Devices are kept in file order. A sample matches each parsed line to the
+ * device at the same position, so a steady device list is neither searched
+ * nor reallocated; only devices that appear or disappear move entries.
+ * Not thread-safe: sample and read from the same thread.
+ */
+class DeviceMonitoring {
+public:
+  /**
+   * @brief Constructs a `DeviceMonitoring` object with no sample yet.
+   */
+  DeviceMonitoring();
+
+  /**
+   * @brief Reads both files and updates the rates.
+   *
+   * The first sample of a device only primes its counters, so its rates
+   * are zero until the next one.
+   *
+   * @return `true` if at least one of the files was read.
+   */
+  bool sample();
+
+  /**
+   * @brief Returns the disks of the most recent sample.
+   */
+  const std::vector<DiskStats> &getDisks() const { return diskStats_; }
+
+  /**
+   * @brief Returns the network interfaces of the most recent sample.
+   */
+  const std::vector<NetStats> &getInterfaces() const { return netStats_; }
+
+  /**
+   * @brief Returns the busiest whole disks.
+   *
+   * @param count The maximum number of disks to return.
+   * @return Up to `count` disks that completed any IO, by descending
+   * utilization.
+   */
+  std::vector<DiskStats> getTopDisks(size_t count) const;
+
+  /**
+   * @brief Returns the busiest network interfaces.
+   *
+   * @param count The maximum number of interfaces to return.
+   * @return Up to `count` interfaces, by descending bytes per second.
+   */
+  std::vector<NetStats> getTopInterfaces(size_t count) const;
+
+private:
+  /**
+   * @brief Updates the disk rates from a parsed `/proc/diskstats`.
+   */
+  void updateDisks(double elapsedSeconds);
+
+  /**
+   * @brief Updates the interface rates from a parsed `/proc/net/dev`.
+   */
+  void updateInterfaces(double elapsedSeconds);
+
+  std::string buffer_;                     ///< File contents, reused
+  std::vector<DiskCounters> diskLines_;    ///< Parsed lines, reused
+  std::vector<NetCounters> netLines_;      ///< Parsed lines, reused
+  std::vector<DiskCounters> diskCounters_; ///< Previous counters, no names
+  std::vector<NetCounters> netCounters_;   ///< Previous counters, no names
+  std::vector<DiskStats> diskStats_;       ///< Rates per disk
+  std::vector<NetStats> netStats_;         ///< Rates per interface
+  std::chrono::steady_clock::time_point lastSample_; ///< Last sample time
+};
+
+#endif // DEVICE_MONITORING_H
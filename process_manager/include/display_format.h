@@ -0,0 +1,77 @@
+/**
+ * @file display_format.h
+ * @brief Provides helpers shared by the table and panel renderers.
+ *
+ * This file defines the `DisplayFormat` class, which formats byte counts in
+ * human-readable units and selects the color used to highlight usage
+ * percentages, so that every view of the process manager renders values the
+ * same way.
+ */
+
+#ifndef DISPLAY_FORMAT_H
+#define DISPLAY_FORMAT_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @class DisplayFormat
+ * @brief A collection of formatting helpers for terminal output.
+ */
+class DisplayFormat {
+public:
+  /**
+   * @brief Formats a byte count using binary units.
+   *
+   * @param bytes The number of bytes.
+   * @return The formatted value, e.g. `512B` or `12.5M`.
+   */
+  static std::string bytes(unsigned long long bytes);
+
+  /**
+   * @brief Draws values as a line of Unicode block characters.
+   *
+   * The bars are scaled from zero to the largest value. When there are more
+   * values than columns, each column shows the largest value it covers, so
+   * short spikes stay visible.
+   *
+   * @param values The values, oldest first.
+   * @param width The maximum number of columns.
+   * @return The sparkline, e.g. `▁▁▂▇█▃▁`.
+   */
+  static std::string sparkline(const std::vector<double> &values,
+                               size_t width);
+
+  /**
+   * @brief Selects the ANSI color used for a usage percentage.
+   *
+   * High usage is displayed in red, moderate usage in yellow and low usage
+   * in green.
+   *
+   * @param usage The usage percentage.
+   * @return The ANSI escape sequence of the color.
+   */
+  static const char *usageColor(double usage);
+
+  /**
+   * @brief Returns the ANSI escape sequence that resets the text color.
+   *
+   * @return The reset escape sequence.
+   */
+  static const char *resetColor();
+
+  /**
+   * @brief Enables or disables colors for all later output.
+   *
+   * When disabled, `usageColor` and `resetColor` return empty strings, e.g.
+   * when a table is written to a pipe.
+   *
+   * @param enabled Whether ANSI colors are emitted.
+   */
+  static void setColorEnabled(bool enabled);
+
+private:
+  static bool colorEnabled_; ///< Whether ANSI colors are emitted
+};
+
+#endif // DISPLAY_FORMAT_H
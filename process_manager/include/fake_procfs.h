@@ -0,0 +1,164 @@
+/**
+ * @file fake_procfs.h
+ * @brief Writes a synthetic procfs tree for tests and benchmarks.
+ *
+ * This file defines the `FakeProcfs` class, which writes a directory that
+ * looks like `/proc` to the scanners: the system-wide `stat`, `meminfo` and
+ * `uptime` files and, for every process, `stat`, `statm`, `status`, `io`,
+ * `cmdline`, `comm`, `smaps_rollup` and an `fd` directory. Point
+ * `ProcPaths::setProcRoot` at it to scan a system of any size. The contents
+ * only depend on the options, including the seed, so runs are reproducible.
+ */
+
+#ifndef FAKE_PROCFS_H
+#define FAKE_PROCFS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief How busy the synthetic processes are.
+ */
+enum class FakeLoad {
+  Idle,  ///< Almost every process sleeps
+  Mixed, ///< Mostly idle, some busy, a few spinning
+  Busy,  ///< Processes together keep every CPU about 90% busy
+};
+
+/**
+ * @struct FakeProcfsOptions
+ * @brief The shape of a synthetic system.
+ */
+struct FakeProcfsOptions {
+  size_t processes = 1000;                     ///< Processes at any time
+  double churn = 0.0;                          ///< Share replaced per step
+  FakeLoad load = FakeLoad::Mixed;             ///< CPU load profile
+  unsigned cpus = 8;                           ///< CPUs in `stat`
+  unsigned long long memTotalKb = 16ull << 20; ///< MemTotal
+  unsigned fdsPerProcess = 4;                  ///< Entries of each `fd`
+  uint64_t seed = 1;                           ///< Seed of the generator
+};
+
+/**
+ * @class FakeProcfs
+ * @brief Creates a synthetic procfs tree and advances it in time.
+ *
+ * `create` writes the initial tree. Every `advance` moves the clock,
+ * charges CPU time and I/O according to the load profile and replaces
+ * `churn` of the processes with new ones under new PIDs. Files are replaced
+ * atomically, so a concurrent scan sees either the old or the new contents.
+ */
+class FakeProcfs {
+public:
+  /**
+   * @brief Constructs a generator; nothing is written yet.
+   *
+   * @param options The shape of the system.
+   */
+  explicit FakeProcfs(const FakeProcfsOptions &options);
+
+  /**
+   * @brief Writes the initial tree.
+   *
+   * @param root The directory to write; created if needed, and must not
+   * contain an earlier tree.
+   * @param[out] error A description of the problem on failure.
+   * @return `true` if the tree was written, `false` otherwise.
+   */
+  bool create(const std::string &root, std::string &error);
+
+  /**
+   * @brief Moves the synthetic system forward in time.
+   *
+   * @param seconds The time that passes.
+   * @param[out] error A description of the problem on failure.
+   * @return `true` if the tree was updated, `false` otherwise.
+   */
+  bool advance(double seconds, std::string &error);
+
+  /**
+   * @brief Returns the PIDs of the current processes, in ascending order.
+   */
+  std::vector<int> pids() const;
+
+  /**
+   * @brief Returns the CPU usage percentage of the whole system that the
+   * processes caused during the last step.
+   */
+  double lastCpuUsage() const { return lastCpuUsage_; }
+
+  /**
+   * @brief Parses a load profile name: `idle`, `mixed` or `busy`.
+   *
+   * @param text The name.
+   * @param[out] load The profile.
+   * @return `true` if the name is known, `false` otherwise.
+   */
+  static bool parseLoad(const std::string &text, FakeLoad &load);
+
+private:
+  /**
+   * @struct Process
+   * @brief The counters of one synthetic process.
+   */
+  struct Process {
+    int pid = 0;                        ///< Process ID
+    int ppid = 1;                       ///< Parent process ID
+    size_t name = 0;                    ///< Index into the name table
+    double share = 0.0;                 ///< CPUs used, e.g. 0.5
+    long threads = 1;                   ///< Number of threads
+    unsigned long long startTime = 0;   ///< Start, in ticks after boot
+    double ticks = 0.0;                 ///< utime + stime, with fraction
+    unsigned long long minorFaults = 0; ///< Minor fault counter
+    unsigned long long majorFaults = 0; ///< Major fault counter
+    unsigned long long voluntary = 0;   ///< Voluntary context switches
+    unsigned long long involuntary = 0; ///< Involuntary context switches
+    unsigned long long readBytes = 0;   ///< Bytes read from storage
+    unsigned long long writeBytes = 0;  ///< Bytes written to storage
+    unsigned long long sizePages = 0;   ///< Virtual size in pages
+    unsigned long long rssPages = 0;    ///< Resident set size in pages
+  };
+
+  /**
+   * @brief Returns a new process with a fresh PID.
+   */
+  Process spawn();
+
+  /**
+   * @brief Writes every file of a process.
+   *
+   * @param process The process.
+   * @param created Also writes the files that never change.
+   */
+  bool writeProcess(const Process &process, bool created, std::string &error);
+
+  /**
+   * @brief Writes the system-wide files.
+   */
+  bool writeSystem(std::string &error);
+
+  /**
+   * @brief Returns the next pseudo-random number (splitmix64).
+   */
+  uint64_t nextRandom();
+
+  /**
+   * @brief Returns a pseudo-random number in [low, high).
+   */
+  double uniform(double low, double high);
+
+  FakeProcfsOptions options_;                ///< Shape of the system
+  std::string root_;                         ///< Directory of the tree
+  std::vector<Process> processes_;           ///< Current processes
+  uint64_t state_;                           ///< Generator state
+  int nextPid_ = 1;                          ///< PID of the next process
+  double uptime_ = 0.0;                      ///< Seconds since boot
+  std::vector<double> cpuBusy_;              ///< Busy ticks per CPU
+  std::vector<double> cpuIdle_;              ///< Idle ticks per CPU
+  unsigned long long forks_ = 0;             ///< Processes ever started
+  size_t pageSizeKb_ = 4;                    ///< Page size in kB
+  double lastCpuUsage_ = 0.0;                ///< Usage of the last step
+};
+
+#endif // FAKE_PROCFS_H
@@ -0,0 +1,146 @@
+/**
+ * @file http_server.h
+ * @brief Provides a minimal epoll-driven HTTP/1.1 server.
+ *
+ * This file defines the `HttpServer` class, which serves a fixed set of
+ * read-only resources over HTTP/1.1 on a single thread. Each resource is
+ * produced by a callback returning a shared, immutable body, so serving a
+ * request never copies or renders the body.
+ */
+
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @class HttpServer
+ * @brief A single-threaded, non-blocking HTTP/1.1 server for GET requests.
+ *
+ * Connections are multiplexed with `epoll`. Keep-alive and pipelined requests
+ * are supported; request bodies are not. `run` blocks until `stop` is called
+ * from another thread or a signal handler.
+ */
+class HttpServer {
+public:
+  /// Produces the current body of a resource
+  using BodyProvider = std::function<std::shared_ptr<const std::string>()>;
+
+  /**
+   * @brief Constructs a server that is not yet listening.
+   */
+  HttpServer();
+
+  /**
+   * @brief Closes the listening socket and all connections.
+   */
+  ~HttpServer();
+
+  HttpServer(const HttpServer &) = delete;
+  HttpServer &operator=(const HttpServer &) = delete;
+
+  /**
+   * @brief Registers a resource served for `GET` requests.
+   *
+   * @param path The request path, e.g. `/metrics`.
+   * @param contentType The value of the `Content-Type` header.
+   * @param provider The callback producing the body.
+   */
+  void addRoute(const std::string &path, const std::string &contentType,
+                BodyProvider provider);
+
+  /**
+   * @brief Binds and listens on an address.
+   *
+   * @param address `HOST:PORT`, where the host is an IPv4 address or an IPv6
+   * address in brackets, e.g. `127.0.0.1:9100` or `[::1]:9100`.
+   * @param[out] error A description of the problem if listening fails.
+   * @return `true` if the server is listening, `false` otherwise.
+   */
+  bool listen(const std::string &address, std::string &error);
+
+  /**
+   * @brief Serves requests until `stop` is called.
+   *
+   * @param[out] error A description of the problem if serving fails.
+   * @return `true` once stopped, `false` if waiting for events failed.
+   */
+  bool run(std::string &error);
+
+  /**
+   * @brief Makes `run` return. Safe to call from any thread.
+   */
+  void stop();
+
+private:
+  /**
+   * @struct Route
+   * @brief A registered resource.
+   */
+  struct Route {
+    std::string contentType; ///< Value of the Content-Type header
+    BodyProvider provider;   ///< Produces the body
+  };
+
+  /**
+   * @struct Connection
+   * @brief The state of one client connection.
+   */
+  struct Connection {
+    std::string input;                       ///< Bytes not yet parsed
+    std::string header;                      ///< Response header to send
+    std::shared_ptr<const std::string> body; ///< Response body to send
+    size_t sent = 0;                         ///< Bytes of the response sent
+    bool closeAfterResponse = false;         ///< Close once sent
+    bool writing = false;                    ///< Waiting for EPOLLOUT
+    bool readClosed = false;                 ///< The client sent EOF
+  };
+
+  /**
+   * @brief Accepts all pending connections.
+   */
+  void acceptConnections();
+
+  /**
+   * @brief Reads from a connection and answers complete requests.
+   *
+   * @param fd The connection's socket.
+   * @return `false` if the connection must be closed.
+   */
+  bool handleReadable(int fd);
+
+  /**
+   * @brief Sends as much of the pending response as the socket accepts.
+   *
+   * @param fd The connection's socket.
+   * @return `false` if the connection must be closed.
+   */
+  bool handleWritable(int fd);
+
+  /**
+   * @brief Parses the next buffered request and prepares its response.
+   *
+   * @param connection The connection holding the request.
+   * @return `true` if a response was prepared, `false` if the request is
+   * incomplete.
+   */
+  bool prepareResponse(Connection &connection);
+
+  /**
+   * @brief Closes a connection and forgets its state.
+   *
+   * @param fd The connection's socket.
+   */
+  void closeConnection(int fd);
+
+  int listenFd_;                                    ///< Listening socket
+  int epollFd_;                                     ///< epoll instance
+  int wakeupFd_;                                    ///< eventfd for `stop`
+  std::unordered_map<std::string, Route> routes_;   ///< Resources by path
+  std::unordered_map<int, Connection> connections_; ///< Clients by socket
+};
+
+#endif // HTTP_SERVER_H
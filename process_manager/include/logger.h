@@ -29,10 +29,11 @@
 class Logger {
 public:
   /**
-   * @brief Constructs a `Logger` object and initializes the logger.
+   * @brief Constructs a `Logger` object.
    *
-   * This constructor ensures the logger is initialized immediately upon object
-   * creation.
+   * The shared log file is opened, and its directory created, by the first
+   * message that is logged, so commands that never log leave no trace on
+   * disk.
    */
   Logger();
 
@@ -79,7 +80,7 @@ public:
    *
    * This private method ensures that the necessary directories are created and
    * the logger is properly initialized. It configures the log pattern and log
-   * file location.
+   * file location. It does nothing once the logger is initialized.
    */
   void initializeLogger();
 
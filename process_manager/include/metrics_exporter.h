@@ -0,0 +1,139 @@
+/**
+ * @file metrics_exporter.h
+ * @brief Renders system and process metrics in the Prometheus text format.
+ *
+ * This file defines the `MetricsExporter` class, which samples the system
+ * counters and, optionally, the busiest processes on a fixed interval and
+ * keeps the rendered exposition text as an immutable snapshot. Scrapes are
+ * served from that snapshot, so their cost does not depend on how often or
+ * how many collectors scrape.
+ */
+
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include "data_monitoring.h"
+#include "numa_topology.h"
+#include "output_buffer.h"
+#include "process_listing.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/**
+ * @class MetricsExporter
+ * @brief Periodically renders a metrics snapshot on a background thread.
+ *
+ * Exposed metrics use the `process_manager_` prefix:
+ * - per-CPU time counters by mode, plus the aggregate and per-CPU usage
+ * - total and available memory and the memory usage
+ * - total, used, free, page cache and anonymous memory per NUMA node
+ * - CPU, memory, RSS and thread count of the top-N processes by CPU, when
+ *   `topN` is not zero
+ * - the time and duration of the last collection
+ */
+class MetricsExporter {
+public:
+  /**
+   * @brief Constructs an exporter; call `start` to begin sampling.
+   *
+   * @param interval The time between two collections.
+   * @param topN The number of processes exported, ranked by CPU usage.
+   */
+  MetricsExporter(std::chrono::milliseconds interval, size_t topN);
+
+  /**
+   * @brief Stops the collection thread.
+   */
+  ~MetricsExporter();
+
+  MetricsExporter(const MetricsExporter &) = delete;
+  MetricsExporter &operator=(const MetricsExporter &) = delete;
+
+  /**
+   * @brief Takes a first snapshot and starts the collection thread.
+   */
+  void start();
+
+  /**
+   * @brief Stops the collection thread and waits for it to finish.
+   */
+  void stop();
+
+  /**
+   * @brief Returns the most recent snapshot.
+   *
+   * @return The rendered exposition text. It stays valid after newer
+   * snapshots are published.
+   */
+  std::shared_ptr<const std::string> snapshot() const;
+
+private:
+  /**
+   * @brief Samples every metric and publishes a new snapshot.
+   */
+  void collect();
+
+  /**
+   * @brief Appends the system-wide CPU and memory metrics.
+   *
+   * @param current The counters sampled by this collection.
+   */
+  void renderSystem(const SystemCounters &current);
+
+  /**
+   * @brief Appends the memory of every NUMA node.
+   */
+  void renderNodes();
+
+  /**
+   * @brief Appends the metrics of the top-N processes.
+   */
+  void renderProcesses();
+
+  /**
+   * @brief Appends the exporter's own cost, as measured by `SelfStats`.
+   */
+  void renderSelf();
+
+  /**
+   * @brief Appends the `# HELP` and `# TYPE` lines of a metric family.
+   */
+  void appendFamily(std::string_view name, std::string_view help,
+                    std::string_view type);
+
+  /**
+   * @brief Appends a label value, escaping backslashes, quotes and newlines.
+   */
+  void appendLabelValue(std::string_view value);
+
+  /**
+   * @brief The collection thread: collects until `stop` is called.
+   */
+  void run();
+
+  std::chrono::milliseconds interval_; ///< Time between collections
+  size_t topN_;                        ///< Processes exported
+  ProcessListing listing_;             ///< Reused across collections
+  SystemCounters previous_;            ///< Counters of the last collection
+  bool hasPrevious_ = false;           ///< `previous_` holds a sample
+  std::string readBuffer_;             ///< Reused for procfs reads
+  SystemTopology topology_;            ///< Nodes, discovered once
+  bool hasTopology_ = false;           ///< `topology_` was discovered
+  OutputBuffer out_;                   ///< Reused while rendering
+
+  mutable std::mutex snapshotMutex_;            ///< Guards `snapshot_`
+  std::shared_ptr<const std::string> snapshot_; ///< Last rendered text
+
+  std::mutex stopMutex_;                  ///< Guards `stopping_`
+  std::condition_variable stopCondition_; ///< Wakes the collection thread
+  bool stopping_ = false;                 ///< Set by `stop`
+  std::thread thread_;                    ///< Collection thread
+};
+
+#endif // METRICS_EXPORTER_H
@@ -0,0 +1,97 @@
+/**
+ * @file numa_topology.h
+ * @brief Discovers the NUMA nodes and CPUs of the system from sysfs.
+ *
+ * This file defines the `SystemTopology` structure and the `NumaTopology`
+ * class, which reads `/sys/devices/system/node` and
+ * `/sys/devices/system/cpu` to find which CPUs belong to which node and
+ * socket, how far the nodes are from each other and how much memory each
+ * node has left. Kernels without NUMA support are described as a single
+ * node holding every CPU and all of `/proc/meminfo`.
+ */
+
+#ifndef NUMA_TOPOLOGY_H
+#define NUMA_TOPOLOGY_H
+
+#include "proc_parsers.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @struct NumaNode
+ * @brief One NUMA node: its CPUs, distances and memory.
+ */
+struct NumaNode {
+  int id = 0;                 ///< Node number
+  std::vector<int> cpus;      ///< Online CPUs of the node, ascending
+  std::vector<int> distances; ///< Distance to each node, by position
+  NodeMemory memory;          ///< Memory counters of the last read
+};
+
+/**
+ * @struct CpuPlacement
+ * @brief Where one online CPU sits in the machine.
+ */
+struct CpuPlacement {
+  int cpu = 0;      ///< CPU number
+  int node = 0;     ///< NUMA node
+  int package = -1; ///< Physical socket, -1 if unknown
+  int core = -1;    ///< Core within the socket, -1 if unknown
+};
+
+/**
+ * @struct SystemTopology
+ * @brief The NUMA nodes and online CPUs of the system.
+ */
+struct SystemTopology {
+  std::vector<NumaNode> nodes;    ///< Online nodes, by id
+  std::vector<CpuPlacement> cpus; ///< Online CPUs, by number
+  bool numa = false;              ///< False for the single-node fallback
+
+  /**
+   * @brief Returns a node by id, or `nullptr` if there is none.
+   */
+  const NumaNode *node(int id) const;
+
+  /**
+   * @brief Returns the node of a CPU, or -1 if the CPU is not online.
+   */
+  int nodeOfCpu(int cpu) const;
+};
+
+/**
+ * @class NumaTopology
+ * @brief Reads the machine topology and the per-node memory from sysfs.
+ *
+ * The topology does not change while the system runs (CPU hotplug aside),
+ * so callers discover it once and only refresh the memory counters.
+ */
+class NumaTopology {
+public:
+  /**
+   * @brief Reads the nodes, their CPUs and distances and the CPU sockets.
+   *
+   * @param[out] topology The discovered topology, memory included.
+   * @param[out] error A description of the problem on failure.
+   * @return `true` if the online CPUs could be determined, `false`
+   * otherwise.
+   */
+  static bool discover(SystemTopology &topology, std::string &error);
+
+  /**
+   * @brief Rereads the memory counters of every node.
+   *
+   * @param[in,out] topology A topology from `discover`.
+   * @param[in,out] buffer A buffer reused between calls.
+   * @return `true` if every node was read, `false` otherwise.
+   */
+  static bool readMemory(SystemTopology &topology, std::string &buffer);
+
+  /**
+   * @brief Formats numbers as a sysfs list, e.g. `0-3,8`.
+   */
+  static std::string formatList(const std::vector<int> &values);
+};
+
+#endif // NUMA_TOPOLOGY_H
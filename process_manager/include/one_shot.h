@@ -0,0 +1,184 @@
+/**
+ * @file one_shot.h
+ * @brief Runs a single command from the command line and exits.
+ *
+ * This file defines the `OneShot` class, which handles invocations such as
+ * `process_manager list --format json --top 10` for scripts, cron jobs and
+ * collectors. Nothing is printed besides the requested output: there is no
+ * banner, no prompt and no log file unless something has to be logged.
+ */
+
+#ifndef ONE_SHOT_H
+#define ONE_SHOT_H
+
+#include "process_listing.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @class OneShot
+ * @brief Executes one non-interactive command.
+ *
+ * Supported commands:
+ * - `list [--format table|json|csv] [--top N] [--columns <list>]
+ *   [--smaps-top N]`
+ * - `monitor [--samples N] [--interval S] [--format json|csv]`
+ * - `serve --listen HOST:PORT [--interval S] [--top N]`
+ * - `daemon [--socket PATH] [--interval S] [--history N] [--shm [NAME]]
+ *   [--shm-capacity N]`
+ * - `query [--socket PATH] [--format table|json] snapshot|top N|history PID|
+ *   subscribe [N]`
+ * - `rules FILE`
+ * - `stats [--socket PATH] [--format table|json] [--scans N [--interval S]]`
+ * - `fake-proc DIR [--processes N] [--churn F] [--load idle|mixed|busy]
+ *   [--cpus N] [--seed N] [--interval S]`
+ * - `numa [--format table|json] [--processes N]`
+ * - `events [--interval S] [--scans N] [--format table|json]`
+ *
+ * `--proc-root DIR` and `--sys-root DIR` before the command read procfs and
+ * sysfs from another directory, e.g. one written by `fake-proc`.
+ * `--scan-cpus LIST` and `--scan-nodes LIST` pin the scan workers to those
+ * CPUs, or to the CPUs of those NUMA nodes. `--scan-backend io_uring` reads
+ * the per-process files in batches through io_uring.
+ */
+class OneShot {
+public:
+  /**
+   * @brief Runs the command given on the command line.
+   *
+   * @param args The command-line arguments without the program name.
+   * @return The process exit status: 0 on success, 1 if the command failed
+   * and 2 if the arguments were invalid.
+   */
+  static int run(const std::vector<std::string> &args);
+
+private:
+  /**
+   * @brief Runs the `list` command.
+   *
+   * With `--interval S`, the processes are scanned twice, S seconds apart,
+   * so that CPU usage and fault rates cover the interval instead of the
+   * lifetime of each process.
+   *
+   * @param args The arguments following the command name.
+   * @param options The options the arguments start from.
+   * @return The process exit status.
+   */
+  static int runList(const std::vector<std::string> &args,
+                     ListOptions options = ListOptions());
+
+  /**
+   * @brief Runs the `threads` command, which lists the threads of a process.
+   *
+   * Accepts the options of `list` after the PID.
+   *
+   * @param args The arguments following the command name.
+   * @return The process exit status.
+   */
+  static int runThreads(const std::vector<std::string> &args);
+
+  /**
+   * @brief Runs the `events` command, which streams process events.
+   *
+   * Scans the processes every `--interval` seconds and prints those that
+   * started, exited or called exec since the previous scan, until SIGINT or
+   * SIGTERM or `--scans` scans. JSON output is one object per scan and line,
+   * with the churn rate.
+   *
+   * @param args The arguments following the command name.
+   * @return The process exit status.
+   */
+  static int runEvents(const std::vector<std::string> &args);
+
+  /**
+   * @brief Runs the `monitor` command.
+   *
+   * Each sample is written as soon as it is taken: one JSON object per line,
+   * or one CSV row after a header.
+   *
+   * @param args The arguments following the command name.
+   * @return The process exit status.
+   */
+  static int runMonitor(const std::vector<std::string> &args);
+
+  /**
+   * @brief Runs the `serve` command.
+   *
+   * Serves Prometheus metrics over HTTP until SIGINT or SIGTERM. Metrics are
+   * collected every `--interval` seconds, not on each scrape.
+   *
+   * @param args The arguments following the command name.
+   * @return The process exit status.
+   */
+  static int runServe(const std::vector<std::string> &args);
+
+  /**
+   * @brief Runs the `daemon` command.
+   *
+   * Samples continuously and answers queries on a Unix socket until SIGINT
+   * or SIGTERM.
+   *
+   * @param args The arguments following the command name.
+   * @return The process exit status.
+   */
+  static int runDaemon(const std::vector<std::string> &args);
+
+  /**
+   * @brief Runs the `query` command against a running daemon.
+   *
+   * @param args The arguments following the command name.
+   * @return The process exit status.
+   */
+  static int runQuery(const std::vector<std::string> &args);
+
+  /**
+   * @brief Runs the `rules` command, which checks a rules file.
+   *
+   * Prints every rule in its compiled form, or the first error.
+   *
+   * @param args The arguments following the command name.
+   * @return The process exit status.
+   */
+  static int runRules(const std::vector<std::string> &args);
+
+  /**
+   * @brief Runs the `stats` command, which reports the tool's own cost.
+   *
+   * Asks the daemon for its `SelfStats`, or with `--scans` measures this
+   * process scanning every source that many times.
+   *
+   * @param args The arguments following the command name.
+   * @return The process exit status.
+   */
+  static int runStats(const std::vector<std::string> &args);
+
+  /**
+   * @brief Runs the `fake-proc` command, which writes a synthetic `/proc`.
+   *
+   * With `--interval`, the tree keeps advancing until SIGINT or SIGTERM.
+   *
+   * @param args The arguments following the command name.
+   * @return The process exit status.
+   */
+  static int runFakeProc(const std::vector<std::string> &args);
+
+  /**
+   * @brief Runs the `numa` command, which shows the NUMA topology.
+   *
+   * Prints the CPUs, memory and distances of every node; with
+   * `--processes N`, also how the memory of the N largest processes is
+   * spread across the nodes.
+   *
+   * @param args The arguments following the command name.
+   * @return The process exit status.
+   */
+  static int runNuma(const std::vector<std::string> &args);
+
+  /**
+   * @brief Prints the usage message to standard error.
+   */
+  static void printUsage();
+};
+
+#endif // ONE_SHOT_H
@@ -0,0 +1,105 @@
+/**
+ * @file output_buffer.h
+ * @brief Provides a growable buffer for machine-readable output.
+ *
+ * This file defines the `OutputBuffer` class, which serializes numbers and
+ * escaped strings directly into one contiguous buffer. Whole documents are
+ * built in memory and written with a single system call, instead of going
+ * through formatted stream insertion for every field.
+ */
+
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <string>
+#include <string_view>
+
+/**
+ * @class OutputBuffer
+ * @brief An append-only text buffer with JSON and CSV helpers.
+ *
+ * The buffer keeps its capacity when cleared, so a caller that emits records
+ * repeatedly allocates only until the largest record fits.
+ */
+class OutputBuffer {
+public:
+  /**
+   * @brief Appends raw text.
+   *
+   * @param text The text to append.
+   */
+  void append(std::string_view text) { buffer_.append(text); }
+
+  /**
+   * @brief Appends a single character.
+   *
+   * @param c The character to append.
+   */
+  void append(char c) { buffer_.push_back(c); }
+
+  /**
+   * @brief Appends an unsigned integer in decimal.
+   *
+   * @param value The value to append.
+   */
+  void appendNumber(unsigned long long value);
+
+  /**
+   * @brief Appends a signed integer in decimal.
+   *
+   * @param value The value to append.
+   */
+  void appendNumber(long long value);
+
+  /**
+   * @brief Appends a floating-point number in fixed notation.
+   *
+   * Non-finite values are written as `0` so the output stays valid JSON.
+   *
+   * @param value The value to append.
+   * @param precision The number of digits after the decimal point.
+   */
+  void appendNumber(double value, int precision);
+
+  /**
+   * @brief Appends a quoted JSON string, escaping special characters.
+   *
+   * @param text The unescaped string.
+   */
+  void appendJsonString(std::string_view text);
+
+  /**
+   * @brief Appends a CSV field, quoting it when needed.
+   *
+   * Fields containing commas, quotes or line breaks are enclosed in double
+   * quotes, with embedded quotes doubled (RFC 4180).
+   *
+   * @param text The unescaped field.
+   */
+  void appendCsvField(std::string_view text);
+
+  /**
+   * @brief Writes the whole buffer to a file descriptor and clears it.
+   *
+   * @param fd The file descriptor to write to.
+   * @return `true` if every byte was written, `false` otherwise.
+   */
+  bool flush(int fd);
+
+  /**
+   * @brief Discards the contents, keeping the capacity.
+   */
+  void clear() { buffer_.clear(); }
+
+  /**
+   * @brief Returns the buffered text.
+   *
+   * @return A view of the contents.
+   */
+  std::string_view view() const { return buffer_; }
+
+private:
+  std::string buffer_; ///< Serialized output
+};
+
+#endif // OUTPUT_BUFFER_H
@@ -0,0 +1,123 @@
+/**
+ * @file overhead_governor.h
+ * @brief Keeps the CPU time of the process manager within a budget.
+ *
+ * This file defines the `OverheadGovernor` class. A refreshing view reports
+ * every refresh to the governor, which measures the CPU time the view used
+ * since the previous one and compares it with a budget given as a percentage
+ * of one core. While the budget is exceeded, the governor steps
+ * through degradation levels: longer intervals first, then fewer processes
+ * with PSS/USS and NUMA detail, then no optional columns. It steps back once
+ * the usage leaves enough room for the lighter level.
+ */
+
+#ifndef OVERHEAD_GOVERNOR_H
+#define OVERHEAD_GOVERNOR_H
+
+#include "logger.h"
+#include "process_listing.h"
+
+#include <chrono>
+#include <string>
+#include <sys/resource.h>
+
+/**
+ * @class OverheadGovernor
+ * @brief Measures the cost of each refresh and degrades to stay in budget.
+ *
+ * The measurement uses `getrusage(RUSAGE_THREAD)` of the refreshing thread,
+ * plus the CPU time of the scan workers reported by the caller. Background
+ * tasks of the process do not count, since degrading cannot reduce them.
+ * Not thread-safe: update and read from the refreshing thread.
+ */
+class OverheadGovernor {
+public:
+  /**
+   * @brief Constructs a governor.
+   *
+   * @param budgetPercent The CPU budget, in percent of one core.
+   */
+  explicit OverheadGovernor(double budgetPercent);
+
+  /**
+   * @brief Measures the CPU time used since the previous call.
+   *
+   * Call once per refresh, after it, from the refreshing thread. The first
+   * call only starts the measurement.
+   *
+   * @param workerCpuMs CPU time other threads spent on the refresh, e.g.
+   * `ScanReport::workerTimeMs`.
+   * @return `true` if the degradation level changed.
+   */
+  bool update(double workerCpuMs);
+
+  /**
+   * @brief Accounts for one refresh cycle with known costs.
+   *
+   * `update` calls this with its measurement; tests call it directly.
+   *
+   * @param cpuMs CPU time used during the cycle.
+   * @param wallMs Length of the cycle.
+   * @return `true` if the degradation level changed.
+   */
+  bool record(double cpuMs, double wallMs);
+
+  /**
+   * @brief Returns the interval to use instead of the requested one.
+   */
+  std::chrono::milliseconds
+  interval(std::chrono::milliseconds requested) const;
+
+  /**
+   * @brief Returns the options to scan with instead of the requested ones.
+   *
+   * @param requested The options asked for.
+   * @param keep A column that must stay, e.g. the sort column.
+   * @return The options with fewer detailed processes or columns, depending
+   * on the level.
+   */
+  ListOptions apply(const ListOptions &requested, ProcessColumn keep) const;
+
+  /**
+   * @brief Returns the CPU usage of the last cycle, in percent of one core.
+   */
+  double usagePercent() const { return usagePercent_; }
+
+  /**
+   * @brief Returns the budget, in percent of one core.
+   */
+  double budgetPercent() const { return budgetPercent_; }
+
+  /**
+   * @brief Returns whether any degradation is in effect.
+   */
+  bool isDegraded() const { return level_ > 0; }
+
+  /**
+   * @brief Describes the degradation in effect, e.g. `interval x4, top 6`.
+   *
+   * @return The description, empty at full detail.
+   */
+  std::string describe() const;
+
+  /**
+   * @brief Checks whether a column reads a source that may be dropped.
+   *
+   * Only the columns computed from `stat`, `statm` and the owner of the
+   * process directory are kept at the last levels.
+   */
+  static bool isOptional(ProcessColumn column);
+
+private:
+  double budgetPercent_;                         ///< Allowed usage
+  double usagePercent_;                          ///< Usage of the last cycle
+  size_t level_;                                 ///< Index of the level
+  size_t overCycles_;                            ///< Cycles over budget
+  size_t underCycles_;                           ///< Cycles with room
+  bool started_;                                 ///< Measurement started
+  rusage lastUsage_;                             ///< Thread's, last update
+  std::chrono::steady_clock::time_point lastAt_; ///< Time of the last update
+  Logger logger_;                                ///< Logs level changes
+};
+
+#endif // OVERHEAD_GOVERNOR_H
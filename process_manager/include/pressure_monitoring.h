@@ -0,0 +1,142 @@
+/**
+ * @file pressure_monitoring.h
+ * @brief Reads Pressure Stall Information and waits for kernel stall events.
+ *
+ * This file defines the `PressureMonitoring` class. CPU and memory usage do
+ * not say whether tasks are waiting; PSI does: it reports the share of time
+ * tasks were stalled on CPU, memory or IO, system-wide in `/proc/pressure`
+ * and per cgroup in the `<resource>.pressure` files. A PSI trigger asks the
+ * kernel to signal `POLLPRI` on the file as soon as the stall time within a
+ * window crosses a threshold, so stalls are seen within milliseconds without
+ * polling the averages.
+ */
+
+#ifndef PRESSURE_MONITORING_H
+#define PRESSURE_MONITORING_H
+
+#include "logger.h"
+#include "proc_parsers.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief The resources PSI reports on.
+ */
+enum class PressureResource : uint8_t {
+  Cpu,    ///< Runnable tasks waiting for a CPU
+  Memory, ///< Tasks waiting on reclaim, refaults or swap-in
+  Io,     ///< Tasks waiting on block IO
+};
+
+/**
+ * @class PressureMonitoring
+ * @brief Reads PSI files and registers triggers on the system-wide ones.
+ *
+ * `waitForStalls` blocks one thread on the triggers until `stop` is called;
+ * the readers and `getStalls` may be called from any other thread.
+ */
+class PressureMonitoring {
+public:
+  /// Number of `PressureResource` values
+  static constexpr size_t RESOURCE_COUNT = 3;
+
+  /**
+   * @brief Constructs a `PressureMonitoring` object.
+   *
+   * Creates the eventfd used by `stop`; triggers are only registered by
+   * `waitForStalls`.
+   */
+  PressureMonitoring();
+
+  /**
+   * @brief Destroys the `PressureMonitoring` object.
+   */
+  ~PressureMonitoring();
+
+  PressureMonitoring(const PressureMonitoring &) = delete;
+  PressureMonitoring &operator=(const PressureMonitoring &) = delete;
+
+  /**
+   * @brief Checks whether the kernel reports PSI.
+   *
+   * @return `true` if `/proc/pressure/cpu` is readable, `false` if the kernel
+   * lacks PSI or it was disabled with `psi=0`.
+   */
+  static bool isAvailable();
+
+  /**
+   * @brief Reads the system-wide pressure of a resource.
+   *
+   * @param[in] resource The resource.
+   * @param[out] pressure The parsed file.
+   * @return `true` if the file was read and parsed.
+   */
+  static bool readSystem(PressureResource resource, ProcPressure &pressure);
+
+  /**
+   * @brief Reads the pressure of a resource in one cgroup v2 group.
+   *
+   * @param[in] directory The directory of the group.
+   * @param[in] resource The resource.
+   * @param[out] pressure The parsed file.
+   * @return `true` if the file was read and parsed.
+   */
+  static bool readCgroup(const std::string &directory,
+                         PressureResource resource, ProcPressure &pressure);
+
+  /**
+   * @brief Returns the display name of a resource, e.g. `Memory`.
+   */
+  static const char *resourceName(PressureResource resource);
+
+  /**
+   * @brief Registers the triggers and waits for stall events until `stop`.
+   *
+   * Each system-wide file gets a `some` trigger. Every event is counted and
+   * logged as a warning; the kernel signals at most once per window. The
+   * triggers are removed before returning, since the kernel samples faster
+   * while a trigger is registered.
+   *
+   * @return `false` if no trigger could be registered; the triggers need
+   * root, or a kernel from 6.4 on for unprivileged users.
+   */
+  bool waitForStalls();
+
+  /**
+   * @brief Makes `waitForStalls` return.
+   *
+   * A stop requested before `waitForStalls` is called makes it return at
+   * once.
+   */
+  void stop();
+
+  /**
+   * @brief Checks whether `waitForStalls` is waiting on a trigger.
+   */
+  bool isArmed() const { return armed_; }
+
+  /**
+   * @brief Returns the stall events seen so far.
+   *
+   * @param[out] last The resource of the most recent event.
+   * @param[out] lastAt When the most recent event was seen.
+   * @return The number of events, 0 if there was none yet.
+   */
+  uint64_t getStalls(PressureResource &last,
+                     std::chrono::steady_clock::time_point &lastAt) const;
+
+private:
+  int wakeupFd_;                                    ///< eventfd for `stop`
+  Logger logger_;                                   ///< Logs stall events
+  std::atomic<bool> armed_;                         ///< Triggers registered
+  mutable std::mutex mutex_;                        ///< Guards the stalls
+  uint64_t stalls_;                                 ///< Events seen
+  PressureResource lastResource_;                   ///< Of the last event
+  std::chrono::steady_clock::time_point lastStall_; ///< Time of the last one
+};
+
+#endif // PRESSURE_MONITORING_H
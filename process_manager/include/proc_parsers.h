@@ -0,0 +1,355 @@
+/**
+ * @file proc_parsers.h
+ * @brief Provides parsers for the procfs files used by the process listing.
+ *
+ * This file defines plain structures holding the fields extracted from
+ * `/proc/<pid>/stat`, `/proc/<pid>/status` and `/proc/<pid>/io`, together with
+ * the `ProcParsers` class that fills them from a buffer. Parsing is kept
+ * separate from reading so that each parser can be exercised on its own.
+ */
+
+#ifndef PROC_PARSERS_H
+#define PROC_PARSERS_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @struct ProcStat
+ * @brief Holds the fields of `/proc/<pid>/stat` used by the listing.
+ */
+struct ProcStat {
+  std::string_view comm;              ///< Name (field 2), points into buffer
+  int ppid = 0;                       ///< Parent process ID (field 4)
+  unsigned long long minorFaults = 0; ///< Minor faults (field 10)
+  unsigned long long majorFaults = 0; ///< Major faults (field 12)
+  unsigned long long utime = 0;       ///< User time in ticks (field 14)
+  unsigned long long stime = 0;       ///< System time in ticks (field 15)
+  unsigned long long cutime = 0;      ///< Children user time (field 16)
+  unsigned long long cstime = 0;      ///< Children system time (field 17)
+  long numThreads = 0;                ///< Number of threads (field 20)
+  unsigned long long startTime = 0;   ///< Start time in ticks (field 22)
+};
+
+/**
+ * @struct ProcStatus
+ * @brief Holds the fields of `/proc/<pid>/status` used by the listing.
+ */
+struct ProcStatus {
+  unsigned long long voluntaryCtxSwitches = 0;   ///< Voluntary switches
+  unsigned long long involuntaryCtxSwitches = 0; ///< Involuntary switches
+};
+
+/**
+ * @struct ProcIo
+ * @brief Holds the fields of `/proc/<pid>/io` used by the listing.
+ */
+struct ProcIo {
+  unsigned long long readBytes = 0;  ///< Bytes fetched from storage
+  unsigned long long writeBytes = 0; ///< Bytes sent to storage
+};
+
+/**
+ * @struct ProcSmaps
+ * @brief Holds the fields of `/proc/<pid>/smaps_rollup` used by the listing.
+ */
+struct ProcSmaps {
+  unsigned long long pssKb = 0; ///< Proportional set size in kB
+  unsigned long long ussKb = 0; ///< Private clean plus private dirty in kB
+};
+
+/**
+ * @struct CpuTimes
+ * @brief Holds the time counters of one `cpu` line of `/proc/stat`.
+ */
+struct CpuTimes {
+  /// Number of modes: user, nice, system, idle, iowait, irq, softirq, steal
+  static constexpr int MODE_COUNT = 8;
+
+  int cpu = -1;                              ///< CPU number, -1 for all CPUs
+  unsigned long long ticks[MODE_COUNT] = {}; ///< Time per mode, in ticks
+};
+
+/**
+ * @struct NodeMemory
+ * @brief Holds the fields of a sysfs `node<N>/meminfo` file.
+ */
+struct NodeMemory {
+  unsigned long long totalKb = 0; ///< MemTotal of the node
+  unsigned long long freeKb = 0;  ///< MemFree of the node
+  unsigned long long usedKb = 0;  ///< MemUsed of the node
+  unsigned long long fileKb = 0;  ///< FilePages: page cache on the node
+  unsigned long long anonKb = 0;  ///< AnonPages: anonymous memory
+};
+
+/**
+ * @struct PressureLine
+ * @brief Holds one line of a Pressure Stall Information file.
+ */
+struct PressureLine {
+  double avg10 = 0.0;               ///< Percent of time stalled, last 10 s
+  double avg60 = 0.0;               ///< Percent of time stalled, last 60 s
+  double avg300 = 0.0;              ///< Percent of time stalled, last 300 s
+  unsigned long long totalUsec = 0; ///< Total stall time in microseconds
+};
+
+/**
+ * @struct ProcPressure
+ * @brief Holds a `/proc/pressure/<resource>` or cgroup `<resource>.pressure`
+ * file.
+ *
+ * `some` counts the time at least one task was stalled on the resource,
+ * `full` the time all non-idle tasks were stalled at once.
+ */
+struct ProcPressure {
+  PressureLine some;    ///< The `some` line
+  PressureLine full;    ///< The `full` line, if present
+  bool hasFull = false; ///< Older kernels have no `full` line for CPU
+};
+
+/**
+ * @struct DiskCounters
+ * @brief Holds the counters of one `/proc/diskstats` line.
+ */
+struct DiskCounters {
+  std::string_view name;               ///< Device name, points into the file
+  unsigned long long reads = 0;        ///< Reads completed
+  unsigned long long readSectors = 0;  ///< 512-byte sectors read
+  unsigned long long readMs = 0;       ///< Time spent reading
+  unsigned long long writes = 0;       ///< Writes completed
+  unsigned long long writeSectors = 0; ///< 512-byte sectors written
+  unsigned long long writeMs = 0;      ///< Time spent writing
+  unsigned long long busyMs = 0;       ///< Time with at least one IO queued
+};
+
+/**
+ * @struct NetCounters
+ * @brief Holds the counters of one interface in `/proc/net/dev`.
+ */
+struct NetCounters {
+  std::string_view name;            ///< Interface name, points into the file
+  unsigned long long rxBytes = 0;   ///< Bytes received
+  unsigned long long rxPackets = 0; ///< Packets received
+  unsigned long long rxDrops = 0;   ///< Received packets dropped
+  unsigned long long txBytes = 0;   ///< Bytes sent
+  unsigned long long txPackets = 0; ///< Packets sent
+  unsigned long long txDrops = 0;   ///< Packets dropped before sending
+};
+
+/**
+ * @class ProcParsers
+ * @brief A collection of parsers for procfs file contents.
+ *
+ * Every parser takes the raw contents of a file, as returned by
+ * `ProcReader::readFile`, and extracts only the fields it needs without
+ * allocating.
+ */
+class ProcParsers {
+public:
+  /**
+   * @brief Parses `/proc/<pid>/stat`.
+   *
+   * The process name may contain spaces and parentheses, so fields are
+   * located relative to the last closing parenthesis. `stat.comm` points
+   * into `contents` and is only valid while the buffer is unchanged.
+   *
+   * @param[in] contents The file contents.
+   * @param[out] stat The parsed fields.
+   * @return `true` if all fields were found, `false` otherwise.
+   */
+  static bool parseStat(std::string_view contents, ProcStat &stat);
+
+  /**
+   * @brief Parses the resident page count from `/proc/<pid>/statm`.
+   *
+   * @param[in] contents The file contents.
+   * @param[out] residentPages The resident set size in pages.
+   * @return `true` if the value was found, `false` otherwise.
+   */
+  static bool parseStatm(std::string_view contents,
+                         unsigned long long &residentPages);
+
+  /**
+   * @brief Parses the context switch counters from `/proc/<pid>/status`.
+   *
+   * @param[in] contents The file contents.
+   * @param[out] status The parsed fields.
+   * @return `true` if both counters were found, `false` otherwise.
+   */
+  static bool parseStatus(std::string_view contents, ProcStatus &status);
+
+  /**
+   * @brief Parses the storage byte counters from `/proc/<pid>/io`.
+   *
+   * @param[in] contents The file contents.
+   * @param[out] io The parsed fields.
+   * @return `true` if both counters were found, `false` otherwise.
+   */
+  static bool parseIo(std::string_view contents, ProcIo &io);
+
+  /**
+   * @brief Parses the PSS and USS from `/proc/<pid>/smaps_rollup`.
+   *
+   * @param[in] contents The file contents.
+   * @param[out] smaps The parsed fields.
+   * @return `true` if all fields were found, `false` otherwise.
+   */
+  static bool parseSmapsRollup(std::string_view contents, ProcSmaps &smaps);
+
+  /**
+   * @brief Parses the total CPU time from the first line of `/proc/stat`.
+   *
+   * @param[in] contents The file contents.
+   * @param[out] totalTime The sum of all CPU time fields, in ticks.
+   * @return `true` if the line was parsed, `false` otherwise.
+   */
+  static bool parseCpuTotal(std::string_view contents,
+                            unsigned long long &totalTime);
+
+  /**
+   * @brief Parses the total and idle CPU times from `/proc/stat`.
+   *
+   * @param[in] contents The file contents.
+   * @param[out] totalTime The sum of all CPU time fields, in ticks.
+   * @param[out] idleTime The idle and iowait time, in ticks.
+   * @return `true` if the line was parsed, `false` otherwise.
+   */
+  static bool parseCpuTimes(std::string_view contents,
+                            unsigned long long &totalTime,
+                            unsigned long long &idleTime);
+
+  /**
+   * @brief Parses the aggregate and per-CPU lines of `/proc/stat`.
+   *
+   * @param[in] contents The file contents.
+   * @param[out] cpus The aggregate line first, then one entry per CPU.
+   * @return `true` if the aggregate line was parsed, `false` otherwise.
+   */
+  static bool parseCpuLines(std::string_view contents,
+                            std::vector<CpuTimes> &cpus);
+
+  /**
+   * @brief Parses `MemTotal` from `/proc/meminfo`.
+   *
+   * @param[in] contents The file contents.
+   * @param[out] totalKb The total memory in kB.
+   * @return `true` if the key was found, `false` otherwise.
+   */
+  static bool parseMemTotal(std::string_view contents,
+                            unsigned long long &totalKb);
+
+  /**
+   * @brief Parses the system uptime from `/proc/uptime`.
+   *
+   * @param[in] contents The file contents.
+   * @param[out] seconds The uptime in seconds.
+   * @return `true` if the value was parsed, `false` otherwise.
+   */
+  static bool parseUptime(std::string_view contents, double &seconds);
+
+  /**
+   * @brief Parses the value of a `key value` line.
+   *
+   * This format is shared by `/proc/<pid>/status`, `/proc/meminfo` and the
+   * cgroup v2 files `cpu.stat` and `memory.stat`. The key must include its
+   * separator (e.g. `"anon "` or `"MemTotal:"`) so that keys sharing a
+   * prefix are not confused.
+   *
+   * @param[in] contents The file contents.
+   * @param[in] key The key that starts the line.
+   * @param[out] value The parsed value.
+   * @return `true` if the key was found, `false` otherwise.
+   */
+  static bool parseKeyedValue(std::string_view contents, const char *key,
+                              unsigned long long &value);
+
+  /**
+   * @brief Parses a cgroup v2 `io.stat` file.
+   *
+   * The byte counters of every device line are summed.
+   *
+   * @param[in] contents The file contents.
+   * @param[out] readBytes The total number of bytes read.
+   * @param[out] writeBytes The total number of bytes written.
+   */
+  static void parseCgroupIoStat(std::string_view contents,
+                                unsigned long long &readBytes,
+                                unsigned long long &writeBytes);
+
+  /**
+   * @brief Parses a Pressure Stall Information file.
+   *
+   * Each line looks like `some avg10=1.50 avg60=0.80 avg300=0.20
+   * total=123456`.
+   *
+   * @param[in] contents The file contents.
+   * @param[out] pressure The parsed lines.
+   * @return `true` if the `some` line was found, `false` otherwise.
+   */
+  static bool parsePressure(std::string_view contents,
+                            ProcPressure &pressure);
+
+  /**
+   * @brief Parses `/proc/diskstats` in one pass, one entry per device.
+   *
+   * The vector is cleared first but keeps its capacity, so a caller that
+   * reuses it allocates only when devices are added.
+   *
+   * @param[in] contents The file contents; the names point into it.
+   * @param[out] disks The devices, in file order.
+   * @return `true` if at least one device was parsed, `false` otherwise.
+   */
+  static bool parseDiskstats(std::string_view contents,
+                             std::vector<DiskCounters> &disks);
+
+  /**
+   * @brief Parses `/proc/net/dev` in one pass, one entry per interface.
+   *
+   * The vector is reused like the one of `parseDiskstats`.
+   *
+   * @param[in] contents The file contents; the names point into it.
+   * @param[out] interfaces The interfaces, in file order.
+   * @return `true` if at least one interface was parsed, `false` otherwise.
+   */
+  static bool parseNetDev(std::string_view contents,
+                          std::vector<NetCounters> &interfaces);
+
+  /**
+   * @brief Parses a sysfs CPU or node list such as `0-3,8,10-11`.
+   *
+   * @param[in] contents The list, e.g. the contents of `cpu/online`.
+   * @param[out] values The listed numbers in ascending order.
+   * @return `true` if the list was well formed, `false` otherwise.
+   */
+  static bool parseCpuList(std::string_view contents,
+                           std::vector<int> &values);
+
+  /**
+   * @brief Parses a sysfs `node<N>/meminfo` file.
+   *
+   * Every line starts with `Node <N> `, followed by a `/proc/meminfo` style
+   * `key: value kB` pair.
+   *
+   * @param[in] contents The file contents.
+   * @param[out] memory The parsed fields.
+   * @return `true` if MemTotal was found, `false` otherwise.
+   */
+  static bool parseNodeMeminfo(std::string_view contents, NodeMemory &memory);
+
+  /**
+   * @brief Sums the resident memory per NUMA node from
+   * `/proc/<pid>/numa_maps`.
+   *
+   * Each mapping lists its pages per node as `N<node>=<pages>` and its
+   * page size as `kernelpagesize_kB=<size>`.
+   *
+   * @param[in] contents The file contents.
+   * @param[out] nodeKb Resident kB indexed by node; grown as needed.
+   * @return `true` if the file had at least one mapping, `false` otherwise.
+   */
+  static bool parseNumaMaps(std::string_view contents,
+                            std::vector<unsigned long long> &nodeKb);
+};
+
+#endif // PROC_PARSERS_H
@@ -0,0 +1,97 @@
+/**
+ * @file proc_paths.h
+ * @brief Locates the procfs and sysfs trees that every reader uses.
+ *
+ * This file defines the `ProcPaths` class. All procfs and sysfs paths are
+ * built from its roots, which default to `/proc` and `/sys`. Pointing them at
+ * a directory written by `FakeProcfs` lets scans run against a synthetic
+ * system of any size.
+ */
+
+#ifndef PROC_PATHS_H
+#define PROC_PATHS_H
+
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+/**
+ * @class ProcPaths
+ * @brief Builds procfs and sysfs paths below configurable roots.
+ *
+ * The roots are process-wide. Change them before starting any scan or
+ * monitoring thread; they are read without synchronization.
+ */
+class ProcPaths {
+public:
+  /**
+   * @brief Returns the procfs root, `/proc` by default.
+   */
+  static const std::string &procRoot();
+
+  /**
+   * @brief Returns the sysfs root, `/sys` by default.
+   */
+  static const std::string &sysRoot();
+
+  /**
+   * @brief Replaces the procfs root.
+   *
+   * @param root The directory standing in for `/proc`.
+   */
+  static void setProcRoot(std::string root);
+
+  /**
+   * @brief Replaces the sysfs root.
+   *
+   * @param root The directory standing in for `/sys`.
+   */
+  static void setSysRoot(std::string root);
+
+  /**
+   * @brief Returns a path below the procfs root.
+   *
+   * @param relative The path below the root, e.g. `meminfo`.
+   * @return e.g. `/proc/meminfo`.
+   */
+  static std::string proc(std::string_view relative);
+
+  /**
+   * @brief Returns a path below the sysfs root.
+   *
+   * @param relative The path below the root, e.g. `fs/cgroup`.
+   * @return e.g. `/sys/fs/cgroup`.
+   */
+  static std::string sys(std::string_view relative);
+
+  /**
+   * @brief Returns the directory of a process, with a trailing slash.
+   *
+   * @param pid The process ID.
+   * @return e.g. `/proc/1234/`, ready for appending a file name.
+   */
+  static std::string process(int pid);
+
+  /**
+   * @brief Writes the directory of a process into a reusable buffer.
+   *
+   * The scan calls this once per process, so it formats into a buffer
+   * from its arena instead of returning a new string.
+   *
+   * @param pid The process ID.
+   * @param[out] path e.g. `/proc/1234/`, replacing the previous contents.
+   */
+  static void process(int pid, std::pmr::string &path);
+
+  /**
+   * @brief Writes the directory of a thread into a reusable buffer.
+   *
+   * @param pid The process ID.
+   * @param tid The thread ID.
+   * @param[out] path e.g. `/proc/1234/task/1240/`, replacing the previous
+   * contents.
+   */
+  static void task(int pid, int tid, std::pmr::string &path);
+};
+
+#endif // PROC_PATHS_H
@@ -0,0 +1,119 @@
+/**
+ * @file proc_reader.h
+ * @brief Provides low-level helpers for reading procfs files.
+ *
+ * This file defines the `ProcReader` class, which wraps the raw system calls
+ * used to read small pseudo-files under `/proc`. Using a single
+ * open/read/close sequence per file avoids the stream construction and locale
+ * overhead of `std::ifstream`, which dominates when thousands of files are read
+ * on every scan.
+ */
+
+#ifndef PROC_READER_H
+#define PROC_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+
+/**
+ * @class ProcReader
+ * @brief A utility class for reading procfs files with minimal overhead.
+ *
+ * The `ProcReader` class provides static helpers that read the full contents
+ * of a pseudo-file into a caller-provided buffer and count the entries of a
+ * procfs directory. The caller owns the buffer so it can be reused between
+ * reads.
+ */
+class ProcReader {
+public:
+  /**
+   * @brief Reads the whole contents of a file into a buffer.
+   *
+   * The buffer is cleared before reading, so its capacity can be reused
+   * across calls.
+   *
+   * @param[in] path The path of the file to read.
+   * @param[out] contents The buffer that receives the file contents.
+   * @return `true` if the file was opened and read, `false` otherwise.
+   */
+  static bool readFile(const std::string &path, std::string &contents);
+
+  /**
+   * @brief Reads the whole contents of a file into an arena-backed buffer.
+   *
+   * The scan uses this overload with buffers from its `ScanArena`. Reads
+   * fill the buffer's whole capacity, so a buffer reserved once is not
+   * reallocated for files that fit.
+   *
+   * @param[in] path The path of the file to read.
+   * @param[out] contents The buffer that receives the file contents.
+   * @return `true` if the file was opened and read, `false` otherwise.
+   */
+  static bool readFile(const char *path, std::pmr::string &contents);
+
+  /**
+   * @brief Counts the entries of a directory, ignoring `.` and `..`.
+   *
+   * This is used for directories such as `/proc/<pid>/fd`, where only the
+   * number of entries is of interest.
+   *
+   * @param[in] path The path of the directory.
+   * @return The number of entries, or -1 if the directory cannot be opened.
+   */
+  static long countEntries(const char *path);
+};
+
+/**
+ * @class ProcDirectory
+ * @brief Lists a procfs directory without allocating.
+ *
+ * Unlike `opendir`, which allocates its buffer on the heap, the entries are
+ * read with `getdents64` into a buffer inside the object, so a scan can list
+ * directories from the stack.
+ */
+class ProcDirectory {
+public:
+  /**
+   * @brief Opens a directory.
+   *
+   * @param path The path of the directory.
+   */
+  explicit ProcDirectory(const char *path);
+
+  /**
+   * @brief Closes the directory.
+   */
+  ~ProcDirectory();
+
+  ProcDirectory(const ProcDirectory &) = delete;
+  ProcDirectory &operator=(const ProcDirectory &) = delete;
+
+  /**
+   * @brief Returns whether the directory could be opened.
+   */
+  bool isOpen() const { return fd_ != -1; }
+
+  /**
+   * @brief Returns the next entry, skipping `.` and `..`.
+   *
+   * @param[out] type The `DT_*` type of the entry; `DT_UNKNOWN` if the file
+   * system does not report it.
+   * @return The name of the entry, valid until the next call, or `nullptr`
+   * after the last entry.
+   */
+  const char *next(unsigned char &type);
+
+private:
+  /// Bytes requested per `getdents64` call
+  static constexpr size_t BUFFER_SIZE = 16 * 1024;
+
+  int fd_;                              ///< Directory descriptor, or -1
+  size_t offset_ = 0;                   ///< Next record in `buffer_`
+  size_t size_ = 0;                     ///< Bytes of records in `buffer_`
+  uint64_t syscalls_ = 1;               ///< open and getdents64 calls so far
+  alignas(8) char buffer_[BUFFER_SIZE]; ///< Records of the last call
+};
+
+#endif // PROC_READER_H
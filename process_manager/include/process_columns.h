@@ -0,0 +1,146 @@
+/**
+ * @file process_columns.h
+ * @brief Defines the columns that can be displayed by the `list` command.
+ *
+ * This file contains the `ProcessColumn` enumeration, the `ColumnSpec`
+ * descriptor and the `ProcessColumns` helper class. Every column declares the
+ * procfs files it is computed from, so a listing only opens and parses the
+ * files that its selected columns need.
+ */
+
+#ifndef PROCESS_COLUMNS_H
+#define PROCESS_COLUMNS_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Identifies a column of the process table.
+ */
+enum class ProcessColumn {
+  Pid,                    ///< Process ID
+  Name,                   ///< Process name from `stat`
+  Cpu,                    ///< CPU usage percentage
+  Memory,                 ///< Memory usage percentage
+  Rss,                    ///< Resident set size
+  Threads,                ///< Number of threads
+  MinorFaults,            ///< Minor page faults per second
+  MajorFaults,            ///< Major page faults per second
+  VoluntaryCtxSwitches,   ///< Voluntary context switches
+  InvoluntaryCtxSwitches, ///< Involuntary context switches
+  IoRead,                 ///< Bytes read from storage
+  IoWrite,                ///< Bytes written to storage
+  OpenFds,                ///< Number of open file descriptors
+  Pss,                    ///< Proportional set size
+  Uss,                    ///< Unique set size
+  User,                   ///< Owner of the process
+  Cmdline,                ///< Full command line
+  NumaNode,               ///< NUMA node holding most of the memory
+  NumaShare,              ///< Share of the memory on that node
+  Tid                     ///< Thread ID of a thread row
+};
+
+/**
+ * @brief Bit flags for the per-process procfs sources a column depends on.
+ */
+enum ProcSource : unsigned {
+  PROC_SOURCE_NONE = 0,          ///< No per-process file is needed
+  PROC_SOURCE_CMDLINE = 1u << 0, ///< `/proc/<pid>/cmdline`
+  PROC_SOURCE_STAT = 1u << 1,    ///< `/proc/<pid>/stat`
+  PROC_SOURCE_STATM = 1u << 2,   ///< `/proc/<pid>/statm`
+  PROC_SOURCE_STATUS = 1u << 3,  ///< `/proc/<pid>/status`
+  PROC_SOURCE_IO = 1u << 4,      ///< `/proc/<pid>/io`
+  PROC_SOURCE_FD = 1u << 5,      ///< `/proc/<pid>/fd` directory
+  PROC_SOURCE_SMAPS = 1u << 6,  ///< `/proc/<pid>/smaps_rollup`
+  PROC_SOURCE_OWNER = 1u << 7,  ///< Owner of the `/proc/<pid>` directory
+  PROC_SOURCE_NUMA = 1u << 8    ///< `/proc/<pid>/numa_maps`
+};
+
+/**
+ * @struct ColumnSpec
+ * @brief Describes how a column is selected, displayed and collected.
+ */
+struct ColumnSpec {
+  ProcessColumn column; ///< Column identifier
+  const char *key;      ///< Name used in `--columns`
+  const char *header;   ///< Header displayed in the table
+  int width;            ///< Display width of the column
+  unsigned sources;     ///< Bitmask of `ProcSource` flags
+};
+
+/**
+ * @class ProcessColumns
+ * @brief A helper class for selecting and describing process table columns.
+ *
+ * The `ProcessColumns` class parses column lists given on the command line,
+ * provides the default column set and computes which procfs files must be
+ * read to populate a set of columns.
+ */
+class ProcessColumns {
+public:
+  /**
+   * @brief Returns the columns displayed when none are requested.
+   *
+   * The default set (PID, CPU%, Memory% and name) only needs `stat` and
+   * `statm`; the name is taken from `stat` instead of a separate `comm` read.
+   *
+   * @return The default column list.
+   */
+  static const std::vector<ProcessColumn> &defaultColumns();
+
+  /**
+   * @brief Returns the columns displayed for threads when none are requested.
+   *
+   * PID, TID, CPU% and the thread name: memory is shared by the threads of
+   * a process, so the default leaves it out.
+   *
+   * @return The default column list of a thread listing.
+   */
+  static const std::vector<ProcessColumn> &defaultThreadColumns();
+
+  /**
+   * @brief Parses a comma-separated list of column keys.
+   *
+   * @param[in] list The list to parse, e.g. `pid,cpu,rss,io_read,threads`.
+   * @param[out] columns The parsed columns, in the requested order.
+   * @param[out] error A description of the problem if parsing fails.
+   * @return `true` if every key was recognized, `false` otherwise.
+   */
+  static bool parse(const std::string &list,
+                    std::vector<ProcessColumn> &columns, std::string &error);
+
+  /**
+   * @brief Looks up a column by its key.
+   *
+   * @param[in] key The key, e.g. `io_read`.
+   * @param[out] column The column, if the key is known.
+   * @return `true` if the key is known, `false` otherwise.
+   */
+  static bool find(std::string_view key, ProcessColumn &column);
+
+  /**
+   * @brief Returns the descriptor of a column.
+   *
+   * @param[in] column The column to describe.
+   * @return The column's descriptor.
+   */
+  static const ColumnSpec &spec(ProcessColumn column);
+
+  /**
+   * @brief Computes the procfs sources needed by a set of columns.
+   *
+   * @param[in] columns The selected columns.
+   * @return A bitmask of `ProcSource` flags.
+   */
+  static unsigned requiredSources(const std::vector<ProcessColumn> &columns);
+
+  /**
+   * @brief Returns the accepted column keys as a comma-separated string.
+   *
+   * @return The list of valid keys, used in help and error messages.
+   */
+  static std::string availableKeys();
+};
+
+#endif // PROCESS_COLUMNS_H
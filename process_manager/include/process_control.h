@@ -1,24 +1,43 @@
 /**
  * @file process_control.h
- * @brief Provides functionality to terminate processes by their PID.
+ * @brief Provides functionality to terminate and restrain processes by PID.
  *
  * This file defines the `ProcessControl` class, which is responsible for
- * terminating processes by sending termination signals (SIGTERM and SIGKILL) to
- * a process identified by its PID.
+ * terminating processes by sending termination signals (SIGTERM and SIGKILL)
+ * to a process identified by its PID, and for restraining a process without
+ * losing its work: lowering its CPU or IO priority, moving it to other CPUs,
+ * or capping the CPU bandwidth of its cgroup.
  */
 
 #ifndef PROCESS_CONTROL_H
 #define PROCESS_CONTROL_H
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief IO scheduling classes, as numbered by `ioprio_set(2)`.
+ */
+enum class IoClass : uint8_t {
+  RealTime = 1,   ///< Served first; levels 0 (highest) to 7
+  BestEffort = 2, ///< The default; levels 0 (highest) to 7
+  Idle = 3,       ///< Only served when no other process needs the disk
+};
+
 /**
  * @class ProcessControl
- * @brief A class for controlling processes, specifically terminating them.
+ * @brief A class for controlling processes: terminating and restraining them.
  *
  * The `ProcessControl` class provides a method to terminate a process using its
  * PID. It checks the validity of the PID, verifies if the process exists, and
  * attempts to terminate the process gracefully (SIGTERM), followed by a forced
  * termination (SIGKILL) if needed. It also logs the termination attempts and
  * outcomes using the `Logger` class.
+ *
+ * Priority and affinity changes apply to every thread of the process, since
+ * the kernel keeps them per thread. Every method reports failures on
+ * standard error and logs the outcome.
  */
 class ProcessControl {
 public:
@@ -35,6 +54,102 @@ public:
    * actions.
    */
   void terminateProcess(int pid);
+
+  /**
+   * @brief Terminates several processes, waiting once for all of them.
+   *
+   * Every process is sent SIGTERM first; after one grace period, those still
+   * running are sent SIGKILL.
+   *
+   * @param pids The processes to terminate.
+   * @return The number of processes terminated.
+   */
+  size_t terminateProcesses(const std::vector<int> &pids);
+
+  /**
+   * @brief Sets the nice value of every thread of a process.
+   *
+   * @param pid The process.
+   * @param niceness The nice value, from -20 (highest priority) to 19.
+   * @return `true` if every thread was reniced.
+   */
+  bool renice(int pid, int niceness);
+
+  /**
+   * @brief Sets the IO scheduling class and level of every thread.
+   *
+   * @param pid The process.
+   * @param ioClass The class.
+   * @param level The level within the class, from 0 to 7; ignored for
+   * `IoClass::Idle`.
+   * @return `true` if every thread was changed.
+   */
+  bool ionice(int pid, IoClass ioClass, int level);
+
+  /**
+   * @brief Restricts every thread of a process to a set of CPUs.
+   *
+   * @param pid The process.
+   * @param cpus The CPUs the process may run on.
+   * @return `true` if every thread was moved.
+   */
+  bool setAffinity(int pid, const std::vector<int> &cpus);
+
+  /**
+   * @brief Writes the `cpu.max` of the cgroup v2 group of a process.
+   *
+   * The limit applies to every process of the group, so this is meant for
+   * a service or a batch job in a group of its own.
+   *
+   * @param pid A process of the group.
+   * @param cpuMax The value, e.g. `50000 100000` for half a CPU or
+   * `max 100000` to lift the limit.
+   * @param[out] cgroup The group's path below the hierarchy, e.g.
+   * `/system.slice/backup.service`, if it was found.
+   * @return `true` if the limit was written.
+   */
+  bool throttle(int pid, const std::string &cpuMax, std::string &cgroup);
+
+  /**
+   * @brief Parses a comma-separated list of PIDs such as `812,913,1020`.
+   *
+   * @param[in] text The list.
+   * @param[out] pids The PIDs, in the order given, without duplicates.
+   * @return `true` if every entry is a positive PID.
+   */
+  static bool parsePids(const std::string &text, std::vector<int> &pids);
+
+  /**
+   * @brief Parses an IO class such as `idle`, `best-effort:7` or `rt:0`.
+   *
+   * @param[in] text The class name, `realtime`, `rt`, `best-effort`, `be`
+   * or `idle`, optionally followed by `:` and a level from 0 to 7.
+   * @param[out] ioClass The class.
+   * @param[out] level The level, 4 if none is given.
+   * @return `true` if the text was well formed.
+   */
+  static bool parseIoClass(const std::string &text, IoClass &ioClass,
+                           int &level);
+
+  /**
+   * @brief Builds a `cpu.max` value from a quota and an optional period.
+   *
+   * @param[in] quota Microseconds per period, or `max` for no limit.
+   * @param[in] period Microseconds, or empty for the kernel's default.
+   * @param[out] cpuMax The value to write.
+   * @return `true` if both are well formed.
+   */
+  static bool formatCpuMax(const std::string &quota, const std::string &period,
+                           std::string &cpuMax);
+
+  /**
+   * @brief Finds the cgroup v2 group of a process.
+   *
+   * @param[in] pid The process.
+   * @param[out] path The group below the hierarchy, `/` for the root.
+   * @return `true` if the process has a cgroup v2 membership.
+   */
+  static bool cgroupOf(int pid, std::string &path);
 };
 
 #endif // PROCESS_CONTROL_H
@@ -0,0 +1,114 @@
+/**
+ * @file process_events.h
+ * @brief Turns consecutive scans into process start, exit and exec events.
+ *
+ * This file defines the `ProcessEvents` class, which compares the process
+ * identities of two scans. A process is identified by its PID and its start
+ * time, so a PID that was reused between the scans is reported as the exit
+ * of one process and the start of another, and a process whose name changed
+ * while its identity did not has called `exec`. Processes that start and
+ * exit between two scans are not seen; the churn rate of the listing counts
+ * the starts and exits that are.
+ */
+
+#ifndef PROCESS_EVENTS_H
+#define PROCESS_EVENTS_H
+
+#include "output_buffer.h"
+#include "process_metadata.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief What happened to a process between two scans.
+ */
+enum class ProcessEventType : uint8_t {
+  Started, ///< The identity was not in the previous scan
+  Exited,  ///< The identity is not in the current scan
+  Exec,    ///< Same identity with a new name
+};
+
+/**
+ * @struct ProcessIdentity
+ * @brief A process as seen by one scan, for the diff with the next one.
+ */
+struct ProcessIdentity {
+  int pid = 0;                            ///< Process ID
+  int ppid = 0;                           ///< Parent process ID
+  unsigned long long startTime = 0;       ///< Start, in ticks since boot
+  uint32_t nameId = StringPool::EMPTY_ID; ///< Interned name
+};
+
+/**
+ * @struct ProcessEvent
+ * @brief A start, exit or exec with the metadata of the process.
+ */
+struct ProcessEvent {
+  ProcessEventType type = ProcessEventType::Started; ///< What happened
+  int pid = 0;                                       ///< Process ID
+  int ppid = 0;                                      ///< Parent process ID
+  unsigned long long startTime = 0; ///< Start, in ticks since boot
+  uint64_t timestampMs = 0;         ///< Wall-clock time of the scan
+  std::string name;                 ///< Name, the new one for an exec
+  std::string previousName;         ///< Name before an exec, else empty
+};
+
+/**
+ * @class ProcessEvents
+ * @brief Diffs process identities and formats the resulting events.
+ */
+class ProcessEvents {
+public:
+  /**
+   * @brief Appends the events between two scans.
+   *
+   * Both lists are sorted by PID and merged in one pass, so the diff costs
+   * no lookup per process. Events come out in PID order; for a reused PID
+   * the exit precedes the start.
+   *
+   * @param previous The identities of the previous scan, sorted by PID.
+   * @param current The identities of the current scan, sorted by PID.
+   * @param strings The cache that interned the names of both lists.
+   * @param timestampMs The wall-clock time of the current scan.
+   * @param[out] events Receives the events, after its current contents.
+   */
+  static void diff(const std::vector<ProcessIdentity> &previous,
+                   const std::vector<ProcessIdentity> &current,
+                   const ProcessMetadataCache &strings, uint64_t timestampMs,
+                   std::vector<ProcessEvent> &events);
+
+  /**
+   * @brief Returns the lowercase name of an event type, e.g. `exited`.
+   */
+  static const char *typeName(ProcessEventType type);
+
+  /**
+   * @brief Describes an event in one line, e.g. for the log.
+   */
+  static std::string describe(const ProcessEvent &event);
+
+  /**
+   * @brief Prints the events as a table, one row per event.
+   *
+   * @param out The stream to print to.
+   * @param events The events, oldest first.
+   * @param header Whether to print the column titles first.
+   */
+  static void printTable(std::ostream &out,
+                         const std::vector<ProcessEvent> &events,
+                         bool header = true);
+
+  /**
+   * @brief Appends the events as a JSON array.
+   *
+   * @param out The buffer to append to.
+   * @param events The events, oldest first.
+   */
+  static void writeJson(OutputBuffer &out,
+                        const std::vector<ProcessEvent> &events);
+};
+
+#endif // PROCESS_EVENTS_H
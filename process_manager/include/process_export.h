@@ -0,0 +1,93 @@
+/**
+ * @file process_export.h
+ * @brief Serializes process listings as JSON or CSV.
+ *
+ * This file defines the `ProcessExport` class, which writes the rows of a
+ * `ProcessListing` into an `OutputBuffer` for consumption by other programs.
+ * Values are written raw (sizes in bytes, percentages as numbers) and without
+ * ANSI colors.
+ */
+
+#ifndef PROCESS_EXPORT_H
+#define PROCESS_EXPORT_H
+
+#include "output_buffer.h"
+#include "process_listing.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief Output formats for non-interactive commands.
+ */
+enum class ExportFormat {
+  Table, ///< Human-readable table, as printed by the interactive shell
+  Json,  ///< A JSON document
+  Csv    ///< Comma-separated values with a header row
+};
+
+/**
+ * @class ProcessExport
+ * @brief Writes process rows in machine-readable formats.
+ */
+class ProcessExport {
+public:
+  /**
+   * @brief Parses the value of a `--format` option.
+   *
+   * @param[in] name One of `table`, `json` or `csv`.
+   * @param[out] format The parsed format.
+   * @return `true` if the name is known, `false` otherwise.
+   */
+  static bool parseFormat(const std::string &name, ExportFormat &format);
+
+  /**
+   * @brief Writes processes as a JSON document.
+   *
+   * The document is an object with a `timestamp` (seconds since the epoch)
+   * and a `processes` array holding one object per process, keyed by column.
+   * Values that could not be collected are `null`. A `self` object holds the
+   * process manager's own counters and latencies (see `SelfStats`). With
+   * `events`, an `events` array and a `churn_per_s` number describe the
+   * processes that started, exited or called exec since the previous scan.
+   *
+   * @param out The buffer to append to.
+   * @param listing The listing holding the rows.
+   * @param columns The columns to write, in order.
+   * @param count The maximum number of rows to write.
+   * @param events Whether to write the events of the listing's last scan.
+   */
+  static void writeJson(OutputBuffer &out, const ProcessListing &listing,
+                        const std::vector<ProcessColumn> &columns,
+                        size_t count, bool events = false);
+
+  /**
+   * @brief Writes processes as CSV with a header row of column keys.
+   *
+   * Values that could not be collected are left empty.
+   *
+   * @param out The buffer to append to.
+   * @param listing The listing holding the rows.
+   * @param columns The columns to write, in order.
+   * @param count The maximum number of rows to write.
+   */
+  static void writeCsv(OutputBuffer &out, const ProcessListing &listing,
+                       const std::vector<ProcessColumn> &columns,
+                       size_t count);
+
+private:
+  /**
+   * @brief Writes the value of one cell.
+   *
+   * @param out The buffer to append to.
+   * @param listing The listing holding the interned strings.
+   * @param process The row.
+   * @param column The column of the cell.
+   * @param format `ExportFormat::Json` or `ExportFormat::Csv`.
+   */
+  static void writeValue(OutputBuffer &out, const ProcessListing &listing,
+                         const ProcessInfo &process, ProcessColumn column,
+                         ExportFormat format);
+};
+
+#endif // PROCESS_EXPORT_H
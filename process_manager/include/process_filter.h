@@ -0,0 +1,143 @@
+/**
+ * @file process_filter.h
+ * @brief Compiles `list --filter` expressions into predicates on processes.
+ *
+ * This file defines the `ProcessFilter` class, which turns an expression
+ * such as
+ *
+ * @code
+ * name~nginx && cpu>5 && user==www
+ * !(rss < 100M || threads <= 1)
+ * @endcode
+ *
+ * into a predicate tree. Every clause compares a column with a value and
+ * knows which procfs sources it needs, so the scan can evaluate the tree
+ * after each file it reads and stop reading a process as soon as the
+ * outcome is decided: a PID clause before any file is opened, a user clause
+ * after one `stat` of the process directory, a name or CPU clause after
+ * `/proc/<pid>/stat`.
+ */
+
+#ifndef PROCESS_FILTER_H
+#define PROCESS_FILTER_H
+
+#include "process_listing.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Outcome of a filter for the values collected so far.
+ */
+enum class FilterMatch : uint8_t {
+  False,   ///< The row is rejected whatever the missing values are
+  True,    ///< The row is kept whatever the missing values are
+  Unknown, ///< The outcome depends on a value that was not collected
+};
+
+/**
+ * @class ProcessFilter
+ * @brief A compiled filter expression.
+ *
+ * Clauses are `KEY OP VALUE`, where `KEY` is a column key and `OP` one of
+ * `==` (or `=`), `!=`, `<`, `<=`, `>`, `>=`, `~` (contains) and `!~` (does
+ * not contain). Text columns (`name`, `cmdline`) take the equality and
+ * containment operators; `user` takes `==` and `!=` with a user name or
+ * UID; the other columns are numbers, with `K`, `M`, `G` and `T` suffixes
+ * for sizes in bytes. Clauses combine with `&&`, `||`, `!` and
+ * parentheses; values with spaces or operator characters are quoted.
+ *
+ * Evaluation uses three-valued logic: a clause whose sources have not been
+ * collected is `Unknown`, `False && Unknown` is `False` and `True ||
+ * Unknown` is `True`. A row that is still `Unknown` after the whole scan,
+ * e.g. because its `io` file was not readable, does not match.
+ */
+class ProcessFilter {
+public:
+  /**
+   * @brief Compiles an expression, replacing any previous one.
+   *
+   * @param text The expression.
+   * @param[out] error The problem, with the offending token, on failure.
+   * @return `true` if the expression compiled, `false` otherwise.
+   */
+  bool compile(const std::string &text, std::string &error);
+
+  /**
+   * @brief Evaluates the filter on the values collected for a row.
+   *
+   * @param process The row; `collected` says which values are set.
+   * @param strings The cache holding the row's interned strings.
+   * @return The outcome, `Unknown` if it depends on missing values.
+   */
+  FilterMatch evaluate(const ProcessInfo &process,
+                       const ProcessMetadataCache &strings) const;
+
+  /**
+   * @brief Returns the `ProcSource` flags of every clause.
+   */
+  unsigned requiredSources() const { return sources_; }
+
+  /**
+   * @brief Returns the expression as it was compiled.
+   */
+  const std::string &text() const { return text_; }
+
+private:
+  /**
+   * @brief The kind of a node of the tree.
+   */
+  enum class NodeType : uint8_t { And, Or, Not, Compare };
+
+  /**
+   * @brief How a clause compares the column with its value.
+   */
+  enum class Operator : uint8_t {
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Contains,
+    NotContains,
+  };
+
+  /**
+   * @struct Node
+   * @brief A clause, or an operator over one or two other nodes.
+   */
+  struct Node {
+    NodeType type = NodeType::Compare;         ///< Kind of node
+    Operator op = Operator::Equal;             ///< Comparison of a clause
+    ProcessColumn column = ProcessColumn::Pid; ///< Compared column
+    double number = 0.0;                       ///< Numeric or UID value
+    std::string text;                          ///< Value of a text clause
+    unsigned sources = PROC_SOURCE_NONE;       ///< Sources of the clause
+    uint32_t left = 0;  ///< First operand of `And`, `Or` and `Not`
+    uint32_t right = 0; ///< Second operand of `And` and `Or`
+  };
+
+  /// Recursive-descent parser that builds `nodes_`
+  struct Parser;
+
+  /**
+   * @brief Evaluates the subtree rooted at a node.
+   */
+  FilterMatch evaluateNode(uint32_t index, const ProcessInfo &process,
+                           const ProcessMetadataCache &strings) const;
+
+  /**
+   * @brief Evaluates a clause whose sources have been collected.
+   */
+  bool compare(const Node &node, const ProcessInfo &process,
+               const ProcessMetadataCache &strings) const;
+
+  std::vector<Node> nodes_;             ///< Operands before their operators
+  uint32_t root_ = 0;                   ///< Index of the root node
+  unsigned sources_ = PROC_SOURCE_NONE; ///< Sources of every clause
+  std::string text_;                    ///< The compiled expression
+};
+
+#endif // PROCESS_FILTER_H
@@ -0,0 +1,303 @@
+/**
+ * @file process_history.h
+ * @brief Keeps a bounded, compressed history of recent samples per process.
+ *
+ * This file defines the `ProcessHistory` class, which stores the CPU, memory,
+ * RSS and IO samples of every process seen by a series of scans, and the
+ * `HistoryRecorder` class, which feeds one from a background scan so the
+ * interactive shell can show what a process looked like over the last
+ * minutes.
+ *
+ * Samples are compressed as in Facebook's Gorilla time-series store:
+ * timestamps are stored as the difference between consecutive deltas, which
+ * is zero for a steady interval and costs one bit, and each value as the XOR
+ * with the previous one, which is zero for a value that did not change and
+ * otherwise keeps only its meaningful bits. An idle process costs about six
+ * bits per sample instead of 48 bytes.
+ */
+
+#ifndef PROCESS_HISTORY_H
+#define PROCESS_HISTORY_H
+
+#include "process_listing.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct HistorySample
+ * @brief One sample of a process.
+ */
+struct HistorySample {
+  uint64_t timestampMs = 0;  ///< Wall-clock time of the sample
+  double cpuUsage = 0.0;     ///< CPU usage percentage
+  double memoryUsage = 0.0;  ///< Memory usage percentage
+  uint64_t rssKb = 0;        ///< Resident set size in kB
+  uint64_t ioReadBytes = 0;  ///< Bytes read from storage so far
+  uint64_t ioWriteBytes = 0; ///< Bytes written to storage so far
+};
+
+/**
+ * @class ProcessHistory
+ * @brief Compressed rings of recent samples, keyed by PID.
+ *
+ * Each process keeps at most `samplesPerProcess` samples. Samples are
+ * appended to blocks of `BLOCK_SAMPLES`; once a process has a full ring
+ * beyond its oldest block, that block is dropped, so a ring holds up to one
+ * block more than it reports. A process that is missing from a scan has
+ * exited and its history is dropped with it.
+ *
+ * When the compressed data exceeds the memory limit, the coldest processes,
+ * those that have been idle the longest, are evicted until usage is back
+ * below 90% of the limit; busy processes keep their history.
+ *
+ * The class is not thread-safe; its owner serializes the calls.
+ */
+class ProcessHistory {
+public:
+  /// Samples per compressed block, the unit in which rings are trimmed
+  static constexpr size_t BLOCK_SAMPLES = 32;
+
+  /**
+   * @brief Creates an empty history.
+   *
+   * @param samplesPerProcess The length of each process's ring.
+   * @param memoryLimitBytes The memory above which cold processes are evicted.
+   */
+  ProcessHistory(size_t samplesPerProcess, size_t memoryLimitBytes);
+
+  /**
+   * @brief Appends a scan to the history.
+   *
+   * @param processes The rows of the scan; threads are not expected.
+   * @param timestampMs The wall-clock time of the scan.
+   */
+  void record(const std::vector<ProcessInfo> &processes,
+              uint64_t timestampMs);
+
+  /**
+   * @brief Decodes the history of a process, oldest first.
+   *
+   * @param pid The process.
+   * @param[out] samples The samples, at most `samplesPerProcess()`.
+   * @return `false` if the process has no history.
+   */
+  bool samples(int pid, std::vector<HistorySample> &samples) const;
+
+  /**
+   * @brief Returns whether the `io` file of a process was ever readable.
+   */
+  bool hasIo(int pid) const;
+
+  /**
+   * @brief Returns the number of processes with a history.
+   */
+  size_t processCount() const { return series_.size(); }
+
+  /**
+   * @brief Returns the approximate memory used by the compressed samples.
+   */
+  size_t memoryBytes() const { return memoryBytes_; }
+
+  /**
+   * @brief Returns the length of each process's ring.
+   */
+  size_t samplesPerProcess() const { return samplesPerProcess_; }
+
+  /**
+   * @brief Returns the number of processes evicted to respect the limit.
+   */
+  size_t evictedCount() const { return evicted_; }
+
+  /**
+   * @brief Prints a sparkline and the minimum, mean, maximum and last value
+   * of each series.
+   *
+   * IO is shown as read and write rates between consecutive samples.
+   *
+   * @param out The stream to print to.
+   * @param pid The process, for the title.
+   * @param samples The samples, oldest first.
+   * @param hasIo Whether to print the IO rates.
+   */
+  static void printSummary(std::ostream &out, int pid,
+                           const std::vector<HistorySample> &samples,
+                           bool hasIo);
+
+private:
+  /// Values compressed per sample: CPU, memory, RSS, IO read and IO write
+  static constexpr size_t VALUE_COUNT = 5;
+
+  /**
+   * @struct Block
+   * @brief A bit stream of up to `BLOCK_SAMPLES` samples and its encoder
+   * state.
+   */
+  struct Block {
+    std::vector<uint8_t> bits;          ///< Compressed samples
+    size_t bitCount = 0;                ///< Bits written to `bits`
+    uint32_t count = 0;                 ///< Samples in the block
+    uint64_t timestamp = 0;             ///< Timestamp of the last sample
+    int64_t delta = 0;                  ///< Delta before that timestamp
+    uint64_t values[VALUE_COUNT] = {};  ///< Last value of each series
+    uint8_t leading[VALUE_COUNT] = {};  ///< Leading zeros of the window
+    uint8_t trailing[VALUE_COUNT] = {}; ///< Trailing zeros of the window
+  };
+
+  /**
+   * @struct Series
+   * @brief The blocks of one process.
+   */
+  struct Series {
+    std::deque<Block> blocks;  ///< Oldest first
+    size_t count = 0;          ///< Samples in all blocks
+    size_t bytes = 0;          ///< Memory charged to the process
+    uint64_t lastActiveMs = 0; ///< Last sample with CPU or IO activity
+    uint32_t generation = 0;   ///< Last `record` call that saw the process
+    bool hasIo = false;        ///< Whether an `io` file was ever read
+    unsigned long long startTime = 0; ///< Identity check against PID reuse
+  };
+
+  /**
+   * @brief Appends a sample to the newest block, opening one if needed.
+   */
+  void append(Series &series, const HistorySample &sample);
+
+  /**
+   * @brief Encodes a sample into a block that is not full.
+   */
+  static void encode(Block &block, const HistorySample &sample);
+
+  /**
+   * @brief Decodes every sample of a block.
+   */
+  static void decode(const Block &block, std::vector<HistorySample> &samples);
+
+  /**
+   * @brief Returns the memory charged for a block.
+   */
+  static size_t blockBytes(const Block &block);
+
+  /**
+   * @brief Evicts the idlest processes until usage is below the low mark.
+   */
+  void evictCold();
+
+  size_t samplesPerProcess_; ///< Length of each ring
+  size_t memoryLimitBytes_;  ///< Eviction threshold
+  size_t memoryBytes_ = 0;   ///< Sum of `Series::bytes`
+  size_t evicted_ = 0;       ///< Processes evicted for memory
+  uint32_t generation_ = 0;  ///< `record` calls so far
+  std::unordered_map<int, Series> series_; ///< Histories by PID
+};
+
+/**
+ * @class HistoryRecorder
+ * @brief Records a `ProcessHistory` from a background scan.
+ *
+ * The recorder scans the processes every interval on its own thread, with
+ * its own `ProcessListing`, and reads only the files the history needs:
+ * `stat`, `statm` and `io`. The same scans keep the most recent process
+ * start, exit and exec events.
+ */
+class HistoryRecorder {
+public:
+  /// Events kept for the `events` command, the oldest dropped first
+  static constexpr size_t RECENT_EVENTS = 256;
+
+  /**
+   * @brief Creates a stopped recorder.
+   *
+   * @param interval The time between scans.
+   * @param samplesPerProcess The length of each process's ring.
+   * @param memoryLimitBytes The memory above which cold processes are evicted.
+   */
+  HistoryRecorder(std::chrono::milliseconds interval, size_t samplesPerProcess,
+                  size_t memoryLimitBytes);
+
+  /**
+   * @brief Stops the recorder.
+   */
+  ~HistoryRecorder();
+
+  HistoryRecorder(const HistoryRecorder &) = delete;
+  HistoryRecorder &operator=(const HistoryRecorder &) = delete;
+
+  /**
+   * @brief Starts the background scans.
+   *
+   * The first scan only primes the CPU samples; the history starts with
+   * the second one, an interval later.
+   */
+  void start();
+
+  /**
+   * @brief Stops the background scans and waits for the current one.
+   */
+  void stop();
+
+  /**
+   * @brief Decodes the history of a process, oldest first.
+   *
+   * @param pid The process.
+   * @param[out] samples The samples.
+   * @param[out] hasIo Whether the `io` values were readable.
+   * @return `false` if the process has no history.
+   */
+  bool samples(int pid, std::vector<HistorySample> &samples,
+               bool &hasIo) const;
+
+  /**
+   * @brief Returns the time between scans.
+   */
+  std::chrono::milliseconds interval() const { return interval_; }
+
+  /**
+   * @brief Returns the number of processes and the memory they use.
+   */
+  void usage(size_t &processes, size_t &bytes) const;
+
+  /**
+   * @brief Copies the most recent process events.
+   *
+   * @param[out] events At most `RECENT_EVENTS` events, oldest first.
+   * @param[out] churnPerSecond Starts and exits per second in the last scan.
+   */
+  void recentEvents(std::vector<ProcessEvent> &events,
+                    double &churnPerSecond) const;
+
+private:
+  /**
+   * @brief Scans the processes and appends them to the history.
+   */
+  void sample();
+
+  /**
+   * @brief Body of the background thread.
+   */
+  void sampleLoop();
+
+  std::chrono::milliseconds interval_; ///< Time between scans
+  ProcessListing listing_;             ///< Touched by the scans only
+  ListOptions options_;                ///< Columns the history needs
+  bool primed_ = false;                ///< Whether a scan was taken
+
+  mutable std::mutex historyMutex_; ///< Guards the members below
+  ProcessHistory history_;          ///< Recorded samples
+  std::deque<ProcessEvent> events_; ///< Recent events, oldest first
+  double churnPerSecond_ = 0.0;     ///< Churn of the last scan
+
+  std::mutex stopMutex_;                  ///< Guards `stopping_`
+  std::condition_variable stopCondition_; ///< Wakes the sampling thread
+  bool stopping_ = false;                 ///< Set by `stop`
+  std::thread sampler_;                   ///< Sampling thread
+};
+
+#endif // PROCESS_HISTORY_H
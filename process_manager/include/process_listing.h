@@ -11,22 +11,144 @@
 #ifndef PROCESS_LISTING_H
 #define PROCESS_LISTING_H
 
+#include "process_columns.h"
+#include "process_events.h"
+#include "process_metadata.h"
+#include "proc_parsers.h"
+#include "scan_arena.h"
+#include "uring_reader.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
 #include <mutex>
+#include <ostream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+class ProcessFilter;
+
 /**
  * @struct ProcessInfo
  * @brief Holds information about a process.
  *
  * This structure stores details of a process such as its PID, name, CPU usage
- * percentage, and memory usage percentage.
+ * percentage, and memory usage percentage. The extended metrics are only
+ * populated when a selected column needs them; `collected` records which
+ * procfs sources were read successfully. Strings are interned in the
+ * listing's metadata cache and stored as ids. In a thread listing, each row
+ * describes one thread of the process and `nameId` is the thread's name.
  */
 struct ProcessInfo {
-  int pid;            ///< Process ID
-  std::string name;   ///< Name of the process
-  double cpuUsage;    ///< CPU usage percentage
-  double memoryUsage; ///< Memory usage percentage
+  int pid = 0;                                   ///< Process ID
+  int tid = 0;                                   ///< Thread ID, or the PID
+  int ppid = 0;                                  ///< Parent process ID
+  unsigned long long startTime = 0;              ///< Start, in ticks since boot
+  uint32_t nameId = StringPool::EMPTY_ID;        ///< Interned name
+  uint32_t cmdlineId = StringPool::EMPTY_ID;     ///< Interned command line
+  uint32_t userId = StringPool::EMPTY_ID;        ///< Interned owner name
+  uint32_t uid = 0;                              ///< Owner's user ID
+  double cpuUsage = 0.0;                         ///< CPU usage percentage
+  double memoryUsage = 0.0;                      ///< Memory usage percentage
+  unsigned long long rssKb = 0;                  ///< Resident set size in kB
+  long threads = 0;                              ///< Number of threads
+  double minorFaultRate = 0.0;                   ///< Minor faults per second
+  double majorFaultRate = 0.0;                   ///< Major faults per second
+  unsigned long long voluntaryCtxSwitches = 0;   ///< Voluntary switches
+  unsigned long long involuntaryCtxSwitches = 0; ///< Involuntary switches
+  unsigned long long ioReadBytes = 0;            ///< Bytes read from storage
+  unsigned long long ioWriteBytes = 0;           ///< Bytes written to storage
+  long openFds = 0;                              ///< Open file descriptors
+  unsigned long long pssKb = 0;                  ///< Proportional set size
+  unsigned long long ussKb = 0;                  ///< Unique set size
+  int numaNode = -1;                             ///< Node with most memory
+  double numaShare = 0.0;                        ///< Percentage on that node
+  unsigned collected = PROC_SOURCE_NONE;         ///< `ProcSource` flags read
+};
+
+/**
+ * @struct ListOptions
+ * @brief Options that control what a process listing collects and shows.
+ */
+struct ListOptions {
+  /// Columns to display, in order
+  std::vector<ProcessColumn> columns = ProcessColumns::defaultColumns();
+
+  /// Maximum number of processes, ranked by RSS, whose `smaps_rollup` is read
+  /// when the PSS or USS column is selected
+  size_t smapsTopN = 25;
+
+  /// Maximum number of processes, ranked by RSS, whose `numa_maps` is read
+  /// when a NUMA column is selected
+  size_t numaTopN = 25;
+
+  /// `ProcSource` flags collected in addition to those of the columns, e.g.
+  /// for sorting by a column that is not displayed
+  unsigned extraSources = PROC_SOURCE_NONE;
+
+  /// One row per thread, from `/proc/<pid>/task`, instead of per process.
+  /// PSS, USS and NUMA residency belong to the process and are not read.
+  bool threads = false;
+
+  /// Only this process, or its threads, when positive
+  int pid = 0;
+
+  /// Rows to keep, or `nullptr` for all; evaluated during the scan so that
+  /// the files of a rejected process are not read
+  std::shared_ptr<const ProcessFilter> filter;
+
+  /// Diff each scan against the previous one into start, exit and exec
+  /// events, which are also logged. Reads `stat`; ignored for threads. The
+  /// events cover every process whose `stat` was read, including those the
+  /// filter rejects afterwards, so a row leaving the filter is not an exit.
+  bool events = false;
+};
+
+/**
+ * @struct SmapsReport
+ * @brief Describes the cost of collecting PSS and USS during a scan.
+ *
+ * The collection of NUMA residency from `numa_maps` is described by the
+ * same fields.
+ */
+struct SmapsReport {
+  size_t candidates = 0;   ///< Processes eligible for smaps_rollup
+  size_t read = 0;         ///< Processes whose smaps_rollup was read
+  size_t cached = 0;       ///< Processes served from the smaps cache
+  double kernelTimeMs = 0; ///< Kernel CPU time spent reading, in ms
+};
+
+/**
+ * @struct ScanReport
+ * @brief Describes the cost and outcome of a process scan.
+ */
+struct ScanReport {
+  size_t processes = 0;                   ///< Processes, or threads, collected
+  size_t added = 0;                       ///< PIDs not seen by the last scan
+  size_t removed = 0;                     ///< PIDs of the last scan now gone
+  size_t filtered = 0;                    ///< Rows the filter left out
+  size_t started = 0;                     ///< Processes started, with events
+  size_t exited = 0;                      ///< Processes exited, with events
+  size_t execs = 0;                       ///< Processes that called exec
+  double churnPerSecond = 0;              ///< Starts and exits per second
+  double wallTimeMs = 0;                  ///< Elapsed time of the scan, in ms
+  double cpuTimeMs = 0;                   ///< CPU time of the scan, in ms
+  double workerTimeMs = 0;                ///< Part of it used by the workers
+  unsigned long long metadataHits = 0;    ///< Metadata served from the cache
+  unsigned long long metadataMisses = 0;  ///< Metadata read from procfs
+};
+
+/**
+ * @brief How a scan reads the per-process files.
+ */
+enum class ScanBackend : uint8_t {
+  Sync,    ///< Open, read and close each file, from parallel threads
+  IoUring, ///< Batches of linked reads through io_uring, if available
 };
 
 /**
@@ -51,78 +173,480 @@ public:
   /**
    * @brief Lists all processes with their resource usage.
    *
-   * This method retrieves a list of processes, calculates their CPU and memory
-   * usage, and displays the information in a formatted table. Processes with
-   * high CPU or memory usage are displayed in red or yellow for better
-   * visibility.
+   * This method retrieves a list of processes, calculates the requested
+   * metrics, and displays the information in a formatted table. Only the
+   * procfs files needed by the selected columns are read. Processes with high
+   * CPU or memory usage are displayed in red or yellow for better visibility.
+   *
+   * @param options The columns to display and collection limits.
    */
-  void listProcesses();
+  void listProcesses(const ListOptions &options = ListOptions());
 
-private:
-  std::vector<ProcessInfo> processes_; ///< List of processes with their details
-  std::mutex mutex_; ///< Mutex to synchronize access to shared data
+  /**
+   * @brief Scans the processes without printing them.
+   *
+   * Samples, cached metadata and PSS/USS readings are kept between calls, so
+   * repeated refreshes only re-read the counters that can change and rates
+   * are computed over the refresh interval. Thread listings keep their
+   * samples per TID; switching between processes and threads starts over.
+   *
+   * @param options The columns to collect and collection limits.
+   */
+  void refresh(const ListOptions &options);
+
+  /**
+   * @brief Sorts the collected processes by a column.
+   *
+   * @param column The column to sort by.
+   * @param descending Whether the largest values come first.
+   */
+  void sortProcesses(ProcessColumn column, bool descending);
+
+  /**
+   * @brief Prints the collected processes as a table.
+   *
+   * When PSS or USS is displayed, a footer reports the cost of collecting
+   * them.
+   *
+   * @param out The stream to print to.
+   * @param columns The columns to display, in order.
+   * @param first The index of the first process to print.
+   * @param count The maximum number of processes to print.
+   */
+  void printTable(std::ostream &out, const std::vector<ProcessColumn> &columns,
+                  size_t first = 0,
+                  size_t count = std::numeric_limits<size_t>::max()) const;
+
+  /**
+   * @brief Returns the numeric value of a column, as used for sorting.
+   *
+   * @param process The row.
+   * @param column A numeric column; text columns return 0.
+   * @return The value, in the unit it is stored in, e.g. kB for RSS.
+   */
+  static double columnValue(const ProcessInfo &process, ProcessColumn column);
+
+  /**
+   * @brief Returns the processes collected by the last scan.
+   *
+   * @return The rows in their current order.
+   */
+  const std::vector<ProcessInfo> &getProcesses() const { return processes_; }
+
+  /**
+   * @brief Returns a string interned by the last scan.
+   *
+   * @param id A name, command line or user id from a `ProcessInfo`.
+   * @return The string, valid until the next scan.
+   */
+  std::string_view getString(uint32_t id) const {
+    return metadata_.getString(id);
+  }
+
+  /**
+   * @brief Returns the number of processes collected by the last scan.
+   *
+   * @return The number of table rows.
+   */
+  size_t getProcessCount() const { return processes_.size(); }
+
+  /**
+   * @brief Returns the cost and outcome of the last scan.
+   *
+   * @return The report of the most recent call to `refresh`.
+   */
+  const ScanReport &getScanReport() const { return scanReport_; }
+
+  /**
+   * @brief Returns the events found by the last scan.
+   *
+   * Empty unless `ListOptions::events` was set for this scan and the
+   * previous one; the first scan with events only primes the diff.
+   *
+   * @return The events in PID order.
+   */
+  const std::vector<ProcessEvent> &getEvents() const { return events_; }
+
+  /**
+   * @brief Returns the cost of the last PSS/USS collection.
+   *
+   * @return The report of the most recent scan that selected PSS or USS.
+   */
+  const SmapsReport &getSmapsReport() const { return smapsReport_; }
+
+  /**
+   * @brief Returns the cost of the last NUMA residency collection.
+   *
+   * @return The report of the most recent scan that selected a NUMA column.
+   */
+  const SmapsReport &getNumaReport() const { return numaReport_; }
+
+  /**
+   * @brief Returns the resident memory per node of a process.
+   *
+   * @param pid The process ID.
+   * @return kB indexed by node, or `nullptr` if the last scan did not read
+   * the process's `numa_maps`.
+   */
+  const std::vector<unsigned long long> *getNumaResidency(int pid) const;
 
   /**
    * @brief Fetches the list of all process PIDs.
    *
    * This method reads the `/proc` directory to collect all process IDs (PIDs)
-   * of running processes. It returns a vector of PIDs.
+   * of running processes. It returns a vector of PIDs sorted in ascending
+   * order.
    *
    * @return A vector containing all process PIDs.
    */
   static std::vector<int> getAllPIDs();
 
   /**
-   * @brief Fetches information for a specific process by its PID.
+   * @brief Fetches the sorted PIDs into a caller-provided vector.
+   *
+   * The scan uses this overload with a vector from its arena.
+   *
+   * @param[out] pids Receives the PIDs, replacing the previous contents.
+   */
+  static void getAllPIDs(std::pmr::vector<int> &pids);
+
+  /**
+   * @brief Fetches the sorted thread IDs of a process.
+   *
+   * @param pid The process ID.
+   * @param[out] tids Receives the TIDs from `/proc/<pid>/task`, replacing
+   * the previous contents; empty if the process is gone.
+   */
+  static void getThreadIds(int pid, std::pmr::vector<int> &tids);
+
+  /**
+   * @brief Returns the arena that backs the transient data of each scan.
+   */
+  const ScanArena &getScanArena() const { return arena_; }
+
+  /**
+   * @brief Selects how every listing reads the per-process files.
+   *
+   * With `ScanBackend::IoUring`, scans fall back to the synchronous reads
+   * when io_uring is unavailable, after a warning on standard error.
+   */
+  static void setScanBackend(ScanBackend backend);
+
+  /**
+   * @brief Returns the backend selected with `setScanBackend`.
+   */
+  static ScanBackend getScanBackend();
+
+private:
+  /**
+   * @struct ScanContext
+   * @brief System-wide values shared by every process of a scan.
+   *
+   * These values are read once per scan instead of once per process.
+   */
+  struct ScanContext {
+    unsigned sources = PROC_SOURCE_NONE;  ///< Per-process files to read
+    const ProcessFilter *filter = nullptr; ///< Rows to keep, or `nullptr`
+    bool events = false;                  ///< Whether identities are recorded
+    unsigned long long systemTime = 0;    ///< Total CPU ticks from /proc/stat
+    unsigned long long totalMemoryKb = 0; ///< MemTotal from /proc/meminfo
+    double uptime = 0.0;                  ///< Seconds since boot
+  };
+
+  /**
+   * @struct ScanBuffers
+   * @brief The path and read buffers of one scan thread.
+   *
+   * They live in the scan's arena and are reused for every file the thread
+   * reads, so reading a process allocates nothing.
+   */
+  struct ScanBuffers {
+    std::pmr::string path;     ///< Path of the file being read
+    std::pmr::string contents; ///< Contents of the file being read
+
+    /**
+     * @brief Reserves both buffers in the arena.
+     */
+    explicit ScanBuffers(std::pmr::memory_resource *arena);
+  };
+
+  /// Files the io_uring backend reads ahead: stat, statm, status and io
+  static constexpr size_t PREFETCH_FILE_COUNT = 4;
+
+  /**
+   * @struct Prefetch
+   * @brief The requests of one process in a batch of `uring_`.
+   */
+  struct Prefetch {
+    size_t requests[PREFETCH_FILE_COUNT]; ///< Per file, or `UringReader::NONE`
+    bool rejected = false; ///< The filter rejected it before queuing
+    uint32_t uid = 0;      ///< Owner read for the filter, if any
+    unsigned collected = PROC_SOURCE_NONE; ///< `PROC_SOURCE_OWNER` if read
+  };
+
+  /**
+   * @struct ScanTarget
+   * @brief One row of a scan: a process, or one of its threads.
+   */
+  struct ScanTarget {
+    int pid = 0; ///< Process ID
+    int tid = 0; ///< Thread ID, or 0 for the process itself
+  };
+
+  /**
+   * @struct ProcessSample
+   * @brief Counters kept from the previous scan to compute deltas.
+   */
+  struct ProcessSample {
+    unsigned long long startTime = 0;   ///< Identity check against PID reuse
+    unsigned long long processTime = 0; ///< Process CPU ticks
+    unsigned long long systemTime = 0;  ///< System CPU ticks
+    unsigned long long minorFaults = 0; ///< Minor fault counter
+    unsigned long long majorFaults = 0; ///< Major fault counter
+    double uptime = 0.0;                ///< Seconds since boot at sampling
+    unsigned long long generation = 0;  ///< Scan that produced the sample
+  };
+
+  std::vector<ProcessInfo> processes_; ///< List of processes with their details
+  std::mutex mutex_; ///< Mutex to synchronize access to shared data
+  std::unordered_map<int, ProcessSample>
+      samples_; ///< Previous counters per PID or TID, guarded by `mutex_`
+  unsigned long long generation_ = 0; ///< Number of completed scans
+  std::atomic<size_t> filtered_{0};   ///< Rows rejected by this scan
+  bool threadRows_ = false;           ///< Whether the last scan listed threads
+
+  /**
+   * @struct SmapsSample
+   * @brief A cached PSS/USS reading of a process.
+   */
+  struct SmapsSample {
+    ProcSmaps smaps;                              ///< Parsed values
+    std::chrono::steady_clock::time_point readAt; ///< When it was read
+    unsigned long long generation = 0;            ///< Last scan that saw it
+  };
+
+  std::unordered_map<int, SmapsSample>
+      smapsCache_;                       ///< PSS/USS readings between scans
+  SmapsReport smapsReport_;              ///< Cost of the last PSS/USS scan
+
+  /**
+   * @struct NumaSample
+   * @brief A cached `numa_maps` reading of a process.
+   */
+  struct NumaSample {
+    std::vector<unsigned long long> nodeKb;       ///< Resident kB per node
+    std::chrono::steady_clock::time_point readAt; ///< When it was read
+    unsigned long long generation = 0;            ///< Last scan that saw it
+  };
+
+  std::unordered_map<int, NumaSample>
+      numaCache_;                        ///< numa_maps readings between scans
+  SmapsReport numaReport_;               ///< Cost of the last numa_maps scan
+  ProcessMetadataCache metadata_;        ///< Names, command lines and owners
+  std::vector<int> previousPids_;        ///< Sorted PIDs or TIDs of last scan
+  ScanReport scanReport_;                ///< Cost of the last scan
+  std::vector<ProcessIdentity>
+      identities_;                       ///< This scan's, guarded by `mutex_`
+  std::vector<ProcessIdentity>
+      previousIdentities_;               ///< Last scan's, sorted by PID
+  bool identitiesPrimed_ = false;        ///< Whether the last scan had events
+  double identitiesUptime_ = 0.0;        ///< Uptime of `previousIdentities_`
+  std::vector<ProcessEvent> events_;     ///< Events of the last scan
+  ScanArena arena_;                      ///< Transient data of the scan
+  std::unique_ptr<UringReader> uring_;   ///< Ring of the io_uring backend
+  unsigned long long totalMemoryKb_ = 0; ///< MemTotal, read once
+
+  /**
+   * @brief Reads the system-wide values needed by the selected sources.
    *
-   * This method retrieves the process name, CPU usage, and memory usage for the
-   * given PID. It stores the information in the `processes_` list.
+   * The total memory does not change while the system runs, so it is only
+   * read by the first scan that needs it.
    *
-   * @param pid The PID of the process whose information is to be fetched.
+   * @param sources The per-process sources that will be read.
+   * @return The context shared by all processes of the scan.
    */
-  void fetchProcessInfo(int pid);
+  ScanContext buildScanContext(unsigned sources);
+
+  /**
+   * @brief Fetches information for a specific process or thread.
+   *
+   * This method reads only the procfs files listed in the context's sources
+   * and computes the metrics derived from them. It stores the information in
+   * the `processes_` list. A thread is read from `/proc/<pid>/task/<tid>`
+   * and its CPU usage leaves out the children reaped by the process.
+   *
+   * @param target The process or thread whose information is to be fetched.
+   * @param context The system-wide values of the current scan.
+   * @param buffers The buffers of the calling scan thread.
+   * @param prefetch The process's files already read by `uring_`, or
+   * `nullptr` to read every file here.
+   */
+  void fetchProcessInfo(const ScanTarget &target, const ScanContext &context,
+                        ScanBuffers &buffers,
+                        const Prefetch *prefetch = nullptr);
+
+  /**
+   * @brief Evaluates the filter clauses that need no file.
+   *
+   * PID and TID clauses are decided without a system call; user clauses
+   * after one `stat` of the row's directory, which also fills `uid`.
+   * Rejected rows are counted in `filtered_`.
+   *
+   * @param[in,out] info The row with its IDs set.
+   * @param context The filter of the scan.
+   * @param directory The row's procfs directory.
+   * @return `false` if the filter rejects the row.
+   */
+  bool prefilter(ProcessInfo &info, const ScanContext &context,
+                 const char *directory);
+
+  /**
+   * @brief Fetches the processes with the io_uring backend.
+   *
+   * The stat, statm, status and io files of as many processes as fit in a
+   * batch are read with one submission, then parsed on the calling thread.
+   * Files that do not fit a buffer, and the `fd` directory, are read
+   * synchronously. Rows the filter rejects before reading any file are
+   * not queued.
+   *
+   * @param targets The processes or threads of the scan.
+   * @param context The system-wide values of the scan.
+   * @return `false` if io_uring is unavailable; nothing was fetched then.
+   */
+  bool fetchWithUring(const std::pmr::vector<ScanTarget> &targets,
+                      const ScanContext &context);
+
+  /**
+   * @brief Lists the threads of the given processes.
+   *
+   * Each batch of processes has its `task` directories walked by its own
+   * thread, so a scan of every thread in the system does not wait on one
+   * walk after the other. The threads of a process stay in TID order.
+   *
+   * @param pids The sorted PIDs whose threads are listed.
+   * @param[out] targets Receives one target per thread.
+   */
+  void listThreads(const std::pmr::vector<int> &pids,
+                   std::pmr::vector<ScanTarget> &targets);
 
   /**
    * @brief Fetches the list of processes asynchronously.
    *
    * This method divides the list of PIDs into smaller batches and uses multiple
-   * threads to fetch the process information concurrently.
+   * threads to fetch the process information concurrently, unless the
+   * io_uring backend is selected and available. A thread listing batches
+   * the TIDs instead, so the threads of one large process are read in
+   * parallel too. Samples of
+   * processes that have exited are discarded afterwards, and the PIDs are
+   * merged against the previous scan to count arrivals and departures. The
+   * PID list, the futures and the buffers come from `arena_`, which the
+   * next scan releases in one step.
+   *
+   * @param options Whether to list threads, and of which processes.
+   * @param sources The per-process sources to read.
    */
-  void fetchProcessList();
+  void fetchProcessList(const ListOptions &options, unsigned sources);
 
   /**
-   * @brief Retrieves the name of a process given its PID.
+   * @brief Collects PSS and USS for the largest processes.
    *
-   * This method reads the process name from `/proc/<pid>/comm`.
+   * `smaps_rollup` is expensive for the kernel to produce, so it is only read
+   * for the `limit` processes with the highest RSS, and a reading is reused
+   * until it is older than the smaps refresh interval. The kernel time spent
+   * is recorded in the smaps report.
    *
-   * @param pid The PID of the process.
-   * @return The name of the process.
+   * @param limit The maximum number of processes to collect.
    */
-  std::string getProcessName(int pid);
+  void fetchSmaps(size_t limit);
+
+  /**
+   * @brief Reads the NUMA residency of the largest processes.
+   *
+   * `numa_maps` walks the page tables like `smaps_rollup`, so it is read
+   * the same way: only for the `limit` processes with the largest RSS, and
+   * served from a cache until the reading is older than the smaps refresh
+   * interval.
+   *
+   * @param limit The maximum number of processes to read.
+   */
+  void fetchNumaMaps(size_t limit);
+
+  /**
+   * @brief Diffs the identities of this scan against the previous one.
+   *
+   * Sets `events_` and the churn of the scan report, and logs the events.
+   *
+   * @param context The system-wide values of the current scan.
+   */
+  void diffIdentities(const ScanContext &context);
+
+  /**
+   * @brief Returns the `limit` collected processes with the largest RSS.
+   */
+  std::vector<ProcessInfo *> largestByRss(size_t limit);
+
+  /**
+   * @brief Computes a row's CPU and fault rates and records its new sample.
+   *
+   * With events, the row's identity is recorded too, even if the filter
+   * rejects it later.
+   *
+   * @param id The PID, or the TID of a thread row.
+   * @param stat The parsed contents of the row's `stat` file.
+   * @param[out] info The row whose rates are set.
+   * @param context The system-wide values of the current scan.
+   */
+  void updateSample(int id, const ProcStat &stat, ProcessInfo &info,
+                    const ScanContext &context);
 
   /**
    * @brief Calculates the CPU usage of a process.
    *
-   * This method reads the `/proc/<pid>/stat` file to compute the CPU usage of a
-   * process. It uses the difference in process times to calculate the CPU usage
-   * percentage.
+   * This method uses the difference in process and system times since the
+   * previous sample to calculate the CPU usage percentage. Without a previous
+   * sample, the average since the process started is returned.
    *
-   * @param pid The PID of the process.
+   * @param stat The parsed contents of `/proc/<pid>/stat`.
+   * @param previous The previous sample of the process, or `nullptr`.
+   * @param context The system-wide values of the current scan.
    * @return The CPU usage percentage.
    */
-  double calculateCPUUsage(int pid);
+  static double calculateCPUUsage(const ProcStat &stat,
+                                  const ProcessSample *previous,
+                                  const ScanContext &context);
 
   /**
    * @brief Calculates the memory usage of a process.
    *
-   * This method reads the `/proc/<pid>/statm` file to determine the memory
-   * usage of a process. It compares the process's resident memory with the
-   * total system memory to compute the memory usage percentage.
+   * This method compares the process's resident memory, read from
+   * `/proc/<pid>/statm`, with the total system memory to compute the memory
+   * usage percentage.
    *
-   * @param pid The PID of the process.
+   * @param rssKb The resident set size of the process in kB.
+   * @param context The system-wide values of the current scan.
    * @return The memory usage percentage.
    */
-  double calculateMemoryUsage(int pid);
+  static double calculateMemoryUsage(unsigned long long rssKb,
+                                     const ScanContext &context);
+
+  /**
+   * @brief Calculates the rate of a monotonically increasing counter.
+   *
+   * The rate is computed against the previous sample when available, or as
+   * the average since the process started otherwise.
+   *
+   * @param current The current counter value.
+   * @param previousValue The counter value of the previous sample.
+   * @param previous The previous sample of the process, or `nullptr`.
+   * @param stat The parsed contents of `/proc/<pid>/stat`.
+   * @param context The system-wide values of the current scan.
+   * @return The rate in events per second.
+   */
+  static double calculateRate(unsigned long long current,
+                              unsigned long long previousValue,
+                              const ProcessSample *previous,
+                              const ProcStat &stat,
+                              const ScanContext &context);
 };
 
 #endif // PROCESS_LISTING_H
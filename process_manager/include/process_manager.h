@@ -11,7 +11,17 @@
 #ifndef PROCESS_MANAGER_H
 #define PROCESS_MANAGER_H
 
+#include "cgroup_monitoring.h"
+#include "command_parser.h"
+#include "logger.h"
+#include "process_control.h"
+#include "process_history.h"
+#include "process_listing.h"
+#include "resource_monitoring.h"
+
+#include <memory>
 #include <string>
+#include <vector>
 
 /**
  * @class ProcessManager
@@ -22,15 +32,19 @@
  * monitoring system resources, killing processes, viewing logs, and displaying
  * help information. The program runs in an interactive loop to accept user
  * commands.
+ *
+ * The services behind the commands are owned by the manager for the whole
+ * session and created on first use, so later commands reuse their warm state:
+ * the previous samples rates are computed from, cached metadata and the
+ * monitor's worker threads. Commands are dispatched through a table.
  */
 class ProcessManager {
 public:
   /**
    * @brief Constructor for the ProcessManager class.
    *
-   * Initializes the `ProcessManager` object. This may include setting up
-   * resources like a logger or initializing other components necessary for
-   * process management.
+   * Initializes the `ProcessManager` object. The services used by the
+   * commands are created when a command first needs them.
    */
   ProcessManager();
 
@@ -57,21 +71,183 @@ private:
    *
    * This method repeatedly prompts the user for input, processes the commands
    * entered, and performs the appropriate actions. It continues until the user
-   * decides to exit the program.
+   * enters `exit` or standard input ends.
    */
   void startInteractiveLoop();
 
   /**
    * @brief Handles the user command.
    *
-   * This method parses and processes the user-entered command. It identifies
-   * the command and calls the appropriate functionality, such as listing
-   * processes or terminating a process.
+   * This method parses the user-entered command, looks its name up in the
+   * command table and calls the handler found there.
    *
    * @param command The command entered by the user.
    */
   void handleCommand(const std::string &command);
 
+  /**
+   * @brief An entry of the command table.
+   */
+  struct Command {
+    const char *name; ///< Name typed by the user
+    void (ProcessManager::*handler)(
+        const std::vector<std::string> &args); ///< Runs the command
+  };
+
+  /// Every interactive command, looked up by `handleCommand`
+  static const Command COMMANDS[];
+
+  /**
+   * @brief Handles the `list` command and its options.
+   *
+   * This method parses the `--columns`, `--smaps-top`, `--threads` and
+   * `--watch` options and lists the processes with the selected columns,
+   * either once or as a live view.
+   *
+   * @param args The arguments passed to the `list` command.
+   */
+  void handleListCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Handles the `threads <pid>` command, which takes the options of
+   * `list` after the PID.
+   */
+  void handleThreadsCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Parses the options of `list` and lists the processes or threads.
+   *
+   * @param args The options.
+   * @param options The options the arguments start from.
+   */
+  void listWithOptions(const std::vector<std::string> &args,
+                       ListOptions options);
+
+  /**
+   * @brief Handles the `history <pid>` command with the session's recorder.
+   */
+  void handleHistoryCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Handles the `events` command with the session's recorder.
+   */
+  void handleEventsCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Handles the `monitor` command with the session's monitor.
+   */
+  void handleMonitorCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Handles the `kill <targets>` command.
+   */
+  void handleKillCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Handles the `renice <targets> <niceness>` command.
+   */
+  void handleReniceCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Handles the `ionice <targets> <class>[:<level>]` command.
+   */
+  void handleIoniceCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Handles the `affinity <targets> <cpulist>` command.
+   */
+  void handleAffinityCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Handles the `throttle <targets> <quota|max> [period]` command.
+   */
+  void handleThrottleCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Resolves the targets that start the arguments of a control
+   * command.
+   *
+   * Targets are a comma-separated list of PIDs, or `--filter <expr>`, which
+   * selects the matching processes of a scan with the session's listing.
+   * This process is never a target of a filter.
+   *
+   * @param args The arguments of the command.
+   * @param[out] next The index of the first argument after the targets.
+   * @param[out] pids The target PIDs.
+   * @return `false` after printing the problem if there are none.
+   */
+  bool resolveTargets(const std::vector<std::string> &args, size_t &next,
+                      std::vector<int> &pids);
+
+  /**
+   * @brief Prints and logs how many targets of a batch were changed.
+   *
+   * Nothing is reported for a single target, whose outcome was printed.
+   */
+  void reportBatch(const std::string &action, size_t succeeded,
+                   size_t targets);
+
+  /**
+   * @brief Handles the `cgroups` command with the session's cgroup statistics.
+   */
+  void handleCgroupsCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Handles the `log` command.
+   */
+  void handleLogCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Handles the `stats` command.
+   */
+  void handleStatsCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Handles the `help` command.
+   */
+  void handleHelpCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Handles the `exit` command by ending the interactive loop.
+   */
+  void handleExitCommand(const std::vector<std::string> &args);
+
+  /**
+   * @brief Returns the session's process listing, creating it on first use.
+   */
+  ProcessListing &processListing();
+
+  /**
+   * @brief Returns the session's thread listing, creating it on first use.
+   */
+  ProcessListing &threadListing();
+
+  /**
+   * @brief Returns the session's resource monitor, creating it on first use.
+   */
+  ResourceMonitoring &resourceMonitor();
+
+  /**
+   * @brief Returns the session's cgroup statistics, creating them on first
+   * use.
+   */
+  CgroupMonitoring &cgroupMonitor();
+
+  /**
+   * @brief Returns the session's history recorder, starting it on first use.
+   */
+  HistoryRecorder &historyRecorder();
+
+  /**
+   * @brief Lists the processes of the latest collector daemon sample.
+   *
+   * Unlike a local scan, the daemon's CPU usage is measured over its last
+   * sampling interval, even for the first listing of the session.
+   *
+   * @param socketPath The daemon's socket.
+   */
+  void listFromDaemon(const std::string &socketPath);
+
   /**
    * @brief Displays the help message with available commands.
    *
@@ -79,6 +255,64 @@ private:
    * along with a brief description of each command's functionality.
    */
   void showHelp();
+
+  /**
+   * @brief Splits command lines into a name and arguments.
+   */
+  CommandParser parser_;
+
+  /**
+   * @brief Logger shared by the commands; its file is opened on first use.
+   */
+  Logger logger_;
+
+  /**
+   * @brief Terminates processes for the `kill` command.
+   */
+  ProcessControl processControl_;
+
+  /**
+   * @brief Whether the interactive loop keeps reading commands.
+   */
+  bool running_ = true;
+
+  /**
+   * @brief Resource monitor kept between `monitor` commands.
+   *
+   * Created on first use, so that its worker threads and the previous CPU
+   * sample are reused by later commands.
+   */
+  std::unique_ptr<ResourceMonitoring> resourceMonitor_;
+
+  /**
+   * @brief Cgroup statistics kept between `cgroups` commands.
+   *
+   * Created on first use, so that the hierarchy walk and the previous sample
+   * used for rates are reused by later commands.
+   */
+  std::unique_ptr<CgroupMonitoring> cgroupMonitor_;
+
+  /**
+   * @brief Process listing kept between `list` commands.
+   *
+   * Created on first use, so that CPU and fault rates are computed since the
+   * previous listing and cached metadata is reused.
+   */
+  std::unique_ptr<ProcessListing> processListing_;
+
+  /**
+   * @brief Thread listing kept between `threads` and `list --threads`
+   * commands, so that CPU usage is computed per TID since the previous one.
+   */
+  std::unique_ptr<ProcessListing> threadListing_;
+
+  /**
+   * @brief Background recorder behind the `history` and `events` commands.
+   *
+   * Started by the first of them, so that sessions that never ask for
+   * history do not pay for a scan every few seconds.
+   */
+  std::unique_ptr<HistoryRecorder> historyRecorder_;
 };
 
 #endif // PROCESS_MANAGER_H
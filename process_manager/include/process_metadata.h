@@ -0,0 +1,138 @@
+/**
+ * @file process_metadata.h
+ * @brief Provides a cache of rarely changing per-process metadata.
+ *
+ * This file defines the `ProcessMetadataCache` class, which keeps the name,
+ * command line and owner of every process keyed by its identity (PID and
+ * start time). Strings are interned in a `StringPool` and referenced by 32-bit
+ * ids, so a process that is seen again on the next scan costs neither a file
+ * read nor an allocation for its metadata.
+ */
+
+#ifndef PROCESS_METADATA_H
+#define PROCESS_METADATA_H
+
+#include "string_pool.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * @brief Bit flags for the metadata fields a caller needs.
+ */
+enum MetadataField : unsigned {
+  METADATA_NAME = 1u << 0,    ///< Process name (always available)
+  METADATA_CMDLINE = 1u << 1, ///< Command line from `/proc/<pid>/cmdline`
+  METADATA_USER = 1u << 2     ///< Owner of `/proc/<pid>`
+};
+
+/**
+ * @struct ProcessMetadata
+ * @brief Interned metadata of a process.
+ */
+struct ProcessMetadata {
+  uint32_t nameId = StringPool::EMPTY_ID;    ///< Interned process name
+  uint32_t cmdlineId = StringPool::EMPTY_ID; ///< Interned command line
+  uint32_t userId = StringPool::EMPTY_ID;    ///< Interned user name
+  uint32_t uid = 0;                          ///< Effective user ID
+  unsigned fields = 0;                       ///< `MetadataField` flags set
+};
+
+/**
+ * @class ProcessMetadataCache
+ * @brief A thread-safe cache of process metadata keyed by process identity.
+ *
+ * An entry is reused as long as the PID, the start time and the name reported
+ * by `/proc/<pid>/stat` are unchanged. A new start time means the PID was
+ * reused; a new name with the same start time means the process called
+ * `exec`, which invalidates the command line. The command line and owner are
+ * only read when a caller asks for them.
+ */
+class ProcessMetadataCache {
+public:
+  /**
+   * @brief Returns the metadata of a process, reading it only on a miss.
+   *
+   * @param pid The PID of the process.
+   * @param startTime The start time from `/proc/<pid>/stat`.
+   * @param comm The name from `/proc/<pid>/stat`.
+   * @param fields The `MetadataField` flags that must be resolved.
+   * @param generation The scan the process was seen in.
+   * @return The resolved metadata.
+   */
+  ProcessMetadata resolve(int pid, unsigned long long startTime,
+                          std::string_view comm, unsigned fields,
+                          unsigned long long generation);
+
+  /**
+   * @brief Returns an interned string.
+   *
+   * The returned view stays valid until the next call to `prune`.
+   *
+   * @param id An id from a `ProcessMetadata` returned by `resolve`.
+   * @return The string, or an empty view for unknown ids.
+   */
+  std::string_view getString(uint32_t id) const;
+
+  /**
+   * @brief Drops the entries of processes that were not seen recently.
+   *
+   * When most of the string pool belongs to dropped entries, the pool is
+   * rebuilt with the remaining strings. Ids returned before this call must
+   * then not be used afterwards; `nameId` translates those of the kept
+   * entries.
+   *
+   * @param generation The oldest scan whose entries are kept.
+   * @return `true` if the pool was rebuilt and ids changed.
+   */
+  bool prune(unsigned long long generation);
+
+  /**
+   * @brief Returns the id of a cached process's name.
+   *
+   * @param pid The PID of the process.
+   * @param startTime The start time of the process.
+   * @return The id, or `StringPool::EMPTY_ID` if the process is not cached.
+   */
+  uint32_t nameId(int pid, unsigned long long startTime) const;
+
+  /**
+   * @brief Returns the number of cache hits and misses so far.
+   *
+   * @param[out] hits Lookups served from the cache.
+   * @param[out] misses Lookups that read procfs.
+   */
+  void getCounters(unsigned long long &hits, unsigned long long &misses) const;
+
+private:
+  /**
+   * @struct Entry
+   * @brief A cached process with the scan it was last seen in.
+   */
+  struct Entry {
+    unsigned long long startTime = 0;  ///< Identity check against PID reuse
+    ProcessMetadata metadata;          ///< Interned metadata
+    unsigned long long generation = 0; ///< Last scan that saw the process
+  };
+
+  /**
+   * @brief Interns the user name of a UID, caching the lookup.
+   *
+   * Must be called with `mutex_` held.
+   *
+   * @param uid The user ID.
+   * @return The id of the interned user name.
+   */
+  uint32_t internUser(uint32_t uid);
+
+  mutable std::mutex mutex_;                       ///< Guards all members
+  StringPool pool_;                                ///< Interned strings
+  std::unordered_map<int, Entry> entries_;         ///< Entries by PID
+  std::unordered_map<uint32_t, uint32_t> userNames_; ///< UID to name id
+  unsigned long long hits_ = 0;                    ///< Cache hits
+  unsigned long long misses_ = 0;                  ///< Cache misses
+};
+
+#endif // PROCESS_METADATA_H
@@ -0,0 +1,92 @@
+/**
+ * @file process_watch.h
+ * @brief Provides a live, periodically refreshed view of the process list.
+ *
+ * This file defines the `ProcessWatch` class, which drives `list --watch`. It
+ * refreshes a long-lived `ProcessListing` at a fixed interval, redraws the
+ * table in place and reacts to scroll and sort keys between refreshes.
+ */
+
+#ifndef PROCESS_WATCH_H
+#define PROCESS_WATCH_H
+
+#include "overhead_governor.h"
+#include "process_listing.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @class ProcessWatch
+ * @brief An interactive, in-place view of a `ProcessListing`.
+ *
+ * The listing is kept alive between refreshes, so per-process samples, cached
+ * metadata and PSS/USS readings are reused. Key presses re-sort or scroll the
+ * rows of the last scan without rescanning `/proc`. A status line reports the
+ * cost of the last refresh.
+ *
+ * With a CPU budget, an `OverheadGovernor` measures every refresh cycle and
+ * may stretch the interval, shrink the PSS/USS and NUMA detail or drop
+ * optional columns; the status line then shows what was given up.
+ */
+class ProcessWatch {
+public:
+  /**
+   * @brief Constructs a watch over a listing.
+   *
+   * @param listing The listing to refresh; it must outlive the watch.
+   * @param options The columns to display and collection limits.
+   * @param interval The time between two refreshes.
+   * @param budgetPercent The CPU budget of the whole process, in percent of
+   * one core, or 0 for no budget.
+   */
+  ProcessWatch(ProcessListing &listing, const ListOptions &options,
+               std::chrono::milliseconds interval, double budgetPercent = 0);
+
+  /**
+   * @brief Runs the view until the user quits.
+   *
+   * The terminal is switched to an alternate screen with unbuffered input
+   * for the duration of the call and restored afterwards.
+   */
+  void run();
+
+private:
+  /**
+   * @brief Handles the keys read from the terminal.
+   *
+   * @param input The bytes read, which may contain several keys.
+   * @return `false` if the user asked to quit, `true` otherwise.
+   */
+  bool handleInput(const std::string &input);
+
+  /**
+   * @brief Sorts the rows of the last scan by the selected column.
+   */
+  void applySort();
+
+  /**
+   * @brief Redraws the table and the status line.
+   */
+  void render();
+
+  /**
+   * @brief Returns the number of table rows that fit on the screen.
+   *
+   * @return The number of process rows to display.
+   */
+  size_t visibleRows() const;
+
+  ProcessListing &listing_;                    ///< Kept between refreshes
+  ListOptions options_;                        ///< Columns and limits asked
+  std::chrono::milliseconds interval_;         ///< Time between refreshes
+  std::vector<ProcessColumn> columns_;         ///< Columns of the last refresh
+  ProcessColumn sortColumn_;                   ///< Always among `columns_`
+  bool descending_;                            ///< Sort order
+  size_t scrollOffset_;                        ///< First visible row
+  std::unique_ptr<OverheadGovernor> governor_; ///< Set with a budget
+};
+
+#endif // PROCESS_WATCH_H
@@ -12,8 +12,11 @@
 #ifndef RESOURCE_MONITORING_H
 #define RESOURCE_MONITORING_H
 
+#include "cgroup_monitoring.h"
 #include "data_monitoring.h"
+#include "device_monitoring.h"
 #include "logger.h"
+#include "pressure_monitoring.h"
 #include "thread_pool.h"
 #include <atomic>
 #include <iostream>
@@ -29,6 +32,10 @@
  * like CPU and memory usage. The class supports real-time, parallelized
  * monitoring, with the ability to start and stop the monitoring process via
  * user input.
+ *
+ * The thread pool is created once and reused: `startMonitoring` can be called
+ * again after the monitor was stopped, and the CPU sampler keeps its previous
+ * reading, so later sessions show a rate from the first update.
  */
 class ResourceMonitoring {
 public:
@@ -52,15 +59,16 @@ public:
    * @brief Starts the monitoring process.
    *
    * Initiates parallelized monitoring of CPU and memory usage. The monitoring
-   * runs until the user inputs a command to stop the process.
+   * runs until the user presses Enter or `stopMonitoring` is called, and
+   * returns once every monitoring task has finished.
    */
   void startMonitoring();
 
   /**
    * @brief Stops the monitoring process.
    *
-   * Halts the resource monitoring, stops all running tasks, and performs
-   * necessary cleanup.
+   * Halts the resource monitoring and signals all running tasks to finish.
+   * Does nothing if monitoring is not active.
    */
   void stopMonitoring();
 
@@ -105,8 +113,8 @@ private:
    * @brief Waits for the user to input a command to stop monitoring.
    *
    * The method waits for the user to press Enter to stop the monitoring
-   * process. It listens for the stop signal and coordinates the stopping of
-   * all monitoring tasks.
+   * process. It returns without stopping when monitoring was stopped
+   * elsewhere, or when standard input is exhausted and not a terminal.
    */
   void waitForStopInput();
 
@@ -129,6 +137,29 @@ private:
    */
   void monitorCPUAndMemory();
 
+  /**
+   * @brief Displays the cgroups with the highest CPU usage.
+   *
+   * Refreshes the cgroup statistics and prints a fixed number of rows so
+   * that the panel can be redrawn in place on every update.
+   */
+  void displayCgroupPanel();
+
+  /**
+   * @brief Displays the system-wide stall percentages and stall events.
+   *
+   * Prints a fixed number of rows, like the cgroup panel.
+   */
+  void displayPressurePanel();
+
+  /**
+   * @brief Samples the disk and network counters and displays their rates.
+   *
+   * Prints the busiest disks and interfaces in a fixed number of rows, like
+   * the cgroup panel.
+   */
+  void displayDevicePanels();
+
   // Thread pool for executing parallel tasks
   ThreadPool pool_;
 
@@ -146,6 +177,18 @@ private:
 
   // Data monitoring object for collecting resource usage data
   DataMonitoring dataMonitor;
+
+  // Cgroup v2 statistics, refreshed on every display update
+  CgroupMonitoring cgroupMonitor_;
+
+  // Disk and network rates, sampled on every display update
+  DeviceMonitoring deviceMonitor_;
+
+  // PSI readings and the triggers waited on while monitoring
+  PressureMonitoring pressureMonitor_;
+
+  // Whether the kernel reports PSI, checked when monitoring starts
+  bool pressureAvailable_;
 };
 
 #endif // RESOURCE_MONITORING_H
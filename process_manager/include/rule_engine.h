@@ -0,0 +1,268 @@
+/**
+ * @file rule_engine.h
+ * @brief Compiles and evaluates declarative threshold rules.
+ *
+ * This file defines the `RuleEngine` class, which reads rules such as
+ *
+ * @code
+ * # name: metric(scope) comparison threshold [for DURATION] [clear VALUE]
+ * #       -> action[, action...]
+ * hog:    cpu(pid) > 90 for 30s clear 50 -> log, renice 10
+ * leak:   rss(pid) >= 4G -> kill TERM
+ * full:   mem(system) > 95 -> log
+ * @endcode
+ *
+ * compiles them into a flat program and evaluates it against every new
+ * sample. A rule fires once when its condition has held for the duration
+ * and re-arms only after the value has crossed back over the `clear` value
+ * (by default the threshold itself), so a value hovering around the
+ * threshold does not repeat the actions.
+ */
+
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include "process_listing.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief The value a rule compares.
+ */
+enum class RuleMetric : uint8_t {
+  Cpu,     ///< CPU usage percentage
+  Memory,  ///< Memory usage percentage
+  Rss,     ///< Resident set size in bytes (processes only)
+  Threads, ///< Number of threads (processes only)
+};
+
+/// Number of `RuleMetric` values
+constexpr size_t RULE_METRIC_COUNT = 4;
+
+/**
+ * @brief What a rule is evaluated for.
+ */
+enum class RuleScope : uint8_t {
+  Process, ///< Every process, written `pid`
+  System,  ///< The whole system, written `system`
+};
+
+/**
+ * @brief How a value is compared with the threshold.
+ */
+enum class RuleComparison : uint8_t { Greater, GreaterEqual, Less, LessEqual };
+
+/**
+ * @brief What happens when a rule fires.
+ */
+enum class RuleActionType : uint8_t {
+  Log,    ///< Log a warning
+  Renice, ///< Set the niceness of the process
+  Kill,   ///< Send a signal to the process
+};
+
+/**
+ * @struct RuleAction
+ * @brief One action of a rule.
+ */
+struct RuleAction {
+  RuleActionType type = RuleActionType::Log; ///< What to do
+  int argument = 0; ///< Niceness for `Renice`, signal for `Kill`
+};
+
+/**
+ * @struct Rule
+ * @brief A compiled rule.
+ */
+struct Rule {
+  std::string name;                                    ///< Name or `ruleN`
+  RuleMetric metric = RuleMetric::Cpu;                 ///< Compared value
+  RuleScope scope = RuleScope::Process;                ///< Evaluated for
+  RuleComparison comparison = RuleComparison::Greater; ///< Comparison
+  double threshold = 0.0;                              ///< Fires beyond this
+  double clear = 0.0;                                  ///< Re-arms beyond this
+  std::chrono::milliseconds duration{0};               ///< Time to hold
+  std::vector<RuleAction> actions;                     ///< Run when firing
+  std::string text;                                    ///< Canonical form
+};
+
+/**
+ * @struct RuleSystemSample
+ * @brief The system-wide values rules with the `system` scope compare.
+ */
+struct RuleSystemSample {
+  double cpuUsage = 0.0;    ///< System CPU usage percentage
+  double memoryUsage = 0.0; ///< System memory usage percentage
+};
+
+/**
+ * @struct RuleFiring
+ * @brief A rule whose condition has held for its duration.
+ */
+struct RuleFiring {
+  uint32_t rule = 0;  ///< Index into `RuleEngine::rules()`
+  int pid = 0;        ///< Process, or 0 for the `system` scope
+  double value = 0.0; ///< Value that fired the rule
+  size_t process = 0; ///< Index into the evaluated processes, if any
+};
+
+/**
+ * @class RuleEngine
+ * @brief Evaluates compiled rules incrementally, one sample at a time.
+ *
+ * Rules are grouped by scope and metric; within a group, the rules that fire
+ * above a threshold are sorted by ascending threshold and those that fire
+ * below one by descending threshold. Each value therefore only visits the
+ * rules it matches plus one, so hundreds of rules cost about as much per
+ * process as a single one. Per-rule state is only kept for the (rule,
+ * process) pairs whose condition holds or whose rule has fired, and is
+ * dropped with the process.
+ *
+ * The engine only decides what fires; `RuleActions` carries the actions out.
+ */
+class RuleEngine {
+public:
+  /**
+   * @brief Compiles rules, one per line; `#` starts a comment.
+   *
+   * @param source The rules.
+   * @param[out] error The first problem, with its line number, on failure.
+   * @return `true` if every rule compiled, `false` otherwise.
+   */
+  bool compile(const std::string &source, std::string &error);
+
+  /**
+   * @brief Compiles the rules of a file.
+   *
+   * @param path The file.
+   * @param[out] error The problem on failure.
+   * @return `true` if every rule compiled, `false` otherwise.
+   */
+  bool load(const std::string &path, std::string &error);
+
+  /**
+   * @brief Evaluates the rules against a new sample.
+   *
+   * @param now The time of the sample.
+   * @param processes The processes of the sample; only the values rules
+   * refer to need to be collected.
+   * @param system The system-wide values of the sample.
+   * @param[out] firings The rules that fired with this sample.
+   */
+  void evaluate(std::chrono::steady_clock::time_point now,
+                const std::vector<ProcessInfo> &processes,
+                const RuleSystemSample &system,
+                std::vector<RuleFiring> &firings);
+
+  /**
+   * @brief Returns the compiled rules.
+   */
+  const std::vector<Rule> &rules() const { return rules_; }
+
+  /**
+   * @brief Returns the `ProcSource` flags the process rules need.
+   */
+  unsigned requiredSources() const;
+
+  /**
+   * @brief Describes a rule in its canonical form, e.g. for logging.
+   */
+  static std::string describe(const Rule &rule);
+
+  /**
+   * @brief Returns the name of a metric as written in rules.
+   */
+  static const char *metricName(RuleMetric metric);
+
+private:
+  /**
+   * @struct Instruction
+   * @brief One comparison of the flat program.
+   */
+  struct Instruction {
+    double threshold = 0.0; ///< Value compared with
+    uint32_t rule = 0;      ///< Rule the comparison belongs to
+    bool inclusive = false; ///< Matches a value equal to the threshold
+  };
+
+  /**
+   * @struct State
+   * @brief Hysteresis state of one rule for one process.
+   */
+  struct State {
+    std::chrono::steady_clock::time_point since; ///< Condition first held
+    uint64_t matched = 0; ///< Last sample the condition held
+    uint64_t held = 0;    ///< Last sample the clear condition held
+    bool fired = false;   ///< Actions ran; waiting to clear
+    double value = 0.0;   ///< Last matching value
+    size_t process = 0;   ///< Index of the process in the last match
+    unsigned long long startTime = 0; ///< Identity check against PID reuse
+  };
+
+  /**
+   * @brief Returns the program slot of a scope, metric and direction.
+   */
+  static size_t group(RuleScope scope, RuleMetric metric, bool rising);
+
+  /**
+   * @brief Returns the program slot of a rule.
+   */
+  static size_t slotOf(const Rule &rule);
+
+  /**
+   * @brief Compiles one rule, without its name.
+   */
+  static bool compileRule(const std::string &text, Rule &rule,
+                          std::string &error);
+
+  /**
+   * @brief Runs the rising and falling groups of a metric against a value.
+   */
+  void runMetric(RuleScope scope, RuleMetric metric, double value, int pid);
+
+  /**
+   * @brief Runs the instructions of a group against one value.
+   */
+  void run(size_t slot, double value, int pid);
+
+  /**
+   * @brief Returns the key of the state of a rule for a process.
+   */
+  static uint64_t key(uint32_t rule, int pid) {
+    return (uint64_t{rule} << 32) | static_cast<uint32_t>(pid);
+  }
+
+  std::vector<Rule> rules_;                            ///< Compiled rules
+  std::vector<std::vector<Instruction>> program_;      ///< Matches by group
+  std::vector<std::vector<Instruction>> clearProgram_; ///< Clears by group
+  std::vector<uint32_t> firedCounts_;                  ///< Fired per group
+  std::unordered_map<uint64_t, State> states_; ///< States by rule and PID
+  uint64_t generation_ = 0;                    ///< Samples evaluated
+  std::chrono::steady_clock::time_point now_;  ///< Time of the sample
+  size_t index_ = 0;                           ///< Process evaluated
+  unsigned long long startTime_ = 0;           ///< Its start time
+};
+
+/**
+ * @class RuleActions
+ * @brief Carries out the actions of fired rules.
+ */
+class RuleActions {
+public:
+  /**
+   * @brief Runs the actions of a fired rule and logs what was done.
+   *
+   * @param rule The rule.
+   * @param firing The firing.
+   * @param name The name of the process, or empty for the `system` scope.
+   * @param dryRun Only log the actions instead of running them.
+   */
+  static void execute(const Rule &rule, const RuleFiring &firing,
+                      const std::string &name, bool dryRun);
+};
+
+#endif // RULE_ENGINE_H
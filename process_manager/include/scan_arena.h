@@ -0,0 +1,94 @@
+/**
+ * @file scan_arena.h
+ * @brief Provides the memory arena that backs the transient data of a scan.
+ *
+ * This file defines the `ScanArena` class, a `std::pmr::memory_resource`
+ * that hands out memory from one buffer and releases all of it at once. A
+ * scan allocates its PID list, its path and read buffers and its futures
+ * from the arena; starting the next scan releases them together instead of
+ * freeing them one by one.
+ */
+
+#ifndef SCAN_ARENA_H
+#define SCAN_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+
+/**
+ * @class ScanArena
+ * @brief A thread-safe monotonic arena that is recycled between scans.
+ *
+ * Allocations bump a pointer inside a buffer the arena owns; deallocations
+ * do nothing. `reset` starts a new epoch: everything allocated before is
+ * released in constant time and the buffer is reused. When an epoch needed
+ * more than the buffer, the overflow comes from the heap and the buffer is
+ * grown to the high-water mark at the next `reset`, so a steady workload
+ * stops touching the heap after its first scan.
+ *
+ * The arena is shared by the scan threads, so allocations take a lock.
+ * Containers should reserve their size up front to keep them rare.
+ */
+class ScanArena : public std::pmr::memory_resource {
+public:
+  /**
+   * @brief Constructs an arena; the buffer is allocated by the first `reset`.
+   *
+   * @param initialSize The size of the first buffer in bytes.
+   */
+  explicit ScanArena(size_t initialSize = DEFAULT_SIZE);
+
+  ScanArena(const ScanArena &) = delete;
+  ScanArena &operator=(const ScanArena &) = delete;
+
+  /**
+   * @brief Releases everything allocated so far and starts a new epoch.
+   *
+   * Nothing allocated from the arena may be used afterwards.
+   */
+  void reset();
+
+  /**
+   * @brief Returns the bytes allocated in the current epoch.
+   */
+  size_t epochBytes() const;
+
+  /**
+   * @brief Returns the size of the owned buffer in bytes.
+   */
+  size_t capacity() const;
+
+  /**
+   * @brief Returns the number of epochs that needed more than the buffer.
+   */
+  size_t overflows() const;
+
+  /// Size of the first buffer, enough for a scan of a few hundred processes
+  static constexpr size_t DEFAULT_SIZE = 256 * 1024;
+
+private:
+  /**
+   * @brief Replaces the buffer with one of `nextCapacity_` bytes; the caller
+   * holds `mutex_`.
+   */
+  void rebuild();
+
+  void *do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void *memory, size_t bytes, size_t alignment) override;
+  bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override;
+
+  mutable std::mutex mutex_;            ///< Serializes the scan threads
+  std::unique_ptr<std::byte[]> buffer_; ///< Memory reused by every epoch
+  size_t capacity_ = 0;                 ///< Size of `buffer_`
+  size_t nextCapacity_;                 ///< Size `reset` makes the buffer
+  size_t epochBytes_ = 0;               ///< Bytes allocated in this epoch
+  size_t overflows_ = 0;                ///< Epochs that spilled to the heap
+  std::optional<std::pmr::monotonic_buffer_resource>
+      arena_; ///< Bump allocator over `buffer_`
+};
+
+#endif // SCAN_ARENA_H
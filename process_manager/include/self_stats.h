@@ -0,0 +1,213 @@
+/**
+ * @file self_stats.h
+ * @brief Measures what the process manager itself costs.
+ *
+ * This file defines the `SelfStats` class, which keeps counters (files
+ * opened, bytes read, system calls, ...), gauges (queue depths) and latency
+ * histograms (scan phases, thread pool queue wait, log writes) of the
+ * running process. Recording is meant for hot paths: every thread writes to
+ * its own shard without locks or atomic read-modify-write operations, and
+ * only `snapshot` walks the shards. The `stats` command, the JSON output of
+ * `list` and the Prometheus exporter show the numbers.
+ */
+
+#ifndef SELF_STATS_H
+#define SELF_STATS_H
+
+#include "output_buffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Monotonic event counters.
+ */
+enum class SelfCounter : uint8_t {
+  Scans,            ///< Process table scans
+  ProcessesScanned, ///< Processes collected by those scans
+  FilesOpened,      ///< procfs files and directories opened
+  BytesRead,        ///< Bytes read from procfs
+  Syscalls,         ///< open, read, close and getdents calls issued
+  PoolTasks,        ///< Tasks run by thread pools
+  LogMessages,      ///< Messages written to the log
+};
+
+/// Number of `SelfCounter` values
+constexpr size_t SELF_COUNTER_COUNT = 7;
+
+/**
+ * @brief Values that go up and down; the peak is kept as well.
+ */
+enum class SelfGauge : uint8_t {
+  PoolQueueDepth,   ///< Tasks waiting in thread pool queues
+  LoggerQueueDepth, ///< Messages waiting for the log file
+};
+
+/// Number of `SelfGauge` values
+constexpr size_t SELF_GAUGE_COUNT = 2;
+
+/**
+ * @brief Latencies recorded into histograms.
+ */
+enum class SelfTimer : uint8_t {
+  Enumerate, ///< Listing the PIDs of a scan
+  Read,      ///< Reading one procfs file or directory
+  Parse,     ///< Parsing one procfs file
+  Compute,   ///< Merging a scan: usage, rates and sorting
+  Render,    ///< Formatting a table or document for output
+  PoolWait,  ///< Time a task waited in a thread pool queue
+  LogWrite,  ///< Writing one log message
+};
+
+/// Number of `SelfTimer` values
+constexpr size_t SELF_TIMER_COUNT = 7;
+
+/// Buckets per histogram; bucket 0 holds values below 128 ns and bucket `i`
+/// values below 2^(i + 7) ns, the last one everything above
+constexpr size_t SELF_HISTOGRAM_BUCKETS = 32;
+
+/**
+ * @struct SelfHistogram
+ * @brief A latency histogram with power-of-two buckets.
+ */
+struct SelfHistogram {
+  std::string name;              ///< Timer name, e.g. `read`
+  uint64_t count = 0;            ///< Recorded values
+  uint64_t sumNs = 0;            ///< Sum of the values
+  uint64_t maxNs = 0;            ///< Largest value
+  std::vector<uint64_t> buckets; ///< `SELF_HISTOGRAM_BUCKETS` counts
+
+  /**
+   * @brief Estimates a quantile as the upper bound of its bucket.
+   *
+   * @param quantile The quantile, e.g. 0.99.
+   * @return The estimate in nanoseconds, at most `maxNs`.
+   */
+  uint64_t quantileNs(double quantile) const;
+};
+
+/**
+ * @struct SelfGaugeValue
+ * @brief The current and peak value of a gauge.
+ */
+struct SelfGaugeValue {
+  std::string name;  ///< Gauge name
+  int64_t value = 0; ///< Current value
+  int64_t peak = 0;  ///< Largest value seen
+};
+
+/**
+ * @struct SelfStatsSnapshot
+ * @brief Everything `SelfStats` measured up to one point in time.
+ */
+struct SelfStatsSnapshot {
+  uint64_t uptimeMs = 0;  ///< Time since the first recording
+  uint64_t cpuTimeUs = 0; ///< User and system CPU time of the process
+  uint64_t maxRssKb = 0;  ///< Peak resident set size of the process
+  std::vector<std::pair<std::string, uint64_t>> counters; ///< By name
+  std::vector<SelfGaugeValue> gauges;                     ///< By name
+  std::vector<SelfHistogram> histograms;                  ///< By name
+};
+
+/**
+ * @class SelfStats
+ * @brief Records and reports the cost of the process manager itself.
+ *
+ * Counters and histograms live in per-thread shards that are folded into a
+ * shared total when their thread exits. A shard is only written by its
+ * thread, with relaxed loads and stores, so recording costs a few
+ * instructions; `snapshot` sums the shards under a lock and may be a few
+ * events behind concurrent recordings. Gauges are shared atomics because
+ * their users already synchronize.
+ */
+class SelfStats {
+public:
+  /**
+   * @brief Adds to a counter.
+   */
+  static void add(SelfCounter counter, uint64_t value = 1);
+
+  /**
+   * @brief Records a latency.
+   *
+   * @param timer The histogram.
+   * @param nanoseconds The latency.
+   */
+  static void record(SelfTimer timer, uint64_t nanoseconds);
+
+  /**
+   * @brief Moves a gauge, updating its peak.
+   */
+  static void adjust(SelfGauge gauge, int64_t delta);
+
+  /**
+   * @brief Returns a monotonic timestamp in nanoseconds for `record`.
+   */
+  static uint64_t now();
+
+  /**
+   * @brief Collects the values of every thread and of the process.
+   */
+  static SelfStatsSnapshot snapshot();
+
+  /**
+   * @brief Clears every counter, gauge peak and histogram, e.g. in tests.
+   */
+  static void reset();
+
+  /**
+   * @brief Prints a snapshot as a human-readable report.
+   */
+  static void writeTable(std::ostream &out, const SelfStatsSnapshot &stats);
+
+  /**
+   * @brief Appends a snapshot as a JSON object.
+   */
+  static void writeJson(OutputBuffer &out, const SelfStatsSnapshot &stats);
+
+  /**
+   * @brief Returns the name of a counter, e.g. `files_opened`.
+   */
+  static const char *counterName(SelfCounter counter);
+
+  /**
+   * @brief Returns the name of a gauge, e.g. `pool_queue_depth`.
+   */
+  static const char *gaugeName(SelfGauge gauge);
+
+  /**
+   * @brief Returns the name of a timer, e.g. `parse`.
+   */
+  static const char *timerName(SelfTimer timer);
+};
+
+/**
+ * @class SelfTimerScope
+ * @brief Records the lifetime of a scope into a histogram.
+ */
+class SelfTimerScope {
+public:
+  /**
+   * @brief Starts timing.
+   */
+  explicit SelfTimerScope(SelfTimer timer)
+      : timer_(timer), start_(SelfStats::now()) {}
+
+  /**
+   * @brief Records the elapsed time.
+   */
+  ~SelfTimerScope() { SelfStats::record(timer_, SelfStats::now() - start_); }
+
+  SelfTimerScope(const SelfTimerScope &) = delete;
+  SelfTimerScope &operator=(const SelfTimerScope &) = delete;
+
+private:
+  SelfTimer timer_; ///< Histogram recorded into
+  uint64_t start_;  ///< Start of the scope
+};
+
+#endif // SELF_STATS_H
@@ -0,0 +1,261 @@
+/**
+ * @file shm_snapshot.h
+ * @brief Publishes process snapshots in POSIX shared memory.
+ *
+ * This file defines the layout of the shared-memory segment written by the
+ * collector daemon, the `ShmSnapshotWriter` that fills it and the
+ * `ShmSnapshotReader` that local processes use to read it in place. Reading
+ * a snapshot takes no system call and no copy: a reader maps the segment
+ * once and then only loads from memory.
+ *
+ * The segment starts with a `ShmHeader`, followed by `ShmHeader::slotCount`
+ * slots. Each slot is a `ShmSlotHeader` followed by `slotCapacity` records.
+ * The writer fills the slot after the current one and then publishes its
+ * index, so with three slots a snapshot stays intact until two newer ones
+ * have been published. Each slot carries a sequence counter
+ * that is odd while the slot is being written (a seqlock); a reader checks
+ * that the counter is even and unchanged after reading.
+ */
+
+#ifndef SHM_SNAPSHOT_H
+#define SHM_SNAPSHOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Identifies a process_manager segment ("PMSH")
+constexpr uint32_t SHM_SNAPSHOT_MAGIC = 0x48534d50;
+/// Incremented whenever the layout changes incompatibly
+constexpr uint16_t SHM_SNAPSHOT_VERSION = 1;
+/// Characters of a process name, including the terminating NUL
+constexpr size_t SHM_NAME_LENGTH = 16;
+
+/**
+ * @struct ShmHeader
+ * @brief Describes the segment; written once before `magic` is set.
+ */
+struct ShmHeader {
+  std::atomic<uint32_t> magic;       ///< `SHM_SNAPSHOT_MAGIC` once ready
+  uint16_t version;                  ///< `SHM_SNAPSHOT_VERSION`
+  uint16_t headerSize;               ///< `sizeof(ShmHeader)`
+  uint32_t slotCount;                ///< Number of slots
+  uint32_t slotHeaderSize;           ///< `sizeof(ShmSlotHeader)`
+  uint32_t recordSize;               ///< `sizeof(ShmProcessRecord)`
+  uint32_t slotCapacity;             ///< Records per slot
+  uint64_t slotSize;                 ///< Bytes per slot
+  std::atomic<uint32_t> currentSlot; ///< Slot of the newest snapshot
+  std::atomic<uint32_t> writerPid;   ///< PID of the publishing process
+};
+
+/**
+ * @struct ShmSystemSample
+ * @brief The system-wide values of a snapshot.
+ */
+struct ShmSystemSample {
+  uint64_t generation = 0;     ///< Sample counter of the writer
+  uint64_t timestampMs = 0;    ///< Wall-clock time of the sample
+  double cpuUsage = 0.0;       ///< System CPU usage percentage
+  double memoryUsage = 0.0;    ///< System memory usage percentage
+  uint64_t memTotalKb = 0;     ///< MemTotal from /proc/meminfo
+  uint64_t memAvailableKb = 0; ///< MemAvailable from /proc/meminfo
+  uint32_t processCount = 0;   ///< Processes on the system
+  uint32_t recordCount = 0;    ///< Records stored, at most the capacity
+};
+
+/**
+ * @struct ShmSlotHeader
+ * @brief The start of a slot: its seqlock and the snapshot's system values.
+ */
+struct ShmSlotHeader {
+  std::atomic<uint64_t> sequence; ///< Odd while the slot is written
+  ShmSystemSample system;         ///< System-wide values
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "Shared-memory counters must be lock-free");
+
+/**
+ * @struct ShmProcessRecord
+ * @brief One process of a snapshot; records are sorted by CPU usage.
+ */
+struct ShmProcessRecord {
+  int32_t pid;                ///< Process ID
+  uint32_t threads;           ///< Number of threads
+  double cpuUsage;            ///< CPU usage percentage
+  double memoryUsage;         ///< Memory usage percentage
+  uint64_t rssKb;             ///< Resident set size in kB
+  char name[SHM_NAME_LENGTH]; ///< NUL-terminated process name
+};
+
+/**
+ * @class ShmSnapshotWriter
+ * @brief Creates a segment and publishes snapshots into it.
+ *
+ * Only one process may write a segment. Fill the records returned by
+ * `beginWrite`, then call `commit`.
+ */
+class ShmSnapshotWriter {
+public:
+  static constexpr uint32_t SLOT_COUNT = 3; ///< Triple buffering
+
+  /**
+   * @brief Constructs a writer without a segment.
+   */
+  ShmSnapshotWriter();
+
+  /**
+   * @brief Unmaps and removes the segment.
+   */
+  ~ShmSnapshotWriter();
+
+  ShmSnapshotWriter(const ShmSnapshotWriter &) = delete;
+  ShmSnapshotWriter &operator=(const ShmSnapshotWriter &) = delete;
+
+  /**
+   * @brief Returns the segment name used when none is given.
+   *
+   * @return `/process_manager-<uid>`, so users do not share a segment.
+   */
+  static std::string defaultName();
+
+  /**
+   * @brief Creates (or replaces) a segment.
+   *
+   * @param name The segment name, starting with `/`.
+   * @param capacity The maximum number of records per snapshot.
+   * @param[out] error A description of the problem on failure.
+   * @return `true` if the segment is ready, `false` otherwise.
+   */
+  bool create(const std::string &name, uint32_t capacity, std::string &error);
+
+  /**
+   * @brief Starts writing the next snapshot.
+   *
+   * @return The records of the slot being written; `capacity()` of them
+   * may be filled.
+   */
+  ShmProcessRecord *beginWrite();
+
+  /**
+   * @brief Finishes the snapshot started by `beginWrite` and publishes it.
+   *
+   * @param system The system-wide values, with `recordCount` set to the
+   * number of records filled.
+   */
+  void commit(const ShmSystemSample &system);
+
+  /**
+   * @brief Returns the number of records a snapshot can hold.
+   */
+  uint32_t capacity() const { return capacity_; }
+
+private:
+  /**
+   * @brief Returns the header of a slot.
+   */
+  ShmSlotHeader *slot(uint32_t index) const;
+
+  std::string name_;     ///< Segment name, for unlinking
+  void *mapping_;        ///< Mapped segment, or `nullptr`
+  size_t size_;          ///< Size of the mapping
+  uint32_t capacity_;    ///< Records per slot
+  uint32_t writingSlot_; ///< Slot filled by the current write
+};
+
+/**
+ * @struct ShmSnapshotView
+ * @brief A snapshot read in place; valid until `ShmSnapshotReader::validate`
+ * says otherwise.
+ */
+struct ShmSnapshotView {
+  const ShmSlotHeader *slot = nullptr;       ///< Slot holding the snapshot
+  const ShmSystemSample *system = nullptr;   ///< System-wide values
+  const ShmProcessRecord *records = nullptr; ///< `recordCount` records
+  uint32_t recordCount = 0;                  ///< Records in the view
+  uint64_t sequence = 0;                     ///< Slot sequence when read
+};
+
+/**
+ * @class ShmSnapshotReader
+ * @brief Maps a segment read-only and reads snapshots without copying.
+ *
+ * Typical use:
+ *
+ * @code
+ * ShmSnapshotView view;
+ * do {
+ *   if (!reader.acquire(view)) { ... }
+ *   // use view.system and view.records
+ * } while (!reader.validate(view));
+ * @endcode
+ *
+ * Any values computed from the view must be discarded when `validate` fails,
+ * because the writer may have overwritten the slot while they were read.
+ */
+class ShmSnapshotReader {
+public:
+  /**
+   * @brief Constructs a reader without a segment.
+   */
+  ShmSnapshotReader();
+
+  /**
+   * @brief Unmaps the segment.
+   */
+  ~ShmSnapshotReader();
+
+  ShmSnapshotReader(const ShmSnapshotReader &) = delete;
+  ShmSnapshotReader &operator=(const ShmSnapshotReader &) = delete;
+
+  /**
+   * @brief Maps a segment created by a writer.
+   *
+   * @param name The segment name, starting with `/`.
+   * @param[out] error A description of the problem on failure, including a
+   * layout version this reader does not understand.
+   * @return `true` if the segment is mapped, `false` otherwise.
+   */
+  bool open(const std::string &name, std::string &error);
+
+  /**
+   * @brief Points a view at the newest snapshot.
+   *
+   * @param[out] view The view.
+   * @return `false` if the newest slot is being written; try again.
+   */
+  bool acquire(ShmSnapshotView &view) const;
+
+  /**
+   * @brief Checks that a view was not overwritten while it was used.
+   *
+   * @param view A view filled by `acquire`.
+   * @return `true` if everything read through the view is consistent.
+   */
+  bool validate(const ShmSnapshotView &view) const;
+
+  /**
+   * @brief Copies the newest snapshot, retrying until it is consistent.
+   *
+   * @param[out] system The system-wide values.
+   * @param[out] records The process records.
+   * @return `false` if no consistent snapshot could be read.
+   */
+  bool copy(ShmSystemSample &system,
+            std::vector<ShmProcessRecord> &records) const;
+
+  /**
+   * @brief Returns the header of the mapped segment.
+   */
+  const ShmHeader *header() const {
+    return static_cast<const ShmHeader *>(mapping_);
+  }
+
+private:
+  const void *mapping_; ///< Mapped segment, or `nullptr`
+  size_t size_;         ///< Size of the mapping
+};
+
+#endif // SHM_SNAPSHOT_H
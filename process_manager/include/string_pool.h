@@ -0,0 +1,90 @@
+/**
+ * @file string_pool.h
+ * @brief Provides an arena-backed pool of interned strings.
+ *
+ * This file defines the `StringPool` class, which stores every distinct string
+ * once in large arena blocks and hands out 32-bit ids. Process tables store
+ * these ids instead of owning a `std::string` per row, so rescanning the same
+ * processes does not allocate.
+ */
+
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class StringPool
+ * @brief An append-only pool of interned strings referenced by id.
+ *
+ * Strings are copied into fixed-size arena blocks that are never moved, so
+ * the views returned by `get` stay valid for the lifetime of the pool. The
+ * pool is not thread-safe; callers serialize access.
+ */
+class StringPool {
+public:
+  /// Id returned for the empty string and for unknown values
+  static constexpr uint32_t EMPTY_ID = 0;
+
+  /**
+   * @brief Constructs an empty pool.
+   *
+   * The empty string is always interned with `EMPTY_ID`.
+   */
+  StringPool();
+
+  /**
+   * @brief Interns a string.
+   *
+   * If an equal string is already in the pool, its id is returned and
+   * nothing is copied.
+   *
+   * @param value The string to intern.
+   * @return The id of the interned string.
+   */
+  uint32_t intern(std::string_view value);
+
+  /**
+   * @brief Returns the string with the given id.
+   *
+   * @param id An id previously returned by `intern`.
+   * @return A view of the interned string, or an empty view for unknown ids.
+   */
+  std::string_view get(uint32_t id) const;
+
+  /**
+   * @brief Returns the number of bytes stored in the arena.
+   *
+   * @return The total length of all interned strings.
+   */
+  size_t bytesUsed() const { return bytesUsed_; }
+
+  /**
+   * @brief Returns the number of interned strings.
+   *
+   * @return The number of distinct strings, including the empty string.
+   */
+  size_t size() const { return strings_.size(); }
+
+private:
+  /**
+   * @brief Copies a string into the arena.
+   *
+   * @param value The string to copy.
+   * @return A view of the copy.
+   */
+  std::string_view store(std::string_view value);
+
+  std::vector<std::unique_ptr<char[]>> blocks_; ///< Arena blocks
+  size_t blockUsed_;                            ///< Bytes used in last block
+  size_t blockCapacity_;                        ///< Capacity of last block
+  size_t bytesUsed_;                            ///< Bytes used in all blocks
+  std::vector<std::string_view> strings_;       ///< Interned strings by id
+  std::unordered_map<std::string_view, uint32_t> ids_; ///< Reverse lookup
+};
+
+#endif // STRING_POOL_H
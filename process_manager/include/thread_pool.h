@@ -12,6 +12,8 @@
 #ifndef THREAD_POOL_H
 #define THREAD_POOL_H
 
+#include "self_stats.h"
+
 #include <atomic>
 #include <condition_variable>
 #include <functional>
@@ -69,7 +71,8 @@ public:
   /**
    * @brief Waits for all tasks to complete.
    *
-   * Blocks the caller until all tasks in the queue have been completed.
+   * Blocks the caller until every task enqueued so far, queued or running,
+   * has returned. Must not be called from a task of the same pool.
    */
   void waitForAll();
 
@@ -82,11 +85,19 @@ private:
    */
   void worker();
 
+  /**
+   * @brief A queued task and the time it was enqueued, for `SelfStats`.
+   */
+  struct Task {
+    std::function<void()> run;
+    uint64_t enqueuedAt = 0;
+  };
+
   // Vector to store worker threads
   std::vector<std::thread> workers_;
 
   // Queue to hold tasks
-  std::queue<std::function<void()>> tasks_;
+  std::queue<Task> tasks_;
 
   // Mutex for protecting access to task queue
   std::mutex tasksMutex_;
@@ -97,16 +108,23 @@ private:
   // Flag to indicate whether the pool is stopped
   std::atomic<bool> stop_;
 
-  // Atomic counter to track active tasks
-  std::atomic<int> activeTasks_;
+  // Tasks enqueued and not yet finished, guarded by `tasksMutex_`
+  int activeTasks_;
+
+  // Condition variable to notify `waitForAll` that the pool is idle
+  std::condition_variable idle_;
 };
 
 // Template function definition inside the header
 template <typename F> void ThreadPool::enqueue(F &&f) {
   {
     std::lock_guard<std::mutex> lock(tasksMutex_);
-    tasks_.emplace(std::forward<F>(f)); // Add the task to the queue
+    // Add the task to the queue; it counts as active until it has run
+    ++activeTasks_;
+    tasks_.push(Task{std::function<void()>(std::forward<F>(f)),
+                     SelfStats::now()});
   }
+  SelfStats::adjust(SelfGauge::PoolQueueDepth, 1);
   cv_.notify_one(); // Notify one thread that a new task is available
 }
 
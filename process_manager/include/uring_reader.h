@@ -0,0 +1,178 @@
+/**
+ * @file uring_reader.h
+ * @brief Reads many small files with a few io_uring system calls.
+ *
+ * This file defines the `UringReader` class, which reads batches of procfs
+ * files through io_uring. Every file becomes a linked open, read and close
+ * chain that works on a registered file slot and a registered buffer, and a
+ * whole batch is submitted and waited for with one `io_uring_enter` call
+ * instead of three or four system calls per file. The class talks to the
+ * kernel directly and needs no library; on kernels or sandboxes without
+ * io_uring it reports itself unavailable and callers read synchronously.
+ */
+
+#ifndef URING_READER_H
+#define URING_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Outcome of one read of a batch.
+ */
+enum class UringStatus : uint8_t {
+  Complete, ///< The whole file is in `contents`
+  Missing,  ///< The file could not be opened or read, e.g. the process exited
+  Fallback, ///< The file must be read synchronously: too large or no ring
+};
+
+/**
+ * @class UringReader
+ * @brief A reusable io_uring instance for batches of small file reads.
+ *
+ * `add` queues up to `capacity` files, `submit` reads them all and
+ * `status` and `contents` return the results until the next `clear`. The
+ * ring, the file table and the buffers are set up once by the constructor
+ * and reused by every batch. An instance must only be used by one thread at
+ * a time.
+ */
+class UringReader {
+public:
+  /**
+   * @brief Sets up the ring; check `isAvailable` afterwards.
+   *
+   * @param capacity The largest number of files per batch.
+   */
+  explicit UringReader(unsigned capacity = DEFAULT_CAPACITY);
+
+  /**
+   * @brief Unmaps the ring and frees the buffers.
+   */
+  ~UringReader();
+
+  UringReader(const UringReader &) = delete;
+  UringReader &operator=(const UringReader &) = delete;
+
+  /**
+   * @brief Returns whether the ring could be set up.
+   */
+  bool isAvailable() const { return ringFd_ != -1; }
+
+  /**
+   * @brief Returns why the ring is unavailable, empty if it is available.
+   */
+  const std::string &error() const { return error_; }
+
+  /**
+   * @brief Returns the largest number of files per batch.
+   */
+  size_t capacity() const { return capacity_; }
+
+  /**
+   * @brief Queues a file for the next `submit`.
+   *
+   * @param path The file; copied, so it may change afterwards.
+   * @return The index of the request, or `NONE` if the batch is full, the
+   * path is too long or the ring is unavailable.
+   */
+  size_t add(std::string_view path);
+
+  /**
+   * @brief Reads every queued file and waits for the results.
+   *
+   * @return `false` if the ring failed; every request then reports
+   * `UringStatus::Fallback`.
+   */
+  bool submit();
+
+  /**
+   * @brief Returns the outcome of a request of the submitted batch.
+   */
+  UringStatus status(size_t request) const { return requests_[request].status; }
+
+  /**
+   * @brief Returns the contents of a completed request; valid until `clear`.
+   */
+  std::string_view contents(size_t request) const;
+
+  /**
+   * @brief Forgets the batch so that the next one can be queued.
+   */
+  void clear() { requests_.clear(); }
+
+  /// Index returned by `add` when a file was not queued
+  static constexpr size_t NONE = static_cast<size_t>(-1);
+
+  /// Default files per batch, a few hundred as the request chains are short
+  static constexpr unsigned DEFAULT_CAPACITY = 256;
+
+  /// Buffer per file; a read that fills it may be truncated
+  static constexpr size_t FILE_BUFFER_SIZE = 4096;
+
+  /// Longest path, including its terminator, that `add` accepts
+  static constexpr size_t PATH_SLOT_SIZE = 128;
+
+private:
+  /**
+   * @brief One queued file and its completions.
+   */
+  struct Request {
+    int openResult = 0; ///< Descriptor slot or a negative errno
+    int readResult = 0; ///< Bytes read or a negative errno
+    UringStatus status = UringStatus::Fallback; ///< Outcome after `submit`
+  };
+
+  /**
+   * @brief Creates the ring, maps its queues and registers the file table
+   * and the buffers; sets `error_` on failure.
+   */
+  bool setUp(unsigned capacity);
+
+  /**
+   * @brief Releases everything `setUp` acquired.
+   */
+  void tearDown();
+
+  /**
+   * @brief Returns the next free submission queue entry, cleared.
+   */
+  struct io_uring_sqe *nextEntry();
+
+  /**
+   * @brief Consumes the available completions.
+   *
+   * @return The number of completions consumed.
+   */
+  unsigned reapCompletions();
+
+  int ringFd_ = -1;               ///< io_uring descriptor, or -1
+  std::string error_;             ///< Why the ring is unavailable
+  size_t capacity_ = 0;           ///< Files per batch
+  std::vector<Request> requests_; ///< The queued or submitted batch
+
+  void *sqRing_ = nullptr;                 ///< Mapped submission ring
+  size_t sqRingSize_ = 0;                  ///< Size of `sqRing_`
+  void *cqRing_ = nullptr;                 ///< Completion ring, or `sqRing_`
+  size_t cqRingSize_ = 0;                  ///< Size of `cqRing_`
+  struct io_uring_sqe *entries_ = nullptr; ///< Mapped submission entries
+  size_t entriesSize_ = 0;                 ///< Size of `entries_`
+
+  unsigned *sqHead_ = nullptr;                 ///< Consumed by the kernel
+  unsigned *sqTail_ = nullptr;                 ///< Published to the kernel
+  unsigned *sqMask_ = nullptr;                 ///< Submission index mask
+  unsigned *sqArray_ = nullptr;                ///< Entry indexes to submit
+  unsigned *cqHead_ = nullptr;                 ///< Completions consumed
+  unsigned *cqTail_ = nullptr;                 ///< Completions published
+  unsigned *cqMask_ = nullptr;                 ///< Completion index mask
+  struct io_uring_cqe *completions_ = nullptr; ///< Completion entries
+  unsigned sqLocalTail_ = 0; ///< Tail including unpublished entries
+
+  std::unique_ptr<char[]> buffers_; ///< `capacity_` registered file buffers
+  std::unique_ptr<char[]> paths_;   ///< `capacity_` path slots
+};
+
+#endif // URING_READER_H
@@ -0,0 +1,70 @@
+/**
+ * @file worker_placement.h
+ * @brief Keeps scan worker threads off latency-critical CPUs.
+ *
+ * This file defines the `WorkerPlacement` class, which holds the CPUs that
+ * scan workers may run on. The scan threads of `ProcessListing` and the
+ * workers of `ThreadPool` apply it when they start, so the cost of reading
+ * procfs lands on housekeeping cores instead of the cores an application
+ * has reserved.
+ */
+
+#ifndef WORKER_PLACEMENT_H
+#define WORKER_PLACEMENT_H
+
+#include "numa_topology.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * @class WorkerPlacement
+ * @brief The process-wide CPU set of scan workers.
+ *
+ * The set is the union of the listed CPUs and of the CPUs of the listed
+ * NUMA nodes. Pinning workers to one node also keeps the memory they touch
+ * on that node, because the kernel allocates from the node a thread runs
+ * on by default. Configure the placement before starting any scan or
+ * worker thread; it is read without synchronization.
+ */
+class WorkerPlacement {
+public:
+  /**
+   * @brief Sets the CPUs scan workers may run on.
+   *
+   * @param cpuList CPUs as a sysfs list, e.g. `0-3,8`; may be empty.
+   * @param nodeList NUMA nodes as a sysfs list, e.g. `1`; may be empty.
+   * @param topology The topology the lists are checked against.
+   * @param[out] error A description of the problem on failure.
+   * @return `true` if the lists name online CPUs and nodes, `false`
+   * otherwise; the placement is unchanged then.
+   */
+  static bool configure(const std::string &cpuList,
+                        const std::string &nodeList,
+                        const SystemTopology &topology, std::string &error);
+
+  /**
+   * @brief Lets workers run anywhere again.
+   */
+  static void clear();
+
+  /**
+   * @brief Returns whether workers are restricted.
+   */
+  static bool isConfigured();
+
+  /**
+   * @brief Returns the CPUs workers may run on, empty if unrestricted.
+   */
+  static const std::vector<int> &cpus();
+
+  /**
+   * @brief Restricts the calling thread to the configured CPUs.
+   *
+   * Does nothing if no placement is configured. A failure is reported
+   * once on standard error and the thread keeps running where it is.
+   */
+  static void applyToCurrentThread();
+};
+
+#endif // WORKER_PLACEMENT_H
@@ -0,0 +1,291 @@
+// src/cgroup_monitoring.cpp
+
+#include "../include/cgroup_monitoring.h"
+#include "../include/display_format.h"
+#include "../include/logger.h"
+#include "../include/pressure_monitoring.h"
+#include "../include/proc_parsers.h"
+#include "../include/proc_paths.h"
+#include "../include/proc_reader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sys/inotify.h>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+// Locations of the cgroup v2 hierarchy below sysfs (unified and hybrid)
+const char *CGROUP_V2_ROOT = "fs/cgroup";
+const char *CGROUP_V2_HYBRID_ROOT = "fs/cgroup/unified";
+const char *CGROUP_CONTROLLERS_FILE = "/cgroup.controllers";
+
+// Accounting files and keys read for each cgroup
+const char *CPU_STAT_FILE = "/cpu.stat";
+const char *MEMORY_CURRENT_FILE = "/memory.current";
+const char *MEMORY_STAT_FILE = "/memory.stat";
+const char *IO_STAT_FILE = "/io.stat";
+const char *CPU_USAGE_KEY = "usage_usec ";
+const char *MEMORY_ANON_KEY = "anon ";
+const char *MEMORY_FILE_KEY = "file ";
+
+// Events that indicate a cgroup was created or removed
+const uint32_t HIERARCHY_EVENTS =
+    IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_ONLYDIR;
+const size_t INOTIFY_BUFFER_SIZE =
+    4096; // Enough for many events with short names
+
+const double USEC_PER_SEC = 1e6;   // Microseconds in a second
+const int PRIME_INTERVAL_MS = 500; // Delay between priming samples
+const int VALUE_COLUMN_WIDTH = 10; // Width of each numeric column
+const size_t MIN_TABLE_WIDTH = 70; // Width of the separator line
+} // namespace
+
+CgroupMonitoring::CgroupMonitoring()
+    : inotifyFd_(-1), walked_(false),
+      lastRefresh_(std::chrono::steady_clock::now()) {
+  for (const char *candidate : {CGROUP_V2_ROOT, CGROUP_V2_HYBRID_ROOT}) {
+    std::string root = ProcPaths::sys(candidate);
+    std::string controllers = root + CGROUP_CONTROLLERS_FILE;
+    if (access(controllers.c_str(), R_OK) == 0) {
+      root_ = root;
+      break;
+    }
+  }
+
+  if (isAvailable()) {
+    // Without inotify the hierarchy is walked on every refresh
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  }
+}
+
+CgroupMonitoring::~CgroupMonitoring() {
+  if (inotifyFd_ != -1) {
+    close(inotifyFd_); // Also removes every watch
+  }
+}
+
+void CgroupMonitoring::walkHierarchy() {
+  // Keep the previous counters so rates survive the walk
+  std::unordered_map<std::string, CgroupNode> previous;
+  for (auto &node : nodes_) {
+    previous.emplace(node.path, std::move(node));
+  }
+  nodes_.clear();
+  watches_.clear();
+
+  auto addCgroup = [&](const std::string &path) {
+    auto it = previous.find(path);
+    if (it != previous.end()) {
+      nodes_.push_back(std::move(it->second));
+    } else {
+      CgroupNode node;
+      node.path = path;
+      nodes_.push_back(std::move(node));
+    }
+
+    if (inotifyFd_ != -1) {
+      std::string fullPath = root_ + (path == "/" ? "" : path);
+      int wd = inotify_add_watch(inotifyFd_, fullPath.c_str(),
+                                 HIERARCHY_EVENTS);
+      if (wd != -1) {
+        watches_[wd] = path;
+      }
+    }
+  };
+
+  addCgroup("/");
+  std::error_code error;
+  fs::recursive_directory_iterator it(
+      root_, fs::directory_options::skip_permission_denied, error);
+  for (; !error && it != fs::recursive_directory_iterator();
+       it.increment(error)) {
+    if (it->is_directory(error) && !it->is_symlink(error)) {
+      addCgroup(it->path().string().substr(root_.size()));
+    }
+  }
+
+  walked_ = true;
+}
+
+bool CgroupMonitoring::hierarchyChanged() {
+  if (inotifyFd_ == -1) {
+    return true;
+  }
+
+  bool changed = false;
+  alignas(inotify_event) char buffer[INOTIFY_BUFFER_SIZE];
+  while (true) {
+    ssize_t length = read(inotifyFd_, buffer, sizeof(buffer));
+    if (length <= 0) {
+      break; // EAGAIN: no more pending events
+    }
+
+    for (char *p = buffer; p < buffer + length;) {
+      const auto *event = reinterpret_cast<const inotify_event *>(p);
+      if ((event->mask & (IN_ISDIR | IN_DELETE_SELF | IN_Q_OVERFLOW)) != 0) {
+        changed = true;
+      }
+      p += sizeof(inotify_event) + event->len;
+    }
+  }
+  return changed;
+}
+
+void CgroupMonitoring::refresh() {
+  if (!isAvailable()) {
+    return;
+  }
+
+  if (!walked_ || hierarchyChanged()) {
+    walkHierarchy();
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(now - lastRefresh_).count();
+  lastRefresh_ = now;
+
+  stats_.clear();
+  stats_.reserve(nodes_.size());
+
+  std::string contents;
+  for (auto &node : nodes_) {
+    std::string base = root_ + (node.path == "/" ? "" : node.path);
+
+    unsigned long long cpuUsageUsec = 0;
+    if (!ProcReader::readFile(base + CPU_STAT_FILE, contents) ||
+        !ProcParsers::parseKeyedValue(contents, CPU_USAGE_KEY, cpuUsageUsec)) {
+      continue; // Removed since the last walk
+    }
+
+    CgroupStats stats;
+    stats.path = node.path;
+
+    if (ProcReader::readFile(base + MEMORY_CURRENT_FILE, contents)) {
+      // memory.current holds a single value, so match it with an empty key
+      ProcParsers::parseKeyedValue(contents, "", stats.memoryCurrent);
+      stats.hasMemory = true;
+      if (ProcReader::readFile(base + MEMORY_STAT_FILE, contents)) {
+        ProcParsers::parseKeyedValue(contents, MEMORY_ANON_KEY,
+                                     stats.memoryAnon);
+        ProcParsers::parseKeyedValue(contents, MEMORY_FILE_KEY,
+                                     stats.memoryFile);
+      }
+    }
+
+    unsigned long long ioReadBytes = 0;
+    unsigned long long ioWriteBytes = 0;
+    if (ProcReader::readFile(base + IO_STAT_FILE, contents)) {
+      ProcParsers::parseCgroupIoStat(contents, ioReadBytes, ioWriteBytes);
+      stats.hasIo = true;
+    }
+
+    if (node.sampled && elapsed > 0.0) {
+      if (cpuUsageUsec >= node.cpuUsageUsec) {
+        stats.cpuUsage = (cpuUsageUsec - node.cpuUsageUsec) /
+                         (elapsed * USEC_PER_SEC) * 100.0;
+      }
+      if (ioReadBytes >= node.ioReadBytes) {
+        stats.ioReadRate = (ioReadBytes - node.ioReadBytes) / elapsed;
+      }
+      if (ioWriteBytes >= node.ioWriteBytes) {
+        stats.ioWriteRate = (ioWriteBytes - node.ioWriteBytes) / elapsed;
+      }
+    }
+
+    node.cpuUsageUsec = cpuUsageUsec;
+    node.ioReadBytes = ioReadBytes;
+    node.ioWriteBytes = ioWriteBytes;
+    node.sampled = true;
+    stats_.push_back(std::move(stats));
+  }
+}
+
+std::vector<CgroupStats> CgroupMonitoring::getTopCgroups(size_t count) const {
+  std::vector<CgroupStats> top = stats_;
+  count = std::min(count, top.size());
+  std::partial_sort(top.begin(), top.begin() + count, top.end(),
+                    [](const CgroupStats &a, const CgroupStats &b) {
+                      return a.cpuUsage > b.cpuUsage;
+                    });
+  top.resize(count);
+  return top;
+}
+
+bool CgroupMonitoring::readPressure(CgroupStats &stats) const {
+  std::string base = root_ + (stats.path == "/" ? "" : stats.path);
+  ProcPressure cpu;
+  ProcPressure memory;
+  ProcPressure io;
+  // The files are missing when booted with cgroup_disable=pressure
+  stats.hasPressure =
+      PressureMonitoring::readCgroup(base, PressureResource::Cpu, cpu) &&
+      PressureMonitoring::readCgroup(base, PressureResource::Memory, memory) &&
+      PressureMonitoring::readCgroup(base, PressureResource::Io, io);
+  stats.cpuPressure = cpu.some.avg10;
+  stats.memoryPressure = memory.some.avg10;
+  stats.ioPressure = io.some.avg10;
+  return stats.hasPressure;
+}
+
+void CgroupMonitoring::listCgroups() {
+  if (!isAvailable()) {
+    std::cerr << "Error: No cgroup v2 hierarchy found under "
+              << ProcPaths::sys(CGROUP_V2_ROOT) << ".\n";
+    return;
+  }
+
+  Logger logger;
+  logger.logAction("Listing cgroups");
+
+  if (!walked_) {
+    // Rates need two samples
+    refresh();
+    std::this_thread::sleep_for(std::chrono::milliseconds(PRIME_INTERVAL_MS));
+  }
+  refresh();
+
+  std::cout << std::left << std::setw(VALUE_COLUMN_WIDTH) << "CPU%"
+            << std::setw(VALUE_COLUMN_WIDTH) << "Memory"
+            << std::setw(VALUE_COLUMN_WIDTH) << "Anon"
+            << std::setw(VALUE_COLUMN_WIDTH) << "File"
+            << std::setw(VALUE_COLUMN_WIDTH) << "Read/s"
+            << std::setw(VALUE_COLUMN_WIDTH) << "Write/s" << "Path\n";
+  std::cout << std::string(MIN_TABLE_WIDTH, '-') << '\n';
+
+  for (const auto &stats : stats_) {
+    std::cout << DisplayFormat::usageColor(stats.cpuUsage)
+              << std::setw(VALUE_COLUMN_WIDTH) << std::fixed
+              << std::setprecision(2) << stats.cpuUsage
+              << DisplayFormat::resetColor();
+    if (stats.hasMemory) {
+      std::cout << std::setw(VALUE_COLUMN_WIDTH)
+                << DisplayFormat::bytes(stats.memoryCurrent)
+                << std::setw(VALUE_COLUMN_WIDTH)
+                << DisplayFormat::bytes(stats.memoryAnon)
+                << std::setw(VALUE_COLUMN_WIDTH)
+                << DisplayFormat::bytes(stats.memoryFile);
+    } else {
+      std::cout << std::setw(VALUE_COLUMN_WIDTH) << "-"
+                << std::setw(VALUE_COLUMN_WIDTH) << "-"
+                << std::setw(VALUE_COLUMN_WIDTH) << "-";
+    }
+    if (stats.hasIo) {
+      std::cout << std::setw(VALUE_COLUMN_WIDTH)
+                << DisplayFormat::bytes(
+                       static_cast<unsigned long long>(stats.ioReadRate))
+                << std::setw(VALUE_COLUMN_WIDTH)
+                << DisplayFormat::bytes(
+                       static_cast<unsigned long long>(stats.ioWriteRate));
+    } else {
+      std::cout << std::setw(VALUE_COLUMN_WIDTH) << "-"
+                << std::setw(VALUE_COLUMN_WIDTH) << "-";
+    }
+    std::cout << stats.path << '\n';
+  }
+}
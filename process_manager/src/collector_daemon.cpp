@@ -0,0 +1,621 @@
+// src/collector_daemon.cpp
+
+#include "../include/collector_daemon.h"
+#include "../include/self_stats.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+namespace {
+const int MAX_EVENTS = 64;               // Events handled per epoll_wait
+const size_t READ_BUFFER_SIZE = 4096;    // Bytes read per read call
+const size_t MAX_INPUT_BYTES = 65536;    // Unparsed request bytes per client
+const size_t MAX_CONNECTIONS = 1024;     // Concurrent clients
+const uint32_t MAX_REQUEST_PAYLOAD = 64; // Requests carry one integer
+const size_t MAX_QUEUED_BYTES = 4 << 20; // Backlog before samples are skipped
+const int MAX_IOVECS = 16;               // Chunks sent per sendmsg
+const std::chrono::milliseconds PRIMING_DELAY(250); // Baseline sample delay
+const char *SOCKET_NAME = "process_manager.sock";   // In XDG_RUNTIME_DIR
+
+/**
+ * @brief Returns the current wall-clock time in milliseconds.
+ */
+uint64_t unixMillis() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+}
+
+/**
+ * @brief Fills a Unix socket address, reporting paths that do not fit.
+ */
+bool socketAddress(const std::string &path, sockaddr_un &address,
+                   std::string &error) {
+  if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+    error = "Invalid socket path '" + path + "'";
+    return false;
+  }
+  address = sockaddr_un{};
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+} // namespace
+
+CollectorDaemon::CollectorDaemon(std::chrono::milliseconds interval,
+                                 size_t historyLength)
+    : interval_(interval),
+      listenFd_(-1), epollFd_(epoll_create1(EPOLL_CLOEXEC)),
+      wakeupFd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      sampleFd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      history_(historyLength, HISTORY_MEMORY_BYTES) {
+  for (int fd : {wakeupFd_, sampleFd_}) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event);
+  }
+}
+
+CollectorDaemon::~CollectorDaemon() {
+  {
+    std::lock_guard<std::mutex> lock(stopMutex_);
+    stopping_ = true;
+  }
+  stopCondition_.notify_all();
+  if (sampler_.joinable()) {
+    sampler_.join();
+  }
+
+  for (auto &[fd, connection] : connections_) {
+    close(fd);
+  }
+  if (listenFd_ >= 0) {
+    close(listenFd_);
+    unlink(socketPath_.c_str());
+  }
+  close(sampleFd_);
+  close(wakeupFd_);
+  close(epollFd_);
+}
+
+std::string CollectorDaemon::defaultSocketPath() {
+  const char *runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+  if (runtimeDir != nullptr && runtimeDir[0] != '\0') {
+    return std::string(runtimeDir) + "/" + SOCKET_NAME;
+  }
+  return "/tmp/process_manager-" + std::to_string(getuid()) + ".sock";
+}
+
+bool CollectorDaemon::listen(const std::string &path, std::string &error) {
+  sockaddr_un address;
+  if (!socketAddress(path, address, error)) {
+    return false;
+  }
+
+  listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listenFd_ < 0) {
+    error = std::string("socket: ") + std::strerror(errno);
+    return false;
+  }
+
+  // Created with owner-only permissions, so no other user can connect
+  mode_t previousMask = umask(0177);
+  int result = bind(listenFd_, reinterpret_cast<sockaddr *>(&address),
+                    sizeof(address));
+  bool notSocket = false;
+  if (result != 0 && errno == EADDRINUSE) {
+    // Never remove anything but a socket, e.g. when a regular file was
+    // given as the path by mistake
+    struct stat status {};
+    notSocket =
+        lstat(path.c_str(), &status) == 0 && !S_ISSOCK(status.st_mode);
+  }
+  if (result != 0 && errno == EADDRINUSE && !notSocket) {
+    // A socket file nobody accepts on was left behind by a dead daemon
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    bool alive = probe >= 0 &&
+                 connect(probe, reinterpret_cast<sockaddr *>(&address),
+                         sizeof(address)) == 0;
+    if (probe >= 0) {
+      close(probe);
+    }
+    if (!alive && unlink(path.c_str()) == 0) {
+      result = bind(listenFd_, reinterpret_cast<sockaddr *>(&address),
+                    sizeof(address));
+    } else {
+      errno = EADDRINUSE;
+    }
+  }
+  umask(previousMask);
+
+  if (notSocket) {
+    error = "Cannot listen on " + path + ": the path exists and is not a "
+            "socket";
+    close(listenFd_);
+    listenFd_ = -1;
+    return false;
+  }
+  if (result != 0 || ::listen(listenFd_, SOMAXCONN) != 0) {
+    error = "Cannot listen on " + path + ": " + std::strerror(errno);
+    close(listenFd_);
+    listenFd_ = -1;
+    return false;
+  }
+  socketPath_ = path;
+
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = listenFd_;
+  epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event);
+  return true;
+}
+
+bool CollectorDaemon::publishSharedMemory(const std::string &name,
+                                          uint32_t capacity,
+                                          std::string &error) {
+  auto writer = std::make_unique<ShmSnapshotWriter>();
+  if (!writer->create(name, capacity, error)) {
+    return false;
+  }
+  sharedWriter_ = std::move(writer);
+  return true;
+}
+
+bool CollectorDaemon::run(std::string &error) {
+  // The first published sample already has a previous one to compute usage
+  // against, so clients never see lifetime averages
+  sample();
+  std::this_thread::sleep_for(std::min<std::chrono::milliseconds>(
+      interval_, PRIMING_DELAY));
+  sample();
+  sampler_ = std::thread(&CollectorDaemon::sampleLoop, this);
+
+  epoll_event events[MAX_EVENTS];
+  while (true) {
+    int count = epoll_wait(epollFd_, events, MAX_EVENTS, -1);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      error = std::string("epoll_wait: ") + std::strerror(errno);
+      return false;
+    }
+
+    for (int i = 0; i < count; ++i) {
+      int fd = events[i].data.fd;
+      if (fd == wakeupFd_) {
+        return true;
+      }
+      if (fd == sampleFd_) {
+        uint64_t value = 0;
+        ssize_t ignored = read(sampleFd_, &value, sizeof(value));
+        (void)ignored;
+        publishToSubscribers();
+        continue;
+      }
+      if (fd == listenFd_) {
+        acceptConnections();
+        continue;
+      }
+
+      auto it = connections_.find(fd);
+      if (it == connections_.end()) {
+        continue; // Closed earlier in this batch
+      }
+      bool keep = (events[i].events & (EPOLLERR | EPOLLHUP)) == 0 ||
+                  (events[i].events & EPOLLIN) != 0;
+      if (keep && (events[i].events & EPOLLIN) != 0) {
+        keep = handleReadable(fd);
+      }
+      if (keep && (events[i].events & EPOLLOUT) != 0) {
+        keep = flush(fd, it->second);
+      }
+      if (!keep) {
+        closeConnection(fd);
+      }
+    }
+  }
+}
+
+void CollectorDaemon::stop() {
+  uint64_t value = 1;
+  ssize_t ignored = write(wakeupFd_, &value, sizeof(value));
+  (void)ignored;
+}
+
+void CollectorDaemon::enableRules(std::unique_ptr<RuleEngine> rules,
+                                  bool dryRun) {
+  rules_ = std::move(rules);
+  rulesDryRun_ = dryRun;
+}
+
+void CollectorDaemon::sampleLoop() {
+  std::unique_lock<std::mutex> lock(stopMutex_);
+  while (!stopCondition_.wait_for(lock, interval_,
+                                  [this] { return stopping_; })) {
+    lock.unlock();
+    sample();
+    lock.lock();
+  }
+}
+
+void CollectorDaemon::sample() {
+  ListOptions options;
+  options.columns = {ProcessColumn::Pid, ProcessColumn::Name,
+                     ProcessColumn::Cpu, ProcessColumn::Memory,
+                     ProcessColumn::Rss, ProcessColumn::Threads};
+  // Processes that start and exit are logged as the scans see them
+  options.events = true;
+  if (rules_) {
+    options.extraSources = rules_->requiredSources();
+  }
+  listing_.refresh(options);
+  listing_.sortProcesses(ProcessColumn::Cpu, true);
+  ++generation_;
+
+  auto published = std::make_shared<Published>();
+  DaemonSystemSample &system = published->system;
+  system.timestampMs = unixMillis();
+  system.generation = generation_;
+
+  SystemCounters current;
+  if (DataMonitoring::readSystemCounters(current, readBuffer_)) {
+    if (!previous_.cpus.empty() && !current.cpus.empty()) {
+      system.cpuUsage =
+          DataMonitoring::cpuUsage(previous_.cpus[0], current.cpus[0]);
+    }
+    system.memTotalKb = current.memTotalKb;
+    system.memAvailableKb = current.memAvailableKb;
+    if (current.memTotalKb > current.memAvailableKb) {
+      system.memoryUsage =
+          100.0 *
+          static_cast<double>(current.memTotalKb - current.memAvailableKb) /
+          current.memTotalKb;
+    }
+    previous_ = std::move(current);
+  }
+
+  const std::vector<ProcessInfo> &processes = listing_.getProcesses();
+  if (rules_) {
+    RuleSystemSample values{system.cpuUsage, system.memoryUsage};
+    rules_->evaluate(std::chrono::steady_clock::now(), processes, values,
+                     firings_);
+    for (const RuleFiring &firing : firings_) {
+      const Rule &rule = rules_->rules()[firing.rule];
+      std::string name;
+      if (rule.scope == RuleScope::Process) {
+        name = listing_.getString(processes[firing.process].nameId);
+      }
+      RuleActions::execute(rule, firing, name, rulesDryRun_);
+    }
+  }
+
+  // Encode every record once; replies only slice this buffer
+  system.processCount = static_cast<uint32_t>(processes.size());
+  auto records = std::make_shared<std::string>();
+  published->offsets.reserve(processes.size() + 1);
+  DaemonProcess record;
+  for (const ProcessInfo &info : processes) {
+    record.pid = info.pid;
+    record.cpuUsage = info.cpuUsage;
+    record.memoryUsage = info.memoryUsage;
+    record.rssKb = info.rssKb;
+    record.threads = static_cast<uint32_t>(std::max(info.threads, 0L));
+    record.name = listing_.getString(info.nameId);
+    published->offsets.push_back(records->size());
+    DaemonProtocol::appendProcess(*records, record);
+  }
+  published->offsets.push_back(records->size());
+  published->records = std::move(records);
+  if (sharedWriter_) {
+    publishShared(system);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(dataMutex_);
+    published_ = std::move(published);
+
+    history_.record(processes, system.timestampMs);
+  }
+
+  uint64_t value = 1;
+  ssize_t ignored = write(sampleFd_, &value, sizeof(value));
+  (void)ignored;
+}
+
+void CollectorDaemon::publishShared(const DaemonSystemSample &system) {
+  // Records are written straight into the segment, sorted like the table
+  const std::vector<ProcessInfo> &processes = listing_.getProcesses();
+  ShmProcessRecord *records = sharedWriter_->beginWrite();
+  uint32_t count = static_cast<uint32_t>(
+      std::min<size_t>(processes.size(), sharedWriter_->capacity()));
+  for (uint32_t i = 0; i < count; ++i) {
+    const ProcessInfo &info = processes[i];
+    ShmProcessRecord &record = records[i];
+    record.pid = info.pid;
+    record.threads = static_cast<uint32_t>(std::max(info.threads, 0L));
+    record.cpuUsage = info.cpuUsage;
+    record.memoryUsage = info.memoryUsage;
+    record.rssKb = info.rssKb;
+    std::string_view name = listing_.getString(info.nameId);
+    size_t length = std::min(name.size(), SHM_NAME_LENGTH - 1);
+    std::memcpy(record.name, name.data(), length);
+    record.name[length] = '\0';
+  }
+
+  ShmSystemSample sample;
+  sample.generation = system.generation;
+  sample.timestampMs = system.timestampMs;
+  sample.cpuUsage = system.cpuUsage;
+  sample.memoryUsage = system.memoryUsage;
+  sample.memTotalKb = system.memTotalKb;
+  sample.memAvailableKb = system.memAvailableKb;
+  sample.processCount = system.processCount;
+  sample.recordCount = count;
+  sharedWriter_->commit(sample);
+}
+
+std::shared_ptr<const CollectorDaemon::Published>
+CollectorDaemon::latest() const {
+  std::lock_guard<std::mutex> lock(dataMutex_);
+  return published_;
+}
+
+void CollectorDaemon::acceptConnections() {
+  while (true) {
+    int fd = accept4(listenFd_, nullptr, nullptr,
+                     SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      return; // EAGAIN once the backlog is drained
+    }
+    if (connections_.size() >= MAX_CONNECTIONS) {
+      close(fd);
+      continue;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+      close(fd);
+      continue;
+    }
+    connections_.emplace(fd, Connection());
+  }
+}
+
+bool CollectorDaemon::handleReadable(int fd) {
+  Connection &connection = connections_[fd];
+  char buffer[READ_BUFFER_SIZE];
+  while (true) {
+    ssize_t bytes = read(fd, buffer, sizeof(buffer));
+    if (bytes > 0) {
+      connection.input.append(buffer, static_cast<size_t>(bytes));
+      if (connection.input.size() > MAX_INPUT_BYTES) {
+        return false;
+      }
+      continue;
+    }
+    if (bytes == 0) {
+      return false; // The client closed the connection
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      break;
+    }
+    return false;
+  }
+
+  size_t consumed = 0;
+  while (connection.input.size() - consumed >= DaemonProtocol::HEADER_SIZE) {
+    std::string_view frame(connection.input);
+    frame.remove_prefix(consumed);
+    DaemonMessage type;
+    uint32_t length = 0;
+    if (!DaemonProtocol::parseHeader(frame, type, length) ||
+        length > MAX_REQUEST_PAYLOAD) {
+      return false; // Not a client of this protocol
+    }
+    if (frame.size() < DaemonProtocol::HEADER_SIZE + length) {
+      break;
+    }
+    if (!handleRequest(connection, type,
+                       frame.substr(DaemonProtocol::HEADER_SIZE, length))) {
+      return false;
+    }
+    consumed += DaemonProtocol::HEADER_SIZE + length;
+  }
+  connection.input.erase(0, consumed);
+  return flush(fd, connection);
+}
+
+bool CollectorDaemon::handleRequest(Connection &connection, DaemonMessage type,
+                                    std::string_view payload) {
+  int64_t argument = 0;
+  if (!DaemonProtocol::parseRequest(type, payload, argument)) {
+    auto error = std::make_shared<std::string>();
+    DaemonProtocol::appendError(*error, "Unsupported request");
+    queue(connection, std::move(error));
+    return true;
+  }
+
+  std::shared_ptr<const Published> published = latest();
+  switch (type) {
+  case DaemonMessage::Snapshot:
+    queueSnapshot(connection, *published,
+                  std::numeric_limits<size_t>::max());
+    break;
+  case DaemonMessage::Top:
+    queueSnapshot(connection, *published, static_cast<size_t>(argument));
+    break;
+  case DaemonMessage::History:
+    queueHistory(connection, static_cast<int>(argument));
+    break;
+  case DaemonMessage::Subscribe:
+    connection.subscribed = true;
+    connection.subscribeCount = argument == 0
+                                    ? std::numeric_limits<size_t>::max()
+                                    : static_cast<size_t>(argument);
+    queueSnapshot(connection, *published, connection.subscribeCount);
+    break;
+  case DaemonMessage::Stats: {
+    auto reply = std::make_shared<std::string>();
+    DaemonProtocol::appendStats(*reply, SelfStats::snapshot());
+    queue(connection, std::move(reply));
+    break;
+  }
+  default:
+    break;
+  }
+  return true;
+}
+
+void CollectorDaemon::queueSnapshot(Connection &connection,
+                                    const Published &published,
+                                    size_t count) {
+  count = std::min(count, published.offsets.size() - 1);
+  auto prefix = std::make_shared<std::string>();
+  DaemonProtocol::appendSnapshotPrefix(*prefix, published.system,
+                                       static_cast<uint32_t>(count),
+                                       published.offsets[count]);
+  queue(connection, std::move(prefix));
+  if (count > 0) {
+    connection.output.push_back(
+        Chunk{published.records, 0, published.offsets[count]});
+    connection.queuedBytes += published.offsets[count];
+  }
+}
+
+void CollectorDaemon::queueHistory(Connection &connection, int pid) {
+  std::vector<HistorySample> samples;
+  bool found = false;
+  {
+    std::lock_guard<std::mutex> lock(dataMutex_);
+    found = history_.samples(pid, samples);
+  }
+
+  auto reply = std::make_shared<std::string>();
+  if (!found) {
+    DaemonProtocol::appendError(*reply,
+                                "No such process: " + std::to_string(pid));
+  } else {
+    // Oldest first, decoded from the compressed blocks
+    DaemonProtocol::appendHistoryPrefix(*reply, pid,
+                                        static_cast<uint32_t>(samples.size()));
+    for (const HistorySample &sample : samples) {
+      DaemonHistorySample entry;
+      entry.timestampMs = sample.timestampMs;
+      entry.cpuUsage = sample.cpuUsage;
+      entry.memoryUsage = sample.memoryUsage;
+      entry.rssKb = sample.rssKb;
+      DaemonProtocol::appendHistorySample(*reply, entry);
+    }
+  }
+  queue(connection, std::move(reply));
+}
+
+void CollectorDaemon::queue(Connection &connection,
+                            std::shared_ptr<const std::string> data) {
+  size_t size = data->size();
+  connection.output.push_back(Chunk{std::move(data), 0, size});
+  connection.queuedBytes += size;
+}
+
+void CollectorDaemon::publishToSubscribers() {
+  std::shared_ptr<const Published> published = latest();
+  std::vector<int> failed;
+  for (auto &[fd, connection] : connections_) {
+    // A client that cannot keep up skips samples rather than growing memory
+    if (!connection.subscribed || connection.queuedBytes > MAX_QUEUED_BYTES) {
+      continue;
+    }
+    queueSnapshot(connection, *published, connection.subscribeCount);
+    if (!flush(fd, connection)) {
+      failed.push_back(fd);
+    }
+  }
+  for (int fd : failed) {
+    closeConnection(fd);
+  }
+}
+
+bool CollectorDaemon::flush(int fd, Connection &connection) {
+  while (!connection.output.empty()) {
+    iovec parts[MAX_IOVECS];
+    int partCount = 0;
+    for (const Chunk &chunk : connection.output) {
+      if (partCount == MAX_IOVECS) {
+        break;
+      }
+      parts[partCount].iov_base =
+          const_cast<char *>(chunk.data->data() + chunk.offset);
+      parts[partCount].iov_len = chunk.end - chunk.offset;
+      ++partCount;
+    }
+
+    msghdr message{};
+    message.msg_iov = parts;
+    message.msg_iovlen = static_cast<size_t>(partCount);
+    ssize_t sent = sendmsg(fd, &message, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        return false;
+      }
+      // Resume once the client has drained its receive buffer
+      if (!connection.writing) {
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+        event.data.fd = fd;
+        epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event);
+        connection.writing = true;
+      }
+      return true;
+    }
+
+    size_t remaining = static_cast<size_t>(sent);
+    connection.queuedBytes -= remaining;
+    while (remaining > 0) {
+      Chunk &chunk = connection.output.front();
+      size_t taken = std::min(remaining, chunk.end - chunk.offset);
+      chunk.offset += taken;
+      remaining -= taken;
+      if (chunk.offset == chunk.end) {
+        connection.output.pop_front();
+      }
+    }
+  }
+
+  if (connection.writing) {
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = fd;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event);
+    connection.writing = false;
+  }
+  return true;
+}
+
+void CollectorDaemon::closeConnection(int fd) {
+  epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+  close(fd);
+  connections_.erase(fd);
+}
@@ -1,17 +1,46 @@
 // src/command_parser.cpp
 
 #include "../include/command_parser.h"
-#include <sstream>
+
+#include <cctype>
 
 ParsedCommand CommandParser::parse(const std::string &input) {
-  ParsedCommand cmd;
-  std::istringstream stream(input);
-  stream >> cmd.name;
+  std::vector<std::string> words;
+  std::string word;
+  bool inWord = false; // Also true for an empty quoted word
+  char quote = '\0';   // Character that closes the open quote, if any
 
-  std::string arg;
-  while (stream >> arg) {
-    cmd.args.push_back(arg);
+  for (char c : input) {
+    if (quote != '\0') {
+      if (c == quote) {
+        quote = '\0';
+      } else {
+        word += c;
+      }
+    } else if (c == '\'' || c == '"') {
+      quote = c;
+      inWord = true;
+    } else if (std::isspace(static_cast<unsigned char>(c))) {
+      if (inWord) {
+        words.push_back(std::move(word));
+        word.clear();
+        inWord = false;
+      }
+    } else {
+      word += c;
+      inWord = true;
+    }
+  }
+  // An unterminated quote runs to the end of the line
+  if (inWord) {
+    words.push_back(std::move(word));
   }
 
+  ParsedCommand cmd;
+  if (!words.empty()) {
+    cmd.name = std::move(words.front());
+    cmd.args.assign(std::make_move_iterator(words.begin() + 1),
+                    std::make_move_iterator(words.end()));
+  }
   return cmd;
 }
@@ -0,0 +1,221 @@
+// src/daemon_client.cpp
+
+#include "../include/daemon_client.h"
+#include "../include/display_format.h"
+#include "../include/process_columns.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+
+namespace {
+const size_t MIN_TABLE_WIDTH = 40; // Minimum width of the separator line
+const size_t NAME_WIDTH = 12;      // Width reserved for the last column
+
+/// Columns of the table printed from a daemon sample, name last
+const ProcessColumn TABLE_COLUMNS[] = {
+    ProcessColumn::Pid, ProcessColumn::Cpu,     ProcessColumn::Memory,
+    ProcessColumn::Rss, ProcessColumn::Threads, ProcessColumn::Name};
+} // namespace
+
+DaemonClient::DaemonClient() : fd_(-1) {}
+
+DaemonClient::~DaemonClient() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+bool DaemonClient::connect(const std::string &path, std::string &error) {
+  sockaddr_un address{};
+  if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+    error = "Invalid socket path '" + path + "'";
+    return false;
+  }
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+  fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd_ < 0 ||
+      ::connect(fd_, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address)) != 0) {
+    error = "Cannot connect to the daemon at " + path + ": " +
+            std::strerror(errno);
+    if (fd_ >= 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+    return false;
+  }
+  return true;
+}
+
+bool DaemonClient::fetchSnapshot(size_t top, DaemonSnapshot &snapshot,
+                                 std::string &error) {
+  std::string payload;
+  if (!sendRequest(top == 0 ? DaemonMessage::Snapshot : DaemonMessage::Top,
+                   static_cast<int64_t>(top), error) ||
+      !readFrame(DaemonMessage::SnapshotReply, payload, error)) {
+    return false;
+  }
+  if (!DaemonProtocol::decodeSnapshot(payload, snapshot)) {
+    error = "Malformed snapshot from the daemon";
+    return false;
+  }
+  return true;
+}
+
+bool DaemonClient::fetchHistory(int pid,
+                                std::vector<DaemonHistorySample> &samples,
+                                std::string &error) {
+  std::string payload;
+  if (!sendRequest(DaemonMessage::History, pid, error) ||
+      !readFrame(DaemonMessage::HistoryReply, payload, error)) {
+    return false;
+  }
+  int32_t replyPid = 0;
+  if (!DaemonProtocol::decodeHistory(payload, replyPid, samples) ||
+      replyPid != pid) {
+    error = "Malformed history from the daemon";
+    return false;
+  }
+  return true;
+}
+
+bool DaemonClient::fetchStats(SelfStatsSnapshot &stats, std::string &error) {
+  std::string payload;
+  if (!sendRequest(DaemonMessage::Stats, 0, error) ||
+      !readFrame(DaemonMessage::StatsReply, payload, error)) {
+    return false;
+  }
+  if (!DaemonProtocol::decodeStats(payload, stats)) {
+    error = "Malformed stats from the daemon";
+    return false;
+  }
+  return true;
+}
+
+bool DaemonClient::subscribe(size_t top, std::string &error) {
+  return sendRequest(DaemonMessage::Subscribe, static_cast<int64_t>(top),
+                     error);
+}
+
+bool DaemonClient::nextSnapshot(DaemonSnapshot &snapshot, std::string &error) {
+  std::string payload;
+  if (!readFrame(DaemonMessage::SnapshotReply, payload, error)) {
+    return false;
+  }
+  if (!DaemonProtocol::decodeSnapshot(payload, snapshot)) {
+    error = "Malformed snapshot from the daemon";
+    return false;
+  }
+  return true;
+}
+
+void DaemonClient::printTable(std::ostream &out,
+                              const DaemonSnapshot &snapshot) {
+  const DaemonSystemSample &system = snapshot.system;
+  out << "CPU " << std::fixed << std::setprecision(2) << system.cpuUsage
+      << "%  Memory " << system.memoryUsage << "% of "
+      << DisplayFormat::bytes(system.memTotalKb * 1024) << "  Processes "
+      << system.processCount << "  Sample " << system.generation << "\n\n";
+
+  size_t tableWidth = 0;
+  for (ProcessColumn column : TABLE_COLUMNS) {
+    const ColumnSpec &spec = ProcessColumns::spec(column);
+    bool last = column == ProcessColumn::Name;
+    tableWidth += last ? NAME_WIDTH : spec.width;
+    out << std::left << std::setw(last ? 0 : spec.width) << spec.header;
+  }
+  out << '\n'
+      << std::string(std::max(tableWidth, MIN_TABLE_WIDTH), '-') << '\n';
+
+  for (const DaemonProcess &process : snapshot.processes) {
+    out << std::setw(ProcessColumns::spec(ProcessColumn::Pid).width)
+        << process.pid << DisplayFormat::usageColor(process.cpuUsage)
+        << std::setw(ProcessColumns::spec(ProcessColumn::Cpu).width)
+        << process.cpuUsage << DisplayFormat::resetColor()
+        << DisplayFormat::usageColor(process.memoryUsage)
+        << std::setw(ProcessColumns::spec(ProcessColumn::Memory).width)
+        << process.memoryUsage << DisplayFormat::resetColor()
+        << std::setw(ProcessColumns::spec(ProcessColumn::Rss).width)
+        << DisplayFormat::bytes(process.rssKb * 1024)
+        << std::setw(ProcessColumns::spec(ProcessColumn::Threads).width)
+        << process.threads << process.name << '\n';
+  }
+}
+
+bool DaemonClient::sendRequest(DaemonMessage type, int64_t argument,
+                               std::string &error) {
+  std::string frame;
+  DaemonProtocol::appendRequest(frame, type, argument);
+  size_t sent = 0;
+  while (sent < frame.size()) {
+    ssize_t bytes =
+        send(fd_, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+    if (bytes < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      error = std::string("Cannot send to the daemon: ") +
+              std::strerror(errno);
+      return false;
+    }
+    sent += static_cast<size_t>(bytes);
+  }
+  return true;
+}
+
+bool DaemonClient::readFrame(DaemonMessage expected, std::string &payload,
+                             std::string &error) {
+  char header[DaemonProtocol::HEADER_SIZE];
+  if (!readExactly(header, sizeof(header), error)) {
+    return false;
+  }
+  DaemonMessage type;
+  uint32_t length = 0;
+  if (!DaemonProtocol::parseHeader(std::string_view(header, sizeof(header)),
+                                   type, length)) {
+    error = "Unexpected reply from the daemon";
+    return false;
+  }
+  payload.resize(length);
+  if (!readExactly(payload.data(), length, error)) {
+    return false;
+  }
+
+  if (type == DaemonMessage::Error) {
+    if (!DaemonProtocol::decodeError(payload, error)) {
+      error = "Malformed error from the daemon";
+    }
+    return false;
+  }
+  if (type != expected) {
+    error = "Unexpected reply from the daemon";
+    return false;
+  }
+  return true;
+}
+
+bool DaemonClient::readExactly(char *data, size_t size, std::string &error) {
+  size_t received = 0;
+  while (received < size) {
+    ssize_t bytes = recv(fd_, data + received, size - received, 0);
+    if (bytes > 0) {
+      received += static_cast<size_t>(bytes);
+    } else if (bytes == 0) {
+      error = "The daemon closed the connection";
+      return false;
+    } else if (errno != EINTR) {
+      error = std::string("Cannot read from the daemon: ") +
+              std::strerror(errno);
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,319 @@
+// src/daemon_protocol.cpp
+
+#include "../include/daemon_protocol.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+const double PERCENT_SCALE = 100.0;        // Percentages travel in hundredths
+const size_t MIN_PROCESS_RECORD_SIZE = 26; // A record with an empty name
+const size_t MAX_STRING_LENGTH = std::numeric_limits<uint16_t>::max();
+
+void putU16(std::string &out, uint16_t value) {
+  out.push_back(static_cast<char>(value & 0xff));
+  out.push_back(static_cast<char>(value >> 8));
+}
+
+void putU32(std::string &out, uint32_t value) {
+  for (int shift = 0; shift < 32; shift += 8) {
+    out.push_back(static_cast<char>((value >> shift) & 0xff));
+  }
+}
+
+void putU64(std::string &out, uint64_t value) {
+  for (int shift = 0; shift < 64; shift += 8) {
+    out.push_back(static_cast<char>((value >> shift) & 0xff));
+  }
+}
+
+void putPercent(std::string &out, double value) {
+  double scaled = std::round(value * PERCENT_SCALE);
+  if (!(scaled > 0.0)) {
+    scaled = 0.0; // Also maps NaN to zero
+  }
+  putU32(out, scaled >= std::numeric_limits<uint32_t>::max()
+                  ? std::numeric_limits<uint32_t>::max()
+                  : static_cast<uint32_t>(scaled));
+}
+
+void putString(std::string &out, std::string_view text) {
+  text = text.substr(0, MAX_STRING_LENGTH);
+  putU16(out, static_cast<uint16_t>(text.size()));
+  out.append(text);
+}
+
+/**
+ * @brief Reads little-endian values from a payload, tracking truncation.
+ *
+ * Reads past the end return zero and clear `ok`, so a decoder can read a
+ * whole record and check once.
+ */
+struct WireReader {
+  std::string_view data;
+  size_t pos = 0;
+  bool ok = true;
+
+  uint64_t read(int bytes) {
+    if (data.size() - pos < static_cast<size_t>(bytes)) {
+      ok = false;
+      pos = data.size();
+      return 0;
+    }
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+      value |= static_cast<uint64_t>(static_cast<unsigned char>(data[pos++]))
+               << (8 * i);
+    }
+    return value;
+  }
+
+  uint16_t u16() { return static_cast<uint16_t>(read(2)); }
+  uint32_t u32() { return static_cast<uint32_t>(read(4)); }
+  uint64_t u64() { return read(8); }
+  double percent() { return u32() / PERCENT_SCALE; }
+
+  std::string string() {
+    size_t length = u16();
+    if (data.size() - pos < length) {
+      ok = false;
+      pos = data.size();
+      return std::string();
+    }
+    std::string text(data.substr(pos, length));
+    pos += length;
+    return text;
+  }
+
+  bool finished() const { return ok && pos == data.size(); }
+};
+} // namespace
+
+void DaemonProtocol::appendHeader(std::string &out, DaemonMessage type,
+                                  uint32_t length) {
+  putU32(out, MAGIC);
+  putU16(out, static_cast<uint16_t>(type));
+  putU32(out, length);
+}
+
+bool DaemonProtocol::parseHeader(std::string_view data, DaemonMessage &type,
+                                 uint32_t &length) {
+  WireReader reader{data.substr(0, HEADER_SIZE)};
+  uint32_t magic = reader.u32();
+  type = static_cast<DaemonMessage>(reader.u16());
+  length = reader.u32();
+  return reader.ok && magic == MAGIC && length <= MAX_PAYLOAD;
+}
+
+void DaemonProtocol::appendRequest(std::string &out, DaemonMessage type,
+                                   int64_t argument) {
+  if (type == DaemonMessage::Snapshot || type == DaemonMessage::Stats) {
+    appendHeader(out, type, 0);
+    return;
+  }
+  appendHeader(out, type, sizeof(uint32_t));
+  putU32(out, static_cast<uint32_t>(argument));
+}
+
+bool DaemonProtocol::parseRequest(DaemonMessage type, std::string_view payload,
+                                  int64_t &argument) {
+  WireReader reader{payload};
+  switch (type) {
+  case DaemonMessage::Snapshot:
+  case DaemonMessage::Stats:
+    argument = 0;
+    break;
+  case DaemonMessage::Top:
+  case DaemonMessage::Subscribe:
+    argument = reader.u32();
+    break;
+  case DaemonMessage::History:
+    argument = static_cast<int32_t>(reader.u32());
+    break;
+  default:
+    return false;
+  }
+  return reader.finished();
+}
+
+void DaemonProtocol::appendSystemSample(std::string &out,
+                                        const DaemonSystemSample &sample) {
+  putU64(out, sample.timestampMs);
+  putU32(out, sample.generation);
+  putPercent(out, sample.cpuUsage);
+  putPercent(out, sample.memoryUsage);
+  putU64(out, sample.memTotalKb);
+  putU64(out, sample.memAvailableKb);
+  putU32(out, sample.processCount);
+}
+
+void DaemonProtocol::appendSnapshotPrefix(std::string &out,
+                                          const DaemonSystemSample &sample,
+                                          uint32_t count, size_t recordBytes) {
+  appendHeader(out, DaemonMessage::SnapshotReply,
+               static_cast<uint32_t>(SYSTEM_SAMPLE_SIZE + sizeof(uint32_t) +
+                                     recordBytes));
+  appendSystemSample(out, sample);
+  putU32(out, count);
+}
+
+void DaemonProtocol::appendHistoryPrefix(std::string &out, int32_t pid,
+                                         uint32_t count) {
+  appendHeader(out, DaemonMessage::HistoryReply,
+               static_cast<uint32_t>(2 * sizeof(uint32_t) +
+                                     count * HISTORY_SAMPLE_SIZE));
+  putU32(out, static_cast<uint32_t>(pid));
+  putU32(out, count);
+}
+
+void DaemonProtocol::appendProcess(std::string &out,
+                                   const DaemonProcess &process) {
+  putU32(out, static_cast<uint32_t>(process.pid));
+  putPercent(out, process.cpuUsage);
+  putPercent(out, process.memoryUsage);
+  putU64(out, process.rssKb);
+  putU32(out, process.threads);
+  putString(out, process.name);
+}
+
+void DaemonProtocol::appendHistorySample(std::string &out,
+                                         const DaemonHistorySample &sample) {
+  putU64(out, sample.timestampMs);
+  putPercent(out, sample.cpuUsage);
+  putPercent(out, sample.memoryUsage);
+  putU64(out, sample.rssKb);
+}
+
+void DaemonProtocol::appendStats(std::string &out,
+                                 const SelfStatsSnapshot &stats) {
+  std::string payload;
+  putU64(payload, stats.uptimeMs);
+  putU64(payload, stats.cpuTimeUs);
+  putU64(payload, stats.maxRssKb);
+  putU16(payload, static_cast<uint16_t>(stats.counters.size()));
+  for (const auto &[name, value] : stats.counters) {
+    putString(payload, name);
+    putU64(payload, value);
+  }
+  putU16(payload, static_cast<uint16_t>(stats.gauges.size()));
+  for (const SelfGaugeValue &gauge : stats.gauges) {
+    putString(payload, gauge.name);
+    putU64(payload, static_cast<uint64_t>(gauge.value));
+    putU64(payload, static_cast<uint64_t>(gauge.peak));
+  }
+  putU16(payload, static_cast<uint16_t>(stats.histograms.size()));
+  for (const SelfHistogram &histogram : stats.histograms) {
+    putString(payload, histogram.name);
+    putU64(payload, histogram.count);
+    putU64(payload, histogram.sumNs);
+    putU64(payload, histogram.maxNs);
+    putU16(payload, static_cast<uint16_t>(histogram.buckets.size()));
+    for (uint64_t bucket : histogram.buckets) {
+      putU64(payload, bucket);
+    }
+  }
+  appendHeader(out, DaemonMessage::StatsReply,
+               static_cast<uint32_t>(payload.size()));
+  out.append(payload);
+}
+
+void DaemonProtocol::appendError(std::string &out, std::string_view message) {
+  message = message.substr(0, MAX_STRING_LENGTH);
+  appendHeader(out, DaemonMessage::Error,
+               static_cast<uint32_t>(sizeof(uint16_t) + message.size()));
+  putString(out, message);
+}
+
+bool DaemonProtocol::decodeSnapshot(std::string_view payload,
+                                    DaemonSnapshot &snapshot) {
+  WireReader reader{payload};
+  DaemonSystemSample &system = snapshot.system;
+  system.timestampMs = reader.u64();
+  system.generation = reader.u32();
+  system.cpuUsage = reader.percent();
+  system.memoryUsage = reader.percent();
+  system.memTotalKb = reader.u64();
+  system.memAvailableKb = reader.u64();
+  system.processCount = reader.u32();
+
+  uint32_t count = reader.u32();
+  snapshot.processes.clear();
+  // The payload size bounds the count, so a corrupt count cannot make the
+  // reservation explode
+  snapshot.processes.reserve(
+      std::min<size_t>(count, payload.size() / MIN_PROCESS_RECORD_SIZE));
+  for (uint32_t i = 0; i < count && reader.ok; ++i) {
+    DaemonProcess process;
+    process.pid = static_cast<int32_t>(reader.u32());
+    process.cpuUsage = reader.percent();
+    process.memoryUsage = reader.percent();
+    process.rssKb = reader.u64();
+    process.threads = reader.u32();
+    process.name = reader.string();
+    snapshot.processes.push_back(std::move(process));
+  }
+  return reader.finished();
+}
+
+bool DaemonProtocol::decodeHistory(std::string_view payload, int32_t &pid,
+                                   std::vector<DaemonHistorySample> &samples) {
+  WireReader reader{payload};
+  pid = static_cast<int32_t>(reader.u32());
+  uint32_t count = reader.u32();
+  if (!reader.ok ||
+      (payload.size() - reader.pos) != count * HISTORY_SAMPLE_SIZE) {
+    return false;
+  }
+  samples.resize(count);
+  for (DaemonHistorySample &sample : samples) {
+    sample.timestampMs = reader.u64();
+    sample.cpuUsage = reader.percent();
+    sample.memoryUsage = reader.percent();
+    sample.rssKb = reader.u64();
+  }
+  return reader.finished();
+}
+
+bool DaemonProtocol::decodeStats(std::string_view payload,
+                                 SelfStatsSnapshot &stats) {
+  WireReader reader{payload};
+  stats = SelfStatsSnapshot();
+  stats.uptimeMs = reader.u64();
+  stats.cpuTimeUs = reader.u64();
+  stats.maxRssKb = reader.u64();
+  uint16_t counters = reader.u16();
+  for (uint16_t i = 0; i < counters && reader.ok; ++i) {
+    std::string name = reader.string();
+    stats.counters.emplace_back(std::move(name), reader.u64());
+  }
+  uint16_t gauges = reader.u16();
+  for (uint16_t i = 0; i < gauges && reader.ok; ++i) {
+    SelfGaugeValue gauge;
+    gauge.name = reader.string();
+    gauge.value = static_cast<int64_t>(reader.u64());
+    gauge.peak = static_cast<int64_t>(reader.u64());
+    stats.gauges.push_back(std::move(gauge));
+  }
+  uint16_t histograms = reader.u16();
+  for (uint16_t i = 0; i < histograms && reader.ok; ++i) {
+    SelfHistogram histogram;
+    histogram.name = reader.string();
+    histogram.count = reader.u64();
+    histogram.sumNs = reader.u64();
+    histogram.maxNs = reader.u64();
+    uint16_t buckets = reader.u16();
+    for (uint16_t b = 0; b < buckets && reader.ok; ++b) {
+      histogram.buckets.push_back(reader.u64());
+    }
+    stats.histograms.push_back(std::move(histogram));
+  }
+  return reader.finished();
+}
+
+bool DaemonProtocol::decodeError(std::string_view payload,
+                                 std::string &message) {
+  WireReader reader{payload};
+  message = reader.string();
+  return reader.finished();
+}
@@ -1,5 +1,7 @@
 
 #include "../include/data_monitoring.h"
+#include "../include/proc_paths.h"
+#include "../include/proc_reader.h"
 #include <atomic>
 #include <chrono>
 #include <fstream>
@@ -15,11 +17,15 @@ std::atomic<double> global_memory_usage(0.0);
 // Constants to replace magic numbers
 const int MEMORY_UPDATE_INTERVAL_SECONDS = 1;    // Interval for memory updates
 const int CPU_UPDATE_INTERVAL_SECONDS = 1;       // Interval for CPU updates
-const char *PROC_MEMINFO_PATH = "/proc/meminfo"; // Path for memory info file
-const char *PROC_STAT_PATH = "/proc/stat";       // Path for CPU stats file
+const char *PROC_MEMINFO_FILE = "meminfo";       // Memory info, below procfs
+const char *PROC_STAT_FILE = "stat";             // CPU stats, below procfs
 const char *MEM_TOTAL_KEY = "MemTotal"; // Key for total memory in /proc/meminfo
 const char *MEM_AVAILABLE_KEY =
     "MemAvailable"; // Key for available memory in /proc/meminfo
+const char *MEM_AVAILABLE_LINE_KEY =
+    "MemAvailable:"; // Key with separator, as used by ProcParsers
+const int CPU_IDLE_MODE = 3;   // Index of idle in CpuTimes::ticks
+const int CPU_IOWAIT_MODE = 4; // Index of iowait in CpuTimes::ticks
 
 DataMonitoring::DataMonitoring() : monitoring_(false) {}
 
@@ -47,9 +53,10 @@ void DataMonitoring::updateMemoryUsage() {
   static unsigned long long prev_available_memory = 0;
 
   while (monitoring_) {
-    std::ifstream meminfo(PROC_MEMINFO_PATH);
+    std::string path = ProcPaths::proc(PROC_MEMINFO_FILE);
+    std::ifstream meminfo(path);
     if (!meminfo) {
-      std::cerr << "Error: Could not open " << PROC_MEMINFO_PATH << ".\n";
+      std::cerr << "Error: Could not open " << path << ".\n";
       return;
     }
 
@@ -91,7 +98,7 @@ void DataMonitoring::updateMemoryUsage() {
 
 void DataMonitoring::updateCPUUsage() {
   while (monitoring_) {
-    std::ifstream file(PROC_STAT_PATH);
+    std::ifstream file(ProcPaths::proc(PROC_STAT_FILE));
     std::string line;
     std::getline(file, line); // Read the first line, which contains CPU stats
     file.close();
@@ -143,3 +150,30 @@ double DataMonitoring::getCPUUsage() {
   return global_cpu_usage
       .load(); // Return the current CPU usage from the global variable
 }
+
+bool DataMonitoring::readSystemCounters(SystemCounters &counters,
+                                        std::string &buffer) {
+  return ProcReader::readFile(ProcPaths::proc(PROC_STAT_FILE), buffer) &&
+         ProcParsers::parseCpuLines(buffer, counters.cpus) &&
+         ProcReader::readFile(ProcPaths::proc(PROC_MEMINFO_FILE), buffer) &&
+         ProcParsers::parseMemTotal(buffer, counters.memTotalKb) &&
+         ProcParsers::parseKeyedValue(buffer, MEM_AVAILABLE_LINE_KEY,
+                                      counters.memAvailableKb);
+}
+
+double DataMonitoring::cpuUsage(const CpuTimes &previous,
+                                const CpuTimes &current) {
+  unsigned long long total = 0;
+  for (int i = 0; i < CpuTimes::MODE_COUNT; ++i) {
+    total += current.ticks[i] - previous.ticks[i];
+  }
+  unsigned long long idle =
+      (current.ticks[CPU_IDLE_MODE] - previous.ticks[CPU_IDLE_MODE]) +
+      (current.ticks[CPU_IOWAIT_MODE] - previous.ticks[CPU_IOWAIT_MODE]);
+
+  // Counters can go backwards when a CPU is hotplugged
+  if (total == 0 || idle > total || total > (1ull << 62)) {
+    return 0.0;
+  }
+  return 100.0 * static_cast<double>(total - idle) / total;
+}
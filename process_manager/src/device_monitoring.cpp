@@ -0,0 +1,175 @@
+// src/device_monitoring.cpp
+
+#include "../include/device_monitoring.h"
+#include "../include/proc_paths.h"
+#include "../include/proc_reader.h"
+
+#include <algorithm>
+#include <unistd.h>
+
+namespace {
+const char *PROC_DISKSTATS_FILE = "diskstats"; // Below procfs
+const char *PROC_NET_DEV_FILE = "net/dev";     // Below procfs
+const char *SYS_BLOCK_DIR = "block/";          // Whole disks, below sysfs
+const double SECTOR_BYTES = 512.0;  // diskstats sectors are always 512 bytes
+const double MS_PER_SECOND = 1000.0;
+
+/**
+ * @brief Returns the increase of a counter, 0 if it was reset.
+ */
+double delta(unsigned long long current, unsigned long long previous) {
+  return current >= previous ? static_cast<double>(current - previous) : 0.0;
+}
+
+/**
+ * @brief Lines up the devices with the lines of a new sample.
+ *
+ * Entry `i` of `stats` and `previous` is made to describe line `i`. A device
+ * found further down is swapped into place, a new one is inserted with the
+ * line's counters as its previous ones, so that its first rates are zero,
+ * and devices left over at the end have disappeared.
+ *
+ * @param lines The parsed lines of the new sample.
+ * @param stats The rates per device, named.
+ * @param previous The counters of the previous sample, in `stats` order.
+ * @param onAdd Called with every inserted device.
+ */
+template <typename Stats, typename Counters, typename OnAdd>
+void alignDevices(const std::vector<Counters> &lines, std::vector<Stats> &stats,
+                  std::vector<Counters> &previous, OnAdd onAdd) {
+  for (size_t i = 0; i < lines.size(); ++i) {
+    if (i < stats.size() && stats[i].name == lines[i].name) {
+      continue; // The common case: the list did not change
+    }
+
+    size_t found = i + 1;
+    while (found < stats.size() && stats[found].name != lines[i].name) {
+      ++found;
+    }
+    if (found < stats.size()) {
+      std::swap(stats[i], stats[found]);
+      std::swap(previous[i], previous[found]);
+    } else {
+      Stats device;
+      device.name = lines[i].name;
+      onAdd(device);
+      stats.insert(stats.begin() + static_cast<long>(i), std::move(device));
+      previous.insert(previous.begin() + static_cast<long>(i), lines[i]);
+    }
+  }
+  stats.resize(std::min(stats.size(), lines.size()));
+  previous.resize(stats.size());
+}
+} // namespace
+
+DeviceMonitoring::DeviceMonitoring()
+    : lastSample_(std::chrono::steady_clock::now()) {}
+
+bool DeviceMonitoring::sample() {
+  auto now = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(now - lastSample_).count();
+  lastSample_ = now;
+
+  bool read = false;
+  if (ProcReader::readFile(ProcPaths::proc(PROC_DISKSTATS_FILE), buffer_) &&
+      ProcParsers::parseDiskstats(buffer_, diskLines_)) {
+    updateDisks(elapsed);
+    read = true;
+  }
+  if (ProcReader::readFile(ProcPaths::proc(PROC_NET_DEV_FILE), buffer_) &&
+      ProcParsers::parseNetDev(buffer_, netLines_)) {
+    updateInterfaces(elapsed);
+    read = true;
+  }
+  return read;
+}
+
+void DeviceMonitoring::updateDisks(double elapsedSeconds) {
+  alignDevices(diskLines_, diskStats_, diskCounters_, [](DiskStats &disk) {
+    // Partitions are listed below their disk, not in /sys/block
+    std::string path = ProcPaths::sys(SYS_BLOCK_DIR) + disk.name;
+    disk.wholeDisk = access(path.c_str(), F_OK) == 0;
+  });
+
+  for (size_t i = 0; i < diskLines_.size(); ++i) {
+    const DiskCounters &current = diskLines_[i];
+    DiskCounters &previous = diskCounters_[i];
+    DiskStats &disk = diskStats_[i];
+
+    double reads = delta(current.reads, previous.reads);
+    double writes = delta(current.writes, previous.writes);
+    disk.active = current.reads + current.writes > 0;
+    if (elapsedSeconds > 0.0) {
+      disk.readIops = reads / elapsedSeconds;
+      disk.writeIops = writes / elapsedSeconds;
+      disk.readRate = delta(current.readSectors, previous.readSectors) *
+                      SECTOR_BYTES / elapsedSeconds;
+      disk.writeRate = delta(current.writeSectors, previous.writeSectors) *
+                       SECTOR_BYTES / elapsedSeconds;
+      disk.utilization = std::min(100.0, delta(current.busyMs,
+                                               previous.busyMs) /
+                                             (elapsedSeconds * MS_PER_SECOND) *
+                                             100.0);
+    }
+    double waitedMs = delta(current.readMs, previous.readMs) +
+                      delta(current.writeMs, previous.writeMs);
+    disk.awaitMs = reads + writes > 0.0 ? waitedMs / (reads + writes) : 0.0;
+
+    previous = current;
+    previous.name = {}; // Points into the buffer of this sample
+  }
+}
+
+void DeviceMonitoring::updateInterfaces(double elapsedSeconds) {
+  alignDevices(netLines_, netStats_, netCounters_, [](NetStats &) {});
+
+  for (size_t i = 0; i < netLines_.size(); ++i) {
+    const NetCounters &current = netLines_[i];
+    NetCounters &previous = netCounters_[i];
+    NetStats &interface = netStats_[i];
+
+    if (elapsedSeconds > 0.0) {
+      interface.rxRate = delta(current.rxBytes, previous.rxBytes) /
+                         elapsedSeconds;
+      interface.txRate = delta(current.txBytes, previous.txBytes) /
+                         elapsedSeconds;
+      interface.rxPackets = delta(current.rxPackets, previous.rxPackets) /
+                            elapsedSeconds;
+      interface.txPackets = delta(current.txPackets, previous.txPackets) /
+                            elapsedSeconds;
+      interface.drops = (delta(current.rxDrops, previous.rxDrops) +
+                         delta(current.txDrops, previous.txDrops)) /
+                        elapsedSeconds;
+    }
+
+    previous = current;
+    previous.name = {}; // Points into the buffer of this sample
+  }
+}
+
+std::vector<DiskStats> DeviceMonitoring::getTopDisks(size_t count) const {
+  std::vector<DiskStats> top;
+  for (const DiskStats &disk : diskStats_) {
+    if (disk.wholeDisk && disk.active) {
+      top.push_back(disk);
+    }
+  }
+  count = std::min(count, top.size());
+  std::partial_sort(top.begin(), top.begin() + static_cast<long>(count),
+                    top.end(), [](const DiskStats &a, const DiskStats &b) {
+                      return a.utilization > b.utilization;
+                    });
+  top.resize(count);
+  return top;
+}
+
+std::vector<NetStats> DeviceMonitoring::getTopInterfaces(size_t count) const {
+  std::vector<NetStats> top = netStats_;
+  count = std::min(count, top.size());
+  std::partial_sort(top.begin(), top.begin() + static_cast<long>(count),
+                    top.end(), [](const NetStats &a, const NetStats &b) {
+                      return a.rxRate + a.txRate > b.rxRate + b.txRate;
+                    });
+  top.resize(count);
+  return top;
+}
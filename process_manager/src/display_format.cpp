@@ -0,0 +1,88 @@
+// src/display_format.cpp
+
+#include "../include/display_format.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+const double HIGH_USAGE_THRESHOLD =
+    50.0; // Threshold for high usage (CPU/Memory)
+const double MODERATE_USAGE_THRESHOLD =
+    20.0; // Threshold for moderate usage (CPU/Memory)
+
+const double BYTES_PER_UNIT = 1024.0;          // Divisor between binary units
+const char BYTE_UNITS[] = "BKMGTP";            // Suffixes of the binary units
+const char *HIGH_USAGE_COLOR = "\033[31m";     // Red for high usage
+const char *MODERATE_USAGE_COLOR = "\033[33m"; // Yellow for moderate usage
+const char *LOW_USAGE_COLOR = "\033[32m";      // Green for low usage
+const char *RESET_COLOR = "\033[0m";           // Reset color
+const char *NO_COLOR = "";                     // Used when colors are off
+const char *const SPARK_BARS[] = {"\u2581", "\u2582", "\u2583", "\u2584",
+                                  "\u2585", "\u2586", "\u2587", "\u2588"};
+const size_t SPARK_LEVELS = 8; // Heights of the sparkline bars
+} // namespace
+
+bool DisplayFormat::colorEnabled_ = true;
+
+std::string DisplayFormat::bytes(unsigned long long bytes) {
+  double value = static_cast<double>(bytes);
+  size_t unit = 0;
+  while (value >= BYTES_PER_UNIT && unit + 2 < sizeof(BYTE_UNITS)) {
+    value /= BYTES_PER_UNIT;
+    ++unit;
+  }
+
+  std::ostringstream stream;
+  if (unit == 0) {
+    stream << bytes << BYTE_UNITS[0];
+  } else {
+    stream << std::fixed << std::setprecision(1) << value << BYTE_UNITS[unit];
+  }
+  return stream.str();
+}
+
+std::string DisplayFormat::sparkline(const std::vector<double> &values,
+                                     size_t width) {
+  size_t columns = std::min(values.size(), width);
+  if (columns == 0) {
+    return std::string();
+  }
+  std::vector<double> peaks(columns, 0.0);
+  for (size_t i = 0; i < values.size(); ++i) {
+    double &peak = peaks[i * columns / values.size()];
+    peak = std::max(peak, values[i]);
+  }
+  double top = *std::max_element(peaks.begin(), peaks.end());
+
+  std::string line;
+  for (double peak : peaks) {
+    size_t level = 0;
+    if (top > 0.0) {
+      level = std::min(static_cast<size_t>(peak / top * SPARK_LEVELS),
+                       SPARK_LEVELS - 1);
+    }
+    line += SPARK_BARS[level];
+  }
+  return line;
+}
+
+const char *DisplayFormat::usageColor(double usage) {
+  if (!colorEnabled_) {
+    return NO_COLOR;
+  }
+  if (usage > HIGH_USAGE_THRESHOLD) {
+    return HIGH_USAGE_COLOR;
+  }
+  if (usage > MODERATE_USAGE_THRESHOLD) {
+    return MODERATE_USAGE_COLOR;
+  }
+  return LOW_USAGE_COLOR;
+}
+
+const char *DisplayFormat::resetColor() {
+  return colorEnabled_ ? RESET_COLOR : NO_COLOR;
+}
+
+void DisplayFormat::setColorEnabled(bool enabled) { colorEnabled_ = enabled; }
@@ -0,0 +1,415 @@
+// src/fake_procfs.cpp
+
+#include "../include/fake_procfs.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+const double TICKS_PER_SECOND = 100.0;    // USER_HZ of the stat files
+const double USER_SHARE = 0.8;            // CPU time spent in user mode
+const double MEMORY_IN_USE = 0.6;         // RSS of all processes vs. total
+const double RSS_SPREAD_BITS = 4.0;       // RSS varies by 2^±4 around mean
+const double RSS_SPREAD_MEAN = 2.87;      // Mean of 2^U for U in [-4, 4)
+const double BUSY_TARGET = 0.9;           // CPU share of the busy profile
+const double IO_PROCESS_SHARE = 0.1;      // Processes doing I/O
+const unsigned long long BOOT_TIME = 1700000000; // btime of the stat file
+const char *REPLACE_SUFFIX = ".new";      // Temporary name while writing
+
+/// Names and command lines of the synthetic processes; an empty command
+/// line marks a kernel thread
+const struct {
+  const char *comm;
+  const char *cmdline;
+} PROGRAMS[] = {
+    {"systemd", "/sbin/init\0splash"},
+    {"kworker/3:1-events", ""},
+    {"bash", "-bash"},
+    {"sshd", "sshd: deploy@pts/0"},
+    {"postgres", "postgres: checkpointer"},
+    {"nginx", "nginx: worker process"},
+    {"python3", "/usr/bin/python3\0-m\0http.server\0008080"},
+    {"java", "/usr/lib/jvm/bin/java\0-Xmx4g\0-jar\0app.jar"},
+    {"node", "node\0/srv/app/server.js"},
+    {"Web Content", "/usr/lib/firefox/firefox\0-contentproc\0-childID\00012"},
+    {"(sd-pam)", "(sd-pam)"},
+    {"containerd-shim", "/usr/bin/containerd-shim-runc-v2\0-namespace\0moby"},
+    {"redis-server", "redis-server *:6379"},
+    {"rsyslogd", "/usr/sbin/rsyslogd\0-n"},
+};
+
+/// Lengths of the command lines above, which contain NUL separators
+const size_t PROGRAM_CMDLINE_LENGTHS[] = {
+    sizeof("/sbin/init\0splash") - 1,
+    0,
+    sizeof("-bash") - 1,
+    sizeof("sshd: deploy@pts/0") - 1,
+    sizeof("postgres: checkpointer") - 1,
+    sizeof("nginx: worker process") - 1,
+    sizeof("/usr/bin/python3\0-m\0http.server\0008080") - 1,
+    sizeof("/usr/lib/jvm/bin/java\0-Xmx4g\0-jar\0app.jar") - 1,
+    sizeof("node\0/srv/app/server.js") - 1,
+    sizeof("/usr/lib/firefox/firefox\0-contentproc\0-childID\00012") - 1,
+    sizeof("(sd-pam)") - 1,
+    sizeof("/usr/bin/containerd-shim-runc-v2\0-namespace\0moby") - 1,
+    sizeof("redis-server *:6379") - 1,
+    sizeof("/usr/sbin/rsyslogd\0-n") - 1,
+};
+
+const size_t PROGRAM_COUNT = sizeof(PROGRAMS) / sizeof(PROGRAMS[0]);
+
+/**
+ * @brief Writes a file, optionally replacing it atomically.
+ */
+bool writeFile(const std::string &path, const std::string &contents,
+               bool replace, std::string &error) {
+  std::string target = replace ? path + REPLACE_SUFFIX : path;
+  {
+    std::ofstream file(target, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    if (!file) {
+      error = "Cannot write " + target;
+      return false;
+    }
+  }
+  if (replace && std::rename(target.c_str(), path.c_str()) != 0) {
+    error = "Cannot replace " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+FakeProcfs::FakeProcfs(const FakeProcfsOptions &options)
+    : options_(options), state_(options.seed) {
+  options_.cpus = std::max(options_.cpus, 1u);
+  long pageSize = sysconf(_SC_PAGESIZE);
+  pageSizeKb_ = pageSize > 0 ? static_cast<size_t>(pageSize) / 1024 : 4;
+}
+
+bool FakeProcfs::parseLoad(const std::string &text, FakeLoad &load) {
+  if (text == "idle") {
+    load = FakeLoad::Idle;
+  } else if (text == "mixed") {
+    load = FakeLoad::Mixed;
+  } else if (text == "busy") {
+    load = FakeLoad::Busy;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+uint64_t FakeProcfs::nextRandom() {
+  uint64_t z = (state_ += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+double FakeProcfs::uniform(double low, double high) {
+  double unit = static_cast<double>(nextRandom() >> 11) * 0x1.0p-53;
+  return low + unit * (high - low);
+}
+
+FakeProcfs::Process FakeProcfs::spawn() {
+  Process process;
+  process.pid = nextPid_++;
+  process.ppid = process.pid == 1 ? 0 : 1;
+  process.name = static_cast<size_t>(nextRandom() % PROGRAM_COUNT);
+  process.startTime =
+      static_cast<unsigned long long>(uptime_ * TICKS_PER_SECOND);
+
+  double roll = uniform(0.0, 1.0);
+  switch (options_.load) {
+  case FakeLoad::Idle:
+    process.share = roll < 0.98 ? uniform(0.0, 0.002) : uniform(0.01, 0.05);
+    break;
+  case FakeLoad::Mixed:
+    process.share = roll < 0.90   ? uniform(0.0, 0.01)
+                    : roll < 0.99 ? uniform(0.01, 0.3)
+                                  : uniform(0.5, 1.0);
+    break;
+  case FakeLoad::Busy:
+    process.share = std::min(1.0, uniform(0.0, 2.0) * BUSY_TARGET *
+                                      options_.cpus /
+                                      std::max<size_t>(options_.processes, 1));
+    break;
+  }
+
+  process.threads =
+      uniform(0.0, 1.0) < 0.7 ? 1 : static_cast<long>(std::exp2(uniform(1, 7)));
+  double meanRssKb = MEMORY_IN_USE * static_cast<double>(options_.memTotalKb) /
+                     std::max<size_t>(options_.processes, 1);
+  double rssKb = meanRssKb *
+                 std::exp2(uniform(-RSS_SPREAD_BITS, RSS_SPREAD_BITS)) /
+                 RSS_SPREAD_MEAN;
+  process.rssPages = std::max<unsigned long long>(
+      1, static_cast<unsigned long long>(rssKb / pageSizeKb_));
+  process.sizePages = static_cast<unsigned long long>(
+      static_cast<double>(process.rssPages) * uniform(2.0, 8.0));
+  ++forks_;
+  return process;
+}
+
+bool FakeProcfs::create(const std::string &root, std::string &error) {
+  std::error_code failure;
+  fs::create_directories(root, failure);
+  if (failure) {
+    error = "Cannot create " + root + ": " + failure.message();
+    return false;
+  }
+  root_ = root;
+  cpuBusy_.assign(options_.cpus, 0.0);
+  cpuIdle_.assign(options_.cpus, 0.0);
+
+  processes_.clear();
+  processes_.reserve(options_.processes);
+  for (size_t i = 0; i < options_.processes; ++i) {
+    processes_.push_back(spawn());
+    if (!writeProcess(processes_.back(), true, error)) {
+      return false;
+    }
+  }
+  return writeSystem(error);
+}
+
+bool FakeProcfs::advance(double seconds, std::string &error) {
+  uptime_ += seconds;
+  double ticksPerCpu = seconds * TICKS_PER_SECOND;
+
+  // Replace a share of the processes with new ones
+  auto replaced = static_cast<size_t>(
+      std::lround(options_.churn * static_cast<double>(processes_.size())));
+  replaced = std::min(replaced, processes_.size());
+  for (size_t i = 0; i < replaced; ++i) {
+    size_t pick = i + static_cast<size_t>(nextRandom() %
+                                          (processes_.size() - i));
+    std::swap(processes_[i], processes_[pick]);
+    std::error_code ignored;
+    fs::remove_all(root_ + "/" + std::to_string(processes_[i].pid), ignored);
+    processes_[i] = spawn();
+    if (!writeProcess(processes_[i], true, error)) {
+      return false;
+    }
+  }
+  std::sort(processes_.begin(), processes_.end(),
+            [](const Process &a, const Process &b) { return a.pid < b.pid; });
+
+  // Charge CPU time, faults, switches and I/O; the processes never use more
+  // than the machine has
+  std::vector<double> used(processes_.size());
+  double total = 0.0;
+  for (size_t i = 0; i < processes_.size(); ++i) {
+    used[i] = processes_[i].share * ticksPerCpu * uniform(0.8, 1.2);
+    total += used[i];
+  }
+  double capacity = ticksPerCpu * options_.cpus;
+  double scale = total > capacity ? capacity / total : 1.0;
+  for (size_t i = 0; i < processes_.size(); ++i) {
+    Process &process = processes_[i];
+    double ticks = used[i] * scale;
+    process.ticks += ticks;
+    process.minorFaults +=
+        static_cast<unsigned long long>(ticks * uniform(5.0, 50.0));
+    process.majorFaults += uniform(0.0, 1.0) < 0.01 ? 1 : 0;
+    process.voluntary +=
+        static_cast<unsigned long long>(seconds * uniform(0.0, 50.0));
+    process.involuntary += static_cast<unsigned long long>(ticks / 10);
+    if (uniform(0.0, 1.0) < IO_PROCESS_SHARE) {
+      process.readBytes +=
+          static_cast<unsigned long long>(seconds * uniform(0, 256)) * 4096;
+      process.writeBytes +=
+          static_cast<unsigned long long>(seconds * uniform(0, 64)) * 4096;
+    }
+    if (!writeProcess(process, false, error)) {
+      return false;
+    }
+  }
+  double busyPerCpu = total * scale / options_.cpus;
+  for (unsigned cpu = 0; cpu < options_.cpus; ++cpu) {
+    cpuBusy_[cpu] += busyPerCpu;
+    cpuIdle_[cpu] += ticksPerCpu - busyPerCpu;
+  }
+  lastCpuUsage_ = capacity > 0 ? 100.0 * total * scale / capacity : 0.0;
+  return writeSystem(error);
+}
+
+std::vector<int> FakeProcfs::pids() const {
+  std::vector<int> pids;
+  pids.reserve(processes_.size());
+  for (const Process &process : processes_) {
+    pids.push_back(process.pid);
+  }
+  std::sort(pids.begin(), pids.end());
+  return pids;
+}
+
+bool FakeProcfs::writeProcess(const Process &process, bool created,
+                              std::string &error) {
+  std::string directory = root_ + "/" + std::to_string(process.pid) + "/";
+  const auto &program = PROGRAMS[process.name];
+  bool kernelThread = PROGRAM_CMDLINE_LENGTHS[process.name] == 0;
+
+  if (created) {
+    std::error_code failure;
+    fs::create_directories(directory + "fd", failure);
+    if (failure) {
+      error = "Cannot create " + directory + ": " + failure.message();
+      return false;
+    }
+    for (unsigned fd = 0; fd < options_.fdsPerProcess && !kernelThread; ++fd) {
+      std::string link = directory + "fd/" + std::to_string(fd);
+      if (symlink("/dev/null", link.c_str()) != 0 && errno != EEXIST) {
+        error = "Cannot create " + link + ": " + std::strerror(errno);
+        return false;
+      }
+    }
+    std::string cmdline(program.cmdline,
+                        PROGRAM_CMDLINE_LENGTHS[process.name]);
+    if (!cmdline.empty()) {
+      cmdline.push_back('\0');
+    }
+    if (!writeFile(directory + "cmdline", cmdline, false, error) ||
+        !writeFile(directory + "comm", std::string(program.comm) + "\n",
+                   false, error)) {
+      return false;
+    }
+  }
+
+  auto ticks = static_cast<unsigned long long>(process.ticks);
+  auto utime = static_cast<unsigned long long>(ticks * USER_SHARE);
+  char line[512];
+  std::snprintf(line, sizeof(line),
+                "%d (%s) %c %d %d %d 0 -1 %u %llu 0 %llu 0 %llu %llu 0 0 20 0 "
+                "%ld 0 %llu %llu %llu 18446744073709551615",
+                process.pid, program.comm, process.share > 0.5 ? 'R' : 'S',
+                process.ppid, process.pid, process.pid,
+                kernelThread ? 0x208040u : 0x400100u, process.minorFaults,
+                process.majorFaults, utime, ticks - utime, process.threads,
+                process.startTime, process.sizePages * pageSizeKb_ * 1024,
+                process.rssPages);
+  // startcode through exit_code, mostly zero as for a sleeping process
+  std::string stat = line;
+  for (int field = 26; field <= 52; ++field) {
+    stat += field == 38 ? " 17" : " 0";
+  }
+  stat += '\n';
+
+  std::snprintf(line, sizeof(line), "%llu %llu %llu 1 0 %llu 0\n",
+                process.sizePages, process.rssPages, process.rssPages / 4,
+                process.sizePages / 2);
+  std::string statm = line;
+
+  std::snprintf(
+      line, sizeof(line),
+      "Name:\t%s\nUmask:\t0022\nState:\t%s\nTgid:\t%d\nNgid:\t0\nPid:\t%d\n"
+      "PPid:\t%d\nTracerPid:\t0\nUid:\t%u\t%u\t%u\t%u\n"
+      "Gid:\t%u\t%u\t%u\t%u\nFDSize:\t64\nVmSize:\t%llu kB\n"
+      "VmRSS:\t%llu kB\nThreads:\t%ld\n",
+      program.comm, process.share > 0.5 ? "R (running)" : "S (sleeping)",
+      process.pid, process.pid, process.ppid, getuid(), getuid(), getuid(),
+      getuid(), getgid(), getgid(), getgid(), getgid(),
+      process.sizePages * pageSizeKb_, process.rssPages * pageSizeKb_,
+      process.threads);
+  std::string status = line;
+  std::snprintf(line, sizeof(line),
+                "Cpus_allowed_list:\t0-%u\nvoluntary_ctxt_switches:\t%llu\n"
+                "nonvoluntary_ctxt_switches:\t%llu\n",
+                options_.cpus - 1, process.voluntary, process.involuntary);
+  status += line;
+
+  std::snprintf(line, sizeof(line),
+                "rchar: %llu\nwchar: %llu\nsyscr: %llu\nsyscw: %llu\n"
+                "read_bytes: %llu\nwrite_bytes: %llu\n"
+                "cancelled_write_bytes: 0\n",
+                process.readBytes * 2, process.writeBytes * 2,
+                process.readBytes / 4096, process.writeBytes / 4096,
+                process.readBytes, process.writeBytes);
+  std::string io = line;
+
+  unsigned long long rssKb = process.rssPages * pageSizeKb_;
+  std::snprintf(line, sizeof(line),
+                "00400000-7ffc00000000 ---p 00000000 00:00 0   [rollup]\n"
+                "Rss:            %8llu kB\nPss:            %8llu kB\n"
+                "Shared_Clean:   %8llu kB\nShared_Dirty:   %8llu kB\n"
+                "Private_Clean:  %8llu kB\nPrivate_Dirty:  %8llu kB\n"
+                "Swap:                  0 kB\n",
+                rssKb, rssKb * 3 / 4, rssKb / 4, 0ull, rssKb / 4, rssKb / 2);
+  std::string smaps = line;
+
+  // Files a scan may be reading are swapped in whole
+  bool replace = !created;
+  return writeFile(directory + "stat", stat, replace, error) &&
+         writeFile(directory + "statm", statm, replace, error) &&
+         writeFile(directory + "status", status, replace, error) &&
+         writeFile(directory + "io", io, replace, error) &&
+         writeFile(directory + "smaps_rollup", smaps, replace, error);
+}
+
+bool FakeProcfs::writeSystem(std::string &error) {
+  auto format = [](const char *label, double busy, double idle) {
+    auto user = static_cast<unsigned long long>(busy * USER_SHARE);
+    auto system = static_cast<unsigned long long>(busy) - user;
+    char line[160];
+    std::snprintf(line, sizeof(line), "%s %llu 0 %llu %llu 0 0 0 0 0 0\n",
+                  label, user, system,
+                  static_cast<unsigned long long>(idle));
+    return std::string(line);
+  };
+  double busy = 0.0;
+  double idle = 0.0;
+  for (unsigned cpu = 0; cpu < options_.cpus; ++cpu) {
+    busy += cpuBusy_[cpu];
+    idle += cpuIdle_[cpu];
+  }
+  std::string stat = format("cpu ", busy, idle);
+  for (unsigned cpu = 0; cpu < options_.cpus; ++cpu) {
+    stat += format(("cpu" + std::to_string(cpu)).c_str(), cpuBusy_[cpu],
+                   cpuIdle_[cpu]);
+  }
+  size_t running = 0;
+  unsigned long long switches = 0;
+  unsigned long long rssKb = 0;
+  for (const Process &process : processes_) {
+    running += process.share > 0.5 ? 1 : 0;
+    switches += process.voluntary + process.involuntary;
+    rssKb += process.rssPages * pageSizeKb_;
+  }
+  stat += "intr 0\nctxt " + std::to_string(switches) + "\nbtime " +
+          std::to_string(BOOT_TIME) + "\nprocesses " +
+          std::to_string(forks_) + "\nprocs_running " +
+          std::to_string(std::max<size_t>(running, 1)) +
+          "\nprocs_blocked 0\n";
+
+  unsigned long long total = options_.memTotalKb;
+  unsigned long long available =
+      rssKb < total ? std::max(total - rssKb, total / 20) : total / 20;
+  char meminfo[512];
+  std::snprintf(meminfo, sizeof(meminfo),
+                "MemTotal:       %llu kB\nMemFree:        %llu kB\n"
+                "MemAvailable:   %llu kB\nBuffers:        %llu kB\n"
+                "Cached:         %llu kB\nSwapCached:     0 kB\n"
+                "SwapTotal:      0 kB\nSwapFree:       0 kB\n"
+                "Shmem:          %llu kB\n",
+                total, available / 2, available, total / 100,
+                available / 2, total / 200);
+
+  char uptime[64];
+  std::snprintf(uptime, sizeof(uptime), "%.2f %.2f\n", uptime_,
+                idle / TICKS_PER_SECOND);
+
+  return writeFile(root_ + "/stat", stat, true, error) &&
+         writeFile(root_ + "/meminfo", meminfo, true, error) &&
+         writeFile(root_ + "/uptime", uptime, true, error);
+}
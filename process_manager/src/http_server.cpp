@@ -0,0 +1,417 @@
+// src/http_server.cpp
+
+#include "../include/http_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+const int MAX_EVENTS = 64;                 // Events handled per epoll_wait
+const size_t READ_BUFFER_SIZE = 4096;      // Bytes read per read call
+const size_t MAX_REQUEST_BYTES = 16384;    // Largest accepted request header
+const size_t MAX_CONNECTIONS = 1024;       // Concurrent clients
+const char *HEADER_END = "\r\n\r\n";       // Terminates the request header
+const char *ALLOWED_METHODS = "GET, HEAD"; // Methods that are served
+
+/**
+ * @brief Returns a lowercase copy of an ASCII string.
+ */
+std::string toLower(std::string text) {
+  std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+    return static_cast<char>(std::tolower(c));
+  });
+  return text;
+}
+
+/**
+ * @brief Returns the value of a header, or an empty string if absent.
+ *
+ * `headers` must already be lowercase.
+ */
+std::string headerValue(const std::string &headers, const std::string &name) {
+  size_t pos = headers.find("\r\n" + name + ":");
+  if (pos == std::string::npos) {
+    return std::string();
+  }
+  pos += name.size() + 3;
+  size_t end = headers.find("\r\n", pos);
+  std::string value = headers.substr(pos, end - pos);
+  size_t first = value.find_first_not_of(" \t");
+  size_t last = value.find_last_not_of(" \t");
+  return first == std::string::npos ? std::string()
+                                    : value.substr(first, last - first + 1);
+}
+
+/**
+ * @brief Returns a shared body holding a fixed message.
+ */
+std::shared_ptr<const std::string> staticBody(const char *text) {
+  return std::make_shared<const std::string>(text);
+}
+} // namespace
+
+HttpServer::HttpServer()
+    : listenFd_(-1), epollFd_(epoll_create1(EPOLL_CLOEXEC)),
+      wakeupFd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = wakeupFd_;
+  epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeupFd_, &event);
+}
+
+HttpServer::~HttpServer() {
+  for (auto &[fd, connection] : connections_) {
+    close(fd);
+  }
+  if (listenFd_ >= 0) {
+    close(listenFd_);
+  }
+  close(wakeupFd_);
+  close(epollFd_);
+}
+
+void HttpServer::addRoute(const std::string &path,
+                          const std::string &contentType,
+                          BodyProvider provider) {
+  routes_[path] = Route{contentType, std::move(provider)};
+}
+
+bool HttpServer::listen(const std::string &address, std::string &error) {
+  size_t colon = address.rfind(':');
+  if (colon == std::string::npos || colon + 1 == address.size()) {
+    error = "Expected HOST:PORT, got '" + address + "'";
+    return false;
+  }
+
+  std::string host = address.substr(0, colon);
+  char *end = nullptr;
+  unsigned long port = std::strtoul(address.c_str() + colon + 1, &end, 10);
+  if (*end != '\0' || port == 0 || port > UINT16_MAX) {
+    error = "Invalid port in '" + address + "'";
+    return false;
+  }
+
+  sockaddr_storage storage{};
+  socklen_t length = 0;
+  int family = AF_INET;
+  if (host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+    auto *ipv6 = reinterpret_cast<sockaddr_in6 *>(&storage);
+    family = AF_INET6;
+    ipv6->sin6_family = AF_INET6;
+    ipv6->sin6_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET6, host.substr(1, host.size() - 2).c_str(),
+                  &ipv6->sin6_addr) != 1) {
+      error = "Invalid IPv6 address '" + host + "'";
+      return false;
+    }
+    length = sizeof(sockaddr_in6);
+  } else {
+    auto *ipv4 = reinterpret_cast<sockaddr_in *>(&storage);
+    ipv4->sin_family = AF_INET;
+    ipv4->sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &ipv4->sin_addr) != 1) {
+      error = "Invalid IPv4 address '" + host + "'";
+      return false;
+    }
+    length = sizeof(sockaddr_in);
+  }
+
+  listenFd_ = socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listenFd_ < 0) {
+    error = std::string("socket: ") + std::strerror(errno);
+    return false;
+  }
+  int reuse = 1;
+  setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  if (bind(listenFd_, reinterpret_cast<sockaddr *>(&storage), length) != 0 ||
+      ::listen(listenFd_, SOMAXCONN) != 0) {
+    error = "Cannot listen on " + address + ": " + std::strerror(errno);
+    close(listenFd_);
+    listenFd_ = -1;
+    return false;
+  }
+
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = listenFd_;
+  epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event);
+  return true;
+}
+
+bool HttpServer::run(std::string &error) {
+  epoll_event events[MAX_EVENTS];
+  while (true) {
+    int count = epoll_wait(epollFd_, events, MAX_EVENTS, -1);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      error = std::string("epoll_wait: ") + std::strerror(errno);
+      return false;
+    }
+
+    for (int i = 0; i < count; ++i) {
+      int fd = events[i].data.fd;
+      if (fd == wakeupFd_) {
+        uint64_t value = 0;
+        ssize_t ignored = read(wakeupFd_, &value, sizeof(value));
+        (void)ignored;
+        return true;
+      }
+      if (fd == listenFd_) {
+        acceptConnections();
+        continue;
+      }
+
+      bool keep = true;
+      if ((events[i].events & (EPOLLERR | EPOLLHUP)) != 0 &&
+          (events[i].events & EPOLLIN) == 0) {
+        keep = false;
+      }
+      if (keep && (events[i].events & EPOLLIN) != 0) {
+        keep = handleReadable(fd);
+      }
+      if (keep && (events[i].events & EPOLLOUT) != 0) {
+        keep = handleWritable(fd);
+      }
+      if (!keep) {
+        closeConnection(fd);
+      }
+    }
+  }
+}
+
+void HttpServer::stop() {
+  uint64_t value = 1;
+  ssize_t ignored = write(wakeupFd_, &value, sizeof(value));
+  (void)ignored;
+}
+
+void HttpServer::acceptConnections() {
+  while (true) {
+    int fd = accept4(listenFd_, nullptr, nullptr,
+                     SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      return; // EAGAIN once the backlog is drained
+    }
+    if (connections_.size() >= MAX_CONNECTIONS) {
+      close(fd);
+      continue;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+      close(fd);
+      continue;
+    }
+    connections_.emplace(fd, Connection());
+  }
+}
+
+bool HttpServer::handleReadable(int fd) {
+  Connection &connection = connections_[fd];
+  char buffer[READ_BUFFER_SIZE];
+  while (true) {
+    ssize_t bytes = read(fd, buffer, sizeof(buffer));
+    if (bytes > 0) {
+      connection.input.append(buffer, static_cast<size_t>(bytes));
+      if (connection.input.size() > MAX_REQUEST_BYTES) {
+        return false;
+      }
+      continue;
+    }
+    if (bytes == 0) {
+      // The client closed its side; it may still wait for the responses to
+      // the requests it sent before, e.g. `printf ... | nc`
+      connection.readClosed = true;
+      break;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      break;
+    }
+    return false;
+  }
+
+  // Pipelined requests wait until the current response is sent
+  if (connection.writing) {
+    if (connection.readClosed) {
+      // Only wait for room to write; EOF would keep reporting EPOLLIN
+      epoll_event event{};
+      event.events = EPOLLOUT;
+      event.data.fd = fd;
+      epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event);
+    }
+    return true;
+  }
+  return handleWritable(fd);
+}
+
+bool HttpServer::handleWritable(int fd) {
+  Connection &connection = connections_[fd];
+  while (connection.header.empty() ? prepareResponse(connection) : true) {
+    size_t headerSize = connection.header.size();
+    size_t bodySize = connection.body ? connection.body->size() : 0;
+
+    // Send the header and the shared body without concatenating them
+    while (connection.sent < headerSize + bodySize) {
+      iovec parts[2];
+      int count = 0;
+      if (connection.sent < headerSize) {
+        parts[count].iov_base = connection.header.data() + connection.sent;
+        parts[count].iov_len = headerSize - connection.sent;
+        ++count;
+      }
+      size_t bodySent =
+          connection.sent > headerSize ? connection.sent - headerSize : 0;
+      if (bodySent < bodySize) {
+        parts[count].iov_base =
+            const_cast<char *>(connection.body->data() + bodySent);
+        parts[count].iov_len = bodySize - bodySent;
+        ++count;
+      }
+
+      msghdr message{};
+      message.msg_iov = parts;
+      message.msg_iovlen = static_cast<size_t>(count);
+      ssize_t bytes = sendmsg(fd, &message, MSG_NOSIGNAL);
+      if (bytes < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+          return false;
+        }
+        // The socket is full: resume when it becomes writable
+        if (!connection.writing) {
+          epoll_event event{};
+          event.events = connection.readClosed
+                             ? EPOLLOUT
+                             : EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+          event.data.fd = fd;
+          epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event);
+          connection.writing = true;
+        }
+        return true;
+      }
+      connection.sent += static_cast<size_t>(bytes);
+    }
+
+    bool closeAfterResponse = connection.closeAfterResponse;
+    connection.header.clear();
+    connection.body.reset();
+    connection.sent = 0;
+    if (closeAfterResponse) {
+      return false;
+    }
+  }
+
+  if (connection.readClosed) {
+    return false; // Every complete request was answered
+  }
+  if (connection.writing) {
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = fd;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &event);
+    connection.writing = false;
+  }
+  return true;
+}
+
+bool HttpServer::prepareResponse(Connection &connection) {
+  size_t headerEnd = connection.input.find(HEADER_END);
+  if (headerEnd == std::string::npos) {
+    return false;
+  }
+
+  std::string request = connection.input.substr(0, headerEnd + 2);
+  connection.input.erase(0, headerEnd + std::strlen(HEADER_END));
+
+  // Request line: METHOD SP TARGET SP VERSION
+  size_t lineEnd = request.find("\r\n");
+  std::string line = request.substr(0, lineEnd);
+  size_t firstSpace = line.find(' ');
+  size_t secondSpace = firstSpace == std::string::npos
+                           ? std::string::npos
+                           : line.find(' ', firstSpace + 1);
+  std::string headers = toLower(request.substr(lineEnd));
+
+  int status = 200;
+  const char *reason = "OK";
+  std::string contentType = "text/plain; charset=utf-8";
+  std::shared_ptr<const std::string> body;
+  bool headOnly = false;
+
+  if (secondSpace == std::string::npos ||
+      line.compare(secondSpace + 1, 5, "HTTP/") != 0 ||
+      !headerValue(headers, "content-length").empty() ||
+      !headerValue(headers, "transfer-encoding").empty()) {
+    // Malformed, or carrying a body this server does not read
+    status = 400;
+    reason = "Bad Request";
+    body = staticBody("Bad Request\n");
+    connection.closeAfterResponse = true;
+  } else {
+    std::string method = line.substr(0, firstSpace);
+    std::string target =
+        line.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+    std::string version = line.substr(secondSpace + 1);
+    std::string connectionHeader = headerValue(headers, "connection");
+    connection.closeAfterResponse =
+        version == "HTTP/1.0" ? connectionHeader != "keep-alive"
+                              : connectionHeader == "close";
+
+    std::string path = target.substr(0, target.find('?'));
+    auto route = routes_.find(path);
+    headOnly = method == "HEAD";
+    if (method != "GET" && method != "HEAD") {
+      status = 405;
+      reason = "Method Not Allowed";
+      body = staticBody("Method Not Allowed\n");
+    } else if (route == routes_.end()) {
+      status = 404;
+      reason = "Not Found";
+      body = staticBody("Not Found\n");
+    } else {
+      contentType = route->second.contentType;
+      body = route->second.provider();
+    }
+  }
+
+  size_t contentLength = body ? body->size() : 0;
+  connection.header = "HTTP/1.1 " + std::to_string(status) + " " + reason +
+                      "\r\nContent-Type: " + contentType +
+                      "\r\nContent-Length: " + std::to_string(contentLength) +
+                      "\r\n";
+  if (status == 405) {
+    connection.header += std::string("Allow: ") + ALLOWED_METHODS + "\r\n";
+  }
+  if (connection.closeAfterResponse) {
+    connection.header += "Connection: close\r\n";
+  }
+  connection.header += "\r\n";
+  connection.body = headOnly ? nullptr : body;
+  connection.sent = 0;
+  return true;
+}
+
+void HttpServer::closeConnection(int fd) {
+  epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, nullptr);
+  close(fd);
+  connections_.erase(fd);
+}
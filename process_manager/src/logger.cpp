@@ -1,5 +1,6 @@
 
 #include "../include/logger.h"
+#include "../include/self_stats.h"
 #include <iostream>
 #include <spdlog/sinks/basic_file_sink.h> // Required for the file sink
 
@@ -10,24 +11,52 @@ const std::string LOG_FILE_PATH = "logs/process_manager.log"; // Log file path
 const std::string LOG_PATTERN =
     "[%Y-%m-%d %H:%M:%S] [%l] %v"; // Log format pattern
 const int DISPLAY_LOG_LINES = 10;  // Number of recent logs to display
+
+/**
+ * @brief Accounts one message for `SelfStats` while it is being written.
+ *
+ * Messages are written synchronously, so the logger's queue is the callers
+ * waiting for the file; its depth is the number of messages in flight.
+ */
+class WriteScope {
+public:
+  WriteScope() : timer_(SelfTimer::LogWrite) {
+    SelfStats::adjust(SelfGauge::LoggerQueueDepth, 1);
+  }
+  ~WriteScope() {
+    SelfStats::adjust(SelfGauge::LoggerQueueDepth, -1);
+    SelfStats::add(SelfCounter::LogMessages);
+  }
+
+private:
+  SelfTimerScope timer_;
+};
 } // namespace
 
-Logger::Logger() { initializeLogger(); }
+Logger::Logger() {
+  // Reuse the shared logger if another instance already opened it
+  logger_ = spdlog::get("basic_logger");
+}
 
 void Logger::initializeLogger() {
-  // Ensure the logs directory exists
-  std::filesystem::create_directories(LOG_DIRECTORY);
+  if (logger_) {
+    return;
+  }
 
   // Create or retrieve the logger
   logger_ = spdlog::get("basic_logger");
   if (!logger_) {
+    // Ensure the logs directory exists
+    std::filesystem::create_directories(LOG_DIRECTORY);
     logger_ = spdlog::basic_logger_mt("basic_logger", LOG_FILE_PATH);
     spdlog::set_pattern(LOG_PATTERN);
   }
 }
 
 void Logger::logAction(const std::string &action) {
+  initializeLogger();
   if (logger_) {
+    WriteScope scope;
     logger_->info(action);
     logger_->flush(); // Ensure logs are immediately written to the file
   } else {
@@ -36,7 +65,9 @@ void Logger::logAction(const std::string &action) {
 }
 
 void Logger::logError(const std::string &error) {
+  initializeLogger();
   if (logger_) {
+    WriteScope scope;
     logger_->error(error);
     logger_->flush(); // Ensure logs are immediately written to the file
   } else {
@@ -45,7 +76,9 @@ void Logger::logError(const std::string &error) {
 }
 
 void Logger::logWarning(const std::string &warning) {
+  initializeLogger();
   if (logger_) {
+    WriteScope scope;
     logger_->warn(warning);
     logger_->flush(); // Ensure logs are immediately written to the file
   } else {
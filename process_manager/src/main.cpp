@@ -1,7 +1,13 @@
 #include "../include/logger.h"
+#include "../include/one_shot.h"
 #include "../include/process_manager.h"
 
-int main() {
+int main(int argc, char *argv[]) {
+  // A command on the command line runs once, without the interactive shell
+  if (argc > 1) {
+    return OneShot::run(std::vector<std::string>(argv + 1, argv + argc));
+  }
+
   // Ensure logger is initialized
   Logger logger;
   logger.logAction("Application started");
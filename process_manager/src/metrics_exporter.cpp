@@ -0,0 +1,375 @@
+// src/metrics_exporter.cpp
+
+#include "../include/metrics_exporter.h"
+#include "../include/self_stats.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+const char *METRIC_PREFIX = "process_manager_"; // Prefix of every metric
+const int PERCENT_PRECISION = 2;                // Digits for percentages
+const int SECONDS_PRECISION = 3;                // Digits for timestamps
+const int DURATION_PRECISION = 6;               // Digits for durations
+const unsigned long long BYTES_PER_KB = 1024;   // Memory is exported in bytes
+const int SMALLEST_BUCKET_BITS = 7; // Upper bound of the first bucket, log2 ns
+const double NS_PER_SECOND = 1e9;   // Latencies are exported in seconds
+
+/// Names of the `CpuTimes::ticks` entries, in order
+const char *CPU_MODE_NAMES[CpuTimes::MODE_COUNT] = {
+    "user", "nice", "system", "idle", "iowait", "irq", "softirq", "steal"};
+
+/**
+ * @brief Returns the current wall-clock time in seconds since the epoch.
+ */
+double unixSeconds() {
+  return std::chrono::duration<double>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+} // namespace
+
+MetricsExporter::MetricsExporter(std::chrono::milliseconds interval,
+                                 size_t topN)
+    : interval_(interval), topN_(topN),
+      snapshot_(std::make_shared<const std::string>()) {
+  // The node layout does not change at runtime; only memory is resampled
+  std::string error;
+  hasTopology_ = NumaTopology::discover(topology_, error);
+}
+
+MetricsExporter::~MetricsExporter() { stop(); }
+
+void MetricsExporter::start() {
+  collect();
+  thread_ = std::thread(&MetricsExporter::run, this);
+}
+
+void MetricsExporter::stop() {
+  {
+    std::lock_guard<std::mutex> lock(stopMutex_);
+    stopping_ = true;
+  }
+  stopCondition_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+std::shared_ptr<const std::string> MetricsExporter::snapshot() const {
+  std::lock_guard<std::mutex> lock(snapshotMutex_);
+  return snapshot_;
+}
+
+void MetricsExporter::run() {
+  std::unique_lock<std::mutex> lock(stopMutex_);
+  while (!stopCondition_.wait_for(lock, interval_,
+                                  [this] { return stopping_; })) {
+    lock.unlock();
+    collect();
+    lock.lock();
+  }
+}
+
+void MetricsExporter::collect() {
+  auto started = std::chrono::steady_clock::now();
+  out_.clear();
+
+  SystemCounters current;
+  if (DataMonitoring::readSystemCounters(current, readBuffer_)) {
+    renderSystem(current);
+    previous_ = std::move(current);
+    hasPrevious_ = true;
+  }
+  if (hasTopology_ && NumaTopology::readMemory(topology_, readBuffer_)) {
+    renderNodes();
+  }
+  if (topN_ > 0) {
+    renderProcesses();
+  }
+  renderSelf();
+
+  double duration = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - started)
+                        .count();
+  appendFamily("collection_timestamp_seconds",
+               "Time of the last collection since the epoch.", "gauge");
+  out_.append(METRIC_PREFIX);
+  out_.append("collection_timestamp_seconds ");
+  out_.appendNumber(unixSeconds(), SECONDS_PRECISION);
+  out_.append('\n');
+  appendFamily("collection_duration_seconds",
+               "Time spent collecting and rendering the last snapshot.",
+               "gauge");
+  out_.append(METRIC_PREFIX);
+  out_.append("collection_duration_seconds ");
+  out_.appendNumber(duration, DURATION_PRECISION);
+  out_.append('\n');
+
+  // Scrapes holding the previous snapshot keep it alive until they finish
+  auto rendered = std::make_shared<const std::string>(out_.view());
+  std::lock_guard<std::mutex> lock(snapshotMutex_);
+  snapshot_ = std::move(rendered);
+}
+
+void MetricsExporter::renderSystem(const SystemCounters &current) {
+  static const double CLOCK_TICKS = static_cast<double>(sysconf(_SC_CLK_TCK));
+
+  appendFamily("cpu_seconds_total", "Time the CPUs spent in each mode.",
+               "counter");
+  for (const CpuTimes &cpu : current.cpus) {
+    if (cpu.cpu < 0) {
+      continue; // The aggregate is the sum of the per-CPU counters
+    }
+    for (int mode = 0; mode < CpuTimes::MODE_COUNT; ++mode) {
+      out_.append(METRIC_PREFIX);
+      out_.append("cpu_seconds_total{cpu=\"");
+      out_.appendNumber(static_cast<long long>(cpu.cpu));
+      out_.append("\",mode=\"");
+      out_.append(CPU_MODE_NAMES[mode]);
+      out_.append("\"} ");
+      out_.appendNumber(cpu.ticks[mode] / CLOCK_TICKS, PERCENT_PRECISION);
+      out_.append('\n');
+    }
+  }
+
+  // Usage needs two samples, so the first snapshot omits it
+  if (hasPrevious_ && previous_.cpus.size() == current.cpus.size()) {
+    appendFamily("cpu_usage_percent",
+                 "CPU busy time since the previous collection; cpu=\"all\" is "
+                 "the whole system.",
+                 "gauge");
+    for (size_t i = 0; i < current.cpus.size(); ++i) {
+      out_.append(METRIC_PREFIX);
+      out_.append("cpu_usage_percent{cpu=\"");
+      if (current.cpus[i].cpu < 0) {
+        out_.append("all");
+      } else {
+        out_.appendNumber(static_cast<long long>(current.cpus[i].cpu));
+      }
+      out_.append("\"} ");
+      out_.appendNumber(
+          DataMonitoring::cpuUsage(previous_.cpus[i], current.cpus[i]),
+          PERCENT_PRECISION);
+      out_.append('\n');
+    }
+  }
+
+  unsigned long long usedKb = current.memTotalKb > current.memAvailableKb
+                                  ? current.memTotalKb - current.memAvailableKb
+                                  : 0;
+  appendFamily("memory_total_bytes", "Total usable memory.", "gauge");
+  out_.append(METRIC_PREFIX);
+  out_.append("memory_total_bytes ");
+  out_.appendNumber(current.memTotalKb * BYTES_PER_KB);
+  out_.append('\n');
+  appendFamily("memory_available_bytes",
+               "Memory available for new allocations without swapping.",
+               "gauge");
+  out_.append(METRIC_PREFIX);
+  out_.append("memory_available_bytes ");
+  out_.appendNumber(current.memAvailableKb * BYTES_PER_KB);
+  out_.append('\n');
+  appendFamily("memory_usage_percent", "Share of memory not available.",
+               "gauge");
+  out_.append(METRIC_PREFIX);
+  out_.append("memory_usage_percent ");
+  out_.appendNumber(current.memTotalKb == 0
+                        ? 0.0
+                        : 100.0 * static_cast<double>(usedKb) /
+                              current.memTotalKb,
+                    PERCENT_PRECISION);
+  out_.append('\n');
+}
+
+void MetricsExporter::renderNodes() {
+  const struct {
+    const char *state;
+    unsigned long long NodeMemory::*field;
+  } states[] = {{"total", &NodeMemory::totalKb},
+                {"used", &NodeMemory::usedKb},
+                {"free", &NodeMemory::freeKb},
+                {"file", &NodeMemory::fileKb},
+                {"anon", &NodeMemory::anonKb}};
+
+  appendFamily("node_memory_bytes",
+               "Memory of each NUMA node by state; file is the page cache.",
+               "gauge");
+  for (const NumaNode &node : topology_.nodes) {
+    for (const auto &entry : states) {
+      out_.append(METRIC_PREFIX);
+      out_.append("node_memory_bytes{node=\"");
+      out_.appendNumber(static_cast<long long>(node.id));
+      out_.append("\",state=\"");
+      out_.append(entry.state);
+      out_.append("\"} ");
+      out_.appendNumber(node.memory.*entry.field * BYTES_PER_KB);
+      out_.append('\n');
+    }
+  }
+}
+
+void MetricsExporter::renderProcesses() {
+  ListOptions options;
+  options.columns = {ProcessColumn::Pid, ProcessColumn::Name,
+                     ProcessColumn::Cpu, ProcessColumn::Memory,
+                     ProcessColumn::Rss, ProcessColumn::Threads};
+  listing_.refresh(options);
+  listing_.sortProcesses(ProcessColumn::Cpu, true);
+
+  const std::vector<ProcessInfo> &processes = listing_.getProcesses();
+  size_t count = std::min(topN_, processes.size());
+
+  // Families are rendered one after the other, as the format requires
+  struct Family {
+    const char *name;
+    const char *help;
+  };
+  const Family families[] = {
+      {"process_cpu_usage_percent", "CPU usage of the process."},
+      {"process_memory_usage_percent", "Share of memory resident."},
+      {"process_resident_memory_bytes", "Resident set size."},
+      {"process_threads", "Number of threads."},
+  };
+  for (size_t family = 0; family < std::size(families); ++family) {
+    appendFamily(families[family].name, families[family].help, "gauge");
+    for (size_t i = 0; i < count; ++i) {
+      const ProcessInfo &info = processes[i];
+      out_.append(METRIC_PREFIX);
+      out_.append(families[family].name);
+      out_.append("{pid=\"");
+      out_.appendNumber(static_cast<long long>(info.pid));
+      out_.append("\",name=\"");
+      appendLabelValue(listing_.getString(info.nameId));
+      out_.append("\"} ");
+      switch (family) {
+      case 0:
+        out_.appendNumber(info.cpuUsage, PERCENT_PRECISION);
+        break;
+      case 1:
+        out_.appendNumber(info.memoryUsage, PERCENT_PRECISION);
+        break;
+      case 2:
+        out_.appendNumber(info.rssKb * BYTES_PER_KB);
+        break;
+      default:
+        out_.appendNumber(static_cast<long long>(info.threads));
+        break;
+      }
+      out_.append('\n');
+    }
+  }
+}
+
+void MetricsExporter::renderSelf() {
+  SelfStatsSnapshot stats = SelfStats::snapshot();
+
+  appendFamily("self_cpu_seconds_total",
+               "CPU time used by the exporter process.", "counter");
+  out_.append(METRIC_PREFIX);
+  out_.append("self_cpu_seconds_total ");
+  out_.appendNumber(static_cast<double>(stats.cpuTimeUs) / 1e6,
+                    DURATION_PRECISION);
+  out_.append('\n');
+  appendFamily("self_max_resident_memory_bytes",
+               "Peak resident set size of the exporter process.", "gauge");
+  out_.append(METRIC_PREFIX);
+  out_.append("self_max_resident_memory_bytes ");
+  out_.appendNumber(stats.maxRssKb * BYTES_PER_KB);
+  out_.append('\n');
+
+  appendFamily("self_events_total",
+               "Work done by the exporter: scans, files, bytes, syscalls.",
+               "counter");
+  for (const auto &[name, value] : stats.counters) {
+    out_.append(METRIC_PREFIX);
+    out_.append("self_events_total{event=\"");
+    out_.append(name);
+    out_.append("\"} ");
+    out_.appendNumber(static_cast<unsigned long long>(value));
+    out_.append('\n');
+  }
+
+  appendFamily("self_queue_depth", "Current depth of internal queues.",
+               "gauge");
+  for (const SelfGaugeValue &gauge : stats.gauges) {
+    out_.append(METRIC_PREFIX);
+    out_.append("self_queue_depth{queue=\"");
+    out_.append(gauge.name);
+    out_.append("\"} ");
+    out_.appendNumber(static_cast<long long>(gauge.value));
+    out_.append('\n');
+  }
+
+  appendFamily("self_latency_seconds",
+               "Latency of the exporter's own operations by phase.",
+               "histogram");
+  for (const SelfHistogram &histogram : stats.histograms) {
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i + 1 < histogram.buckets.size(); ++i) {
+      cumulative += histogram.buckets[i];
+      out_.append(METRIC_PREFIX);
+      out_.append("self_latency_seconds_bucket{phase=\"");
+      out_.append(histogram.name);
+      out_.append("\",le=\"");
+      out_.appendNumber(
+          static_cast<double>(uint64_t{1} << (i + SMALLEST_BUCKET_BITS)) /
+              NS_PER_SECOND,
+          DURATION_PRECISION + 3);
+      out_.append("\"} ");
+      out_.appendNumber(static_cast<unsigned long long>(cumulative));
+      out_.append('\n');
+    }
+    out_.append(METRIC_PREFIX);
+    out_.append("self_latency_seconds_bucket{phase=\"");
+    out_.append(histogram.name);
+    out_.append("\",le=\"+Inf\"} ");
+    out_.appendNumber(static_cast<unsigned long long>(histogram.count));
+    out_.append('\n');
+    out_.append(METRIC_PREFIX);
+    out_.append("self_latency_seconds_sum{phase=\"");
+    out_.append(histogram.name);
+    out_.append("\"} ");
+    out_.appendNumber(static_cast<double>(histogram.sumNs) / NS_PER_SECOND,
+                      DURATION_PRECISION + 3);
+    out_.append('\n');
+    out_.append(METRIC_PREFIX);
+    out_.append("self_latency_seconds_count{phase=\"");
+    out_.append(histogram.name);
+    out_.append("\"} ");
+    out_.appendNumber(static_cast<unsigned long long>(histogram.count));
+    out_.append('\n');
+  }
+}
+
+void MetricsExporter::appendFamily(std::string_view name,
+                                   std::string_view help,
+                                   std::string_view type) {
+  out_.append("# HELP ");
+  out_.append(METRIC_PREFIX);
+  out_.append(name);
+  out_.append(' ');
+  out_.append(help);
+  out_.append("\n# TYPE ");
+  out_.append(METRIC_PREFIX);
+  out_.append(name);
+  out_.append(' ');
+  out_.append(type);
+  out_.append('\n');
+}
+
+void MetricsExporter::appendLabelValue(std::string_view value) {
+  for (char c : value) {
+    if (c == '\\') {
+      out_.append("\\\\");
+    } else if (c == '"') {
+      out_.append("\\\"");
+    } else if (c == '\n') {
+      out_.append("\\n");
+    } else {
+      out_.append(c);
+    }
+  }
+}
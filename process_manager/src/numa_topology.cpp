@@ -0,0 +1,203 @@
+// src/numa_topology.cpp
+
+#include "../include/numa_topology.h"
+#include "../include/proc_paths.h"
+#include "../include/proc_reader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+
+namespace {
+const char *CPU_ONLINE_FILE = "devices/system/cpu/online";   // Below sysfs
+const char *NODE_ONLINE_FILE = "devices/system/node/online"; // Below sysfs
+const char *CPU_DIRECTORY = "devices/system/cpu/cpu";        // + N
+const char *NODE_DIRECTORY = "devices/system/node/node";     // + N
+const char *PACKAGE_FILE = "/topology/physical_package_id";
+const char *CORE_FILE = "/topology/core_id";
+const char *NODE_CPUS_FILE = "/cpulist";
+const char *NODE_DISTANCE_FILE = "/distance";
+const char *NODE_MEMINFO_FILE = "/meminfo";
+const char *PROC_MEMINFO_FILE = "meminfo"; // Below procfs, for the fallback
+const char *MEM_FREE_KEY = "MemFree:";
+const char *CACHED_KEY = "Cached:";
+const char *ANON_PAGES_KEY = "AnonPages:";
+const int LOCAL_DISTANCE = 10; // Distance of a node to itself
+
+/**
+ * @brief Parses whitespace-separated integers, e.g. `10 21` or `-1`.
+ */
+bool parseIntegers(std::string_view text, std::vector<int> &values) {
+  values.clear();
+  const char *p = text.data();
+  const char *end = p + text.size();
+  while (p < end) {
+    if (*p == ' ' || *p == '\t' || *p == '\n') {
+      ++p;
+      continue;
+    }
+    int value = 0;
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) {
+      return false;
+    }
+    values.push_back(value);
+    p = result.ptr;
+  }
+  return !values.empty();
+}
+
+/**
+ * @brief Reads a sysfs file holding one integer.
+ */
+bool readInteger(const std::string &path, std::string &buffer, int &value) {
+  std::vector<int> values;
+  if (!ProcReader::readFile(path, buffer) || !parseIntegers(buffer, values)) {
+    return false;
+  }
+  value = values.front();
+  return true;
+}
+
+/**
+ * @brief Returns the sysfs directory of a node, e.g. `.../node/node1`.
+ */
+std::string nodeDirectory(int node) {
+  return ProcPaths::sys(NODE_DIRECTORY) + std::to_string(node);
+}
+
+/**
+ * @brief Fills the memory of the single fallback node from /proc/meminfo.
+ */
+bool readSystemMemory(NodeMemory &memory, std::string &buffer) {
+  memory = NodeMemory();
+  if (!ProcReader::readFile(ProcPaths::proc(PROC_MEMINFO_FILE), buffer) ||
+      !ProcParsers::parseMemTotal(buffer, memory.totalKb)) {
+    return false;
+  }
+  ProcParsers::parseKeyedValue(buffer, MEM_FREE_KEY, memory.freeKb);
+  ProcParsers::parseKeyedValue(buffer, CACHED_KEY, memory.fileKb);
+  ProcParsers::parseKeyedValue(buffer, ANON_PAGES_KEY, memory.anonKb);
+  memory.usedKb =
+      memory.totalKb > memory.freeKb ? memory.totalKb - memory.freeKb : 0;
+  return true;
+}
+} // namespace
+
+const NumaNode *SystemTopology::node(int id) const {
+  for (const NumaNode &candidate : nodes) {
+    if (candidate.id == id) {
+      return &candidate;
+    }
+  }
+  return nullptr;
+}
+
+int SystemTopology::nodeOfCpu(int cpu) const {
+  auto it = std::lower_bound(
+      cpus.begin(), cpus.end(), cpu,
+      [](const CpuPlacement &placement, int value) {
+        return placement.cpu < value;
+      });
+  return it != cpus.end() && it->cpu == cpu ? it->node : -1;
+}
+
+bool NumaTopology::discover(SystemTopology &topology, std::string &error) {
+  topology = SystemTopology();
+  std::string buffer;
+
+  std::string onlinePath = ProcPaths::sys(CPU_ONLINE_FILE);
+  std::vector<int> online;
+  if (!ProcReader::readFile(onlinePath, buffer) ||
+      !ProcParsers::parseCpuList(buffer, online) || online.empty()) {
+    error = "Could not read the online CPUs from " + onlinePath;
+    return false;
+  }
+  for (int cpu : online) {
+    CpuPlacement placement;
+    placement.cpu = cpu;
+    std::string directory = ProcPaths::sys(CPU_DIRECTORY) + std::to_string(cpu);
+    readInteger(directory + PACKAGE_FILE, buffer, placement.package);
+    readInteger(directory + CORE_FILE, buffer, placement.core);
+    topology.cpus.push_back(placement);
+  }
+
+  // Kernels built without NUMA have no node directory: one node has it all
+  std::vector<int> nodes;
+  if (!ProcReader::readFile(ProcPaths::sys(NODE_ONLINE_FILE), buffer) ||
+      !ProcParsers::parseCpuList(buffer, nodes) || nodes.empty()) {
+    NumaNode node;
+    node.cpus = online;
+    node.distances = {LOCAL_DISTANCE};
+    topology.nodes.push_back(std::move(node));
+    readMemory(topology, buffer);
+    return true;
+  }
+
+  topology.numa = true;
+  for (int id : nodes) {
+    NumaNode node;
+    node.id = id;
+    std::string directory = nodeDirectory(id);
+    std::vector<int> cpus;
+    if (ProcReader::readFile(directory + NODE_CPUS_FILE, buffer) &&
+        ProcParsers::parseCpuList(buffer, cpus)) {
+      // Offline CPUs may still be listed; keep the ones that can run
+      std::set_intersection(cpus.begin(), cpus.end(), online.begin(),
+                            online.end(), std::back_inserter(node.cpus));
+    }
+    if (ProcReader::readFile(directory + NODE_DISTANCE_FILE, buffer)) {
+      parseIntegers(buffer, node.distances);
+    }
+    for (int cpu : node.cpus) {
+      auto placement = std::find_if(
+          topology.cpus.begin(), topology.cpus.end(),
+          [cpu](const CpuPlacement &entry) { return entry.cpu == cpu; });
+      if (placement != topology.cpus.end()) {
+        placement->node = id;
+      }
+    }
+    topology.nodes.push_back(std::move(node));
+  }
+  readMemory(topology, buffer);
+  return true;
+}
+
+bool NumaTopology::readMemory(SystemTopology &topology, std::string &buffer) {
+  if (!topology.numa) {
+    return !topology.nodes.empty() &&
+           readSystemMemory(topology.nodes.front().memory, buffer);
+  }
+
+  bool complete = true;
+  for (NumaNode &node : topology.nodes) {
+    if (!ProcReader::readFile(nodeDirectory(node.id) + NODE_MEMINFO_FILE,
+                              buffer) ||
+        !ProcParsers::parseNodeMeminfo(buffer, node.memory)) {
+      node.memory = NodeMemory();
+      complete = false;
+    }
+  }
+  return complete;
+}
+
+std::string NumaTopology::formatList(const std::vector<int> &values) {
+  std::string text;
+  for (size_t i = 0; i < values.size();) {
+    // Extend the run while the numbers are consecutive
+    size_t last = i;
+    while (last + 1 < values.size() && values[last + 1] == values[last] + 1) {
+      ++last;
+    }
+    if (!text.empty()) {
+      text += ',';
+    }
+    text += std::to_string(values[i]);
+    if (last > i) {
+      text += '-';
+      text += std::to_string(values[last]);
+    }
+    i = last + 1;
+  }
+  return text;
+}
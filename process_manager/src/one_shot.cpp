@@ -0,0 +1,1409 @@
+// src/one_shot.cpp
+
+#include "../include/one_shot.h"
+#include "../include/collector_daemon.h"
+#include "../include/daemon_client.h"
+#include "../include/data_monitoring.h"
+#include "../include/display_format.h"
+#include "../include/http_server.h"
+#include "../include/metrics_exporter.h"
+#include "../include/fake_procfs.h"
+#include "../include/numa_topology.h"
+#include "../include/output_buffer.h"
+#include "../include/proc_paths.h"
+#include "../include/process_export.h"
+#include "../include/process_filter.h"
+#include "../include/process_listing.h"
+#include "../include/rule_engine.h"
+#include "../include/self_stats.h"
+#include "../include/worker_placement.h"
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace {
+const int EXIT_USAGE = 2; // Exit status for invalid arguments
+
+const char *LIST_COMMAND = "list";       // Command listing processes
+const char *MONITOR_COMMAND = "monitor"; // Command sampling CPU and memory
+const char *SERVE_COMMAND = "serve";     // Command exporting metrics
+const char *DAEMON_COMMAND = "daemon";   // Command running the collector
+const char *QUERY_COMMAND = "query";     // Command querying the collector
+const char *RULES_COMMAND = "rules";     // Command checking a rules file
+const char *FAKE_PROC_COMMAND = "fake-proc"; // Command writing a fake /proc
+const char *STATS_COMMAND = "stats";     // Command reporting own overhead
+const char *NUMA_COMMAND = "numa";       // Command showing the NUMA layout
+const char *THREADS_COMMAND = "threads"; // Command listing a process's threads
+const char *EVENTS_COMMAND = "events";   // Command streaming process events
+const char *PROC_ROOT_OPTION = "--proc-root";
+const char *SYS_ROOT_OPTION = "--sys-root";
+const char *SCAN_CPUS_OPTION = "--scan-cpus";
+const char *SCAN_NODES_OPTION = "--scan-nodes";
+const char *SCAN_BACKEND_OPTION = "--scan-backend";
+const char *SYNC_BACKEND = "sync";         // Values of `--scan-backend`
+const char *IO_URING_BACKEND = "io_uring";
+const char *FORMAT_OPTION = "--format";
+const char *TOP_OPTION = "--top";
+const char *COLUMNS_OPTION = "--columns";
+const char *SMAPS_TOP_OPTION = "--smaps-top";
+const char *NUMA_TOP_OPTION = "--numa-top";
+const char *THREADS_OPTION = "--threads";
+const char *FILTER_OPTION = "--filter";
+const char *SAMPLES_OPTION = "--samples";
+const char *INTERVAL_OPTION = "--interval";
+const char *LISTEN_OPTION = "--listen";
+const char *SOCKET_OPTION = "--socket";
+const char *HISTORY_OPTION = "--history";
+const char *SHM_OPTION = "--shm";
+const char *SHM_CAPACITY_OPTION = "--shm-capacity";
+const char *RULES_OPTION = "--rules";
+const char *DRY_RUN_OPTION = "--dry-run";
+const char *PROCESSES_OPTION = "--processes";
+const char *CHURN_OPTION = "--churn";
+const char *LOAD_OPTION = "--load";
+const char *CPUS_OPTION = "--cpus";
+const char *SEED_OPTION = "--seed";
+const char *SCANS_OPTION = "--scans";
+
+const double DEFAULT_MONITOR_INTERVAL_SECONDS = 1.0; // Time between samples
+const double MIN_MONITOR_INTERVAL_SECONDS = 0.1;     // Fastest sampling
+const double DEFAULT_SERVE_INTERVAL_SECONDS = 5.0;   // Time between snapshots
+const double DEFAULT_DAEMON_INTERVAL_SECONDS = 1.0;  // Time between samples
+const size_t DEFAULT_HISTORY_LENGTH = 300;           // Samples per process
+const size_t DEFAULT_SHM_CAPACITY = 32768;           // Processes per snapshot
+const char *METRICS_PATH = "/metrics"; // Path scraped by Prometheus
+const char *METRICS_CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+const int PERCENT_PRECISION = 2; // Digits after the point for percentages
+const unsigned long long BYTES_PER_KB = 1024; // Memory is exported in bytes
+const int NODE_WIDTH = 6;          // Width of the node column of `numa`
+const int CPU_LIST_WIDTH = 18;     // Width of a CPU list column
+const int MEMORY_WIDTH = 12;       // Width of a memory size column
+const int SHARE_WIDTH = 8;         // Width of a percentage column
+const int PID_WIDTH = 8;           // Width of a PID column
+const size_t NAME_WIDTH = 20;      // Width of a process name column
+
+/**
+ * @brief Parses a non-negative integer option value.
+ */
+bool parseCount(const std::string &text, size_t &value) {
+  if (text.empty() || text[0] == '-') {
+    return false;
+  }
+  char *end = nullptr;
+  unsigned long long parsed = std::strtoull(text.c_str(), &end, 10);
+  if (*end != '\0') {
+    return false;
+  }
+  value = static_cast<size_t>(parsed);
+  return true;
+}
+
+/**
+ * @brief Parses a duration in seconds, e.g. `0.5`.
+ */
+bool parseSeconds(const std::string &text, double &value) {
+  char *end = nullptr;
+  value = std::strtod(text.c_str(), &end);
+  // `nan` and `inf` parse, but no interval or timeout can use them
+  return !text.empty() && *end == '\0' && std::isfinite(value);
+}
+
+/**
+ * @brief Fetches the value of the option at `index`, reporting if missing.
+ */
+bool optionValue(const std::vector<std::string> &args, size_t &index,
+                 std::string &value) {
+  if (index + 1 >= args.size()) {
+    std::cerr << "Error: '" << args[index] << "' requires a value.\n";
+    return false;
+  }
+  value = args[++index];
+  return true;
+}
+
+/**
+ * @class SignalWaiter
+ * @brief Stops a long-running command on SIGINT or SIGTERM.
+ *
+ * The waiting thread also ends when the command finishes on its own, e.g.
+ * after an error, so finishing never waits for a signal that will not come.
+ */
+class SignalWaiter {
+public:
+  /**
+   * @brief Blocks the signals and starts waiting for the first one.
+   *
+   * The signals are blocked in the calling thread, and thereby in every
+   * thread it starts later, so construct the waiter before starting others.
+   *
+   * @param stop Called from the waiting thread when a signal arrives.
+   */
+  explicit SignalWaiter(std::function<void()> stop)
+      : wakeupFd_(eventfd(0, EFD_CLOEXEC)), signalled_(false) {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    signalFd_ = signalfd(-1, &signals, SFD_CLOEXEC);
+    waiter_ = std::thread([this, stop = std::move(stop)] {
+      pollfd fds[] = {{signalFd_, POLLIN, 0}, {wakeupFd_, POLLIN, 0}};
+      while (poll(fds, 2, -1) < 0 && errno == EINTR) {
+      }
+      if ((fds[0].revents & POLLIN) != 0) {
+        signalled_ = true;
+        stop();
+      }
+    });
+  }
+
+  ~SignalWaiter() { finish(); }
+
+  SignalWaiter(const SignalWaiter &) = delete;
+  SignalWaiter &operator=(const SignalWaiter &) = delete;
+
+  /**
+   * @brief Stops waiting and joins the waiting thread.
+   *
+   * @return `true` if a signal arrived, so that `stop` was called.
+   */
+  bool finish() {
+    if (waiter_.joinable()) {
+      uint64_t value = 1;
+      ssize_t ignored = write(wakeupFd_, &value, sizeof(value));
+      (void)ignored;
+      waiter_.join();
+      close(signalFd_);
+      close(wakeupFd_);
+    }
+    return signalled_;
+  }
+
+private:
+  int signalFd_;                ///< Readable once a signal is pending
+  int wakeupFd_;                ///< Written by `finish`
+  std::atomic<bool> signalled_; ///< Set before `stop` is called
+  std::thread waiter_;          ///< Polls both descriptors
+};
+
+/**
+ * @brief Appends a daemon sample as a JSON object.
+ */
+void writeSnapshotJson(OutputBuffer &out, const DaemonSnapshot &snapshot) {
+  const DaemonSystemSample &system = snapshot.system;
+  out.append("{\"timestamp_ms\":");
+  out.appendNumber(static_cast<unsigned long long>(system.timestampMs));
+  out.append(",\"sample\":");
+  out.appendNumber(static_cast<unsigned long long>(system.generation));
+  out.append(",\"cpu\":");
+  out.appendNumber(system.cpuUsage, PERCENT_PRECISION);
+  out.append(",\"memory\":");
+  out.appendNumber(system.memoryUsage, PERCENT_PRECISION);
+  out.append(",\"memory_total\":");
+  out.appendNumber(system.memTotalKb * BYTES_PER_KB);
+  out.append(",\"memory_available\":");
+  out.appendNumber(system.memAvailableKb * BYTES_PER_KB);
+  out.append(",\"process_count\":");
+  out.appendNumber(static_cast<unsigned long long>(system.processCount));
+  out.append(",\"processes\":[");
+  for (size_t i = 0; i < snapshot.processes.size(); ++i) {
+    const DaemonProcess &process = snapshot.processes[i];
+    out.append(i == 0 ? "{\"pid\":" : ",{\"pid\":");
+    out.appendNumber(static_cast<long long>(process.pid));
+    out.append(",\"name\":");
+    out.appendJsonString(process.name);
+    out.append(",\"cpu\":");
+    out.appendNumber(process.cpuUsage, PERCENT_PRECISION);
+    out.append(",\"mem\":");
+    out.appendNumber(process.memoryUsage, PERCENT_PRECISION);
+    out.append(",\"rss\":");
+    out.appendNumber(process.rssKb * BYTES_PER_KB);
+    out.append(",\"threads\":");
+    out.appendNumber(static_cast<unsigned long long>(process.threads));
+    out.append('}');
+  }
+  out.append("]}\n");
+}
+
+/**
+ * @brief Returns the resident memory of a process per node, in kB, padded
+ * with zeros to one entry per node of the topology.
+ */
+std::vector<unsigned long long>
+residencyByNode(const ProcessListing &listing, const ProcessInfo &process,
+                const SystemTopology &topology) {
+  std::vector<unsigned long long> byNode(topology.nodes.size(), 0);
+  const std::vector<unsigned long long> *residency =
+      listing.getNumaResidency(process.pid);
+  if (residency == nullptr) {
+    return byNode;
+  }
+  for (size_t i = 0; i < topology.nodes.size(); ++i) {
+    size_t id = static_cast<size_t>(topology.nodes[i].id);
+    byNode[i] = id < residency->size() ? (*residency)[id] : 0;
+  }
+  return byNode;
+}
+
+/**
+ * @brief Appends the topology, and the residency of the listed processes,
+ * as a JSON document.
+ */
+void writeNumaJson(OutputBuffer &out, const SystemTopology &topology,
+                   const ProcessListing &listing, size_t processes) {
+  out.append("{\"numa\":");
+  out.append(topology.numa ? "true" : "false");
+  out.append(",\"nodes\":[");
+  for (size_t i = 0; i < topology.nodes.size(); ++i) {
+    const NumaNode &node = topology.nodes[i];
+    out.append(i == 0 ? "{" : ",{");
+    out.append("\"node\":");
+    out.appendNumber(static_cast<long long>(node.id));
+    out.append(",\"cpus\":");
+    out.appendJsonString(NumaTopology::formatList(node.cpus));
+    out.append(",\"memory_total\":");
+    out.appendNumber(node.memory.totalKb * BYTES_PER_KB);
+    out.append(",\"memory_used\":");
+    out.appendNumber(node.memory.usedKb * BYTES_PER_KB);
+    out.append(",\"memory_free\":");
+    out.appendNumber(node.memory.freeKb * BYTES_PER_KB);
+    out.append(",\"file\":");
+    out.appendNumber(node.memory.fileKb * BYTES_PER_KB);
+    out.append(",\"anon\":");
+    out.appendNumber(node.memory.anonKb * BYTES_PER_KB);
+    out.append(",\"distances\":[");
+    for (size_t j = 0; j < node.distances.size(); ++j) {
+      if (j > 0) {
+        out.append(',');
+      }
+      out.appendNumber(static_cast<long long>(node.distances[j]));
+    }
+    out.append("]}");
+  }
+  out.append("],\"cpus\":[");
+  for (size_t i = 0; i < topology.cpus.size(); ++i) {
+    const CpuPlacement &cpu = topology.cpus[i];
+    out.append(i == 0 ? "{" : ",{");
+    out.append("\"cpu\":");
+    out.appendNumber(static_cast<long long>(cpu.cpu));
+    out.append(",\"node\":");
+    out.appendNumber(static_cast<long long>(cpu.node));
+    out.append(",\"package\":");
+    out.appendNumber(static_cast<long long>(cpu.package));
+    out.append(",\"core\":");
+    out.appendNumber(static_cast<long long>(cpu.core));
+    out.append('}');
+  }
+  out.append("],\"scan_cpus\":");
+  out.appendJsonString(NumaTopology::formatList(WorkerPlacement::cpus()));
+
+  out.append(",\"processes\":[");
+  const std::vector<ProcessInfo> &rows = listing.getProcesses();
+  size_t written = 0;
+  for (size_t i = 0; i < rows.size() && written < processes; ++i) {
+    const ProcessInfo &process = rows[i];
+    if ((process.collected & PROC_SOURCE_NUMA) == 0) {
+      continue;
+    }
+    out.append(written++ == 0 ? "{" : ",{");
+    out.append("\"pid\":");
+    out.appendNumber(static_cast<long long>(process.pid));
+    out.append(",\"name\":");
+    out.appendJsonString(listing.getString(process.nameId));
+    out.append(",\"rss\":");
+    out.appendNumber(process.rssKb * BYTES_PER_KB);
+    out.append(",\"nodes\":[");
+    std::vector<unsigned long long> byNode =
+        residencyByNode(listing, process, topology);
+    for (size_t j = 0; j < byNode.size(); ++j) {
+      if (j > 0) {
+        out.append(',');
+      }
+      out.appendNumber(byNode[j] * BYTES_PER_KB);
+    }
+    out.append("]}");
+  }
+  out.append("]}\n");
+}
+
+/**
+ * @brief Prints the topology, and the residency of the listed processes,
+ * as tables.
+ */
+void writeNumaTable(std::ostream &out, const SystemTopology &topology,
+                    const ProcessListing &listing, size_t processes) {
+  out << std::left << std::setw(NODE_WIDTH) << "Node"
+      << std::setw(CPU_LIST_WIDTH) << "CPUs" << std::setw(MEMORY_WIDTH)
+      << "Total" << std::setw(MEMORY_WIDTH) << "Used" << std::setw(SHARE_WIDTH)
+      << "Used%" << std::setw(MEMORY_WIDTH) << "File" << std::setw(MEMORY_WIDTH)
+      << "Anon"
+      << "Distances\n";
+  for (const NumaNode &node : topology.nodes) {
+    double used = node.memory.totalKb == 0
+                      ? 0.0
+                      : 100.0 * static_cast<double>(node.memory.usedKb) /
+                            node.memory.totalKb;
+    out << std::setw(NODE_WIDTH) << node.id << std::setw(CPU_LIST_WIDTH)
+        << NumaTopology::formatList(node.cpus) << std::setw(MEMORY_WIDTH)
+        << DisplayFormat::bytes(node.memory.totalKb * BYTES_PER_KB)
+        << std::setw(MEMORY_WIDTH)
+        << DisplayFormat::bytes(node.memory.usedKb * BYTES_PER_KB)
+        << DisplayFormat::usageColor(used) << std::setw(SHARE_WIDTH)
+        << std::fixed << std::setprecision(1) << used
+        << DisplayFormat::resetColor() << std::setw(MEMORY_WIDTH)
+        << DisplayFormat::bytes(node.memory.fileKb * BYTES_PER_KB)
+        << std::setw(MEMORY_WIDTH)
+        << DisplayFormat::bytes(node.memory.anonKb * BYTES_PER_KB);
+    for (size_t i = 0; i < node.distances.size(); ++i) {
+      out << (i == 0 ? "" : " ") << node.distances[i];
+    }
+    out << '\n';
+  }
+  if (!topology.numa) {
+    out << "(no NUMA support in the kernel: one node holds everything)\n";
+  }
+  if (WorkerPlacement::isConfigured()) {
+    out << "Scan workers pinned to CPUs "
+        << NumaTopology::formatList(WorkerPlacement::cpus()) << '\n';
+  }
+  if (processes == 0) {
+    return;
+  }
+
+  out << '\n' << std::setw(PID_WIDTH) << "PID"
+      << std::setw(static_cast<int>(NAME_WIDTH)) << "Name"
+      << std::setw(MEMORY_WIDTH) << "RSS";
+  // The last column is not padded, like in `list`
+  for (size_t i = 0; i < topology.nodes.size(); ++i) {
+    bool last = i + 1 == topology.nodes.size();
+    std::ostringstream header;
+    header << 'N' << topology.nodes[i].id;
+    out << std::setw(last ? 0 : MEMORY_WIDTH) << header.str();
+  }
+  out << '\n';
+  const std::vector<ProcessInfo> &rows = listing.getProcesses();
+  size_t written = 0;
+  for (size_t i = 0; i < rows.size() && written < processes; ++i) {
+    const ProcessInfo &process = rows[i];
+    if ((process.collected & PROC_SOURCE_NUMA) == 0) {
+      continue;
+    }
+    ++written;
+    out << std::setw(PID_WIDTH) << process.pid
+        << std::setw(static_cast<int>(NAME_WIDTH))
+        << listing.getString(process.nameId).substr(0, NAME_WIDTH - 1)
+        << std::setw(MEMORY_WIDTH)
+        << DisplayFormat::bytes(process.rssKb * BYTES_PER_KB);
+    std::vector<unsigned long long> byNode =
+        residencyByNode(listing, process, topology);
+    for (size_t j = 0; j < byNode.size(); ++j) {
+      bool last = j + 1 == byNode.size();
+      out << std::setw(last ? 0 : MEMORY_WIDTH)
+          << DisplayFormat::bytes(byNode[j] * BYTES_PER_KB);
+    }
+    out << '\n';
+  }
+  const SmapsReport &report = listing.getNumaReport();
+  out << "numa_maps: " << report.read << " read of the top "
+      << report.candidates << " processes by RSS, " << std::fixed
+      << std::setprecision(2) << report.kernelTimeMs << " ms kernel time\n";
+}
+
+} // namespace
+
+int OneShot::run(const std::vector<std::string> &args) {
+  // Global options precede the command
+  size_t command = 0;
+  std::string scanCpus;
+  std::string scanNodes;
+  while (command < args.size() && (args[command] == PROC_ROOT_OPTION ||
+                                   args[command] == SYS_ROOT_OPTION ||
+                                   args[command] == SCAN_CPUS_OPTION ||
+                                   args[command] == SCAN_NODES_OPTION ||
+                                   args[command] == SCAN_BACKEND_OPTION)) {
+    std::string value;
+    if (!optionValue(args, command, value)) {
+      return EXIT_USAGE;
+    }
+    const std::string &option = args[command - 1];
+    if (option == PROC_ROOT_OPTION) {
+      ProcPaths::setProcRoot(value);
+    } else if (option == SYS_ROOT_OPTION) {
+      ProcPaths::setSysRoot(value);
+    } else if (option == SCAN_CPUS_OPTION) {
+      scanCpus = value;
+    } else if (option == SCAN_BACKEND_OPTION) {
+      if (value != SYNC_BACKEND && value != IO_URING_BACKEND) {
+        std::cerr << "Error: '--scan-backend' must be sync or io_uring.\n";
+        return EXIT_USAGE;
+      }
+      ProcessListing::setScanBackend(value == SYNC_BACKEND
+                                         ? ScanBackend::Sync
+                                         : ScanBackend::IoUring);
+    } else {
+      scanNodes = value;
+    }
+    ++command;
+  }
+  if (command == args.size()) {
+    printUsage();
+    return EXIT_USAGE;
+  }
+
+  // Placement needs the topology, which is read below the chosen sysfs root
+  if (!scanCpus.empty() || !scanNodes.empty()) {
+    SystemTopology topology;
+    std::string error;
+    if (!NumaTopology::discover(topology, error) ||
+        !WorkerPlacement::configure(scanCpus, scanNodes, topology, error)) {
+      std::cerr << "Error: " << error << ".\n";
+      return EXIT_USAGE;
+    }
+  }
+
+  const std::string &name = args[command];
+  std::vector<std::string> commandArgs(args.begin() + command + 1,
+                                       args.end());
+  if (name == LIST_COMMAND) {
+    return runList(commandArgs);
+  }
+  if (name == MONITOR_COMMAND) {
+    return runMonitor(commandArgs);
+  }
+  if (name == SERVE_COMMAND) {
+    return runServe(commandArgs);
+  }
+  if (name == DAEMON_COMMAND) {
+    return runDaemon(commandArgs);
+  }
+  if (name == QUERY_COMMAND) {
+    return runQuery(commandArgs);
+  }
+  if (name == RULES_COMMAND) {
+    return runRules(commandArgs);
+  }
+  if (name == FAKE_PROC_COMMAND) {
+    return runFakeProc(commandArgs);
+  }
+  if (name == STATS_COMMAND) {
+    return runStats(commandArgs);
+  }
+  if (name == NUMA_COMMAND) {
+    return runNuma(commandArgs);
+  }
+  if (name == THREADS_COMMAND) {
+    return runThreads(commandArgs);
+  }
+  if (name == EVENTS_COMMAND) {
+    return runEvents(commandArgs);
+  }
+
+  std::cerr << "Unknown command: " << name << '\n';
+  printUsage();
+  return EXIT_USAGE;
+}
+
+int OneShot::runList(const std::vector<std::string> &args,
+                     ListOptions options) {
+  ExportFormat format = ExportFormat::Table;
+  size_t top = std::numeric_limits<size_t>::max();
+  bool sortByCpu = false;
+  bool columnsGiven = false;
+  double intervalSeconds = 0.0;
+
+  for (size_t i = 0; i < args.size(); ++i) {
+    std::string value;
+    if (args[i] == FORMAT_OPTION) {
+      if (!optionValue(args, i, value)) {
+        return EXIT_USAGE;
+      }
+      if (!ProcessExport::parseFormat(value, format)) {
+        std::cerr << "Error: Unknown format '" << value
+                  << "'. Use table, json or csv.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == TOP_OPTION) {
+      if (!optionValue(args, i, value) || !parseCount(value, top)) {
+        std::cerr << "Error: '--top' requires a number of processes.\n";
+        return EXIT_USAGE;
+      }
+      sortByCpu = true;
+    } else if (args[i] == COLUMNS_OPTION) {
+      if (!optionValue(args, i, value)) {
+        return EXIT_USAGE;
+      }
+      std::string error;
+      if (!ProcessColumns::parse(value, options.columns, error)) {
+        std::cerr << "Error: " << error << '\n';
+        return EXIT_USAGE;
+      }
+      columnsGiven = true;
+    } else if (args[i] == SMAPS_TOP_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !parseCount(value, options.smapsTopN)) {
+        std::cerr << "Error: '--smaps-top' requires a number of processes.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == NUMA_TOP_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !parseCount(value, options.numaTopN)) {
+        std::cerr << "Error: '--numa-top' requires a number of processes.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == THREADS_OPTION) {
+      options.threads = true;
+    } else if (args[i] == FILTER_OPTION) {
+      if (!optionValue(args, i, value)) {
+        return EXIT_USAGE;
+      }
+      auto filter = std::make_shared<ProcessFilter>();
+      std::string error;
+      if (!filter->compile(value, error)) {
+        std::cerr << "Error: " << error << '\n';
+        return EXIT_USAGE;
+      }
+      options.filter = std::move(filter);
+    } else if (args[i] == INTERVAL_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !parseSeconds(value, intervalSeconds) || intervalSeconds <= 0.0) {
+        std::cerr << "Error: '--interval' requires a positive number of "
+                     "seconds.\n";
+        return EXIT_USAGE;
+      }
+    } else {
+      std::cerr << "Error: Unknown option for 'list': " << args[i] << '\n';
+      return EXIT_USAGE;
+    }
+  }
+
+  if (options.threads && !columnsGiven) {
+    options.columns = ProcessColumns::defaultThreadColumns();
+  }
+  // CPU usage needs stat even when the CPU column is not displayed
+  if (sortByCpu) {
+    options.extraSources |= PROC_SOURCE_STAT;
+  }
+  // Two scans of processes also tell which started and exited in between
+  bool events = intervalSeconds > 0.0 && !options.threads &&
+                format == ExportFormat::Json;
+  options.events = events;
+
+  ProcessListing listing;
+  listing.refresh(options);
+  if (intervalSeconds > 0.0) {
+    // The second scan measures CPU usage over the interval, per PID or TID
+    std::this_thread::sleep_for(
+        std::chrono::duration<double>(intervalSeconds));
+    listing.refresh(options);
+  }
+  if (sortByCpu) {
+    listing.sortProcesses(ProcessColumn::Cpu, true);
+  }
+
+  OutputBuffer out;
+  if (format == ExportFormat::Json) {
+    ProcessExport::writeJson(out, listing, options.columns, top, events);
+  } else if (format == ExportFormat::Csv) {
+    ProcessExport::writeCsv(out, listing, options.columns, top);
+  } else {
+    // Colors are only useful on a terminal
+    DisplayFormat::setColorEnabled(isatty(STDOUT_FILENO) != 0);
+    std::ostringstream table;
+    listing.printTable(table, options.columns, 0, top);
+    out.append(table.str());
+  }
+  return out.flush(STDOUT_FILENO) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int OneShot::runThreads(const std::vector<std::string> &args) {
+  size_t pid = 0;
+  if (args.empty() || !parseCount(args[0], pid) || pid == 0 ||
+      pid > static_cast<size_t>(std::numeric_limits<int>::max())) {
+    std::cerr << "Error: 'threads' requires a PID.\n";
+    return EXIT_USAGE;
+  }
+  if (access(ProcPaths::process(static_cast<int>(pid)).c_str(), F_OK) != 0) {
+    std::cerr << "Error: No process with PID " << pid << ".\n";
+    return EXIT_FAILURE;
+  }
+
+  ListOptions options;
+  options.threads = true;
+  options.pid = static_cast<int>(pid);
+  return runList(std::vector<std::string>(args.begin() + 1, args.end()),
+                 options);
+}
+
+int OneShot::runEvents(const std::vector<std::string> &args) {
+  double intervalSeconds = DEFAULT_MONITOR_INTERVAL_SECONDS;
+  size_t scans = 0;
+  ExportFormat format = ExportFormat::Table;
+
+  for (size_t i = 0; i < args.size(); ++i) {
+    std::string value;
+    if (args[i] == INTERVAL_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !parseSeconds(value, intervalSeconds) ||
+          intervalSeconds < MIN_MONITOR_INTERVAL_SECONDS) {
+        std::cerr << "Error: '--interval' requires at least "
+                  << MIN_MONITOR_INTERVAL_SECONDS << " seconds.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == SCANS_OPTION) {
+      if (!optionValue(args, i, value) || !parseCount(value, scans) ||
+          scans == 0) {
+        std::cerr << "Error: '--scans' requires a positive number.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == FORMAT_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !ProcessExport::parseFormat(value, format) ||
+          format == ExportFormat::Csv) {
+        std::cerr << "Error: '--format' must be table or json.\n";
+        return EXIT_USAGE;
+      }
+    } else {
+      std::cerr << "Error: Unknown option for 'events': " << args[i] << '\n';
+      return EXIT_USAGE;
+    }
+  }
+
+  // Identities only need stat; no column reads anything else
+  ListOptions options;
+  options.columns = {ProcessColumn::Pid, ProcessColumn::Name};
+  options.events = true;
+  ProcessListing listing;
+  listing.refresh(options);
+
+  std::mutex mutex;
+  std::condition_variable wakeup;
+  bool stopped = false;
+  SignalWaiter waiter([&] {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+    wakeup.notify_all();
+  });
+  if (format == ExportFormat::Table) {
+    ProcessEvents::printTable(std::cout, {});
+    std::cout.flush();
+  }
+  auto interval = std::chrono::duration<double>(intervalSeconds);
+  bool failed = false;
+  size_t done = 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  while ((scans == 0 || done < scans) &&
+         !wakeup.wait_for(lock, interval, [&stopped] { return stopped; })) {
+    lock.unlock();
+    listing.refresh(options);
+    ++done;
+    const ScanReport &report = listing.getScanReport();
+    OutputBuffer out;
+    if (format == ExportFormat::Json) {
+      // One object per scan and line, so a consumer can follow the stream
+      out.append("{\"started\":");
+      out.appendNumber(static_cast<unsigned long long>(report.started));
+      out.append(",\"exited\":");
+      out.appendNumber(static_cast<unsigned long long>(report.exited));
+      out.append(",\"execs\":");
+      out.appendNumber(static_cast<unsigned long long>(report.execs));
+      out.append(",\"churn_per_s\":");
+      out.appendNumber(report.churnPerSecond, PERCENT_PRECISION);
+      out.append(",\"events\":");
+      ProcessEvents::writeJson(out, listing.getEvents());
+      out.append("}\n");
+    } else if (!listing.getEvents().empty()) {
+      std::ostringstream table;
+      ProcessEvents::printTable(table, listing.getEvents(), false);
+      out.append(table.str());
+    }
+    if (!out.flush(STDOUT_FILENO)) {
+      failed = true;
+      lock.lock();
+      break;
+    }
+    lock.lock();
+  }
+  lock.unlock();
+  waiter.finish();
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int OneShot::runMonitor(const std::vector<std::string> &args) {
+  size_t samples = 1;
+  double intervalSeconds = DEFAULT_MONITOR_INTERVAL_SECONDS;
+  ExportFormat format = ExportFormat::Json;
+
+  for (size_t i = 0; i < args.size(); ++i) {
+    std::string value;
+    if (args[i] == SAMPLES_OPTION) {
+      if (!optionValue(args, i, value) || !parseCount(value, samples) ||
+          samples == 0) {
+        std::cerr << "Error: '--samples' requires a positive number.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == INTERVAL_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !parseSeconds(value, intervalSeconds) ||
+          intervalSeconds < MIN_MONITOR_INTERVAL_SECONDS) {
+        std::cerr << "Error: '--interval' must be at least 0.1 seconds.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == FORMAT_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !ProcessExport::parseFormat(value, format) ||
+          format == ExportFormat::Table) {
+        std::cerr << "Error: 'monitor' supports the json and csv formats.\n";
+        return EXIT_USAGE;
+      }
+    } else {
+      std::cerr << "Error: Unknown option for 'monitor': " << args[i] << '\n';
+      return EXIT_USAGE;
+    }
+  }
+
+  std::string contents;
+  SystemCounters previous;
+  if (!DataMonitoring::readSystemCounters(previous, contents)) {
+    std::cerr << "Error: Could not read the stat and meminfo files of "
+              << ProcPaths::procRoot() << ".\n";
+    return EXIT_FAILURE;
+  }
+
+  OutputBuffer out;
+  if (format == ExportFormat::Csv) {
+    out.append("timestamp_ms,cpu,memory,memory_used,memory_total\n");
+  }
+
+  auto interval = std::chrono::duration<double>(intervalSeconds);
+  for (size_t i = 0; i < samples; ++i) {
+    std::this_thread::sleep_for(interval);
+
+    SystemCounters current;
+    if (!DataMonitoring::readSystemCounters(current, contents)) {
+      std::cerr << "Error: Could not read system statistics.\n";
+      return EXIT_FAILURE;
+    }
+
+    // CPU usage is the busy share of the ticks elapsed since the last sample
+    double cpuUsage =
+        DataMonitoring::cpuUsage(previous.cpus[0], current.cpus[0]);
+    unsigned long long usedKb =
+        current.memTotalKb > current.memAvailableKb
+            ? current.memTotalKb - current.memAvailableKb
+            : 0;
+    double memoryUsage =
+        current.memTotalKb == 0
+            ? 0.0
+            : 100.0 * static_cast<double>(usedKb) / current.memTotalKb;
+    long long timestampMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+
+    if (format == ExportFormat::Json) {
+      out.append("{\"timestamp_ms\":");
+      out.appendNumber(timestampMs);
+      out.append(",\"cpu\":");
+      out.appendNumber(cpuUsage, PERCENT_PRECISION);
+      out.append(",\"memory\":");
+      out.appendNumber(memoryUsage, PERCENT_PRECISION);
+      out.append(",\"memory_used\":");
+      out.appendNumber(usedKb * BYTES_PER_KB);
+      out.append(",\"memory_total\":");
+      out.appendNumber(current.memTotalKb * BYTES_PER_KB);
+      out.append("}\n");
+    } else {
+      out.appendNumber(timestampMs);
+      out.append(',');
+      out.appendNumber(cpuUsage, PERCENT_PRECISION);
+      out.append(',');
+      out.appendNumber(memoryUsage, PERCENT_PRECISION);
+      out.append(',');
+      out.appendNumber(usedKb * BYTES_PER_KB);
+      out.append(',');
+      out.appendNumber(current.memTotalKb * BYTES_PER_KB);
+      out.append('\n');
+    }
+
+    // Stream each sample so a pipeline sees it without waiting for the rest
+    if (!out.flush(STDOUT_FILENO)) {
+      return EXIT_FAILURE;
+    }
+    previous = std::move(current);
+  }
+  return EXIT_SUCCESS;
+}
+
+int OneShot::runServe(const std::vector<std::string> &args) {
+  std::string address;
+  double intervalSeconds = DEFAULT_SERVE_INTERVAL_SECONDS;
+  size_t top = 0;
+
+  for (size_t i = 0; i < args.size(); ++i) {
+    std::string value;
+    if (args[i] == LISTEN_OPTION) {
+      if (!optionValue(args, i, address)) {
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == INTERVAL_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !parseSeconds(value, intervalSeconds) ||
+          intervalSeconds < MIN_MONITOR_INTERVAL_SECONDS) {
+        std::cerr << "Error: '--interval' must be at least 0.1 seconds.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == TOP_OPTION) {
+      if (!optionValue(args, i, value) || !parseCount(value, top)) {
+        std::cerr << "Error: '--top' requires a number of processes.\n";
+        return EXIT_USAGE;
+      }
+    } else {
+      std::cerr << "Error: Unknown option for 'serve': " << args[i] << '\n';
+      return EXIT_USAGE;
+    }
+  }
+  if (address.empty()) {
+    std::cerr << "Error: 'serve' requires '--listen HOST:PORT'.\n";
+    return EXIT_USAGE;
+  }
+
+  HttpServer server;
+  std::string error;
+  if (!server.listen(address, error)) {
+    std::cerr << "Error: " << error << '\n';
+    return EXIT_FAILURE;
+  }
+
+  SignalWaiter waiter([&server] { server.stop(); });
+
+  MetricsExporter exporter(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::duration<double>(intervalSeconds)),
+      top);
+  exporter.start();
+
+  server.addRoute(METRICS_PATH, METRICS_CONTENT_TYPE,
+                  [&exporter] { return exporter.snapshot(); });
+  auto index = std::make_shared<const std::string>(
+      "process_manager exporter\nMetrics are served at /metrics\n");
+  server.addRoute("/", "text/plain; charset=utf-8", [index] { return index; });
+
+  std::cerr << "Serving metrics on http://" << address << METRICS_PATH
+            << '\n';
+  bool served = server.run(error);
+  waiter.finish();
+  exporter.stop();
+  if (!served) {
+    std::cerr << "Error: " << error << '\n';
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+int OneShot::runDaemon(const std::vector<std::string> &args) {
+  std::string path = CollectorDaemon::defaultSocketPath();
+  double intervalSeconds = DEFAULT_DAEMON_INTERVAL_SECONDS;
+  size_t historyLength = DEFAULT_HISTORY_LENGTH;
+  std::string sharedName;
+  size_t sharedCapacity = DEFAULT_SHM_CAPACITY;
+  std::unique_ptr<RuleEngine> rules;
+  bool dryRun = false;
+
+  for (size_t i = 0; i < args.size(); ++i) {
+    std::string value;
+    if (args[i] == SOCKET_OPTION) {
+      if (!optionValue(args, i, path)) {
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == INTERVAL_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !parseSeconds(value, intervalSeconds) ||
+          intervalSeconds < MIN_MONITOR_INTERVAL_SECONDS) {
+        std::cerr << "Error: '--interval' must be at least 0.1 seconds.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == HISTORY_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !parseCount(value, historyLength) || historyLength == 0) {
+        std::cerr << "Error: '--history' requires a positive number.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == SHM_OPTION) {
+      // The segment name is optional
+      sharedName = i + 1 < args.size() && args[i + 1].rfind("--", 0) != 0
+                       ? args[++i]
+                       : ShmSnapshotWriter::defaultName();
+    } else if (args[i] == SHM_CAPACITY_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !parseCount(value, sharedCapacity) || sharedCapacity == 0 ||
+          sharedCapacity > std::numeric_limits<uint32_t>::max()) {
+        std::cerr << "Error: '--shm-capacity' requires a positive number.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == RULES_OPTION) {
+      std::string error;
+      rules = std::make_unique<RuleEngine>();
+      if (!optionValue(args, i, value) || !rules->load(value, error)) {
+        if (!error.empty()) {
+          std::cerr << "Error: " << error << '\n';
+        }
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == DRY_RUN_OPTION) {
+      dryRun = true;
+    } else {
+      std::cerr << "Error: Unknown option for 'daemon': " << args[i] << '\n';
+      return EXIT_USAGE;
+    }
+  }
+
+  CollectorDaemon daemon(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::duration<double>(intervalSeconds)),
+      historyLength);
+  std::string error;
+  if (!daemon.listen(path, error) ||
+      (!sharedName.empty() &&
+       !daemon.publishSharedMemory(
+           sharedName, static_cast<uint32_t>(sharedCapacity), error))) {
+    std::cerr << "Error: " << error << '\n';
+    return EXIT_FAILURE;
+  }
+  if (rules) {
+    std::cerr << "Evaluating " << rules->rules().size() << " rules"
+              << (dryRun ? " (dry run)" : "") << '\n';
+    daemon.enableRules(std::move(rules), dryRun);
+  }
+
+  SignalWaiter waiter([&daemon] { daemon.stop(); });
+  std::cerr << "Collector listening on " << path << '\n';
+  bool served = daemon.run(error);
+  waiter.finish();
+  if (!served) {
+    std::cerr << "Error: " << error << '\n';
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+int OneShot::runQuery(const std::vector<std::string> &args) {
+  std::string path = CollectorDaemon::defaultSocketPath();
+  ExportFormat format = ExportFormat::Table;
+  std::vector<std::string> request;
+
+  for (size_t i = 0; i < args.size(); ++i) {
+    std::string value;
+    if (args[i] == SOCKET_OPTION) {
+      if (!optionValue(args, i, path)) {
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == FORMAT_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !ProcessExport::parseFormat(value, format) ||
+          format == ExportFormat::Csv) {
+        std::cerr << "Error: 'query' supports the table and json formats.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i].rfind("--", 0) == 0) {
+      std::cerr << "Error: Unknown option for 'query': " << args[i] << '\n';
+      return EXIT_USAGE;
+    } else {
+      request.push_back(args[i]);
+    }
+  }
+
+  // snapshot | top N | history PID | subscribe [N]
+  size_t argument = 0;
+  bool valid = !request.empty() && request.size() <= 2;
+  if (valid && request.size() == 2) {
+    valid = parseCount(request[1], argument);
+  }
+  if (valid) {
+    const std::string &name = request[0];
+    valid = (name == "snapshot" && request.size() == 1) ||
+            (name == "top" && request.size() == 2 && argument > 0) ||
+            (name == "history" && request.size() == 2 && argument > 0) ||
+            name == "subscribe";
+  }
+  if (!valid) {
+    std::cerr << "Error: 'query' expects snapshot, top N, history PID or "
+                 "subscribe [N].\n";
+    return EXIT_USAGE;
+  }
+
+  DaemonClient client;
+  std::string error;
+  if (!client.connect(path, error)) {
+    std::cerr << "Error: " << error << '\n';
+    return EXIT_FAILURE;
+  }
+  DisplayFormat::setColorEnabled(isatty(STDOUT_FILENO) != 0);
+
+  OutputBuffer out;
+  auto emit = [&out, format](const DaemonSnapshot &snapshot) {
+    if (format == ExportFormat::Json) {
+      writeSnapshotJson(out, snapshot);
+    } else {
+      std::ostringstream table;
+      DaemonClient::printTable(table, snapshot);
+      out.append(table.str());
+    }
+    return out.flush(STDOUT_FILENO);
+  };
+
+  if (request[0] == "history") {
+    std::vector<DaemonHistorySample> samples;
+    if (!client.fetchHistory(static_cast<int>(argument), samples, error)) {
+      std::cerr << "Error: " << error << '\n';
+      return EXIT_FAILURE;
+    }
+    if (format == ExportFormat::Json) {
+      out.append("{\"pid\":");
+      out.appendNumber(static_cast<unsigned long long>(argument));
+      out.append(",\"samples\":[");
+    } else {
+      out.append("Time(ms)       CPU%      Memory%   RSS\n");
+    }
+    for (size_t i = 0; i < samples.size(); ++i) {
+      const DaemonHistorySample &sample = samples[i];
+      if (format == ExportFormat::Json) {
+        out.append(i == 0 ? "{\"timestamp_ms\":" : ",{\"timestamp_ms\":");
+        out.appendNumber(static_cast<unsigned long long>(sample.timestampMs));
+        out.append(",\"cpu\":");
+        out.appendNumber(sample.cpuUsage, PERCENT_PRECISION);
+        out.append(",\"mem\":");
+        out.appendNumber(sample.memoryUsage, PERCENT_PRECISION);
+        out.append(",\"rss\":");
+        out.appendNumber(sample.rssKb * BYTES_PER_KB);
+        out.append('}');
+      } else {
+        std::ostringstream row;
+        row << std::left << std::setw(15) << sample.timestampMs
+            << std::setw(10) << std::fixed << std::setprecision(2)
+            << sample.cpuUsage << std::setw(10) << sample.memoryUsage
+            << DisplayFormat::bytes(sample.rssKb * BYTES_PER_KB) << '\n';
+        out.append(row.str());
+      }
+    }
+    if (format == ExportFormat::Json) {
+      out.append("]}\n");
+    }
+    return out.flush(STDOUT_FILENO) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  DaemonSnapshot snapshot;
+  if (request[0] != "subscribe") {
+    if (!client.fetchSnapshot(argument, snapshot, error)) {
+      std::cerr << "Error: " << error << '\n';
+      return EXIT_FAILURE;
+    }
+    return emit(snapshot) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  // Streams until the daemon goes away or the reader closes the pipe
+  if (!client.subscribe(argument, error)) {
+    std::cerr << "Error: " << error << '\n';
+    return EXIT_FAILURE;
+  }
+  while (client.nextSnapshot(snapshot, error)) {
+    if (!emit(snapshot)) {
+      return EXIT_FAILURE;
+    }
+  }
+  std::cerr << "Error: " << error << '\n';
+  return EXIT_FAILURE;
+}
+
+int OneShot::runRules(const std::vector<std::string> &args) {
+  if (args.size() != 1) {
+    std::cerr << "Error: 'rules' requires a rules file.\n";
+    return EXIT_USAGE;
+  }
+  RuleEngine rules;
+  std::string error;
+  if (!rules.load(args[0], error)) {
+    std::cerr << "Error: " << error << '\n';
+    return EXIT_FAILURE;
+  }
+  for (const Rule &rule : rules.rules()) {
+    std::cout << rule.name << ": " << rule.text << '\n';
+  }
+  return EXIT_SUCCESS;
+}
+
+int OneShot::runFakeProc(const std::vector<std::string> &args) {
+  FakeProcfsOptions options;
+  std::string root;
+  double intervalSeconds = 0.0;
+
+  for (size_t i = 0; i < args.size(); ++i) {
+    std::string value;
+    size_t count = 0;
+    if (args[i] == PROCESSES_OPTION) {
+      if (!optionValue(args, i, value) || !parseCount(value, count)) {
+        std::cerr << "Error: '--processes' requires a number.\n";
+        return EXIT_USAGE;
+      }
+      options.processes = count;
+    } else if (args[i] == CHURN_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !parseSeconds(value, options.churn) || options.churn < 0.0 ||
+          options.churn > 1.0) {
+        std::cerr << "Error: '--churn' must be between 0 and 1.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == LOAD_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !FakeProcfs::parseLoad(value, options.load)) {
+        std::cerr << "Error: '--load' must be idle, mixed or busy.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == CPUS_OPTION) {
+      if (!optionValue(args, i, value) || !parseCount(value, count) ||
+          count == 0) {
+        std::cerr << "Error: '--cpus' requires a positive number.\n";
+        return EXIT_USAGE;
+      }
+      options.cpus = static_cast<unsigned>(count);
+    } else if (args[i] == SEED_OPTION) {
+      if (!optionValue(args, i, value) || !parseCount(value, count)) {
+        std::cerr << "Error: '--seed' requires a number.\n";
+        return EXIT_USAGE;
+      }
+      options.seed = count;
+    } else if (args[i] == INTERVAL_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !parseSeconds(value, intervalSeconds) ||
+          intervalSeconds < MIN_MONITOR_INTERVAL_SECONDS) {
+        std::cerr << "Error: '--interval' must be at least 0.1 seconds.\n";
+        return EXIT_USAGE;
+      }
+    } else if (root.empty() && args[i][0] != '-') {
+      root = args[i];
+    } else {
+      std::cerr << "Error: Unknown option for 'fake-proc': " << args[i]
+                << '\n';
+      return EXIT_USAGE;
+    }
+  }
+  if (root.empty()) {
+    std::cerr << "Error: 'fake-proc' requires a directory.\n";
+    return EXIT_USAGE;
+  }
+
+  FakeProcfs procfs(options);
+  std::string error;
+  if (!procfs.create(root, error)) {
+    std::cerr << "Error: " << error << '\n';
+    return EXIT_FAILURE;
+  }
+  if (intervalSeconds == 0.0) {
+    return EXIT_SUCCESS;
+  }
+
+  // Keep the tree moving until SIGINT or SIGTERM
+  std::mutex mutex;
+  std::condition_variable wakeup;
+  bool stopped = false;
+  SignalWaiter waiter([&] {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+    wakeup.notify_all();
+  });
+  std::cerr << "Advancing " << root << " every " << intervalSeconds
+            << " s\n";
+  auto interval = std::chrono::duration<double>(intervalSeconds);
+  bool failed = false;
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!wakeup.wait_for(lock, interval, [&stopped] { return stopped; })) {
+    if (!procfs.advance(intervalSeconds, error)) {
+      std::cerr << "Error: " << error << '\n';
+      failed = true;
+      break;
+    }
+  }
+  lock.unlock();
+  waiter.finish();
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int OneShot::runStats(const std::vector<std::string> &args) {
+  std::string path = CollectorDaemon::defaultSocketPath();
+  ExportFormat format = ExportFormat::Table;
+  size_t scans = 0;
+  double intervalSeconds = DEFAULT_MONITOR_INTERVAL_SECONDS;
+
+  for (size_t i = 0; i < args.size(); ++i) {
+    std::string value;
+    if (args[i] == SOCKET_OPTION) {
+      if (!optionValue(args, i, path)) {
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == FORMAT_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !ProcessExport::parseFormat(value, format) ||
+          format == ExportFormat::Csv) {
+        std::cerr << "Error: '--format' must be table or json.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == SCANS_OPTION) {
+      if (!optionValue(args, i, value) || !parseCount(value, scans) ||
+          scans == 0) {
+        std::cerr << "Error: '--scans' requires a positive number.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == INTERVAL_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !parseSeconds(value, intervalSeconds) || intervalSeconds < 0.0) {
+        std::cerr << "Error: '--interval' requires a number of seconds.\n";
+        return EXIT_USAGE;
+      }
+    } else {
+      std::cerr << "Error: Unknown option for 'stats': " << args[i] << '\n';
+      return EXIT_USAGE;
+    }
+  }
+
+  SelfStatsSnapshot stats;
+  if (scans > 0) {
+    // Measure this process doing the work of `list`
+    ListOptions options;
+    ProcessListing listing;
+    for (size_t scan = 0; scan < scans; ++scan) {
+      if (scan > 0) {
+        std::this_thread::sleep_for(
+            std::chrono::duration<double>(intervalSeconds));
+      }
+      listing.refresh(options);
+      std::ostringstream discarded;
+      listing.printTable(discarded, options.columns);
+    }
+    stats = SelfStats::snapshot();
+  } else {
+    DaemonClient client;
+    std::string error;
+    if (!client.connect(path, error) || !client.fetchStats(stats, error)) {
+      std::cerr << "Error: " << error << '\n';
+      return EXIT_FAILURE;
+    }
+  }
+
+  OutputBuffer out;
+  if (format == ExportFormat::Json) {
+    SelfStats::writeJson(out, stats);
+    out.append('\n');
+  } else {
+    std::ostringstream table;
+    SelfStats::writeTable(table, stats);
+    out.append(table.str());
+  }
+  return out.flush(STDOUT_FILENO) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int OneShot::runNuma(const std::vector<std::string> &args) {
+  ExportFormat format = ExportFormat::Table;
+  size_t processes = 0;
+
+  for (size_t i = 0; i < args.size(); ++i) {
+    std::string value;
+    if (args[i] == FORMAT_OPTION) {
+      if (!optionValue(args, i, value) ||
+          !ProcessExport::parseFormat(value, format) ||
+          format == ExportFormat::Csv) {
+        std::cerr << "Error: '--format' must be table or json.\n";
+        return EXIT_USAGE;
+      }
+    } else if (args[i] == PROCESSES_OPTION) {
+      if (!optionValue(args, i, value) || !parseCount(value, processes)) {
+        std::cerr << "Error: '--processes' requires a number of processes.\n";
+        return EXIT_USAGE;
+      }
+    } else {
+      std::cerr << "Error: Unknown option for 'numa': " << args[i] << '\n';
+      return EXIT_USAGE;
+    }
+  }
+
+  SystemTopology topology;
+  std::string error;
+  if (!NumaTopology::discover(topology, error)) {
+    std::cerr << "Error: " << error << ".\n";
+    return EXIT_FAILURE;
+  }
+
+  // The residency of the largest processes, read from numa_maps
+  ProcessListing listing;
+  if (processes > 0) {
+    ListOptions options;
+    options.columns = {ProcessColumn::Pid, ProcessColumn::Name,
+                       ProcessColumn::Rss, ProcessColumn::NumaNode};
+    options.numaTopN = processes;
+    listing.refresh(options);
+    listing.sortProcesses(ProcessColumn::Rss, true);
+  }
+
+  OutputBuffer out;
+  if (format == ExportFormat::Json) {
+    writeNumaJson(out, topology, listing, processes);
+  } else {
+    DisplayFormat::setColorEnabled(isatty(STDOUT_FILENO) != 0);
+    std::ostringstream table;
+    writeNumaTable(table, topology, listing, processes);
+    out.append(table.str());
+  }
+  return out.flush(STDOUT_FILENO) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void OneShot::printUsage() {
+  std::cerr << "Usage:\n"
+            << "  process_manager                 Start the interactive shell\n"
+            << "  process_manager [--proc-root DIR] [--sys-root DIR]\n"
+            << "                  [--scan-cpus LIST] [--scan-nodes LIST]\n"
+            << "                  [--scan-backend sync|io_uring]\n"
+            << "                  COMMAND\n"
+            << "  process_manager list [--format table|json|csv] [--top N]\n"
+            << "                       [--columns <list>] [--smaps-top N]\n"
+            << "                       [--numa-top N] [--threads]\n"
+            << "                       [--interval S] [--filter EXPR]\n"
+            << "  process_manager threads PID [list options]\n"
+            << "  process_manager events [--interval S] [--scans N]\n"
+            << "                         [--format table|json]\n"
+            << "  process_manager monitor [--samples N] [--interval S]\n"
+            << "                          [--format json|csv]\n"
+            << "  process_manager serve --listen HOST:PORT [--interval S]\n"
+            << "                        [--top N]\n"
+            << "  process_manager daemon [--socket PATH] [--interval S]\n"
+            << "                         [--history N] [--shm [NAME]]\n"
+            << "                         [--shm-capacity N] [--rules FILE]\n"
+            << "                         [--dry-run]\n"
+            << "  process_manager query [--socket PATH] [--format table|json]\n"
+            << "                        snapshot | top N | history PID |\n"
+            << "                        subscribe [N]\n"
+            << "  process_manager rules FILE      Check a rules file\n"
+            << "  process_manager stats [--socket PATH] [--format table|json]\n"
+            << "                        [--scans N [--interval S]]\n"
+            << "  process_manager fake-proc DIR [--processes N] [--churn F]\n"
+            << "                  [--load idle|mixed|busy] [--cpus N]\n"
+            << "                  [--seed N] [--interval S]\n"
+            << "  process_manager numa [--format table|json] [--processes N]\n"
+            << "Columns: " << ProcessColumns::availableKeys() << '\n'
+            << "Filters: KEY OP VALUE clauses joined by &&, || and !, e.g.\n"
+            << "         'name~nginx && cpu>5 && user==www'\n";
+}
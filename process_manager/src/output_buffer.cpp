@@ -0,0 +1,110 @@
+// src/output_buffer.cpp
+
+#include "../include/output_buffer.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+
+namespace {
+const size_t NUMBER_BUFFER_SIZE = 32; // Fits any 64-bit integer
+const size_t DOUBLE_BUFFER_SIZE = 64; // Fits fixed doubles of usual range
+const char HEX_DIGITS[] = "0123456789abcdef"; // For \u escapes
+} // namespace
+
+void OutputBuffer::appendNumber(unsigned long long value) {
+  char digits[NUMBER_BUFFER_SIZE];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value);
+  buffer_.append(digits, result.ptr);
+}
+
+void OutputBuffer::appendNumber(long long value) {
+  char digits[NUMBER_BUFFER_SIZE];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value);
+  buffer_.append(digits, result.ptr);
+}
+
+void OutputBuffer::appendNumber(double value, int precision) {
+  if (!std::isfinite(value)) {
+    buffer_.push_back('0');
+    return;
+  }
+
+  char digits[DOUBLE_BUFFER_SIZE];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value,
+                              std::chars_format::fixed, precision);
+  if (result.ec != std::errc()) {
+    // Too large for fixed notation; let the shortest form decide
+    result = std::to_chars(digits, digits + sizeof(digits), value);
+  }
+  buffer_.append(digits, result.ptr);
+}
+
+void OutputBuffer::appendJsonString(std::string_view text) {
+  buffer_.push_back('"');
+  for (char c : text) {
+    switch (c) {
+    case '"':
+      buffer_.append("\\\"");
+      break;
+    case '\\':
+      buffer_.append("\\\\");
+      break;
+    case '\n':
+      buffer_.append("\\n");
+      break;
+    case '\r':
+      buffer_.append("\\r");
+      break;
+    case '\t':
+      buffer_.append("\\t");
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        buffer_.append("\\u00");
+        buffer_.push_back(HEX_DIGITS[(c >> 4) & 0xf]);
+        buffer_.push_back(HEX_DIGITS[c & 0xf]);
+      } else {
+        buffer_.push_back(c);
+      }
+    }
+  }
+  buffer_.push_back('"');
+}
+
+void OutputBuffer::appendCsvField(std::string_view text) {
+  if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+    buffer_.append(text);
+    return;
+  }
+
+  buffer_.push_back('"');
+  for (char c : text) {
+    if (c == '"') {
+      buffer_.push_back('"');
+    }
+    buffer_.push_back(c);
+  }
+  buffer_.push_back('"');
+}
+
+bool OutputBuffer::flush(int fd) {
+  const char *data = buffer_.data();
+  size_t remaining = buffer_.size();
+  while (remaining > 0) {
+    ssize_t written = write(fd, data, remaining);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      buffer_.clear();
+      return false;
+    }
+    data += written;
+    remaining -= static_cast<size_t>(written);
+  }
+  buffer_.clear();
+  return true;
+}
@@ -0,0 +1,163 @@
+// src/overhead_governor.cpp
+
+#include "../include/overhead_governor.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace {
+/**
+ * @brief One degradation level; each one is lighter than the previous.
+ */
+struct Level {
+  int intervalFactor; ///< Multiplies the requested interval
+  size_t topNDivisor; ///< Divides the PSS/USS and NUMA top-N
+  bool dropOptional;  ///< Removes the columns of optional sources
+};
+
+const Level LEVELS[] = {
+    {1, 1, false}, // Full detail
+    {2, 1, false}, // Stretch the interval first
+    {4, 1, false},
+    {4, 4, false}, // Then read PSS/USS and NUMA for fewer processes
+    {4, 4, true},  // Then stop reading the optional sources
+    {8, 4, true},
+};
+const size_t LEVEL_COUNT = sizeof(LEVELS) / sizeof(LEVELS[0]);
+
+const size_t OVER_BUDGET_CYCLES = 2; // Consecutive cycles before degrading
+const size_t RELAX_CYCLES = 10;      // Consecutive cycles before relaxing
+const double RELAX_FRACTION = 0.5;   // Share of the budget the lighter level
+                                     // may be predicted to use
+
+// Sources of the columns that are kept at every level
+const unsigned CHEAP_SOURCES =
+    PROC_SOURCE_STAT | PROC_SOURCE_STATM | PROC_SOURCE_OWNER;
+
+double cpuMs(const rusage &usage) {
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+}
+} // namespace
+
+OverheadGovernor::OverheadGovernor(double budgetPercent)
+    : budgetPercent_(budgetPercent), usagePercent_(0.0), level_(0),
+      overCycles_(0), underCycles_(0), started_(false), lastUsage_{} {}
+
+bool OverheadGovernor::update(double workerCpuMs) {
+  // Other threads of the process, e.g. the history recorder, are not the
+  // governed view's cost and cannot be lightened by degrading it
+  rusage usage{};
+  getrusage(RUSAGE_THREAD, &usage);
+  auto now = std::chrono::steady_clock::now();
+  bool changed = false;
+  if (started_) {
+    // The first cycle only starts the measurement, so caches warmed by the
+    // first scan do not count against the budget
+    changed = record(
+        cpuMs(usage) - cpuMs(lastUsage_) + workerCpuMs,
+        std::chrono::duration<double, std::milli>(now - lastAt_).count());
+  }
+  started_ = true;
+  lastUsage_ = usage;
+  lastAt_ = now;
+  return changed;
+}
+
+bool OverheadGovernor::record(double cpuMs, double wallMs) {
+  if (wallMs <= 0.0) {
+    return false;
+  }
+  usagePercent_ = 100.0 * cpuMs / wallMs;
+
+  size_t previousLevel = level_;
+  if (usagePercent_ > budgetPercent_) {
+    underCycles_ = 0;
+    if (++overCycles_ >= OVER_BUDGET_CYCLES && level_ + 1 < LEVEL_COUNT) {
+      ++level_;
+      overCycles_ = 0;
+    }
+  } else {
+    overCycles_ = 0;
+    // A shorter interval costs proportionally more, so relax only when the
+    // lighter level is predicted to stay well within the budget
+    double stretch = level_ == 0 ? 1.0
+                                 : static_cast<double>(
+                                       LEVELS[level_].intervalFactor) /
+                                       LEVELS[level_ - 1].intervalFactor;
+    if (level_ > 0 &&
+        usagePercent_ * stretch < budgetPercent_ * RELAX_FRACTION) {
+      if (++underCycles_ >= RELAX_CYCLES) {
+        --level_;
+        underCycles_ = 0;
+      }
+    } else {
+      underCycles_ = 0;
+    }
+  }
+
+  if (level_ == previousLevel) {
+    return false;
+  }
+  std::ostringstream message;
+  message.precision(2);
+  message << std::fixed << "Self CPU usage " << usagePercent_
+          << "% of one core against a budget of " << budgetPercent_ << "%: ";
+  if (level_ == 0) {
+    message << "back to full detail.";
+    logger_.logAction(message.str());
+  } else {
+    message << (level_ > previousLevel ? "degraded to " : "relaxed to ")
+            << describe() << ".";
+    logger_.logWarning(message.str());
+  }
+  return true;
+}
+
+std::chrono::milliseconds
+OverheadGovernor::interval(std::chrono::milliseconds requested) const {
+  return requested * LEVELS[level_].intervalFactor;
+}
+
+ListOptions OverheadGovernor::apply(const ListOptions &requested,
+                                    ProcessColumn keep) const {
+  ListOptions options = requested;
+  const Level &level = LEVELS[level_];
+  if (level.topNDivisor > 1) {
+    // Keep at least the largest process, unless none was asked for
+    options.smapsTopN = std::min(requested.smapsTopN,
+                                 std::max<size_t>(1, requested.smapsTopN /
+                                                         level.topNDivisor));
+    options.numaTopN = std::min(requested.numaTopN,
+                                std::max<size_t>(1, requested.numaTopN /
+                                                        level.topNDivisor));
+  }
+  if (level.dropOptional) {
+    options.columns.erase(
+        std::remove_if(options.columns.begin(), options.columns.end(),
+                       [keep](ProcessColumn column) {
+                         return column != keep && isOptional(column);
+                       }),
+        options.columns.end());
+  }
+  return options;
+}
+
+std::string OverheadGovernor::describe() const {
+  const Level &level = LEVELS[level_];
+  std::ostringstream text;
+  if (level.intervalFactor > 1) {
+    text << "interval x" << level.intervalFactor;
+  }
+  if (level.topNDivisor > 1) {
+    text << ", PSS/USS and NUMA top-N /" << level.topNDivisor;
+  }
+  if (level.dropOptional) {
+    text << ", optional columns off";
+  }
+  return text.str();
+}
+
+bool OverheadGovernor::isOptional(ProcessColumn column) {
+  return (ProcessColumns::spec(column).sources & ~CHEAP_SOURCES) != 0;
+}
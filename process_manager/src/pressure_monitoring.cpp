@@ -0,0 +1,165 @@
+// src/pressure_monitoring.cpp
+
+#include "../include/pressure_monitoring.h"
+#include "../include/proc_paths.h"
+#include "../include/proc_reader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <sstream>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+// Files of each resource, indexed by `PressureResource`
+const char *SYSTEM_FILES[] = {"pressure/cpu", "pressure/memory",
+                              "pressure/io"};
+const char *CGROUP_FILES[] = {"/cpu.pressure", "/memory.pressure",
+                              "/io.pressure"};
+const char *RESOURCE_NAMES[] = {"CPU", "Memory", "IO"};
+
+// Stall time per window that fires a trigger, in microseconds. Some CPU
+// pressure is normal on a busy machine, memory and IO stalls are not
+const unsigned long long TRIGGER_THRESHOLD_US[] = {1000000, 300000, 300000};
+
+// Unprivileged users may only register windows that are multiples of 2 s
+const unsigned long long TRIGGER_WINDOW_US = 2000000;
+} // namespace
+
+PressureMonitoring::PressureMonitoring()
+    : wakeupFd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), armed_(false),
+      stalls_(0),
+      lastResource_(PressureResource::Cpu) {}
+
+PressureMonitoring::~PressureMonitoring() { close(wakeupFd_); }
+
+bool PressureMonitoring::isAvailable() {
+  ProcPressure pressure;
+  return readSystem(PressureResource::Cpu, pressure);
+}
+
+bool PressureMonitoring::readSystem(PressureResource resource,
+                                    ProcPressure &pressure) {
+  std::string contents;
+  return ProcReader::readFile(
+             ProcPaths::proc(SYSTEM_FILES[static_cast<size_t>(resource)]),
+             contents) &&
+         ProcParsers::parsePressure(contents, pressure);
+}
+
+bool PressureMonitoring::readCgroup(const std::string &directory,
+                                    PressureResource resource,
+                                    ProcPressure &pressure) {
+  std::string contents;
+  return ProcReader::readFile(
+             directory + CGROUP_FILES[static_cast<size_t>(resource)],
+             contents) &&
+         ProcParsers::parsePressure(contents, pressure);
+}
+
+const char *PressureMonitoring::resourceName(PressureResource resource) {
+  return RESOURCE_NAMES[static_cast<size_t>(resource)];
+}
+
+bool PressureMonitoring::waitForStalls() {
+  // One slot per resource, then the eventfd of `stop`
+  pollfd fds[RESOURCE_COUNT + 1];
+  PressureResource resources[RESOURCE_COUNT];
+  size_t count = 0;
+  for (size_t i = 0; i < RESOURCE_COUNT; ++i) {
+    std::string path = ProcPaths::proc(SYSTEM_FILES[i]);
+    int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd == -1) {
+      continue;
+    }
+
+    // The trigger is the written string itself, including its NUL
+    std::string trigger = "some " + std::to_string(TRIGGER_THRESHOLD_US[i]) +
+                          " " + std::to_string(TRIGGER_WINDOW_US);
+    if (write(fd, trigger.c_str(), trigger.size() + 1) < 0) {
+      logger_.logWarning("Cannot register a PSI trigger on " + path + ": " +
+                         std::strerror(errno));
+      close(fd);
+      continue;
+    }
+    fds[count] = pollfd{fd, POLLPRI, 0};
+    resources[count] = static_cast<PressureResource>(i);
+    ++count;
+  }
+
+  bool armed = count > 0;
+  armed_ = armed;
+  if (armed) {
+    logger_.logAction("Registered " + std::to_string(count) +
+                      " PSI triggers.");
+  }
+
+  // Without triggers, still wait for `stop` so that it is consumed
+  fds[count] = pollfd{wakeupFd_, POLLIN, 0};
+  bool stopped = false;
+  while (!stopped) {
+    if (poll(fds, count + 1, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      logger_.logError(std::string("PSI poll failed: ") +
+                       std::strerror(errno));
+      break;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+      if ((fds[i].revents & POLLERR) != 0) {
+        // The file is gone, e.g. PSI was disabled at runtime
+        close(fds[i].fd);
+        fds[i].fd = -1;
+      } else if ((fds[i].revents & POLLPRI) != 0) {
+        ProcPressure pressure;
+        std::ostringstream message;
+        message << resourceName(resources[i]) << " pressure stall";
+        if (readSystem(resources[i], pressure)) {
+          message << ": some avg10=" << pressure.some.avg10 << "%";
+        }
+        logger_.logWarning(message.str());
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stalls_;
+        lastResource_ = resources[i];
+        lastStall_ = std::chrono::steady_clock::now();
+      }
+    }
+
+    if ((fds[count].revents & POLLIN) != 0) {
+      uint64_t value = 0;
+      ssize_t ignored = read(wakeupFd_, &value, sizeof(value));
+      (void)ignored;
+      stopped = true;
+    }
+  }
+
+  // Closing the files removes the triggers
+  armed_ = false;
+  for (size_t i = 0; i < count; ++i) {
+    if (fds[i].fd != -1) {
+      close(fds[i].fd);
+    }
+  }
+  return armed;
+}
+
+void PressureMonitoring::stop() {
+  uint64_t value = 1;
+  ssize_t ignored = write(wakeupFd_, &value, sizeof(value));
+  (void)ignored;
+}
+
+uint64_t PressureMonitoring::getStalls(
+    PressureResource &last,
+    std::chrono::steady_clock::time_point &lastAt) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  last = lastResource_;
+  lastAt = lastStall_;
+  return stalls_;
+}
@@ -0,0 +1,606 @@
+// src/proc_parsers.cpp
+
+#include "../include/proc_parsers.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace {
+// Field positions in /proc/<pid>/stat, counted from 1 as in proc(5)
+const int STAT_FIRST_FIELD_AFTER_COMM = 3; // "state" follows the comm field
+const int STAT_PPID_FIELD = 4;
+const int STAT_MINFLT_FIELD = 10;
+const int STAT_MAJFLT_FIELD = 12;
+const int STAT_UTIME_FIELD = 14;
+const int STAT_STIME_FIELD = 15;
+const int STAT_CUTIME_FIELD = 16;
+const int STAT_CSTIME_FIELD = 17;
+const int STAT_NUM_THREADS_FIELD = 20;
+const int STAT_STARTTIME_FIELD = 22;
+
+const char *VOLUNTARY_CTXT_KEY = "voluntary_ctxt_switches:";
+const char *NONVOLUNTARY_CTXT_KEY = "nonvoluntary_ctxt_switches:";
+const char *READ_BYTES_KEY = "read_bytes:";
+const char *WRITE_BYTES_KEY = "write_bytes:";
+const char *MEM_TOTAL_KEY = "MemTotal:";
+const char *PSS_KEY = "Pss:";
+const char *PRIVATE_CLEAN_KEY = "Private_Clean:";
+const char *PRIVATE_DIRTY_KEY = "Private_Dirty:";
+const char *CPU_LINE_PREFIX = "cpu ";
+const char *CPU_NAME_PREFIX = "cpu"; // Also starts the per-CPU lines
+const char *IO_READ_BYTES_KEY = "rbytes=";
+const char *IO_WRITE_BYTES_KEY = "wbytes=";
+const char *NODE_LINE_PREFIX = "Node ";          // Starts node meminfo lines
+const char *NODE_MEM_TOTAL_KEY = "MemTotal:";
+const char *NODE_MEM_FREE_KEY = "MemFree:";
+const char *NODE_MEM_USED_KEY = "MemUsed:";
+const char *NODE_FILE_PAGES_KEY = "FilePages:";
+const char *NODE_ANON_PAGES_KEY = "AnonPages:";
+const char *NUMA_PAGE_SIZE_KEY = "kernelpagesize_kB="; // Page size of a map
+const unsigned long long DEFAULT_NUMA_PAGE_KB = 4; // When none is listed
+const unsigned long long MAX_NUMA_NODE = 1023;     // Largest accepted node
+const char *PRESSURE_SOME_PREFIX = "some ";        // Starts the `some` line
+const char *PRESSURE_FULL_PREFIX = "full ";        // Starts the `full` line
+const char *PRESSURE_AVG10_KEY = "avg10=";
+const char *PRESSURE_AVG60_KEY = "avg60=";
+const char *PRESSURE_AVG300_KEY = "avg300=";
+const char *PRESSURE_TOTAL_KEY = "total=";
+
+// Counters of a /proc/diskstats line after the name; later kernels append
+// discard and flush counters, which are not used
+enum DiskstatsField {
+  DISK_READS,
+  DISK_READS_MERGED,
+  DISK_READ_SECTORS,
+  DISK_READ_MS,
+  DISK_WRITES,
+  DISK_WRITES_MERGED,
+  DISK_WRITE_SECTORS,
+  DISK_WRITE_MS,
+  DISK_IN_FLIGHT,
+  DISK_BUSY_MS,
+  DISK_FIELD_COUNT
+};
+
+// Counters of a /proc/net/dev line after the colon
+enum NetDevField {
+  NET_RX_BYTES,
+  NET_RX_PACKETS,
+  NET_RX_ERRORS,
+  NET_RX_DROPS,
+  NET_RX_FIFO,
+  NET_RX_FRAME,
+  NET_RX_COMPRESSED,
+  NET_RX_MULTICAST,
+  NET_TX_BYTES,
+  NET_TX_PACKETS,
+  NET_TX_ERRORS,
+  NET_TX_DROPS,
+  NET_FIELD_COUNT
+};
+
+// Skips spaces and tabs starting at `p`
+const char *skipBlanks(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t')) {
+    ++p;
+  }
+  return p;
+}
+
+// Parses an unsigned decimal number at `p` and advances `p` past it
+bool parseNumber(const char *&p, const char *end, unsigned long long &value) {
+  p = skipBlanks(p, end);
+  if (p >= end || *p < '0' || *p > '9') {
+    return false;
+  }
+  value = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    value = value * 10 + static_cast<unsigned long long>(*p - '0');
+    ++p;
+  }
+  return true;
+}
+
+// Finds "key value" at the beginning of a line and parses the value
+bool findKeyValue(std::string_view contents, const char *key,
+                  unsigned long long &value) {
+  size_t keyLength = std::strlen(key);
+  size_t pos = 0;
+  while (pos < contents.size()) {
+    if (contents.compare(pos, keyLength, key) == 0) {
+      const char *p = contents.data() + pos + keyLength;
+      return parseNumber(p, contents.data() + contents.size(), value);
+    }
+    pos = contents.find('\n', pos);
+    if (pos == std::string::npos) {
+      break;
+    }
+    ++pos;
+  }
+  return false;
+}
+
+// Returns the end of the line starting at `p`
+const char *findLineEnd(const char *p, const char *end) {
+  const char *lineEnd =
+      static_cast<const char *>(std::memchr(p, '\n', end - p));
+  return lineEnd != nullptr ? lineEnd : end;
+}
+
+// Parses `count` numbers at `p` into `values`; fails at the end of the line
+bool parseNumbers(const char *p, const char *end, unsigned long long *values,
+                  int count) {
+  for (int i = 0; i < count; ++i) {
+    if (!parseNumber(p, end, values[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Parses the `key=value` fields of one pressure line, between `p` and `end`
+void parsePressureLine(const char *p, const char *end, PressureLine &line) {
+  while (p < end) {
+    p = skipBlanks(p, end);
+    const char *tokenEnd = p;
+    while (tokenEnd < end && *tokenEnd != ' ') {
+      ++tokenEnd;
+    }
+    std::string_view token(p, static_cast<size_t>(tokenEnd - p));
+    double *average = nullptr;
+    size_t keyLength = 0;
+    if (token.starts_with(PRESSURE_AVG10_KEY)) {
+      average = &line.avg10;
+      keyLength = std::strlen(PRESSURE_AVG10_KEY);
+    } else if (token.starts_with(PRESSURE_AVG60_KEY)) {
+      average = &line.avg60;
+      keyLength = std::strlen(PRESSURE_AVG60_KEY);
+    } else if (token.starts_with(PRESSURE_AVG300_KEY)) {
+      average = &line.avg300;
+      keyLength = std::strlen(PRESSURE_AVG300_KEY);
+    } else if (token.starts_with(PRESSURE_TOTAL_KEY)) {
+      const char *number = p + std::strlen(PRESSURE_TOTAL_KEY);
+      parseNumber(number, tokenEnd, line.totalUsec);
+    }
+    if (average != nullptr) {
+      std::from_chars(p + keyLength, tokenEnd, *average);
+    }
+    p = tokenEnd;
+  }
+}
+} // namespace
+
+bool ProcParsers::parseStat(std::string_view contents, ProcStat &stat) {
+  // The comm field is enclosed in parentheses and may itself contain them
+  size_t commStart = contents.find('(');
+  size_t commEnd = contents.rfind(')');
+  if (commStart == std::string::npos || commEnd == std::string::npos ||
+      commEnd < commStart) {
+    return false;
+  }
+
+  const char *p = contents.data() + commEnd + 1;
+  const char *end = contents.data() + contents.size();
+
+  // Fields that are not numeric (state) or may be negative stay at zero; none
+  // of them are used
+  unsigned long long values[STAT_STARTTIME_FIELD + 1] = {};
+  for (int field = STAT_FIRST_FIELD_AFTER_COMM; field <= STAT_STARTTIME_FIELD;
+       ++field) {
+    p = skipBlanks(p, end);
+    if (p >= end) {
+      return false;
+    }
+    const char *tokenEnd = p;
+    while (tokenEnd < end && *tokenEnd != ' ' && *tokenEnd != '\n') {
+      ++tokenEnd;
+    }
+    const char *token = p;
+    parseNumber(token, tokenEnd, values[field]);
+    p = tokenEnd;
+  }
+
+  stat.comm = std::string_view(contents.data() + commStart + 1,
+                               commEnd - commStart - 1);
+  stat.ppid = static_cast<int>(values[STAT_PPID_FIELD]);
+  stat.minorFaults = values[STAT_MINFLT_FIELD];
+  stat.majorFaults = values[STAT_MAJFLT_FIELD];
+  stat.utime = values[STAT_UTIME_FIELD];
+  stat.stime = values[STAT_STIME_FIELD];
+  stat.cutime = values[STAT_CUTIME_FIELD];
+  stat.cstime = values[STAT_CSTIME_FIELD];
+  stat.numThreads = static_cast<long>(values[STAT_NUM_THREADS_FIELD]);
+  stat.startTime = values[STAT_STARTTIME_FIELD];
+  return true;
+}
+
+bool ProcParsers::parseStatm(std::string_view contents,
+                             unsigned long long &residentPages) {
+  const char *p = contents.data();
+  const char *end = contents.data() + contents.size();
+  unsigned long long size = 0;
+  // The first value is the total program size, the second one is RSS
+  return parseNumber(p, end, size) && parseNumber(p, end, residentPages);
+}
+
+bool ProcParsers::parseStatus(std::string_view contents,
+                              ProcStatus &status) {
+  return findKeyValue(contents, VOLUNTARY_CTXT_KEY,
+                      status.voluntaryCtxSwitches) &&
+         findKeyValue(contents, NONVOLUNTARY_CTXT_KEY,
+                      status.involuntaryCtxSwitches);
+}
+
+bool ProcParsers::parseIo(std::string_view contents, ProcIo &io) {
+  return findKeyValue(contents, READ_BYTES_KEY, io.readBytes) &&
+         findKeyValue(contents, WRITE_BYTES_KEY, io.writeBytes);
+}
+
+bool ProcParsers::parseSmapsRollup(std::string_view contents,
+                                   ProcSmaps &smaps) {
+  unsigned long long privateClean = 0;
+  unsigned long long privateDirty = 0;
+  if (!findKeyValue(contents, PSS_KEY, smaps.pssKb) ||
+      !findKeyValue(contents, PRIVATE_CLEAN_KEY, privateClean) ||
+      !findKeyValue(contents, PRIVATE_DIRTY_KEY, privateDirty)) {
+    return false;
+  }
+  smaps.ussKb = privateClean + privateDirty;
+  return true;
+}
+
+bool ProcParsers::parseCpuTotal(std::string_view contents,
+                                unsigned long long &totalTime) {
+  unsigned long long idleTime = 0;
+  return parseCpuTimes(contents, totalTime, idleTime);
+}
+
+bool ProcParsers::parseCpuTimes(std::string_view contents,
+                                unsigned long long &totalTime,
+                                unsigned long long &idleTime) {
+  size_t prefixLength = std::strlen(CPU_LINE_PREFIX);
+  if (contents.compare(0, prefixLength, CPU_LINE_PREFIX) != 0) {
+    return false;
+  }
+
+  const char *p = contents.data() + prefixLength;
+  const char *end = contents.data() + contents.size();
+
+  // user, nice, system, idle, iowait, irq, softirq and steal
+  const int CPU_TIME_FIELDS = 8;
+  const int CPU_IDLE_FIELD = 3;
+  const int CPU_IOWAIT_FIELD = 4;
+  totalTime = 0;
+  idleTime = 0;
+  for (int i = 0; i < CPU_TIME_FIELDS; ++i) {
+    unsigned long long value = 0;
+    if (!parseNumber(p, end, value)) {
+      return false;
+    }
+    totalTime += value;
+    if (i == CPU_IDLE_FIELD || i == CPU_IOWAIT_FIELD) {
+      idleTime += value;
+    }
+  }
+  return true;
+}
+
+bool ProcParsers::parseCpuLines(std::string_view contents,
+                                std::vector<CpuTimes> &cpus) {
+  cpus.clear();
+  size_t prefixLength = std::strlen(CPU_NAME_PREFIX);
+  const char *p = contents.data();
+  const char *end = contents.data() + contents.size();
+
+  // The cpu lines come first; stop at the first other line
+  while (p < end && static_cast<size_t>(end - p) > prefixLength &&
+         std::strncmp(p, CPU_NAME_PREFIX, prefixLength) == 0) {
+    p += prefixLength;
+    CpuTimes times;
+    if (*p != ' ') {
+      unsigned long long cpu = 0;
+      if (!parseNumber(p, end, cpu)) {
+        break;
+      }
+      times.cpu = static_cast<int>(cpu);
+    }
+    for (int i = 0; i < CpuTimes::MODE_COUNT; ++i) {
+      if (!parseNumber(p, end, times.ticks[i])) {
+        return !cpus.empty() && cpus[0].cpu == -1;
+      }
+    }
+    cpus.push_back(times);
+
+    const char *lineEnd =
+        static_cast<const char *>(std::memchr(p, '\n', end - p));
+    p = lineEnd != nullptr ? lineEnd + 1 : end;
+  }
+  return !cpus.empty() && cpus[0].cpu == -1;
+}
+
+bool ProcParsers::parseMemTotal(std::string_view contents,
+                                unsigned long long &totalKb) {
+  return findKeyValue(contents, MEM_TOTAL_KEY, totalKb);
+}
+
+bool ProcParsers::parseUptime(std::string_view contents, double &seconds) {
+  // The view need not be NUL-terminated, so std::strtod cannot be used
+  const char *end = contents.data() + contents.size();
+  const char *p = skipBlanks(contents.data(), end);
+  std::from_chars_result result = std::from_chars(p, end, seconds);
+  return result.ec == std::errc() && result.ptr != p;
+}
+
+bool ProcParsers::parseKeyedValue(std::string_view contents, const char *key,
+                                  unsigned long long &value) {
+  return findKeyValue(contents, key, value);
+}
+
+void ProcParsers::parseCgroupIoStat(std::string_view contents,
+                                    unsigned long long &readBytes,
+                                    unsigned long long &writeBytes) {
+  readBytes = 0;
+  writeBytes = 0;
+
+  // Each line looks like "8:0 rbytes=1 wbytes=2 rios=3 wios=4 ..."
+  const size_t readKeyLength = std::strlen(IO_READ_BYTES_KEY);
+  const size_t writeKeyLength = std::strlen(IO_WRITE_BYTES_KEY);
+  const char *p = contents.data();
+  const char *end = contents.data() + contents.size();
+  while (p < end) {
+    const char *tokenEnd = p;
+    while (tokenEnd < end && *tokenEnd != ' ' && *tokenEnd != '\n') {
+      ++tokenEnd;
+    }
+
+    size_t length = static_cast<size_t>(tokenEnd - p);
+    unsigned long long value = 0;
+    if (length > readKeyLength &&
+        std::strncmp(p, IO_READ_BYTES_KEY, readKeyLength) == 0) {
+      const char *number = p + readKeyLength;
+      if (parseNumber(number, tokenEnd, value)) {
+        readBytes += value;
+      }
+    } else if (length > writeKeyLength &&
+               std::strncmp(p, IO_WRITE_BYTES_KEY, writeKeyLength) == 0) {
+      const char *number = p + writeKeyLength;
+      if (parseNumber(number, tokenEnd, value)) {
+        writeBytes += value;
+      }
+    }
+    p = tokenEnd + 1;
+  }
+}
+
+bool ProcParsers::parseCpuList(std::string_view contents,
+                               std::vector<int> &values) {
+  values.clear();
+  const char *p = contents.data();
+  const char *end = p + contents.size();
+  while (end > p && (end[-1] == '\n' || end[-1] == ' ')) {
+    --end;
+  }
+
+  while (p < end) {
+    unsigned long long first = 0;
+    unsigned long long last = 0;
+    if (!parseNumber(p, end, first)) {
+      return false;
+    }
+    last = first;
+    if (p < end && *p == '-') {
+      ++p;
+      if (!parseNumber(p, end, last) || last < first) {
+        return false;
+      }
+    }
+    for (unsigned long long value = first; value <= last; ++value) {
+      values.push_back(static_cast<int>(value));
+    }
+    if (p < end) {
+      if (*p != ',') {
+        return false;
+      }
+      ++p;
+    }
+  }
+  std::sort(values.begin(), values.end());
+  return true;
+}
+
+bool ProcParsers::parseNodeMeminfo(std::string_view contents,
+                                   NodeMemory &memory) {
+  memory = NodeMemory();
+  const struct {
+    const char *key;
+    unsigned long long NodeMemory::*field;
+  } KEYS[] = {{NODE_MEM_TOTAL_KEY, &NodeMemory::totalKb},
+              {NODE_MEM_FREE_KEY, &NodeMemory::freeKb},
+              {NODE_MEM_USED_KEY, &NodeMemory::usedKb},
+              {NODE_FILE_PAGES_KEY, &NodeMemory::fileKb},
+              {NODE_ANON_PAGES_KEY, &NodeMemory::anonKb}};
+
+  bool haveTotal = false;
+  const size_t prefixLength = std::strlen(NODE_LINE_PREFIX);
+  const char *p = contents.data();
+  const char *end = p + contents.size();
+  while (p < end) {
+    const char *lineEnd =
+        static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (lineEnd == nullptr) {
+      lineEnd = end;
+    }
+
+    // Skip "Node <N> " and match the key that follows
+    unsigned long long node = 0;
+    const char *key = p + prefixLength;
+    if (static_cast<size_t>(lineEnd - p) > prefixLength &&
+        std::strncmp(p, NODE_LINE_PREFIX, prefixLength) == 0 &&
+        parseNumber(key, lineEnd, node)) {
+      key = skipBlanks(key, lineEnd);
+      for (const auto &entry : KEYS) {
+        size_t keyLength = std::strlen(entry.key);
+        if (static_cast<size_t>(lineEnd - key) > keyLength &&
+            std::strncmp(key, entry.key, keyLength) == 0) {
+          const char *value = key + keyLength;
+          if (parseNumber(value, lineEnd, memory.*entry.field) &&
+              entry.field == &NodeMemory::totalKb) {
+            haveTotal = true;
+          }
+          break;
+        }
+      }
+    }
+    p = lineEnd + 1;
+  }
+  return haveTotal;
+}
+
+bool ProcParsers::parseNumaMaps(std::string_view contents,
+                                std::vector<unsigned long long> &nodeKb) {
+  nodeKb.clear();
+  const size_t pageSizeKeyLength = std::strlen(NUMA_PAGE_SIZE_KEY);
+  bool haveMapping = false;
+  const char *p = contents.data();
+  const char *end = p + contents.size();
+  while (p < end) {
+    const char *lineEnd =
+        static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (lineEnd == nullptr) {
+      lineEnd = end;
+    }
+    haveMapping = true;
+
+    // The page size comes last on the line, so find it first
+    unsigned long long pageKb = DEFAULT_NUMA_PAGE_KB;
+    std::string_view line(p, static_cast<size_t>(lineEnd - p));
+    size_t pageSize = line.rfind(NUMA_PAGE_SIZE_KEY);
+    if (pageSize != std::string_view::npos) {
+      const char *value = p + pageSize + pageSizeKeyLength;
+      parseNumber(value, lineEnd, pageKb);
+    }
+
+    // Tokens such as "N1=512" are separated by single spaces
+    const char *token = p;
+    while (token < lineEnd) {
+      const char *tokenEnd = static_cast<const char *>(
+          std::memchr(token, ' ', static_cast<size_t>(lineEnd - token)));
+      if (tokenEnd == nullptr) {
+        tokenEnd = lineEnd;
+      }
+      unsigned long long node = 0;
+      unsigned long long pages = 0;
+      const char *number = token + 1;
+      if (*token == 'N' && parseNumber(number, tokenEnd, node) &&
+          number < tokenEnd && *number == '=' && node <= MAX_NUMA_NODE) {
+        ++number;
+        if (parseNumber(number, tokenEnd, pages)) {
+          if (nodeKb.size() <= node) {
+            nodeKb.resize(node + 1, 0);
+          }
+          nodeKb[node] += pages * pageKb;
+        }
+      }
+      token = tokenEnd + 1;
+    }
+    p = lineEnd + 1;
+  }
+  return haveMapping;
+}
+
+bool ProcParsers::parsePressure(std::string_view contents,
+                                ProcPressure &pressure) {
+  pressure = ProcPressure{};
+  bool hasSome = false;
+  size_t pos = 0;
+  while (pos < contents.size()) {
+    size_t lineEnd = contents.find('\n', pos);
+    if (lineEnd == std::string::npos) {
+      lineEnd = contents.size();
+    }
+    std::string_view line = contents.substr(pos, lineEnd - pos);
+    const char *end = line.data() + line.size();
+    if (line.starts_with(PRESSURE_SOME_PREFIX)) {
+      parsePressureLine(line.data() + std::strlen(PRESSURE_SOME_PREFIX), end,
+                        pressure.some);
+      hasSome = true;
+    } else if (line.starts_with(PRESSURE_FULL_PREFIX)) {
+      parsePressureLine(line.data() + std::strlen(PRESSURE_FULL_PREFIX), end,
+                        pressure.full);
+      pressure.hasFull = true;
+    }
+    pos = lineEnd + 1;
+  }
+  return hasSome;
+}
+
+bool ProcParsers::parseDiskstats(std::string_view contents,
+                                 std::vector<DiskCounters> &disks) {
+  disks.clear();
+  const char *p = contents.data();
+  const char *end = p + contents.size();
+  while (p < end) {
+    const char *lineEnd = findLineEnd(p, end);
+
+    // Each line looks like "   8       0 sda 1 2 3 ..."
+    unsigned long long major = 0;
+    unsigned long long minor = 0;
+    if (parseNumber(p, lineEnd, major) && parseNumber(p, lineEnd, minor)) {
+      const char *name = skipBlanks(p, lineEnd);
+      const char *nameEnd = name;
+      while (nameEnd < lineEnd && *nameEnd != ' ') {
+        ++nameEnd;
+      }
+
+      unsigned long long values[DISK_FIELD_COUNT];
+      if (nameEnd > name &&
+          parseNumbers(nameEnd, lineEnd, values, DISK_FIELD_COUNT)) {
+        DiskCounters disk;
+        disk.name = std::string_view(name, static_cast<size_t>(nameEnd - name));
+        disk.reads = values[DISK_READS];
+        disk.readSectors = values[DISK_READ_SECTORS];
+        disk.readMs = values[DISK_READ_MS];
+        disk.writes = values[DISK_WRITES];
+        disk.writeSectors = values[DISK_WRITE_SECTORS];
+        disk.writeMs = values[DISK_WRITE_MS];
+        disk.busyMs = values[DISK_BUSY_MS];
+        disks.push_back(disk);
+      }
+    }
+    p = lineEnd + 1;
+  }
+  return !disks.empty();
+}
+
+bool ProcParsers::parseNetDev(std::string_view contents,
+                              std::vector<NetCounters> &interfaces) {
+  interfaces.clear();
+  const char *p = contents.data();
+  const char *end = p + contents.size();
+  while (p < end) {
+    const char *lineEnd = findLineEnd(p, end);
+
+    // The two header lines have no colon; interface lines look like
+    // "  eth0: 1234 5 0 0 0 0 0 0 5678 6 0 0 0 0 0 0"
+    const char *colon =
+        static_cast<const char *>(std::memchr(p, ':', lineEnd - p));
+    unsigned long long values[NET_FIELD_COUNT];
+    if (colon != nullptr &&
+        parseNumbers(colon + 1, lineEnd, values, NET_FIELD_COUNT)) {
+      const char *name = skipBlanks(p, colon);
+      NetCounters interface;
+      interface.name =
+          std::string_view(name, static_cast<size_t>(colon - name));
+      interface.rxBytes = values[NET_RX_BYTES];
+      interface.rxPackets = values[NET_RX_PACKETS];
+      interface.rxDrops = values[NET_RX_DROPS];
+      interface.txBytes = values[NET_TX_BYTES];
+      interface.txPackets = values[NET_TX_PACKETS];
+      interface.txDrops = values[NET_TX_DROPS];
+      interfaces.push_back(interface);
+    }
+    p = lineEnd + 1;
+  }
+  return !interfaces.empty();
+}
@@ -0,0 +1,90 @@
+// src/proc_paths.cpp
+
+#include "../include/proc_paths.h"
+
+#include <charconv>
+#include <iterator>
+#include <limits>
+
+namespace {
+const char *DEFAULT_PROC_ROOT = "/proc"; // Root of the real procfs
+const char *DEFAULT_SYS_ROOT = "/sys";   // Root of the real sysfs
+
+/**
+ * @brief Returns the storage of the procfs root.
+ */
+std::string &procRootStorage() {
+  static std::string root = DEFAULT_PROC_ROOT;
+  return root;
+}
+
+/**
+ * @brief Returns the storage of the sysfs root.
+ */
+std::string &sysRootStorage() {
+  static std::string root = DEFAULT_SYS_ROOT;
+  return root;
+}
+
+/**
+ * @brief Removes trailing slashes, keeping a lone `/`.
+ */
+std::string normalize(std::string root) {
+  while (root.size() > 1 && root.back() == '/') {
+    root.pop_back();
+  }
+  return root;
+}
+} // namespace
+
+const std::string &ProcPaths::procRoot() { return procRootStorage(); }
+
+const std::string &ProcPaths::sysRoot() { return sysRootStorage(); }
+
+void ProcPaths::setProcRoot(std::string root) {
+  procRootStorage() = normalize(std::move(root));
+}
+
+void ProcPaths::setSysRoot(std::string root) {
+  sysRootStorage() = normalize(std::move(root));
+}
+
+std::string ProcPaths::proc(std::string_view relative) {
+  std::string path = procRoot();
+  path += '/';
+  path += relative;
+  return path;
+}
+
+std::string ProcPaths::sys(std::string_view relative) {
+  std::string path = sysRoot();
+  path += '/';
+  path += relative;
+  return path;
+}
+
+std::string ProcPaths::process(int pid) {
+  std::string path = procRoot();
+  path += '/';
+  path += std::to_string(pid);
+  path += '/';
+  return path;
+}
+
+void ProcPaths::process(int pid, std::pmr::string &path) {
+  char digits[std::numeric_limits<int>::digits10 + 2];
+  std::to_chars_result end = std::to_chars(digits, std::end(digits), pid);
+  path.assign(procRoot());
+  path += '/';
+  path.append(digits, end.ptr);
+  path += '/';
+}
+
+void ProcPaths::task(int pid, int tid, std::pmr::string &path) {
+  process(pid, path);
+  char digits[std::numeric_limits<int>::digits10 + 2];
+  std::to_chars_result end = std::to_chars(digits, std::end(digits), tid);
+  path += "task/";
+  path.append(digits, end.ptr);
+  path += '/';
+}
@@ -0,0 +1,136 @@
+// src/proc_reader.cpp
+
+#include "../include/proc_reader.h"
+#include "../include/self_stats.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+const size_t READ_CHUNK_SIZE = 4096; // Smallest buffer, and its growth step
+
+/**
+ * @brief Returns whether a directory entry name is `.` or `..`.
+ */
+bool isDotEntry(const char *name) {
+  return name[0] == '.' &&
+         (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+/**
+ * @brief Reads a file into a `std::string` or `std::pmr::string`.
+ */
+template <typename Buffer>
+bool readInto(const char *path, Buffer &contents) {
+  SelfTimerScope timer(SelfTimer::Read);
+  contents.clear();
+
+  int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    SelfStats::add(SelfCounter::Syscalls);
+    return false;
+  }
+  SelfStats::add(SelfCounter::FilesOpened);
+  uint64_t syscalls = 2; // open and close
+
+  // procfs files report a size of zero, so read until EOF into the whole
+  // capacity, growing by fixed chunks only when it is full
+  size_t used = 0;
+  contents.resize(std::max(contents.capacity(), READ_CHUNK_SIZE));
+  while (true) {
+    if (used == contents.size()) {
+      contents.resize(used + READ_CHUNK_SIZE);
+    }
+    ssize_t bytes =
+        ::read(fd, contents.data() + used, contents.size() - used);
+    ++syscalls;
+    if (bytes < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ::close(fd);
+      SelfStats::add(SelfCounter::Syscalls, syscalls);
+      contents.clear();
+      return false;
+    }
+    if (bytes == 0) {
+      break;
+    }
+    used += static_cast<size_t>(bytes);
+  }
+  contents.resize(used);
+
+  ::close(fd);
+  SelfStats::add(SelfCounter::Syscalls, syscalls);
+  SelfStats::add(SelfCounter::BytesRead, used);
+  return true;
+}
+} // namespace
+
+bool ProcReader::readFile(const std::string &path, std::string &contents) {
+  return readInto(path.c_str(), contents);
+}
+
+bool ProcReader::readFile(const char *path, std::pmr::string &contents) {
+  return readInto(path, contents);
+}
+
+long ProcReader::countEntries(const char *path) {
+  SelfTimerScope timer(SelfTimer::Read);
+  ProcDirectory directory(path);
+  if (!directory.isOpen()) {
+    return -1;
+  }
+
+  long count = 0;
+  unsigned char type = DT_UNKNOWN;
+  while (directory.next(type) != nullptr) {
+    ++count;
+  }
+  return count;
+}
+
+ProcDirectory::ProcDirectory(const char *path)
+    : fd_(::open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) {
+  if (fd_ != -1) {
+    SelfStats::add(SelfCounter::FilesOpened);
+  }
+}
+
+ProcDirectory::~ProcDirectory() {
+  if (fd_ != -1) {
+    ::close(fd_);
+    ++syscalls_;
+  }
+  SelfStats::add(SelfCounter::Syscalls, syscalls_);
+}
+
+const char *ProcDirectory::next(unsigned char &type) {
+  while (fd_ != -1) {
+    if (offset_ >= size_) {
+      long bytes = ::syscall(SYS_getdents64, fd_, buffer_, BUFFER_SIZE);
+      ++syscalls_;
+      if (bytes < 0 && errno == EINTR) {
+        continue;
+      }
+      if (bytes <= 0) {
+        return nullptr; // End of the directory, or it was removed
+      }
+      offset_ = 0;
+      size_ = static_cast<size_t>(bytes);
+    }
+
+    // getdents64 fills the buffer with variable-length dirent64 records
+    const auto *entry = reinterpret_cast<const dirent64 *>(buffer_ + offset_);
+    offset_ += entry->d_reclen;
+    if (!isDotEntry(entry->d_name)) {
+      type = entry->d_type;
+      return entry->d_name;
+    }
+  }
+  return nullptr;
+}
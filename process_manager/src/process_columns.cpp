@@ -0,0 +1,120 @@
+// src/process_columns.cpp
+
+#include "../include/process_columns.h"
+
+#include <sstream>
+
+namespace {
+// Column table; the order matches the ProcessColumn enumeration
+const ColumnSpec COLUMN_SPECS[] = {
+    {ProcessColumn::Pid, "pid", "PID", 8, PROC_SOURCE_NONE},
+    {ProcessColumn::Name, "name", "Name", 32, PROC_SOURCE_STAT},
+    {ProcessColumn::Cpu, "cpu", "CPU%", 10, PROC_SOURCE_STAT},
+    {ProcessColumn::Memory, "mem", "Memory%", 10, PROC_SOURCE_STATM},
+    {ProcessColumn::Rss, "rss", "RSS", 10, PROC_SOURCE_STATM},
+    {ProcessColumn::Threads, "threads", "Threads", 9, PROC_SOURCE_STAT},
+    {ProcessColumn::MinorFaults, "minflt", "MinFlt/s", 10, PROC_SOURCE_STAT},
+    {ProcessColumn::MajorFaults, "majflt", "MajFlt/s", 10, PROC_SOURCE_STAT},
+    {ProcessColumn::VoluntaryCtxSwitches, "vctx", "VolCtx", 12,
+     PROC_SOURCE_STATUS},
+    {ProcessColumn::InvoluntaryCtxSwitches, "nvctx", "InvolCtx", 12,
+     PROC_SOURCE_STATUS},
+    {ProcessColumn::IoRead, "io_read", "IORead", 10, PROC_SOURCE_IO},
+    {ProcessColumn::IoWrite, "io_write", "IOWrite", 10, PROC_SOURCE_IO},
+    {ProcessColumn::OpenFds, "fds", "FDs", 7, PROC_SOURCE_FD},
+    // smaps_rollup is only read for the largest processes by RSS
+    {ProcessColumn::Pss, "pss", "PSS", 10,
+     PROC_SOURCE_SMAPS | PROC_SOURCE_STATM},
+    {ProcessColumn::Uss, "uss", "USS", 10,
+     PROC_SOURCE_SMAPS | PROC_SOURCE_STATM},
+    // Metadata is cached per process identity, which needs the start time
+    {ProcessColumn::User, "user", "User", 12,
+     PROC_SOURCE_OWNER | PROC_SOURCE_STAT},
+    {ProcessColumn::Cmdline, "cmdline", "Command", 48,
+     PROC_SOURCE_CMDLINE | PROC_SOURCE_STAT},
+    // numa_maps is only read for the largest processes by RSS, like smaps
+    {ProcessColumn::NumaNode, "numa_node", "Node", 6,
+     PROC_SOURCE_NUMA | PROC_SOURCE_STATM},
+    {ProcessColumn::NumaShare, "numa_share", "Node%", 8,
+     PROC_SOURCE_NUMA | PROC_SOURCE_STATM},
+    {ProcessColumn::Tid, "tid", "TID", 8, PROC_SOURCE_NONE},
+};
+
+const char COLUMN_SEPARATOR = ','; // Separator used in --columns lists
+} // namespace
+
+const std::vector<ProcessColumn> &ProcessColumns::defaultColumns() {
+  static const std::vector<ProcessColumn> columns = {
+      ProcessColumn::Pid, ProcessColumn::Cpu, ProcessColumn::Memory,
+      ProcessColumn::Name};
+  return columns;
+}
+
+const std::vector<ProcessColumn> &ProcessColumns::defaultThreadColumns() {
+  static const std::vector<ProcessColumn> columns = {
+      ProcessColumn::Pid, ProcessColumn::Tid, ProcessColumn::Cpu,
+      ProcessColumn::Name};
+  return columns;
+}
+
+bool ProcessColumns::parse(const std::string &list,
+                           std::vector<ProcessColumn> &columns,
+                           std::string &error) {
+  columns.clear();
+
+  std::istringstream stream(list);
+  std::string key;
+  while (std::getline(stream, key, COLUMN_SEPARATOR)) {
+    if (key.empty()) {
+      continue;
+    }
+
+    ProcessColumn column;
+    if (!find(key, column)) {
+      error = "Unknown column '" + key + "'. Available columns: " +
+              availableKeys();
+      return false;
+    }
+    columns.push_back(column);
+  }
+
+  if (columns.empty()) {
+    error = "No columns given. Available columns: " + availableKeys();
+    return false;
+  }
+  return true;
+}
+
+bool ProcessColumns::find(std::string_view key, ProcessColumn &column) {
+  for (const auto &spec : COLUMN_SPECS) {
+    if (key == spec.key) {
+      column = spec.column;
+      return true;
+    }
+  }
+  return false;
+}
+
+const ColumnSpec &ProcessColumns::spec(ProcessColumn column) {
+  return COLUMN_SPECS[static_cast<size_t>(column)];
+}
+
+unsigned
+ProcessColumns::requiredSources(const std::vector<ProcessColumn> &columns) {
+  unsigned sources = PROC_SOURCE_NONE;
+  for (ProcessColumn column : columns) {
+    sources |= spec(column).sources;
+  }
+  return sources;
+}
+
+std::string ProcessColumns::availableKeys() {
+  std::string keys;
+  for (const auto &spec : COLUMN_SPECS) {
+    if (!keys.empty()) {
+      keys += COLUMN_SEPARATOR;
+    }
+    keys += spec.key;
+  }
+  return keys;
+}
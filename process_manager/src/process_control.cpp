@@ -1,12 +1,25 @@
 
 #include "../include/process_control.h"
 #include "../include/logger.h"
+#include "../include/numa_topology.h"
+#include "../include/proc_paths.h"
+#include "../include/proc_reader.h"
+#include "../include/process_listing.h"
 
+#include <algorithm>
 #include <cerrno>
+#include <charconv>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <sched.h>
 #include <signal.h>
+#include <string_view>
+#include <sys/resource.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -14,64 +27,331 @@
 constexpr int INVALID_PID = -1; // Invalid process ID value
 constexpr int SLEEP_DURATION =
     1; // Sleep time in seconds before checking process termination
+constexpr int MAX_IO_LEVEL = 7;        // Lowest level of an IO class
+constexpr int DEFAULT_IO_LEVEL = 4;    // Level of a class given without one
+constexpr int IOPRIO_WHO_PROCESS = 1;  // `ioprio_set` target: one thread
+constexpr int IOPRIO_CLASS_SHIFT = 13; // Class bits above the level
+constexpr const char *CGROUP_FILE = "cgroup";   // Memberships, below the PID
+constexpr const char *CGROUP_V2_PREFIX = "0::"; // The unified hierarchy
+constexpr const char *CGROUP_V2_ROOTS[] = {"fs/cgroup", "fs/cgroup/unified"};
+constexpr const char *CPU_MAX_FILE = "/cpu.max";
+constexpr const char *UNLIMITED_QUOTA = "max";
+
+namespace {
+/**
+ * @brief Parses a whole string as a decimal integer.
+ */
+bool parseInt(std::string_view text, long long &value) {
+  auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  return !text.empty() && error == std::errc() &&
+         end == text.data() + text.size();
+}
+
+/**
+ * @brief Reports a failed action on one process and logs it.
+ */
+void reportFailure(Logger &logger, const std::string &action, int pid,
+                   int error) {
+  std::cerr << "Error: Failed to " << action << " PID " << pid << ": "
+            << std::strerror(error) << ".\n";
+  logger.logError("Failed to " + action + " PID " + std::to_string(pid) +
+                  ": " + std::strerror(error));
+}
+
+/**
+ * @brief Applies a per-thread setting to every thread of a process.
+ *
+ * Threads that exit meanwhile are skipped.
+ *
+ * @param pid The process.
+ * @param action What is done, for the error messages, e.g. `renice`.
+ * @param outcome What was done, for the log, e.g. `to nice 10`.
+ * @param apply Changes one thread, returning `false` with `errno` set.
+ * @return `true` if every remaining thread was changed.
+ */
+template <typename Apply>
+bool applyToThreads(int pid, const std::string &action,
+                    const std::string &outcome, Apply apply) {
+  Logger logger;
+  if (pid <= 0) {
+    std::cerr << "Error: Invalid PID " << pid << ".\n";
+    logger.logError("Invalid PID " + std::to_string(pid) + " to " + action +
+                    ".");
+    return false;
+  }
+  std::pmr::vector<int> tids;
+  ProcessListing::getThreadIds(pid, tids);
+  if (tids.empty()) {
+    reportFailure(logger, action, pid, ESRCH);
+    return false;
+  }
+  for (int tid : tids) {
+    if (!apply(tid) && errno != ESRCH) {
+      reportFailure(logger, action, pid, errno);
+      return false;
+    }
+  }
+  std::cout << "Set PID " << pid << ' ' << outcome << ".\n";
+  logger.logAction("Set PID " + std::to_string(pid) + " " + outcome + " (" +
+                   std::to_string(tids.size()) + " threads).");
+  return true;
+}
+} // namespace
 
 void ProcessControl::terminateProcess(int pid) {
+  terminateProcesses({pid});
+}
+
+size_t ProcessControl::terminateProcesses(const std::vector<int> &pids) {
   Logger logger;
+  std::vector<int> signalled;
 
-  // Step 1: Validate PID
-  if (pid <= INVALID_PID) {
-    std::cerr << "Error: Invalid PID " << pid << ".\n";
-    logger.logError("Invalid PID " + std::to_string(pid) + " for termination.");
-    return;
-  }
-
-  // Step 2: Check process existence
-  if (kill(pid, 0) == -1) {
-    if (errno == ESRCH) {
-      std::cerr << "Error: Process with PID " << pid << " does not exist.\n";
-      logger.logError("Attempted to terminate non-existing process PID " +
-                      std::to_string(pid) + ".");
-    } else if (errno == EPERM) {
-      std::cerr << "Error: Permission denied to terminate PID " << pid << ".\n";
-      logger.logError("Permission denied to terminate PID " +
-                      std::to_string(pid) + ".");
-    } else {
-      std::cerr << "Error: Unable to check process status for PID " << pid
+  for (int pid : pids) {
+    // Step 1: Validate PID
+    if (pid <= INVALID_PID) {
+      std::cerr << "Error: Invalid PID " << pid << ".\n";
+      logger.logError("Invalid PID " + std::to_string(pid) +
+                      " for termination.");
+      continue;
+    }
+
+    // Step 2: Check process existence
+    if (kill(pid, 0) == -1) {
+      if (errno == ESRCH) {
+        std::cerr << "Error: Process with PID " << pid
+                  << " does not exist.\n";
+        logger.logError("Attempted to terminate non-existing process PID " +
+                        std::to_string(pid) + ".");
+      } else if (errno == EPERM) {
+        std::cerr << "Error: Permission denied to terminate PID " << pid
+                  << ".\n";
+        logger.logError("Permission denied to terminate PID " +
+                        std::to_string(pid) + ".");
+      } else {
+        std::cerr << "Error: Unable to check process status for PID " << pid
+                  << ": " << std::strerror(errno) << ".\n";
+        logger.logError("Error checking process status for PID " +
+                        std::to_string(pid) + ": " + std::strerror(errno));
+      }
+      continue;
+    }
+
+    // Step 3: Terminate the process
+    if (kill(pid, SIGTERM) == -1) {
+      std::cerr << "Error: Failed to terminate process with PID " << pid
                 << ": " << std::strerror(errno) << ".\n";
-      logger.logError("Error checking process status for PID " +
-                      std::to_string(pid) + ": " + std::strerror(errno));
+      logger.logError("Failed to terminate PID " + std::to_string(pid) +
+                      ": " + std::strerror(errno));
+      continue;
     }
-    return;
-  }
-
-  // Step 3: Terminate the process
-  if (kill(pid, SIGTERM) == -1) {
-    std::cerr << "Error: Failed to terminate process with PID " << pid << ": "
-              << std::strerror(errno) << ".\n";
-    logger.logError("Failed to terminate PID " + std::to_string(pid) + ": " +
-                    std::strerror(errno));
-    return;
-  }
-
-  // Step 4: Verify termination
-  sleep(SLEEP_DURATION); // Give the system a moment to terminate the process
-  if (kill(pid, 0) == 0) {
-    // Process still exists, attempt SIGKILL
-    std::cerr << "Warning: Process with PID " << pid
-              << " did not terminate. Attempting forced termination...\n";
-    logger.logWarning("PID " + std::to_string(pid) +
-                      " did not terminate. Attempting SIGKILL.");
-
-    if (kill(pid, SIGKILL) == -1) {
-      std::cerr << "Error: Failed to forcefully terminate process with PID "
-                << pid << ": " << std::strerror(errno) << ".\n";
-      logger.logError("Failed to forcefully terminate PID " +
-                      std::to_string(pid) + ": " + std::strerror(errno));
-      return;
+    signalled.push_back(pid);
+  }
+  if (signalled.empty()) {
+    return 0;
+  }
+
+  // Step 4: Verify termination, after one grace period for the whole batch
+  sleep(SLEEP_DURATION); // Give the system a moment to terminate the processes
+  size_t terminated = 0;
+  for (int pid : signalled) {
+    if (kill(pid, 0) == 0) {
+      // Process still exists, attempt SIGKILL
+      std::cerr << "Warning: Process with PID " << pid
+                << " did not terminate. Attempting forced termination...\n";
+      logger.logWarning("PID " + std::to_string(pid) +
+                        " did not terminate. Attempting SIGKILL.");
+
+      if (kill(pid, SIGKILL) == -1) {
+        std::cerr << "Error: Failed to forcefully terminate process with PID "
+                  << pid << ": " << std::strerror(errno) << ".\n";
+        logger.logError("Failed to forcefully terminate PID " +
+                        std::to_string(pid) + ": " + std::strerror(errno));
+        continue;
+      }
     }
+
+    // Step 5: Log success
+    std::cout << "Process with PID " << pid << " terminated successfully.\n";
+    logger.logAction("Successfully terminated PID " + std::to_string(pid) +
+                     ".");
+    ++terminated;
   }
+  return terminated;
+}
+
+bool ProcessControl::renice(int pid, int niceness) {
+  return applyToThreads(pid, "renice",
+                        "to nice " + std::to_string(niceness),
+                        [niceness](int tid) {
+                          return setpriority(PRIO_PROCESS,
+                                             static_cast<id_t>(tid),
+                                             niceness) == 0;
+                        });
+}
+
+bool ProcessControl::ionice(int pid, IoClass ioClass, int level) {
+  if (ioClass == IoClass::Idle) {
+    level = 0;
+  }
+  int priority = (static_cast<int>(ioClass) << IOPRIO_CLASS_SHIFT) | level;
+  return applyToThreads(
+      pid, "set the IO priority of",
+      "to IO class " + std::to_string(static_cast<int>(ioClass)) +
+          " level " + std::to_string(level),
+      [priority](int tid) {
+        return syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, priority) == 0;
+      });
+}
 
-  // Step 5: Log success
-  std::cout << "Process with PID " << pid << " terminated successfully.\n";
-  logger.logAction("Successfully terminated PID " + std::to_string(pid) + ".");
+bool ProcessControl::setAffinity(int pid, const std::vector<int> &cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+      std::cerr << "Error: CPU " << cpu << " is out of range.\n";
+      return false;
+    }
+    CPU_SET(cpu, &set);
+  }
+  return applyToThreads(pid, "set the CPU affinity of",
+                        "to CPUs " + NumaTopology::formatList(cpus),
+                        [&set](int tid) {
+                          return sched_setaffinity(tid, sizeof(set), &set) ==
+                                 0;
+                        });
+}
+
+bool ProcessControl::throttle(int pid, const std::string &cpuMax,
+                              std::string &cgroup) {
+  Logger logger;
+  std::string action = "throttle the cgroup of";
+  if (!cgroupOf(pid, cgroup)) {
+    reportFailure(logger, action, pid, ESRCH);
+    return false;
+  }
+  if (cgroup == "/") {
+    // The root group has no cpu.max: it would throttle the whole system
+    std::cerr << "Error: PID " << pid
+              << " is in the root cgroup, which cannot be throttled.\n";
+    logger.logError("Cannot throttle PID " + std::to_string(pid) +
+                    " in the root cgroup.");
+    return false;
+  }
+
+  for (const char *root : CGROUP_V2_ROOTS) {
+    std::string path = ProcPaths::sys(root) + cgroup + CPU_MAX_FILE;
+    int fd = open(path.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd == -1) {
+      if (errno == ENOENT) {
+        continue; // Not this mount point, or no cpu controller
+      }
+      reportFailure(logger, action, pid, errno);
+      return false;
+    }
+    ssize_t written = write(fd, cpuMax.data(), cpuMax.size());
+    int error = errno;
+    close(fd);
+    if (written != static_cast<ssize_t>(cpuMax.size())) {
+      reportFailure(logger, action, pid, written == -1 ? error : EIO);
+      return false;
+    }
+    std::cout << "Set cpu.max of cgroup " << cgroup << " to '" << cpuMax
+              << "'.\n";
+    logger.logAction("Set cpu.max of cgroup " + cgroup + " to '" + cpuMax +
+                     "' for PID " + std::to_string(pid) + ".");
+    return true;
+  }
+  std::cerr << "Error: The cpu controller is not enabled for cgroup "
+            << cgroup << " of PID " << pid << ".\n";
+  logger.logError("Cannot throttle PID " + std::to_string(pid) +
+                  ": no cpu.max in cgroup " + cgroup + ".");
+  return false;
+}
+
+bool ProcessControl::parsePids(const std::string &text,
+                               std::vector<int> &pids) {
+  pids.clear();
+  std::string_view rest = text;
+  while (true) {
+    size_t comma = rest.find(',');
+    long long pid = 0;
+    if (!parseInt(rest.substr(0, comma), pid) || pid <= 0 ||
+        pid > std::numeric_limits<int>::max()) {
+      return false;
+    }
+    if (std::find(pids.begin(), pids.end(), pid) == pids.end()) {
+      pids.push_back(static_cast<int>(pid));
+    }
+    if (comma == std::string_view::npos) {
+      return true;
+    }
+    rest.remove_prefix(comma + 1);
+  }
+}
+
+bool ProcessControl::parseIoClass(const std::string &text, IoClass &ioClass,
+                                  int &level) {
+  std::string_view name = text;
+  level = DEFAULT_IO_LEVEL;
+  size_t colon = name.find(':');
+  if (colon != std::string_view::npos) {
+    long long value = 0;
+    if (!parseInt(name.substr(colon + 1), value) || value < 0 ||
+        value > MAX_IO_LEVEL) {
+      return false;
+    }
+    level = static_cast<int>(value);
+    name = name.substr(0, colon);
+  }
+  if (name == "realtime" || name == "rt") {
+    ioClass = IoClass::RealTime;
+  } else if (name == "best-effort" || name == "be") {
+    ioClass = IoClass::BestEffort;
+  } else if (name == "idle") {
+    ioClass = IoClass::Idle;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool ProcessControl::formatCpuMax(const std::string &quota,
+                                  const std::string &period,
+                                  std::string &cpuMax) {
+  long long value = 0;
+  if (quota != UNLIMITED_QUOTA && (!parseInt(quota, value) || value <= 0)) {
+    return false;
+  }
+  cpuMax = quota;
+  if (!period.empty()) {
+    if (!parseInt(period, value) || value <= 0) {
+      return false;
+    }
+    cpuMax += ' ';
+    cpuMax += period;
+  }
+  return true;
+}
+
+bool ProcessControl::cgroupOf(int pid, std::string &path) {
+  std::string contents;
+  if (pid <= 0 ||
+      !ProcReader::readFile(ProcPaths::process(pid) + CGROUP_FILE, contents)) {
+    return false;
+  }
+  size_t start = 0;
+  while (start < contents.size()) {
+    size_t end = contents.find('\n', start);
+    if (end == std::string::npos) {
+      end = contents.size();
+    }
+    std::string_view line(contents.data() + start, end - start);
+    if (line.rfind(CGROUP_V2_PREFIX, 0) == 0) {
+      path = line.substr(std::strlen(CGROUP_V2_PREFIX));
+      return !path.empty();
+    }
+    start = end + 1;
+  }
+  return false;
 }
@@ -0,0 +1,162 @@
+// src/process_events.cpp
+
+#include "../include/process_events.h"
+
+#include <ctime>
+#include <iomanip>
+
+namespace {
+const int TIME_WIDTH = 10;            // Width of the time column
+const int TYPE_WIDTH = 9;             // Width of the event column
+const int PID_WIDTH = 8;              // Width of the PID and PPID columns
+const size_t NAME_WIDTH = 40;         // Longest name, with an exec's old name
+const uint64_t MS_PER_SECOND = 1000;  // Timestamps are in milliseconds
+const int KTHREADD_PID = 2;           // Parent of every kernel thread
+
+/**
+ * @brief Builds an event of a process from its identity.
+ */
+ProcessEvent makeEvent(ProcessEventType type, const ProcessIdentity &identity,
+                       const ProcessMetadataCache &strings,
+                       uint64_t timestampMs) {
+  ProcessEvent event;
+  event.type = type;
+  event.pid = identity.pid;
+  event.ppid = identity.ppid;
+  event.startTime = identity.startTime;
+  event.timestampMs = timestampMs;
+  event.name = strings.getString(identity.nameId);
+  return event;
+}
+
+/**
+ * @brief Formats the local time of day of a timestamp, e.g. `14:03:59`.
+ */
+std::string timeOfDay(uint64_t timestampMs) {
+  std::time_t seconds = static_cast<std::time_t>(timestampMs / MS_PER_SECOND);
+  std::tm local{};
+  localtime_r(&seconds, &local);
+  char text[16];
+  std::strftime(text, sizeof(text), "%H:%M:%S", &local);
+  return text;
+}
+} // namespace
+
+void ProcessEvents::diff(const std::vector<ProcessIdentity> &previous,
+                         const std::vector<ProcessIdentity> &current,
+                         const ProcessMetadataCache &strings,
+                         uint64_t timestampMs,
+                         std::vector<ProcessEvent> &events) {
+  auto before = previous.begin();
+  auto after = current.begin();
+  while (before != previous.end() || after != current.end()) {
+    if (after == current.end() ||
+        (before != previous.end() && before->pid < after->pid)) {
+      events.push_back(makeEvent(ProcessEventType::Exited, *before, strings,
+                                 timestampMs));
+      ++before;
+    } else if (before == previous.end() || after->pid < before->pid) {
+      events.push_back(makeEvent(ProcessEventType::Started, *after, strings,
+                                 timestampMs));
+      ++after;
+    } else {
+      if (before->startTime != after->startTime) {
+        // The PID was reused: one process exited and another one started
+        events.push_back(makeEvent(ProcessEventType::Exited, *before, strings,
+                                   timestampMs));
+        events.push_back(makeEvent(ProcessEventType::Started, *after, strings,
+                                   timestampMs));
+      } else if (before->nameId != after->nameId &&
+                 after->ppid != KTHREADD_PID) {
+        // Kernel workers rename themselves with their work; only user
+        // processes change their name by calling exec
+        ProcessEvent event =
+            makeEvent(ProcessEventType::Exec, *after, strings, timestampMs);
+        event.previousName = strings.getString(before->nameId);
+        events.push_back(std::move(event));
+      }
+      ++before;
+      ++after;
+    }
+  }
+}
+
+const char *ProcessEvents::typeName(ProcessEventType type) {
+  switch (type) {
+  case ProcessEventType::Started:
+    return "started";
+  case ProcessEventType::Exited:
+    return "exited";
+  case ProcessEventType::Exec:
+    return "exec";
+  }
+  return "unknown";
+}
+
+std::string ProcessEvents::describe(const ProcessEvent &event) {
+  std::string text = "Process ";
+  text += std::to_string(event.pid);
+  text += ' ';
+  text += typeName(event.type);
+  text += ": ";
+  if (event.type == ProcessEventType::Exec) {
+    text += event.previousName;
+    text += " -> ";
+  }
+  text += event.name;
+  text += " (parent ";
+  text += std::to_string(event.ppid);
+  text += ')';
+  return text;
+}
+
+void ProcessEvents::printTable(std::ostream &out,
+                               const std::vector<ProcessEvent> &events,
+                               bool header) {
+  out << std::left;
+  if (header) {
+    out << std::setw(TIME_WIDTH) << "TIME" << std::setw(TYPE_WIDTH) << "EVENT"
+        << std::setw(PID_WIDTH) << "PID" << std::setw(PID_WIDTH) << "PPID"
+        << "NAME\n";
+  }
+  for (const ProcessEvent &event : events) {
+    std::string name = event.name;
+    if (event.type == ProcessEventType::Exec) {
+      name = event.previousName + " -> " + name;
+    }
+    if (name.size() > NAME_WIDTH) {
+      name = name.substr(0, NAME_WIDTH - 3) + "...";
+    }
+    out << std::setw(TIME_WIDTH) << timeOfDay(event.timestampMs)
+        << std::setw(TYPE_WIDTH) << typeName(event.type)
+        << std::setw(PID_WIDTH) << event.pid << std::setw(PID_WIDTH)
+        << event.ppid << name << '\n';
+  }
+  out << std::right;
+}
+
+void ProcessEvents::writeJson(OutputBuffer &out,
+                              const std::vector<ProcessEvent> &events) {
+  out.append('[');
+  for (size_t i = 0; i < events.size(); ++i) {
+    const ProcessEvent &event = events[i];
+    out.append(i == 0 ? "{\"type\":" : ",{\"type\":");
+    out.appendJsonString(typeName(event.type));
+    out.append(",\"timestamp_ms\":");
+    out.appendNumber(static_cast<unsigned long long>(event.timestampMs));
+    out.append(",\"pid\":");
+    out.appendNumber(static_cast<long long>(event.pid));
+    out.append(",\"ppid\":");
+    out.appendNumber(static_cast<long long>(event.ppid));
+    out.append(",\"start_time\":");
+    out.appendNumber(event.startTime);
+    out.append(",\"name\":");
+    out.appendJsonString(event.name);
+    if (event.type == ProcessEventType::Exec) {
+      out.append(",\"previous_name\":");
+      out.appendJsonString(event.previousName);
+    }
+    out.append('}');
+  }
+  out.append(']');
+}
@@ -0,0 +1,172 @@
+// src/process_export.cpp
+
+#include "../include/process_export.h"
+#include "../include/self_stats.h"
+
+#include <algorithm>
+#include <ctime>
+
+namespace {
+const int PERCENT_PRECISION = 2; // Digits after the point for percentages
+const int RATE_PRECISION = 1;    // Digits after the point for rates
+const unsigned long long BYTES_PER_KB = 1024; // Sizes are exported in bytes
+} // namespace
+
+bool ProcessExport::parseFormat(const std::string &name,
+                                ExportFormat &format) {
+  if (name == "table") {
+    format = ExportFormat::Table;
+  } else if (name == "json") {
+    format = ExportFormat::Json;
+  } else if (name == "csv") {
+    format = ExportFormat::Csv;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void ProcessExport::writeJson(OutputBuffer &out, const ProcessListing &listing,
+                              const std::vector<ProcessColumn> &columns,
+                              size_t count, bool events) {
+  SelfTimerScope timer(SelfTimer::Render);
+  const std::vector<ProcessInfo> &processes = listing.getProcesses();
+  count = std::min(count, processes.size());
+
+  out.append("{\"timestamp\":");
+  out.appendNumber(static_cast<long long>(std::time(nullptr)));
+  out.append(",\"processes\":[");
+  for (size_t row = 0; row < count; ++row) {
+    out.append(row == 0 ? "{" : ",{");
+    for (size_t i = 0; i < columns.size(); ++i) {
+      if (i > 0) {
+        out.append(',');
+      }
+      out.appendJsonString(ProcessColumns::spec(columns[i]).key);
+      out.append(':');
+      writeValue(out, listing, processes[row], columns[i], ExportFormat::Json);
+    }
+    out.append('}');
+  }
+  out.append(']');
+  if (events) {
+    out.append(",\"events\":");
+    ProcessEvents::writeJson(out, listing.getEvents());
+    out.append(",\"churn_per_s\":");
+    out.appendNumber(listing.getScanReport().churnPerSecond, RATE_PRECISION);
+  }
+  // The cost of producing this document, so it can be attributed
+  out.append(",\"self\":");
+  SelfStats::writeJson(out, SelfStats::snapshot());
+  out.append("}\n");
+}
+
+void ProcessExport::writeCsv(OutputBuffer &out, const ProcessListing &listing,
+                             const std::vector<ProcessColumn> &columns,
+                             size_t count) {
+  SelfTimerScope timer(SelfTimer::Render);
+  const std::vector<ProcessInfo> &processes = listing.getProcesses();
+  count = std::min(count, processes.size());
+
+  for (size_t i = 0; i < columns.size(); ++i) {
+    if (i > 0) {
+      out.append(',');
+    }
+    out.append(ProcessColumns::spec(columns[i]).key);
+  }
+  out.append('\n');
+
+  for (size_t row = 0; row < count; ++row) {
+    for (size_t i = 0; i < columns.size(); ++i) {
+      if (i > 0) {
+        out.append(',');
+      }
+      writeValue(out, listing, processes[row], columns[i], ExportFormat::Csv);
+    }
+    out.append('\n');
+  }
+}
+
+void ProcessExport::writeValue(OutputBuffer &out,
+                               const ProcessListing &listing,
+                               const ProcessInfo &process,
+                               ProcessColumn column, ExportFormat format) {
+  const ColumnSpec &spec = ProcessColumns::spec(column);
+  if ((process.collected & spec.sources) != spec.sources) {
+    if (format == ExportFormat::Json) {
+      out.append("null");
+    }
+    return;
+  }
+
+  auto writeString = [&](std::string_view text) {
+    if (format == ExportFormat::Json) {
+      out.appendJsonString(text);
+    } else {
+      out.appendCsvField(text);
+    }
+  };
+
+  switch (column) {
+  case ProcessColumn::Pid:
+    out.appendNumber(static_cast<long long>(process.pid));
+    break;
+  case ProcessColumn::Name:
+    writeString(listing.getString(process.nameId));
+    break;
+  case ProcessColumn::Cpu:
+    out.appendNumber(process.cpuUsage, PERCENT_PRECISION);
+    break;
+  case ProcessColumn::Memory:
+    out.appendNumber(process.memoryUsage, PERCENT_PRECISION);
+    break;
+  case ProcessColumn::Rss:
+    out.appendNumber(process.rssKb * BYTES_PER_KB);
+    break;
+  case ProcessColumn::Threads:
+    out.appendNumber(static_cast<long long>(process.threads));
+    break;
+  case ProcessColumn::MinorFaults:
+    out.appendNumber(process.minorFaultRate, RATE_PRECISION);
+    break;
+  case ProcessColumn::MajorFaults:
+    out.appendNumber(process.majorFaultRate, RATE_PRECISION);
+    break;
+  case ProcessColumn::VoluntaryCtxSwitches:
+    out.appendNumber(process.voluntaryCtxSwitches);
+    break;
+  case ProcessColumn::InvoluntaryCtxSwitches:
+    out.appendNumber(process.involuntaryCtxSwitches);
+    break;
+  case ProcessColumn::IoRead:
+    out.appendNumber(process.ioReadBytes);
+    break;
+  case ProcessColumn::IoWrite:
+    out.appendNumber(process.ioWriteBytes);
+    break;
+  case ProcessColumn::OpenFds:
+    out.appendNumber(static_cast<long long>(process.openFds));
+    break;
+  case ProcessColumn::Pss:
+    out.appendNumber(process.pssKb * BYTES_PER_KB);
+    break;
+  case ProcessColumn::Uss:
+    out.appendNumber(process.ussKb * BYTES_PER_KB);
+    break;
+  case ProcessColumn::User:
+    writeString(listing.getString(process.userId));
+    break;
+  case ProcessColumn::Cmdline:
+    writeString(listing.getString(process.cmdlineId));
+    break;
+  case ProcessColumn::NumaNode:
+    out.appendNumber(static_cast<long long>(process.numaNode));
+    break;
+  case ProcessColumn::NumaShare:
+    out.appendNumber(process.numaShare, PERCENT_PRECISION);
+    break;
+  case ProcessColumn::Tid:
+    out.appendNumber(static_cast<long long>(process.tid));
+    break;
+  }
+}
@@ -0,0 +1,429 @@
+// src/process_filter.cpp
+
+#include "../include/process_filter.h"
+
+#include <pwd.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <string_view>
+
+namespace {
+const char *OPERATOR_CHARACTERS = "()&|!=<>~\"'"; // End an unquoted word
+const char *TWO_CHARACTER_TOKENS[] = {"&&", "||", "==", "!=",
+                                      "<=", ">=", "!~"};
+const double BYTES_PER_KB = 1024.0; // Sizes are compared in bytes
+
+/**
+ * @struct Token
+ * @brief A word (a column or a value) or an operator of an expression.
+ */
+struct Token {
+  std::string text; ///< Without the quotes of a quoted word
+  bool word;        ///< False for operators and parentheses
+};
+
+/**
+ * @brief Returns whether a column is compared as text.
+ */
+bool isText(ProcessColumn column) {
+  return column == ProcessColumn::Name || column == ProcessColumn::Cmdline;
+}
+
+/**
+ * @brief Returns whether a column holds a size; sizes accept unit suffixes.
+ */
+bool isSize(ProcessColumn column) {
+  return column == ProcessColumn::Rss || column == ProcessColumn::Pss ||
+         column == ProcessColumn::Uss || column == ProcessColumn::IoRead ||
+         column == ProcessColumn::IoWrite;
+}
+
+/**
+ * @brief Parses a number; sizes accept `K`, `M`, `G` and `T` (optionally
+ * followed by `B`) and percentages a trailing `%`.
+ */
+bool parseNumber(const std::string &text, ProcessColumn column,
+                 double &value) {
+  char *end = nullptr;
+  value = std::strtod(text.c_str(), &end);
+  if (end == text.c_str()) {
+    return false;
+  }
+  std::string suffix(end);
+  for (char &c : suffix) {
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  }
+  if (suffix.empty()) {
+    return true;
+  }
+  bool percent = column == ProcessColumn::Cpu ||
+                 column == ProcessColumn::Memory ||
+                 column == ProcessColumn::NumaShare;
+  if (suffix == "%") {
+    return percent;
+  }
+  if (suffix.size() == 2 && suffix[1] == 'B') {
+    suffix.pop_back();
+  }
+  size_t power = std::string_view("KMGT").find(suffix);
+  if (!isSize(column) || suffix.size() != 1 ||
+      power == std::string_view::npos) {
+    return false;
+  }
+  for (size_t i = 0; i <= power; ++i) {
+    value *= BYTES_PER_KB;
+  }
+  return true;
+}
+} // namespace
+
+/**
+ * @brief Turns the tokens of an expression into `nodes_`.
+ *
+ * The grammar, loosest binding first:
+ *
+ *     or     := and ('||' and)*
+ *     and    := unary ('&&' unary)*
+ *     unary  := '!' unary | '(' or ')' | KEY OP VALUE
+ */
+struct ProcessFilter::Parser {
+  ProcessFilter &filter;     ///< Receives the nodes
+  std::vector<Token> tokens; ///< The expression, split
+  size_t position = 0;       ///< Next token to parse
+  std::string error;         ///< First problem found
+
+  /**
+   * @brief Splits an expression into tokens.
+   */
+  bool tokenize(const std::string &text) {
+    size_t i = 0;
+    while (i < text.size()) {
+      char c = text[i];
+      if (std::isspace(static_cast<unsigned char>(c))) {
+        ++i;
+      } else if (c == '"' || c == '\'') {
+        size_t close = text.find(c, i + 1);
+        if (close == std::string::npos) {
+          error = "Unterminated quote in filter";
+          return false;
+        }
+        tokens.push_back({text.substr(i + 1, close - i - 1), true});
+        i = close + 1;
+      } else if (std::string_view(OPERATOR_CHARACTERS).find(c) !=
+                 std::string_view::npos) {
+        std::string_view rest = std::string_view(text).substr(i);
+        size_t length = 1;
+        for (const char *token : TWO_CHARACTER_TOKENS) {
+          if (rest.substr(0, 2) == token) {
+            length = 2;
+          }
+        }
+        if (length == 1 && (c == '&' || c == '|')) {
+          error = std::string("Unexpected '") + c + "' in filter; use " +
+                  c + c;
+          return false;
+        }
+        tokens.push_back({text.substr(i, length), false});
+        i += length;
+      } else {
+        size_t start = i;
+        while (i < text.size() &&
+               !std::isspace(static_cast<unsigned char>(text[i])) &&
+               std::string_view(OPERATOR_CHARACTERS).find(text[i]) ==
+                   std::string_view::npos) {
+          ++i;
+        }
+        tokens.push_back({text.substr(start, i - start), true});
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Consumes the next token if it is the given operator.
+   */
+  bool accept(const char *op) {
+    if (position < tokens.size() && !tokens[position].word &&
+        tokens[position].text == op) {
+      ++position;
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Describes the next token for an error message.
+   */
+  std::string next() const {
+    return position < tokens.size() ? "'" + tokens[position].text + "'"
+                                    : "the end";
+  }
+
+  /**
+   * @brief Appends a node and returns its index.
+   */
+  uint32_t add(Node node) {
+    filter.nodes_.push_back(std::move(node));
+    return static_cast<uint32_t>(filter.nodes_.size() - 1);
+  }
+
+  /**
+   * @brief Parses operands joined by `&&` or `||` into a left-leaning tree.
+   */
+  template <typename Operand>
+  bool parseChain(const char *op, NodeType type, uint32_t &index,
+                  Operand operand) {
+    if (!operand(index)) {
+      return false;
+    }
+    while (accept(op)) {
+      uint32_t right = 0;
+      if (!operand(right)) {
+        return false;
+      }
+      Node node;
+      node.type = type;
+      node.left = index;
+      node.right = right;
+      index = add(std::move(node));
+    }
+    return true;
+  }
+
+  bool parseOr(uint32_t &index) {
+    return parseChain("||", NodeType::Or, index,
+                      [this](uint32_t &operand) { return parseAnd(operand); });
+  }
+
+  bool parseAnd(uint32_t &index) {
+    return parseChain("&&", NodeType::And, index, [this](uint32_t &operand) {
+      return parseUnary(operand);
+    });
+  }
+
+  bool parseUnary(uint32_t &index) {
+    if (accept("!")) {
+      Node node;
+      node.type = NodeType::Not;
+      if (!parseUnary(node.left)) {
+        return false;
+      }
+      index = add(std::move(node));
+      return true;
+    }
+    if (accept("(")) {
+      if (!parseOr(index)) {
+        return false;
+      }
+      if (!accept(")")) {
+        error = "Expected ')' in filter, found " + next();
+        return false;
+      }
+      return true;
+    }
+    return parseClause(index);
+  }
+
+  bool parseClause(uint32_t &index) {
+    if (position >= tokens.size() || !tokens[position].word) {
+      error = "Expected a column in filter, found " + next();
+      return false;
+    }
+    const std::string &key = tokens[position++].text;
+    Node node;
+    if (!ProcessColumns::find(key, node.column)) {
+      error = "Unknown column '" + key + "' in filter. Available columns: " +
+              ProcessColumns::availableKeys();
+      return false;
+    }
+
+    static const struct {
+      const char *text;
+      Operator op;
+    } OPERATORS[] = {{"==", Operator::Equal},       {"=", Operator::Equal},
+                     {"!=", Operator::NotEqual},    {"<", Operator::Less},
+                     {"<=", Operator::LessEqual},   {">", Operator::Greater},
+                     {">=", Operator::GreaterEqual}, {"~", Operator::Contains},
+                     {"!~", Operator::NotContains}};
+    bool found = false;
+    for (const auto &entry : OPERATORS) {
+      if (accept(entry.text)) {
+        node.op = entry.op;
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      error = "Expected a comparison after '" + key + "', found " + next();
+      return false;
+    }
+    if (position >= tokens.size() || !tokens[position].word) {
+      error = "Expected a value after '" + key + "', found " + next();
+      return false;
+    }
+    const std::string &value = tokens[position++].text;
+
+    bool equality =
+        node.op == Operator::Equal || node.op == Operator::NotEqual;
+    bool containment =
+        node.op == Operator::Contains || node.op == Operator::NotContains;
+    if (isText(node.column)) {
+      if (!equality && !containment) {
+        error = "'" + key + "' only takes ==, !=, ~ and !~";
+        return false;
+      }
+      node.text = value;
+      node.sources = ProcessColumns::spec(node.column).sources;
+    } else if (node.column == ProcessColumn::User) {
+      if (!equality) {
+        error = "'user' only takes == and !=";
+        return false;
+      }
+      // Names are resolved once here, so the scan compares UIDs only
+      char *end = nullptr;
+      unsigned long uid = std::strtoul(value.c_str(), &end, 10);
+      if (value.empty() || *end != '\0') {
+        const passwd *entry = getpwnam(value.c_str());
+        if (entry == nullptr) {
+          error = "Unknown user '" + value + "' in filter";
+          return false;
+        }
+        uid = entry->pw_uid;
+      }
+      node.number = static_cast<double>(uid);
+      // The owner of the directory is known without opening a file
+      node.sources = PROC_SOURCE_OWNER;
+    } else {
+      if (containment) {
+        error = "'" + key + "' is a number; '~' only applies to text";
+        return false;
+      }
+      if (!parseNumber(value, node.column, node.number)) {
+        error = "Invalid value '" + value + "' for '" + key + "' in filter";
+        return false;
+      }
+      // Sizes kept in kB are compared in kB
+      if (node.column == ProcessColumn::Rss ||
+          node.column == ProcessColumn::Pss ||
+          node.column == ProcessColumn::Uss) {
+        node.number /= BYTES_PER_KB;
+      }
+      node.sources = ProcessColumns::spec(node.column).sources;
+    }
+    filter.sources_ |= node.sources;
+    index = add(std::move(node));
+    return true;
+  }
+};
+
+bool ProcessFilter::compile(const std::string &text, std::string &error) {
+  nodes_.clear();
+  sources_ = PROC_SOURCE_NONE;
+  text_ = text;
+
+  Parser parser{*this, {}, 0, {}};
+  bool parsed = parser.tokenize(text);
+  if (parsed && parser.tokens.empty()) {
+    parser.error = "Empty filter";
+    parsed = false;
+  }
+  parsed = parsed && parser.parseOr(root_);
+  if (parsed && parser.position != parser.tokens.size()) {
+    parser.error = "Unexpected " + parser.next() + " in filter";
+    parsed = false;
+  }
+  if (!parsed) {
+    error = parser.error;
+    nodes_.clear();
+    sources_ = PROC_SOURCE_NONE;
+    return false;
+  }
+  return true;
+}
+
+FilterMatch ProcessFilter::evaluate(const ProcessInfo &process,
+                                    const ProcessMetadataCache &strings) const {
+  if (nodes_.empty()) {
+    return FilterMatch::True;
+  }
+  return evaluateNode(root_, process, strings);
+}
+
+FilterMatch
+ProcessFilter::evaluateNode(uint32_t index, const ProcessInfo &process,
+                            const ProcessMetadataCache &strings) const {
+  const Node &node = nodes_[index];
+  switch (node.type) {
+  case NodeType::And:
+  case NodeType::Or: {
+    // `False` decides an `And`, `True` an `Or`, whatever the other side is
+    FilterMatch decisive =
+        node.type == NodeType::And ? FilterMatch::False : FilterMatch::True;
+    FilterMatch left = evaluateNode(node.left, process, strings);
+    if (left == decisive) {
+      return decisive;
+    }
+    FilterMatch right = evaluateNode(node.right, process, strings);
+    if (right == decisive) {
+      return decisive;
+    }
+    return left == FilterMatch::Unknown || right == FilterMatch::Unknown
+               ? FilterMatch::Unknown
+               : left;
+  }
+  case NodeType::Not: {
+    FilterMatch operand = evaluateNode(node.left, process, strings);
+    if (operand == FilterMatch::Unknown) {
+      return operand;
+    }
+    return operand == FilterMatch::True ? FilterMatch::False
+                                        : FilterMatch::True;
+  }
+  case NodeType::Compare:
+    break;
+  }
+
+  if ((process.collected & node.sources) != node.sources) {
+    return FilterMatch::Unknown;
+  }
+  return compare(node, process, strings) ? FilterMatch::True
+                                         : FilterMatch::False;
+}
+
+bool ProcessFilter::compare(const Node &node, const ProcessInfo &process,
+                            const ProcessMetadataCache &strings) const {
+  if (isText(node.column)) {
+    std::string_view value = strings.getString(
+        node.column == ProcessColumn::Name ? process.nameId
+                                           : process.cmdlineId);
+    switch (node.op) {
+    case Operator::Equal:
+      return value == node.text;
+    case Operator::NotEqual:
+      return value != node.text;
+    case Operator::NotContains:
+      return value.find(node.text) == std::string_view::npos;
+    default:
+      return value.find(node.text) != std::string_view::npos;
+    }
+  }
+
+  double value = node.column == ProcessColumn::User
+                     ? static_cast<double>(process.uid)
+                     : ProcessListing::columnValue(process, node.column);
+  switch (node.op) {
+  case Operator::Equal:
+    return value == node.number;
+  case Operator::NotEqual:
+    return value != node.number;
+  case Operator::Less:
+    return value < node.number;
+  case Operator::LessEqual:
+    return value <= node.number;
+  case Operator::Greater:
+    return value > node.number;
+  default:
+    return value >= node.number;
+  }
+}
@@ -0,0 +1,559 @@
+// src/process_history.cpp
+
+#include "../include/process_history.h"
+#include "../include/display_format.h"
+
+#include <algorithm>
+#include <bit>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+namespace {
+const double ACTIVE_CPU_PERCENT = 0.5; // CPU usage that makes a process warm
+const double LOW_WATERMARK = 0.9;      // Share of the limit kept on eviction
+const size_t SERIES_OVERHEAD = 96;     // Map node and `Series` bookkeeping
+const uint8_t NO_WINDOW = 0xff;        // `leading` before the first XOR
+const unsigned MAX_LEADING_ZEROS = 31; // Leading zeros fit in 5 bits
+const size_t SPARKLINE_WIDTH = 38;     // Columns of the summary sparklines
+const int LABEL_WIDTH = 10;            // Width of the series names
+const int STAT_WIDTH = 8;              // Width of min, avg, max and last
+const double BYTES_PER_KB = 1024.0;    // RSS is sampled in kB
+
+/**
+ * @brief Appends the low `count` bits of `value` to a stream, MSB first.
+ */
+void writeBits(std::vector<uint8_t> &bits, size_t &bitCount, uint64_t value,
+               unsigned count) {
+  size_t needed = (bitCount + count + 7) / 8;
+  if (bits.size() < needed) {
+    bits.resize(needed);
+  }
+  while (count > 0) {
+    unsigned free = 8 - static_cast<unsigned>(bitCount % 8);
+    unsigned taken = std::min(free, count);
+    uint64_t chunk = (value >> (count - taken)) & ((1u << taken) - 1);
+    bits[bitCount / 8] |= static_cast<uint8_t>(chunk << (free - taken));
+    bitCount += taken;
+    count -= taken;
+  }
+}
+
+/**
+ * @brief Reads bits back from a stream written by `writeBits`.
+ */
+class BitReader {
+public:
+  explicit BitReader(const std::vector<uint8_t> &bits) : bits_(bits) {}
+
+  uint64_t read(unsigned count) {
+    uint64_t value = 0;
+    while (count > 0) {
+      unsigned left = 8 - static_cast<unsigned>(position_ % 8);
+      unsigned taken = std::min(left, count);
+      uint64_t chunk = (bits_[position_ / 8] >> (left - taken)) &
+                       ((1u << taken) - 1);
+      value = (value << taken) | chunk;
+      position_ += taken;
+      count -= taken;
+    }
+    return value;
+  }
+
+private:
+  const std::vector<uint8_t> &bits_; ///< The stream
+  size_t position_ = 0;              ///< Next bit to read
+};
+
+/**
+ * @struct DodBucket
+ * @brief A range of delta-of-delta values and its prefix code.
+ */
+struct DodBucket {
+  uint64_t prefix;       ///< Prefix bits
+  unsigned prefixLength; ///< Number of prefix bits
+  unsigned valueBits;    ///< Bits of the biased value
+  int64_t bias;          ///< Added so the value is not negative
+};
+
+// The common intervals are exact or jitter by a few milliseconds
+const DodBucket DOD_BUCKETS[] = {
+    {0b10, 2, 7, 63},
+    {0b110, 3, 9, 255},
+    {0b1110, 4, 12, 2047},
+};
+const uint64_t DOD_RAW_PREFIX = 0b1111; // Followed by 64 raw bits
+const unsigned DOD_RAW_PREFIX_LENGTH = 4;
+
+/**
+ * @brief Returns the 64 bits a value is stored as.
+ */
+void toWords(const HistorySample &sample, uint64_t *words) {
+  words[0] = std::bit_cast<uint64_t>(sample.cpuUsage);
+  words[1] = std::bit_cast<uint64_t>(sample.memoryUsage);
+  // Counters are XORed as integers, so small increments stay small
+  words[2] = sample.rssKb;
+  words[3] = sample.ioReadBytes;
+  words[4] = sample.ioWriteBytes;
+}
+
+/**
+ * @brief Fills a sample from the words `toWords` returned.
+ */
+void fromWords(const uint64_t *words, HistorySample &sample) {
+  sample.cpuUsage = std::bit_cast<double>(words[0]);
+  sample.memoryUsage = std::bit_cast<double>(words[1]);
+  sample.rssKb = words[2];
+  sample.ioReadBytes = words[3];
+  sample.ioWriteBytes = words[4];
+}
+
+/**
+ * @brief Formats a value of a summary line.
+ */
+using StatFormat = std::string (*)(double);
+
+std::string percent(double value) {
+  std::ostringstream text;
+  text << std::fixed << std::setprecision(1) << value;
+  return text.str();
+}
+
+std::string size(double value) {
+  return DisplayFormat::bytes(static_cast<unsigned long long>(value));
+}
+
+std::string rate(double value) { return size(value) + "/s"; }
+
+/**
+ * @brief Prints the sparkline and statistics of one series.
+ */
+void printSeries(std::ostream &out, const char *label,
+                 const std::vector<double> &values, StatFormat format) {
+  if (values.empty()) {
+    return;
+  }
+  auto [low, high] = std::minmax_element(values.begin(), values.end());
+  double mean = std::accumulate(values.begin(), values.end(), 0.0) /
+                static_cast<double>(values.size());
+  std::string line = DisplayFormat::sparkline(values, SPARKLINE_WIDTH);
+  // The bars are multibyte, so pad by the number of columns
+  line.append(SPARKLINE_WIDTH - std::min(values.size(), SPARKLINE_WIDTH), ' ');
+  out << std::left << std::setw(LABEL_WIDTH) << label << line << std::right
+      << std::setw(STAT_WIDTH) << format(*low) << std::setw(STAT_WIDTH)
+      << format(mean) << std::setw(STAT_WIDTH) << format(*high)
+      << std::setw(STAT_WIDTH) << format(values.back()) << '\n';
+}
+
+/**
+ * @brief Milliseconds since the Unix epoch.
+ */
+uint64_t unixMillis() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+}
+} // namespace
+
+ProcessHistory::ProcessHistory(size_t samplesPerProcess,
+                               size_t memoryLimitBytes)
+    : samplesPerProcess_(std::max<size_t>(samplesPerProcess, 1)),
+      memoryLimitBytes_(memoryLimitBytes) {}
+
+void ProcessHistory::record(const std::vector<ProcessInfo> &processes,
+                            uint64_t timestampMs) {
+  ++generation_;
+  for (const ProcessInfo &info : processes) {
+    Series &series = series_[info.pid];
+    if (series.count != 0 && series.startTime != info.startTime) {
+      // A new process reused the PID; its history starts empty
+      memoryBytes_ -= series.bytes;
+      series = Series{};
+    }
+    if (series.count == 0) {
+      series.startTime = info.startTime;
+      memoryBytes_ += SERIES_OVERHEAD;
+      series.bytes = SERIES_OVERHEAD;
+    }
+    HistorySample sample;
+    sample.timestampMs = timestampMs;
+    sample.cpuUsage = info.cpuUsage;
+    sample.memoryUsage = info.memoryUsage;
+    sample.rssKb = info.rssKb;
+    sample.ioReadBytes = info.ioReadBytes;
+    sample.ioWriteBytes = info.ioWriteBytes;
+
+    bool active = sample.cpuUsage >= ACTIVE_CPU_PERCENT;
+    if (!series.blocks.empty()) {
+      const Block &last = series.blocks.back();
+      active = active || last.values[3] != sample.ioReadBytes ||
+               last.values[4] != sample.ioWriteBytes;
+    }
+    if (active) {
+      series.lastActiveMs = timestampMs;
+    }
+    series.hasIo = series.hasIo || (info.collected & PROC_SOURCE_IO) != 0;
+    series.generation = generation_;
+    append(series, sample);
+  }
+
+  // Exited processes take their history with them
+  for (auto it = series_.begin(); it != series_.end();) {
+    if (it->second.generation != generation_) {
+      memoryBytes_ -= it->second.bytes;
+      it = series_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (memoryBytes_ > memoryLimitBytes_) {
+    evictCold();
+  }
+}
+
+bool ProcessHistory::samples(int pid,
+                             std::vector<HistorySample> &samples) const {
+  samples.clear();
+  auto it = series_.find(pid);
+  if (it == series_.end()) {
+    return false;
+  }
+  samples.reserve(it->second.count);
+  for (const Block &block : it->second.blocks) {
+    decode(block, samples);
+  }
+  // The oldest block may reach further back than the ring
+  if (samples.size() > samplesPerProcess_) {
+    samples.erase(samples.begin(),
+                  samples.end() - static_cast<ptrdiff_t>(samplesPerProcess_));
+  }
+  return true;
+}
+
+bool ProcessHistory::hasIo(int pid) const {
+  auto it = series_.find(pid);
+  return it != series_.end() && it->second.hasIo;
+}
+
+void ProcessHistory::printSummary(std::ostream &out, int pid,
+                                  const std::vector<HistorySample> &samples,
+                                  bool hasIo) {
+  if (samples.empty()) {
+    return;
+  }
+  double spanSeconds =
+      static_cast<double>(samples.back().timestampMs -
+                          samples.front().timestampMs) /
+      1000.0;
+  out << "PID " << pid << ": " << samples.size() << " samples over "
+      << std::fixed << std::setprecision(0) << spanSeconds << " s\n";
+  out << std::left << std::setw(LABEL_WIDTH) << ""
+      << std::setw(static_cast<int>(SPARKLINE_WIDTH)) << "oldest to newest"
+      << std::right << std::setw(STAT_WIDTH) << "min" << std::setw(STAT_WIDTH)
+      << "avg" << std::setw(STAT_WIDTH) << "max" << std::setw(STAT_WIDTH)
+      << "last" << '\n';
+
+  std::vector<double> cpu, memory, rss, reads, writes;
+  for (size_t i = 0; i < samples.size(); ++i) {
+    const HistorySample &sample = samples[i];
+    cpu.push_back(sample.cpuUsage);
+    memory.push_back(sample.memoryUsage);
+    rss.push_back(static_cast<double>(sample.rssKb) * BYTES_PER_KB);
+    if (i == 0) {
+      continue;
+    }
+    // Counters only go down across an exec that was not seen as a new PID
+    const HistorySample &previous = samples[i - 1];
+    double seconds =
+        static_cast<double>(sample.timestampMs - previous.timestampMs) /
+        1000.0;
+    if (seconds <= 0.0) {
+      continue;
+    }
+    auto delta = [seconds](uint64_t now, uint64_t before) {
+      return now >= before ? static_cast<double>(now - before) / seconds
+                           : 0.0;
+    };
+    reads.push_back(delta(sample.ioReadBytes, previous.ioReadBytes));
+    writes.push_back(delta(sample.ioWriteBytes, previous.ioWriteBytes));
+  }
+
+  printSeries(out, "CPU%", cpu, percent);
+  printSeries(out, "Memory%", memory, percent);
+  printSeries(out, "RSS", rss, size);
+  if (hasIo) {
+    printSeries(out, "IO read", reads, rate);
+    printSeries(out, "IO write", writes, rate);
+  }
+}
+
+void ProcessHistory::append(Series &series, const HistorySample &sample) {
+  if (series.blocks.empty() || series.blocks.back().count == BLOCK_SAMPLES) {
+    if (!series.blocks.empty()) {
+      // A full block never grows again
+      Block &full = series.blocks.back();
+      size_t before = blockBytes(full);
+      full.bits.shrink_to_fit();
+      series.bytes -= before - blockBytes(full);
+      memoryBytes_ -= before - blockBytes(full);
+    }
+    series.blocks.emplace_back();
+    series.bytes += sizeof(Block);
+    memoryBytes_ += sizeof(Block);
+  }
+
+  Block &block = series.blocks.back();
+  size_t before = block.bits.capacity();
+  encode(block, sample);
+  series.bytes += block.bits.capacity() - before;
+  memoryBytes_ += block.bits.capacity() - before;
+  ++series.count;
+
+  // Drop the oldest block once the newer ones hold a whole ring
+  const Block &oldest = series.blocks.front();
+  if (series.blocks.size() > 1 &&
+      series.count - oldest.count >= samplesPerProcess_) {
+    series.count -= oldest.count;
+    series.bytes -= blockBytes(oldest);
+    memoryBytes_ -= blockBytes(oldest);
+    series.blocks.pop_front();
+  }
+}
+
+void ProcessHistory::encode(Block &block, const HistorySample &sample) {
+  uint64_t words[VALUE_COUNT];
+  toWords(sample, words);
+
+  if (block.count == 0) {
+    writeBits(block.bits, block.bitCount, sample.timestampMs, 64);
+    for (size_t i = 0; i < VALUE_COUNT; ++i) {
+      writeBits(block.bits, block.bitCount, words[i], 64);
+      block.values[i] = words[i];
+      block.leading[i] = NO_WINDOW;
+    }
+    block.timestamp = sample.timestampMs;
+    block.delta = 0;
+    ++block.count;
+    return;
+  }
+
+  // Timestamps: the change of the delta, in the smallest bucket it fits
+  int64_t delta = static_cast<int64_t>(sample.timestampMs - block.timestamp);
+  int64_t dod = delta - block.delta;
+  if (dod == 0) {
+    writeBits(block.bits, block.bitCount, 0, 1);
+  } else {
+    bool written = false;
+    for (const DodBucket &bucket : DOD_BUCKETS) {
+      int64_t biased = dod + bucket.bias;
+      if (biased >= 0 && biased < (int64_t{1} << bucket.valueBits)) {
+        writeBits(block.bits, block.bitCount, bucket.prefix,
+                  bucket.prefixLength);
+        writeBits(block.bits, block.bitCount, static_cast<uint64_t>(biased),
+                  bucket.valueBits);
+        written = true;
+        break;
+      }
+    }
+    if (!written) {
+      writeBits(block.bits, block.bitCount, DOD_RAW_PREFIX,
+                DOD_RAW_PREFIX_LENGTH);
+      writeBits(block.bits, block.bitCount, static_cast<uint64_t>(dod), 64);
+    }
+  }
+  block.timestamp = sample.timestampMs;
+  block.delta = delta;
+
+  // Values: the XOR with the previous value, in the previous bit window if
+  // its meaningful bits fit there
+  for (size_t i = 0; i < VALUE_COUNT; ++i) {
+    uint64_t x = words[i] ^ block.values[i];
+    block.values[i] = words[i];
+    if (x == 0) {
+      writeBits(block.bits, block.bitCount, 0, 1);
+      continue;
+    }
+    unsigned leading =
+        std::min<unsigned>(std::countl_zero(x), MAX_LEADING_ZEROS);
+    unsigned trailing = std::countr_zero(x);
+    if (block.leading[i] != NO_WINDOW && leading >= block.leading[i] &&
+        trailing >= block.trailing[i]) {
+      unsigned length = 64 - block.leading[i] - block.trailing[i];
+      writeBits(block.bits, block.bitCount, 0b10, 2);
+      writeBits(block.bits, block.bitCount, x >> block.trailing[i], length);
+    } else {
+      unsigned length = 64 - leading - trailing;
+      writeBits(block.bits, block.bitCount, 0b11, 2);
+      writeBits(block.bits, block.bitCount, leading, 5);
+      writeBits(block.bits, block.bitCount, length - 1, 6);
+      writeBits(block.bits, block.bitCount, x >> trailing, length);
+      block.leading[i] = static_cast<uint8_t>(leading);
+      block.trailing[i] = static_cast<uint8_t>(trailing);
+    }
+  }
+  ++block.count;
+}
+
+void ProcessHistory::decode(const Block &block,
+                            std::vector<HistorySample> &samples) {
+  if (block.count == 0) {
+    return;
+  }
+  BitReader reader(block.bits);
+  uint64_t timestamp = reader.read(64);
+  int64_t delta = 0;
+  uint64_t words[VALUE_COUNT];
+  unsigned leading[VALUE_COUNT] = {};
+  unsigned trailing[VALUE_COUNT] = {};
+  for (size_t i = 0; i < VALUE_COUNT; ++i) {
+    words[i] = reader.read(64);
+  }
+  HistorySample sample;
+  sample.timestampMs = timestamp;
+  fromWords(words, sample);
+  samples.push_back(sample);
+
+  for (uint32_t n = 1; n < block.count; ++n) {
+    int64_t dod = 0;
+    if (reader.read(1) != 0) {
+      // Count the 1s of the prefix to find the bucket
+      size_t bucket = 0;
+      while (bucket < std::size(DOD_BUCKETS) && reader.read(1) != 0) {
+        ++bucket;
+      }
+      if (bucket < std::size(DOD_BUCKETS)) {
+        const DodBucket &range = DOD_BUCKETS[bucket];
+        dod = static_cast<int64_t>(reader.read(range.valueBits)) - range.bias;
+      } else {
+        dod = static_cast<int64_t>(reader.read(64));
+      }
+    }
+    delta += dod;
+    timestamp += static_cast<uint64_t>(delta);
+
+    for (size_t i = 0; i < VALUE_COUNT; ++i) {
+      if (reader.read(1) == 0) {
+        continue;
+      }
+      if (reader.read(1) != 0) {
+        leading[i] = static_cast<unsigned>(reader.read(5));
+        unsigned length = static_cast<unsigned>(reader.read(6)) + 1;
+        trailing[i] = 64 - leading[i] - length;
+      }
+      unsigned length = 64 - leading[i] - trailing[i];
+      words[i] ^= reader.read(length) << trailing[i];
+    }
+    sample.timestampMs = timestamp;
+    fromWords(words, sample);
+    samples.push_back(sample);
+  }
+}
+
+size_t ProcessHistory::blockBytes(const Block &block) {
+  return sizeof(Block) + block.bits.capacity();
+}
+
+void ProcessHistory::evictCold() {
+  std::vector<std::pair<uint64_t, int>> byActivity;
+  byActivity.reserve(series_.size());
+  for (const auto &[pid, series] : series_) {
+    byActivity.emplace_back(series.lastActiveMs, pid);
+  }
+  std::sort(byActivity.begin(), byActivity.end());
+
+  auto target = static_cast<size_t>(memoryLimitBytes_ * LOW_WATERMARK);
+  for (const auto &[lastActiveMs, pid] : byActivity) {
+    if (memoryBytes_ <= target) {
+      break;
+    }
+    auto it = series_.find(pid);
+    memoryBytes_ -= it->second.bytes;
+    series_.erase(it);
+    ++evicted_;
+  }
+}
+
+HistoryRecorder::HistoryRecorder(std::chrono::milliseconds interval,
+                                 size_t samplesPerProcess,
+                                 size_t memoryLimitBytes)
+    : interval_(interval), history_(samplesPerProcess, memoryLimitBytes) {
+  options_.columns = {ProcessColumn::Pid,    ProcessColumn::Cpu,
+                      ProcessColumn::Memory, ProcessColumn::Rss,
+                      ProcessColumn::IoRead, ProcessColumn::IoWrite};
+  options_.events = true;
+}
+
+HistoryRecorder::~HistoryRecorder() { stop(); }
+
+void HistoryRecorder::start() {
+  if (sampler_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(stopMutex_);
+    stopping_ = false;
+  }
+  sampler_ = std::thread(&HistoryRecorder::sampleLoop, this);
+}
+
+void HistoryRecorder::stop() {
+  {
+    std::lock_guard<std::mutex> lock(stopMutex_);
+    stopping_ = true;
+  }
+  stopCondition_.notify_all();
+  if (sampler_.joinable()) {
+    sampler_.join();
+  }
+}
+
+bool HistoryRecorder::samples(int pid, std::vector<HistorySample> &samples,
+                              bool &hasIo) const {
+  std::lock_guard<std::mutex> lock(historyMutex_);
+  hasIo = history_.hasIo(pid);
+  return history_.samples(pid, samples);
+}
+
+void HistoryRecorder::usage(size_t &processes, size_t &bytes) const {
+  std::lock_guard<std::mutex> lock(historyMutex_);
+  processes = history_.processCount();
+  bytes = history_.memoryBytes();
+}
+
+void HistoryRecorder::recentEvents(std::vector<ProcessEvent> &events,
+                                   double &churnPerSecond) const {
+  std::lock_guard<std::mutex> lock(historyMutex_);
+  events.assign(events_.begin(), events_.end());
+  churnPerSecond = churnPerSecond_;
+}
+
+void HistoryRecorder::sample() {
+  listing_.refresh(options_);
+  // The first scan has no previous sample, so its CPU usage is a lifetime
+  // average; it only primes the listing
+  if (!primed_) {
+    primed_ = true;
+    return;
+  }
+  uint64_t timestampMs = unixMillis();
+  std::lock_guard<std::mutex> lock(historyMutex_);
+  history_.record(listing_.getProcesses(), timestampMs);
+  const std::vector<ProcessEvent> &events = listing_.getEvents();
+  events_.insert(events_.end(), events.begin(), events.end());
+  while (events_.size() > RECENT_EVENTS) {
+    events_.pop_front();
+  }
+  churnPerSecond_ = listing_.getScanReport().churnPerSecond;
+}
+
+void HistoryRecorder::sampleLoop() {
+  sample();
+  std::unique_lock<std::mutex> lock(stopMutex_);
+  while (!stopCondition_.wait_for(lock, interval_,
+                                  [this] { return stopping_; })) {
+    lock.unlock();
+    sample();
+    lock.lock();
+  }
+}
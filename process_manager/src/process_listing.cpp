@@ -1,98 +1,573 @@
 // src/process_listing.cpp
 
 #include "../include/process_listing.h"
+#include "../include/display_format.h"
 #include "../include/logger.h"
+#include "../include/process_filter.h"
+#include "../include/proc_paths.h"
+#include "../include/proc_reader.h"
+#include "../include/self_stats.h"
+#include "../include/worker_placement.h"
 
 #include <algorithm>
-#include <filesystem>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <dirent.h>
 #include <fstream>
 #include <future>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <sys/resource.h>
+#include <sys/stat.h>
 #include <thread>
 #include <unistd.h>
 #include <vector>
 
-namespace fs = std::filesystem;
-
 namespace {
 // Constants for better readability
 const size_t BATCH_SIZE = 15;      // Number of PIDs to process per thread
 const size_t MAX_NAME_LENGTH = 30; // Max length for process name display
-const double HIGH_USAGE_THRESHOLD =
-    50.0; // Threshold for high usage (CPU/Memory)
-const double MODERATE_USAGE_THRESHOLD =
-    20.0; // Threshold for moderate usage (CPU/Memory)
-const size_t PROCESS_STAT_FIELDS_TO_SKIP =
-    13; // Number of fields to skip in /proc/<pid>/stat
-const std::string PROC_STAT_PATH = "/proc/stat"; // Path to CPU stats
-const std::string PROC_COMM_PATH_PREFIX =
-    "/proc/"; // Prefix for process comm files
+
+const size_t MIN_TABLE_WIDTH = 40;   // Minimum width of the separator line
+const size_t LAST_COLUMN_WIDTH = 12; // Width reserved for the last column
+
+const char *PROC_STAT_FILE = "stat";       // CPU stats, below procfs
+const char *PROC_MEMINFO_FILE = "meminfo"; // Memory info, below procfs
+const char *PROC_UPTIME_FILE = "uptime";   // Uptime, below procfs
+const int SMAPS_MAX_AGE_SECONDS =
+    5; // Age after which a smaps_rollup reading is refreshed
+
+const size_t PATH_RESERVE = 64;       // Bytes reserved for a procfs path
+const size_t CONTENTS_RESERVE = 4096; // Bytes reserved for a procfs file
+const size_t PID_RESERVE_SLACK = 64;  // PIDs reserved beyond the last scan
+const char *TASK_DIRECTORY = "task";  // Threads of a process, below its PID
+const size_t MAX_LOGGED_EVENTS = 20;  // Events logged per scan, then a count
+
+/// Files the io_uring backend reads ahead, by index in `Prefetch::requests`
+enum PrefetchFile : size_t {
+  PREFETCH_STAT,
+  PREFETCH_STATM,
+  PREFETCH_STATUS,
+  PREFETCH_IO,
+};
+const char *PREFETCH_NAMES[] = {"stat", "statm", "status", "io"};
+const unsigned PREFETCH_SOURCES[] = {PROC_SOURCE_STAT, PROC_SOURCE_STATM,
+                                     PROC_SOURCE_STATUS, PROC_SOURCE_IO};
+
+std::atomic<ScanBackend> scanBackend{ScanBackend::Sync}; // Of every listing
+std::atomic<bool> uringWarningShown{false}; // Unavailability reported once
+
+/**
+ * @brief Returns the CPU time used by the calling thread, in ms.
+ */
+double threadCpuMs() {
+  rusage usage{};
+  getrusage(RUSAGE_THREAD, &usage);
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+}
+
+/**
+ * @brief Writes the directory of a process, or of one of its threads.
+ */
+void targetDirectory(int pid, int tid, std::pmr::string &path) {
+  if (tid != 0) {
+    ProcPaths::task(pid, tid, path);
+  } else {
+    ProcPaths::process(pid, path);
+  }
+}
+
+/**
+ * @brief Reads a procfs file and parses it, timing the two separately.
+ */
+template <typename Path, typename Buffer, typename Parser>
+bool readParsed(const Path &path, Buffer &contents, Parser parse) {
+  if (!ProcReader::readFile(path, contents)) {
+    return false;
+  }
+  SelfTimerScope timer(SelfTimer::Parse);
+  return parse(contents);
+}
+
+/**
+ * @brief Returns the wall-clock time in milliseconds since the epoch.
+ */
+uint64_t unixMillis() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+}
 } // Anonymous namespace
 
 ProcessListing::ProcessListing() {
   // Constructor if needed
 }
 
-#include <iomanip>
-#include <iostream>
+void ProcessListing::setScanBackend(ScanBackend backend) {
+  scanBackend.store(backend, std::memory_order_relaxed);
+}
 
-void ProcessListing::listProcesses() {
+ScanBackend ProcessListing::getScanBackend() {
+  return scanBackend.load(std::memory_order_relaxed);
+}
+
+ProcessListing::ScanBuffers::ScanBuffers(std::pmr::memory_resource *arena)
+    : path(arena), contents(arena) {
+  path.reserve(PATH_RESERVE);
+  contents.reserve(CONTENTS_RESERVE);
+}
+
+void ProcessListing::listProcesses(const ListOptions &options) {
   Logger logger;
   logger.logAction("Listing processes");
 
-  fetchProcessList();
+  refresh(options);
+  printTable(std::cout, options.columns);
+}
+
+void ProcessListing::refresh(const ListOptions &options) {
+  auto startedAt = std::chrono::steady_clock::now();
+  // Only the threads of the scan count, not e.g. a background recorder
+  double cpuBefore = threadCpuMs();
+  unsigned long long hitsBefore = 0;
+  unsigned long long missesBefore = 0;
+  metadata_.getCounters(hitsBefore, missesBefore);
 
+  unsigned sources = ProcessColumns::requiredSources(options.columns) |
+                     options.extraSources;
+  // The filter reads the owner itself; user names are only for display
+  if (options.filter) {
+    sources |= options.filter->requiredSources() & ~PROC_SOURCE_OWNER;
+  }
+  // Identities come from stat; a thread listing has no events
+  if (options.events && !options.threads) {
+    sources |= PROC_SOURCE_STAT;
+  }
+  filtered_ = 0;
+  fetchProcessList(options, sources);
+  // The memory maps are shared by the threads, so only processes read them
+  if ((sources & PROC_SOURCE_SMAPS) != 0 && !options.threads) {
+    fetchSmaps(options.smapsTopN);
+  }
+  if ((sources & PROC_SOURCE_NUMA) != 0 && !options.threads) {
+    fetchNumaMaps(options.numaTopN);
+  }
+  if (options.filter) {
+    // Rows still undecided, e.g. on PSS or an unreadable file, do not match
+    auto kept = std::remove_if(
+        processes_.begin(), processes_.end(), [&](const ProcessInfo &process) {
+          return options.filter->evaluate(process, metadata_) !=
+                 FilterMatch::True;
+        });
+    filtered_ += static_cast<size_t>(processes_.end() - kept);
+    processes_.erase(kept, processes_.end());
+  }
+
+  scanReport_.processes = processes_.size();
+  scanReport_.filtered = filtered_;
+  scanReport_.cpuTimeMs =
+      threadCpuMs() - cpuBefore + scanReport_.workerTimeMs;
+  scanReport_.wallTimeMs = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - startedAt)
+                               .count();
+  metadata_.getCounters(scanReport_.metadataHits, scanReport_.metadataMisses);
+  scanReport_.metadataHits -= hitsBefore;
+  scanReport_.metadataMisses -= missesBefore;
+  SelfStats::add(SelfCounter::Scans);
+  SelfStats::add(SelfCounter::ProcessesScanned, processes_.size());
+}
+
+double ProcessListing::columnValue(const ProcessInfo &process,
+                                   ProcessColumn column) {
+  switch (column) {
+  case ProcessColumn::Cpu:
+    return process.cpuUsage;
+  case ProcessColumn::Memory:
+    return process.memoryUsage;
+  case ProcessColumn::Rss:
+    return static_cast<double>(process.rssKb);
+  case ProcessColumn::Threads:
+    return static_cast<double>(process.threads);
+  case ProcessColumn::MinorFaults:
+    return process.minorFaultRate;
+  case ProcessColumn::MajorFaults:
+    return process.majorFaultRate;
+  case ProcessColumn::VoluntaryCtxSwitches:
+    return static_cast<double>(process.voluntaryCtxSwitches);
+  case ProcessColumn::InvoluntaryCtxSwitches:
+    return static_cast<double>(process.involuntaryCtxSwitches);
+  case ProcessColumn::IoRead:
+    return static_cast<double>(process.ioReadBytes);
+  case ProcessColumn::IoWrite:
+    return static_cast<double>(process.ioWriteBytes);
+  case ProcessColumn::OpenFds:
+    return static_cast<double>(process.openFds);
+  case ProcessColumn::Pss:
+    return static_cast<double>(process.pssKb);
+  case ProcessColumn::Uss:
+    return static_cast<double>(process.ussKb);
+  case ProcessColumn::NumaNode:
+    return static_cast<double>(process.numaNode);
+  case ProcessColumn::NumaShare:
+    return process.numaShare;
+  case ProcessColumn::Tid:
+    return static_cast<double>(process.tid);
+  default:
+    return static_cast<double>(process.pid);
+  }
+}
+
+void ProcessListing::sortProcesses(ProcessColumn column, bool descending) {
+  // Text columns compare the interned strings
+  uint32_t ProcessInfo::*textId = nullptr;
+  if (column == ProcessColumn::Name) {
+    textId = &ProcessInfo::nameId;
+  } else if (column == ProcessColumn::User) {
+    textId = &ProcessInfo::userId;
+  } else if (column == ProcessColumn::Cmdline) {
+    textId = &ProcessInfo::cmdlineId;
+  }
+
+  // Ties are broken by PID and TID so the order is stable between refreshes
+  std::sort(processes_.begin(), processes_.end(),
+            [&](const ProcessInfo &a, const ProcessInfo &b) {
+              int order = 0;
+              if (textId != nullptr) {
+                order = metadata_.getString(a.*textId)
+                            .compare(metadata_.getString(b.*textId));
+              } else {
+                double left = columnValue(a, column);
+                double right = columnValue(b, column);
+                order = left < right ? -1 : (left > right ? 1 : 0);
+              }
+              if (order == 0) {
+                return a.pid != b.pid ? a.pid < b.pid : a.tid < b.tid;
+              }
+              return descending ? order > 0 : order < 0;
+            });
+}
+
+void ProcessListing::printTable(std::ostream &out,
+                                const std::vector<ProcessColumn> &columns,
+                                size_t first, size_t count) const {
+  SelfTimerScope timer(SelfTimer::Render);
   // Print header with proper spacing
-  std::cout << std::left << std::setw(8) << "PID" << std::setw(10) << "CPU%"
-            << std::setw(10) << "Memory%" << "Name\n";
-  std::cout << std::string(40, '-') << '\n'; // Separator line
+  size_t tableWidth = 0;
+  for (size_t i = 0; i < columns.size(); ++i) {
+    const ColumnSpec &spec = ProcessColumns::spec(columns[i]);
+    bool last = i + 1 == columns.size();
+    size_t width = last ? LAST_COLUMN_WIDTH : spec.width;
+    tableWidth += width;
+    out << std::left << std::setw(last ? 0 : static_cast<int>(width))
+        << spec.header;
+  }
+  out << '\n';
+  out << std::string(std::max(tableWidth, MIN_TABLE_WIDTH), '-')
+      << '\n'; // Separator line
 
   // Print each process with formatted columns
-  for (const auto &process : processes_) {
-    // Print PID (uncolored)
-    std::cout << std::left << std::setw(8) << process.pid;
-
-    // Print CPU% with colors
-    if (process.cpuUsage > HIGH_USAGE_THRESHOLD) {
-      std::cout << "\033[31m"; // Red for high usage
-    } else if (process.cpuUsage > MODERATE_USAGE_THRESHOLD) {
-      std::cout << "\033[33m"; // Yellow for moderate usage
+  first = std::min(first, processes_.size());
+  size_t end = first + std::min(count, processes_.size() - first);
+  for (size_t row = first; row < end; ++row) {
+    const ProcessInfo &process = processes_[row];
+    for (size_t i = 0; i < columns.size(); ++i) {
+      const ColumnSpec &spec = ProcessColumns::spec(columns[i]);
+      bool last = i + 1 == columns.size();
+      int width = last ? 0 : spec.width;
+
+      // Columns whose source could not be read (e.g. permissions) show "-"
+      if ((process.collected & spec.sources) != spec.sources) {
+        out << std::setw(width) << "-";
+        continue;
+      }
+
+      switch (spec.column) {
+      case ProcessColumn::Pid:
+        out << std::setw(width) << process.pid;
+        break;
+      case ProcessColumn::Name:
+        out << std::setw(width)
+            << metadata_.getString(process.nameId).substr(0, MAX_NAME_LENGTH);
+        break;
+      case ProcessColumn::Cpu:
+        out << DisplayFormat::usageColor(process.cpuUsage)
+            << std::setw(width) << std::fixed << std::setprecision(2)
+            << process.cpuUsage << DisplayFormat::resetColor();
+        break;
+      case ProcessColumn::Memory:
+        out << DisplayFormat::usageColor(process.memoryUsage)
+            << std::setw(width) << std::fixed << std::setprecision(2)
+            << process.memoryUsage << DisplayFormat::resetColor();
+        break;
+      case ProcessColumn::Rss:
+        out << std::setw(width)
+            << DisplayFormat::bytes(process.rssKb * 1024);
+        break;
+      case ProcessColumn::Threads:
+        out << std::setw(width) << process.threads;
+        break;
+      case ProcessColumn::MinorFaults:
+        out << std::setw(width) << std::fixed << std::setprecision(1)
+            << process.minorFaultRate;
+        break;
+      case ProcessColumn::MajorFaults:
+        out << std::setw(width) << std::fixed << std::setprecision(1)
+            << process.majorFaultRate;
+        break;
+      case ProcessColumn::VoluntaryCtxSwitches:
+        out << std::setw(width) << process.voluntaryCtxSwitches;
+        break;
+      case ProcessColumn::InvoluntaryCtxSwitches:
+        out << std::setw(width) << process.involuntaryCtxSwitches;
+        break;
+      case ProcessColumn::IoRead:
+        out << std::setw(width)
+            << DisplayFormat::bytes(process.ioReadBytes);
+        break;
+      case ProcessColumn::IoWrite:
+        out << std::setw(width)
+            << DisplayFormat::bytes(process.ioWriteBytes);
+        break;
+      case ProcessColumn::OpenFds:
+        out << std::setw(width) << process.openFds;
+        break;
+      case ProcessColumn::Pss:
+        out << std::setw(width)
+            << DisplayFormat::bytes(process.pssKb * 1024);
+        break;
+      case ProcessColumn::Uss:
+        out << std::setw(width)
+            << DisplayFormat::bytes(process.ussKb * 1024);
+        break;
+      case ProcessColumn::User:
+        out << std::setw(width)
+            << metadata_.getString(process.userId)
+                   .substr(0, static_cast<size_t>(spec.width) - 1);
+        break;
+      case ProcessColumn::Cmdline: {
+        std::string_view cmdline = metadata_.getString(process.cmdlineId);
+        if (cmdline.empty()) {
+          // Kernel threads have no command line; show the name like ps does
+          std::string name(metadata_.getString(process.nameId));
+          out << std::setw(width) << "[" + name + "]";
+        } else {
+          out << std::setw(width) << cmdline;
+        }
+        break;
+      }
+      case ProcessColumn::NumaNode:
+        out << std::setw(width) << process.numaNode;
+        break;
+      case ProcessColumn::NumaShare:
+        out << std::setw(width) << std::fixed << std::setprecision(1)
+            << process.numaShare;
+        break;
+      case ProcessColumn::Tid:
+        out << std::setw(width) << process.tid;
+        break;
+      }
+    }
+    out << '\n';
+  }
+
+  if ((ProcessColumns::requiredSources(columns) & PROC_SOURCE_SMAPS) != 0) {
+    out << "smaps_rollup: " << smapsReport_.read << " read, "
+        << smapsReport_.cached << " cached of the top "
+        << smapsReport_.candidates << " processes by RSS, "
+        << std::fixed << std::setprecision(2)
+        << smapsReport_.kernelTimeMs << " ms kernel time\n";
+  }
+  if ((ProcessColumns::requiredSources(columns) & PROC_SOURCE_NUMA) != 0) {
+    out << "numa_maps: " << numaReport_.read << " read, "
+        << numaReport_.cached << " cached of the top "
+        << numaReport_.candidates << " processes by RSS, " << std::fixed
+        << std::setprecision(2) << numaReport_.kernelTimeMs
+        << " ms kernel time\n";
+  }
+}
+
+ProcessListing::ScanContext ProcessListing::buildScanContext(unsigned sources) {
+  ScanContext context;
+  context.sources = sources;
+
+  std::string contents;
+  if ((sources & PROC_SOURCE_STAT) != 0) {
+    // Needed for CPU usage and for the rates of stat counters
+    readParsed(ProcPaths::proc(PROC_STAT_FILE), contents,
+               [&context](std::string_view text) {
+                 return ProcParsers::parseCpuTotal(text, context.systemTime);
+               });
+    readParsed(ProcPaths::proc(PROC_UPTIME_FILE), contents,
+               [&context](std::string_view text) {
+                 return ProcParsers::parseUptime(text, context.uptime);
+               });
+  }
+  if ((sources & PROC_SOURCE_STATM) != 0 && totalMemoryKb_ == 0) {
+    readParsed(ProcPaths::proc(PROC_MEMINFO_FILE), contents,
+               [this](std::string_view text) {
+                 return ProcParsers::parseMemTotal(text, totalMemoryKb_);
+               });
+  }
+  context.totalMemoryKb = totalMemoryKb_;
+  return context;
+}
+
+void ProcessListing::fetchProcessList(const ListOptions &options,
+                                      unsigned sources) {
+  processes_.clear();
+  // Rows of the previous scan are gone, so their string ids may be remapped;
+  // the entries of the last scan's identities are kept, with their new ids
+  if (metadata_.prune(generation_)) {
+    for (ProcessIdentity &identity : previousIdentities_) {
+      identity.nameId = metadata_.nameId(identity.pid, identity.startTime);
+    }
+  }
+  identities_.clear();
+  // Everything the previous scan allocated from the arena is released here
+  arena_.reset();
+  // The main thread's TID is the PID, so process and thread samples differ
+  if (options.threads != threadRows_) {
+    samples_.clear();
+    previousPids_.clear();
+    threadRows_ = options.threads;
+  }
+  ScanContext context = buildScanContext(sources);
+  context.filter = options.filter.get();
+  context.events = options.events && !options.threads;
+
+  std::pmr::vector<int> pids(&arena_);
+  std::pmr::vector<ScanTarget> targets(&arena_);
+  {
+    SelfTimerScope timer(SelfTimer::Enumerate);
+    if (options.pid > 0) {
+      pids.push_back(options.pid);
+    } else {
+      pids.reserve(previousPids_.size() + PID_RESERVE_SLACK);
+      getAllPIDs(pids);
+    }
+    if (options.threads) {
+      targets.reserve(previousPids_.size() + PID_RESERVE_SLACK);
+      listThreads(pids, targets);
     } else {
-      std::cout << "\033[32m"; // Green for low usage
+      targets.reserve(pids.size());
+      for (int pid : pids) {
+        targets.push_back({pid, 0});
+      }
     }
-    std::cout << std::setw(10) << std::fixed << std::setprecision(2)
-              << process.cpuUsage << "\033[0m"; // Reset color
+  }
+  scanReport_.workerTimeMs = 0;
+  if (getScanBackend() != ScanBackend::IoUring ||
+      !fetchWithUring(targets, context)) {
+    size_t numBatches =
+        (targets.size() + BATCH_SIZE - 1) / BATCH_SIZE; // Calculate batches
+    std::pmr::vector<std::future<void>> futures(&arena_);
+    futures.reserve(numBatches);
+    std::pmr::vector<double> workerMs(numBatches, 0.0, &arena_);
 
-    // Print Memory% with colors
-    if (process.memoryUsage > HIGH_USAGE_THRESHOLD) {
-      std::cout << "\033[31m"; // Red for high usage
-    } else if (process.memoryUsage > MODERATE_USAGE_THRESHOLD) {
-      std::cout << "\033[33m"; // Yellow for moderate usage
+    for (size_t i = 0; i < numBatches; ++i) {
+      futures.push_back(std::async(std::launch::async, [&, i]() {
+        double cpuBefore = threadCpuMs();
+        WorkerPlacement::applyToCurrentThread();
+        ScanBuffers buffers(&arena_);
+        size_t start = i * BATCH_SIZE;
+        size_t end = std::min(start + BATCH_SIZE, targets.size());
+        for (size_t j = start; j < end; ++j) {
+          fetchProcessInfo(targets[j], context, buffers);
+        }
+        workerMs[i] = threadCpuMs() - cpuBefore;
+      }));
+    }
+
+    for (auto &fut : futures) {
+      fut.get();
+    }
+    for (double ms : workerMs) {
+      scanReport_.workerTimeMs += ms;
+    }
+  }
+  SelfTimerScope timer(SelfTimer::Compute);
+
+  // Threads are counted by TID, which is unique across processes
+  std::pmr::vector<int> tids(&arena_);
+  if (options.threads) {
+    tids.reserve(targets.size());
+    for (const ScanTarget &target : targets) {
+      tids.push_back(target.tid);
+    }
+    std::sort(tids.begin(), tids.end());
+  }
+  const std::pmr::vector<int> &ids = options.threads ? tids : pids;
+
+  // Merge the sorted ID lists to count the rows that came and went
+  scanReport_.added = 0;
+  scanReport_.removed = 0;
+  auto previous = previousPids_.begin();
+  auto current = ids.begin();
+  while (previous != previousPids_.end() || current != ids.end()) {
+    if (current == ids.end() ||
+        (previous != previousPids_.end() && *previous < *current)) {
+      ++scanReport_.removed;
+      ++previous;
+    } else if (previous == previousPids_.end() || *current < *previous) {
+      ++scanReport_.added;
+      ++current;
     } else {
-      std::cout << "\033[32m"; // Green for low usage
+      ++previous;
+      ++current;
     }
-    std::cout << std::setw(10) << std::fixed << std::setprecision(2)
-              << process.memoryUsage << "\033[0m"; // Reset color
+  }
+  previousPids_.assign(ids.begin(), ids.end());
 
-    // Print Name (uncolored)
-    std::cout << process.name.substr(0, MAX_NAME_LENGTH)
-              << '\n'; // Limit name to 30 chars
+  if (context.events) {
+    diffIdentities(context);
+  } else {
+    previousIdentities_.clear();
+    identitiesPrimed_ = false;
+    events_.clear();
+    scanReport_.started = 0;
+    scanReport_.exited = 0;
+    scanReport_.execs = 0;
+    scanReport_.churnPerSecond = 0;
   }
+
+  // Forget the samples of processes that were not seen in this scan
+  ++generation_;
+  for (auto it = samples_.begin(); it != samples_.end();) {
+    if (it->second.generation != generation_) {
+      it = samples_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  std::sort(processes_.begin(), processes_.end(),
+            [](const ProcessInfo &a, const ProcessInfo &b) {
+              return a.pid != b.pid ? a.pid < b.pid : a.tid < b.tid;
+            });
 }
 
-void ProcessListing::fetchProcessList() {
-  std::vector<int> pids = getAllPIDs();
-  size_t numBatches =
-      (pids.size() + BATCH_SIZE - 1) / BATCH_SIZE; // Calculate batches
-  std::vector<std::future<void>> futures;
+void ProcessListing::listThreads(const std::pmr::vector<int> &pids,
+                                 std::pmr::vector<ScanTarget> &targets) {
+  size_t numBatches = (pids.size() + BATCH_SIZE - 1) / BATCH_SIZE;
+  std::pmr::vector<std::pmr::vector<ScanTarget>> found(numBatches, &arena_);
+  std::pmr::vector<std::future<void>> futures(&arena_);
+  futures.reserve(numBatches);
 
   for (size_t i = 0; i < numBatches; ++i) {
     futures.push_back(std::async(std::launch::async, [&, i]() {
+      WorkerPlacement::applyToCurrentThread();
+      std::pmr::vector<int> tids(&arena_);
       size_t start = i * BATCH_SIZE;
       size_t end = std::min(start + BATCH_SIZE, pids.size());
       for (size_t j = start; j < end; ++j) {
-        fetchProcessInfo(pids[j]);
+        getThreadIds(pids[j], tids);
+        for (int tid : tids) {
+          found[i].push_back({pids[j], tid});
+        }
       }
     }));
   }
@@ -100,134 +575,566 @@ void ProcessListing::fetchProcessList() {
   for (auto &fut : futures) {
     fut.get();
   }
+  // The batches hold consecutive PIDs, so appending them keeps the order
+  for (const auto &batch : found) {
+    targets.insert(targets.end(), batch.begin(), batch.end());
+  }
 }
 
-std::vector<int> ProcessListing::getAllPIDs() {
-  std::vector<int> pids;
-  for (const auto &entry : fs::directory_iterator("/proc")) {
-    if (entry.is_directory()) {
-      std::string filename = entry.path().filename().string();
-      if (std::all_of(filename.begin(), filename.end(), ::isdigit)) {
-        pids.push_back(std::stoi(filename));
+bool ProcessListing::fetchWithUring(
+    const std::pmr::vector<ScanTarget> &targets, const ScanContext &context) {
+  // The ring and its registered buffers are kept for the following scans
+  if (!uring_) {
+    uring_ = std::make_unique<UringReader>();
+  }
+  if (!uring_->isAvailable()) {
+    if (!uringWarningShown.exchange(true)) {
+      std::cerr << "Warning: " << uring_->error()
+                << "; reading procfs synchronously.\n";
+    }
+    return false;
+  }
+
+  size_t filesPerProcess = 0;
+  for (unsigned source : PREFETCH_SOURCES) {
+    filesPerProcess += (context.sources & source) != 0 ? 1 : 0;
+  }
+  size_t batchSize =
+      uring_->capacity() / std::max<size_t>(filesPerProcess, 1);
+  std::pmr::vector<Prefetch> batch(std::min(batchSize, targets.size()),
+                                   &arena_);
+  ScanBuffers buffers(&arena_);
+
+  for (size_t start = 0; start < targets.size(); start += batchSize) {
+    size_t end = std::min(start + batchSize, targets.size());
+    uring_->clear();
+    for (size_t j = start; j < end; ++j) {
+      Prefetch &prefetch = batch[j - start];
+      targetDirectory(targets[j].pid, targets[j].tid, buffers.path);
+      size_t prefixLength = buffers.path.size();
+      // Rows the IDs or the owner already reject queue no reads
+      prefetch.rejected = false;
+      prefetch.collected = PROC_SOURCE_NONE;
+      if (context.filter != nullptr) {
+        ProcessInfo ids;
+        ids.pid = targets[j].pid;
+        ids.tid = targets[j].tid != 0 ? targets[j].tid : targets[j].pid;
+        prefetch.rejected = !prefilter(ids, context, buffers.path.c_str());
+        prefetch.uid = ids.uid;
+        prefetch.collected = ids.collected;
       }
+      for (size_t file = 0; file < PREFETCH_FILE_COUNT; ++file) {
+        prefetch.requests[file] = UringReader::NONE;
+        if (!prefetch.rejected &&
+            (context.sources & PREFETCH_SOURCES[file]) != 0) {
+          buffers.path.resize(prefixLength);
+          buffers.path += PREFETCH_NAMES[file];
+          prefetch.requests[file] = uring_->add(buffers.path);
+        }
+      }
+    }
+    // A failed submission leaves every file to the synchronous reads
+    uring_->submit();
+    for (size_t j = start; j < end; ++j) {
+      fetchProcessInfo(targets[j], context, buffers, &batch[j - start]);
     }
   }
-  return pids;
+  return true;
 }
 
-void ProcessListing::fetchProcessInfo(int pid) {
-  ProcessInfo info;
-  info.pid = pid;
-  info.name = getProcessName(pid);
-  info.cpuUsage = calculateCPUUsage(pid);
-  info.memoryUsage = calculateMemoryUsage(pid);
+void ProcessListing::fetchSmaps(size_t limit) {
+  smapsReport_ = SmapsReport();
+  std::vector<ProcessInfo *> candidates = largestByRss(limit);
+  smapsReport_.candidates = candidates.size();
 
-  // Lock mutex before modifying shared data
-  std::lock_guard<std::mutex> lock(mutex_);
-  processes_.push_back(info);
+  auto now = std::chrono::steady_clock::now();
+  rusage before{};
+  getrusage(RUSAGE_THREAD, &before);
+
+  std::string contents;
+  for (ProcessInfo *process : candidates) {
+    SmapsSample &sample = smapsCache_[process->pid];
+    bool fresh =
+        sample.generation != 0 &&
+        now - sample.readAt < std::chrono::seconds(SMAPS_MAX_AGE_SECONDS);
+    if (!fresh) {
+      std::string path = ProcPaths::process(process->pid) + "smaps_rollup";
+      if (!readParsed(path, contents, [&sample](std::string_view text) {
+            return ProcParsers::parseSmapsRollup(text, sample.smaps);
+          })) {
+        smapsCache_.erase(process->pid); // Exited or not permitted
+        continue;
+      }
+      sample.readAt = now;
+      ++smapsReport_.read;
+    } else {
+      ++smapsReport_.cached;
+    }
+
+    sample.generation = generation_;
+    process->pssKb = sample.smaps.pssKb;
+    process->ussKb = sample.smaps.ussKb;
+    process->collected |= PROC_SOURCE_SMAPS;
+  }
+
+  rusage after{};
+  getrusage(RUSAGE_THREAD, &after);
+  smapsReport_.kernelTimeMs =
+      (after.ru_stime.tv_sec - before.ru_stime.tv_sec) * 1000.0 +
+      (after.ru_stime.tv_usec - before.ru_stime.tv_usec) / 1000.0;
+
+  // Drop readings of processes that left the top N or exited
+  for (auto it = smapsCache_.begin(); it != smapsCache_.end();) {
+    if (it->second.generation != generation_) {
+      it = smapsCache_.erase(it);
+    } else {
+      ++it;
+    }
+  }
 }
 
-std::string ProcessListing::getProcessName(int pid) {
-  std::string name = "Unknown";
-  std::string path = PROC_COMM_PATH_PREFIX + std::to_string(pid) + "/comm";
-  std::ifstream commFile(path);
-  if (commFile.is_open()) {
-    std::getline(commFile, name);
-    commFile.close();
+void ProcessListing::fetchNumaMaps(size_t limit) {
+  numaReport_ = SmapsReport();
+  std::vector<ProcessInfo *> candidates = largestByRss(limit);
+  numaReport_.candidates = candidates.size();
+
+  auto now = std::chrono::steady_clock::now();
+  rusage before{};
+  getrusage(RUSAGE_THREAD, &before);
+
+  std::string contents;
+  for (ProcessInfo *process : candidates) {
+    NumaSample &sample = numaCache_[process->pid];
+    bool fresh =
+        sample.generation != 0 &&
+        now - sample.readAt < std::chrono::seconds(SMAPS_MAX_AGE_SECONDS);
+    if (!fresh) {
+      std::string path = ProcPaths::process(process->pid) + "numa_maps";
+      if (!readParsed(path, contents, [&sample](std::string_view text) {
+            return ProcParsers::parseNumaMaps(text, sample.nodeKb);
+          })) {
+        numaCache_.erase(process->pid); // Exited or not permitted
+        continue;
+      }
+      sample.readAt = now;
+      ++numaReport_.read;
+    } else {
+      ++numaReport_.cached;
+    }
+    sample.generation = generation_;
+
+    // The node holding the most pages, and its share of the resident total
+    unsigned long long totalKb = 0;
+    for (unsigned long long kb : sample.nodeKb) {
+      totalKb += kb;
+    }
+    if (totalKb == 0) {
+      continue;
+    }
+    auto largest = std::max_element(sample.nodeKb.begin(), sample.nodeKb.end());
+    process->numaNode = static_cast<int>(largest - sample.nodeKb.begin());
+    process->numaShare = 100.0 * static_cast<double>(*largest) / totalKb;
+    process->collected |= PROC_SOURCE_NUMA;
+  }
+
+  rusage after{};
+  getrusage(RUSAGE_THREAD, &after);
+  numaReport_.kernelTimeMs =
+      (after.ru_stime.tv_sec - before.ru_stime.tv_sec) * 1000.0 +
+      (after.ru_stime.tv_usec - before.ru_stime.tv_usec) / 1000.0;
+
+  for (auto it = numaCache_.begin(); it != numaCache_.end();) {
+    if (it->second.generation != generation_) {
+      it = numaCache_.erase(it);
+    } else {
+      ++it;
+    }
   }
-  return name;
 }
 
-double ProcessListing::calculateCPUUsage(int pid) {
-  static std::unordered_map<int, std::vector<unsigned long long>> prev_times;
-  unsigned long long utime, stime, cutime, cstime, total_time;
-  unsigned long long system_total_time = 0;
-  unsigned long long prev_total_time = 0;
-  unsigned long long prev_proc_time = 0;
+const std::vector<unsigned long long> *
+ProcessListing::getNumaResidency(int pid) const {
+  auto it = numaCache_.find(pid);
+  if (it == numaCache_.end() || it->second.generation != generation_) {
+    return nullptr;
+  }
+  return &it->second.nodeKb;
+}
 
-  // Read process-specific times
-  std::ifstream statFile("/proc/" + std::to_string(pid) + "/stat");
-  if (!statFile.is_open()) {
-    return 0.0; // Return 0.0 if the process stat file cannot be read
+std::vector<ProcessInfo *> ProcessListing::largestByRss(size_t limit) {
+  std::vector<ProcessInfo *> candidates;
+  candidates.reserve(processes_.size());
+  for (auto &process : processes_) {
+    if ((process.collected & PROC_SOURCE_STATM) != 0 && process.rssKb > 0) {
+      candidates.push_back(&process);
+    }
   }
+  limit = std::min(limit, candidates.size());
+  std::partial_sort(candidates.begin(), candidates.begin() + limit,
+                    candidates.end(),
+                    [](const ProcessInfo *a, const ProcessInfo *b) {
+                      return a->rssKb > b->rssKb;
+                    });
+  candidates.resize(limit);
+  return candidates;
+}
+
+std::vector<int> ProcessListing::getAllPIDs() {
+  std::pmr::vector<int> pids;
+  getAllPIDs(pids);
+  return std::vector<int>(pids.begin(), pids.end());
+}
 
-  std::string ignore;
-  for (int i = 0; i < PROCESS_STAT_FIELDS_TO_SKIP; ++i) {
-    statFile >> ignore; // Skip unnecessary fields
+void ProcessListing::getAllPIDs(std::pmr::vector<int> &pids) {
+  pids.clear();
+  ProcDirectory directory(ProcPaths::procRoot().c_str());
+  unsigned char type = DT_UNKNOWN;
+  while (const char *name = directory.next(type)) {
+    // Process directories are the entries whose names are all digits
+    if (type != DT_DIR && type != DT_UNKNOWN) {
+      continue;
+    }
+    const char *end = name + std::strlen(name);
+    int pid = 0;
+    std::from_chars_result result = std::from_chars(name, end, pid);
+    if (result.ec == std::errc() && result.ptr == end && name[0] != '-') {
+      pids.push_back(pid);
+    }
   }
-  statFile >> utime >> stime >> cutime >> cstime;
-  statFile.close();
+  std::sort(pids.begin(), pids.end());
+}
 
-  total_time = utime + stime + cutime + cstime;
+void ProcessListing::getThreadIds(int pid, std::pmr::vector<int> &tids) {
+  tids.clear();
+  std::string path = ProcPaths::process(pid) + TASK_DIRECTORY;
+  ProcDirectory directory(path.c_str());
+  unsigned char type = DT_UNKNOWN;
+  while (const char *name = directory.next(type)) {
+    const char *end = name + std::strlen(name);
+    int tid = 0;
+    std::from_chars_result result = std::from_chars(name, end, tid);
+    if (result.ec == std::errc() && result.ptr == end && tid > 0) {
+      tids.push_back(tid);
+    }
+  }
+  std::sort(tids.begin(), tids.end());
+}
 
-  // Calculate system-wide CPU time
-  std::ifstream cpuStatFile(PROC_STAT_PATH);
-  if (!cpuStatFile.is_open()) {
-    return 0.0;
+void ProcessListing::fetchProcessInfo(const ScanTarget &target,
+                                      const ScanContext &context,
+                                      ScanBuffers &buffers,
+                                      const Prefetch *prefetch) {
+  // Samples and metadata are kept per TID for threads, per PID otherwise
+  int id = target.tid != 0 ? target.tid : target.pid;
+  ProcessInfo info;
+  info.pid = target.pid;
+  info.tid = id;
+
+  // Paths are built in place: the directory, then each file name after it
+  targetDirectory(target.pid, target.tid, buffers.path);
+  size_t prefixLength = buffers.path.size();
+  auto file = [&buffers, prefixLength](const char *name) {
+    buffers.path.resize(prefixLength);
+    buffers.path += name;
+    return buffers.path.c_str();
+  };
+  std::pmr::string &contents = buffers.contents;
+
+  if (prefetch != nullptr) {
+    if (prefetch->rejected) {
+      return;
+    }
+    info.uid = prefetch->uid;
+    info.collected |= prefetch->collected;
+  } else if (context.filter != nullptr &&
+             !prefilter(info, context, buffers.path.c_str())) {
+    return;
   }
+  // Stops reading a row once the values collected so far reject it
+  FilterMatch match = context.filter != nullptr ? FilterMatch::Unknown
+                                                : FilterMatch::True;
+  auto rejected = [&]() {
+    if (match == FilterMatch::Unknown) {
+      match = context.filter->evaluate(info, metadata_);
+      if (match == FilterMatch::False) {
+        ++filtered_;
+      }
+    }
+    return match == FilterMatch::False;
+  };
 
-  std::string line;
-  std::getline(cpuStatFile, line);
-  cpuStatFile.close();
+  // Uses the contents the io_uring backend read ahead, if there are any
+  auto load = [&](PrefetchFile index, auto parse) {
+    if (prefetch != nullptr && prefetch->requests[index] != UringReader::NONE) {
+      size_t request = prefetch->requests[index];
+      switch (uring_->status(request)) {
+      case UringStatus::Complete: {
+        SelfTimerScope timer(SelfTimer::Parse);
+        return parse(uring_->contents(request));
+      }
+      case UringStatus::Missing:
+        return false;
+      case UringStatus::Fallback:
+        break;
+      }
+    }
+    return readParsed(file(PREFETCH_NAMES[index]), contents, parse);
+  };
 
-  std::istringstream iss(line);
-  iss >> ignore; // Skip 'cpu'
-  unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
-  iss >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal;
+  ProcStat stat;
+  if ((context.sources & PROC_SOURCE_STAT) != 0) {
+    if (!load(PREFETCH_STAT, [&stat](std::string_view text) {
+          return ProcParsers::parseStat(text, stat);
+        })) {
+      return; // The process exited while being scanned
+    }
+    if (target.tid != 0) {
+      // A thread's stat repeats the children reaped by the whole process
+      stat.cutime = 0;
+      stat.cstime = 0;
+    }
+    info.threads = stat.numThreads;
+    info.ppid = stat.ppid;
+    info.startTime = stat.startTime;
+    info.collected |= PROC_SOURCE_STAT;
 
-  system_total_time =
-      user + nice + system + idle + iowait + irq + softirq + steal;
-  total_time -= prev_proc_time;
-  system_total_time -= prev_total_time;
+    // Name, command line and owner are read once per process identity
+    unsigned fields = METADATA_NAME;
+    if ((context.sources & PROC_SOURCE_CMDLINE) != 0) {
+      fields |= METADATA_CMDLINE;
+    }
+    if ((context.sources & PROC_SOURCE_OWNER) != 0) {
+      fields |= METADATA_USER;
+    }
+    ProcessMetadata metadata = metadata_.resolve(
+        id, stat.startTime, stat.comm, fields, generation_ + 1);
+    info.nameId = metadata.nameId;
+    info.cmdlineId = metadata.cmdlineId;
+    info.userId = metadata.userId;
+    if ((metadata.fields & METADATA_CMDLINE) != 0) {
+      info.collected |= PROC_SOURCE_CMDLINE;
+    }
+    if ((metadata.fields & METADATA_USER) != 0) {
+      info.uid = metadata.uid;
+      info.collected |= PROC_SOURCE_OWNER;
+    }
 
-  prev_proc_time = total_time;
-  prev_total_time = system_total_time;
+    // The CPU sample is kept even if the filter rejects the row, so a
+    // process that starts matching later gets a delta, not a lifetime average
+    updateSample(id, stat, info, context);
+    if (rejected()) {
+      return;
+    }
+  }
 
-  // Return CPU usage as percentage
-  if (system_total_time == 0)
-    return 0.0;
-  return (static_cast<double>(total_time) / system_total_time) * 100.0;
+  if ((context.sources & PROC_SOURCE_STATM) != 0) {
+    unsigned long long residentPages = 0;
+    if (load(PREFETCH_STATM, [&residentPages](std::string_view text) {
+          return ProcParsers::parseStatm(text, residentPages);
+        })) {
+      static const long PAGE_SIZE_KB = sysconf(_SC_PAGESIZE) / 1024;
+      info.rssKb = residentPages * PAGE_SIZE_KB;
+      info.memoryUsage = calculateMemoryUsage(info.rssKb, context);
+      info.collected |= PROC_SOURCE_STATM;
+    }
+    if (rejected()) {
+      return;
+    }
+  }
+
+  if ((context.sources & PROC_SOURCE_STATUS) != 0) {
+    ProcStatus status;
+    if (load(PREFETCH_STATUS, [&status](std::string_view text) {
+          return ProcParsers::parseStatus(text, status);
+        })) {
+      info.voluntaryCtxSwitches = status.voluntaryCtxSwitches;
+      info.involuntaryCtxSwitches = status.involuntaryCtxSwitches;
+      info.collected |= PROC_SOURCE_STATUS;
+    }
+    if (rejected()) {
+      return;
+    }
+  }
+
+  if ((context.sources & PROC_SOURCE_IO) != 0) {
+    ProcIo io;
+    // Reading another user's io file requires elevated privileges
+    if (load(PREFETCH_IO, [&io](std::string_view text) {
+          return ProcParsers::parseIo(text, io);
+        })) {
+      info.ioReadBytes = io.readBytes;
+      info.ioWriteBytes = io.writeBytes;
+      info.collected |= PROC_SOURCE_IO;
+    }
+    if (rejected()) {
+      return;
+    }
+  }
+
+  if ((context.sources & PROC_SOURCE_FD) != 0) {
+    long fds = ProcReader::countEntries(file("fd"));
+    if (fds >= 0) {
+      info.openFds = fds;
+      info.collected |= PROC_SOURCE_FD;
+    }
+  }
+
+  // Lock mutex before modifying shared data
+  std::lock_guard<std::mutex> lock(mutex_);
+  processes_.push_back(info);
 }
 
-double ProcessListing::calculateMemoryUsage(int pid) {
-  unsigned long long resident_pages = 0;
-  long page_size_kb = sysconf(_SC_PAGESIZE) / 1024; // Page size in KB
+void ProcessListing::updateSample(int id, const ProcStat &stat,
+                                  ProcessInfo &info,
+                                  const ScanContext &context) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = samples_.find(id);
+  const ProcessSample *previous = nullptr;
+  if (it != samples_.end() && it->second.startTime == stat.startTime) {
+    previous = &it->second;
+  }
+
+  info.cpuUsage = calculateCPUUsage(stat, previous, context);
+  info.minorFaultRate =
+      calculateRate(stat.minorFaults, previous ? previous->minorFaults : 0,
+                    previous, stat, context);
+  info.majorFaultRate =
+      calculateRate(stat.majorFaults, previous ? previous->majorFaults : 0,
+                    previous, stat, context);
 
-  // Read process memory info
-  std::ifstream statmFile("/proc/" + std::to_string(pid) + "/statm");
-  if (!statmFile.is_open()) {
-    return 0.0; // Return 0.0 if the statm file cannot be read
+  ProcessSample &sample = samples_[id];
+  sample.startTime = stat.startTime;
+  sample.processTime = stat.utime + stat.stime + stat.cutime + stat.cstime;
+  sample.systemTime = context.systemTime;
+  sample.minorFaults = stat.minorFaults;
+  sample.majorFaults = stat.majorFaults;
+  sample.uptime = context.uptime;
+  sample.generation = generation_ + 1;
+
+  if (context.events) {
+    identities_.push_back({info.pid, stat.ppid, stat.startTime, info.nameId});
   }
+}
 
-  std::string dummy;                    // Variable to discard unused values
-  statmFile >> dummy >> resident_pages; // Read the second value (RSS)
-  statmFile.close();
+void ProcessListing::diffIdentities(const ScanContext &context) {
+  std::sort(identities_.begin(), identities_.end(),
+            [](const ProcessIdentity &a, const ProcessIdentity &b) {
+              return a.pid < b.pid;
+            });
+  events_.clear();
+  scanReport_.started = 0;
+  scanReport_.exited = 0;
+  scanReport_.execs = 0;
+  scanReport_.churnPerSecond = 0;
+  if (identitiesPrimed_) {
+    ProcessEvents::diff(previousIdentities_, identities_, metadata_,
+                        unixMillis(), events_);
+    for (const ProcessEvent &event : events_) {
+      switch (event.type) {
+      case ProcessEventType::Started:
+        ++scanReport_.started;
+        break;
+      case ProcessEventType::Exited:
+        ++scanReport_.exited;
+        break;
+      case ProcessEventType::Exec:
+        ++scanReport_.execs;
+        break;
+      }
+    }
+    double elapsed = context.uptime - identitiesUptime_;
+    if (elapsed > 0.0) {
+      scanReport_.churnPerSecond =
+          static_cast<double>(scanReport_.started + scanReport_.exited) /
+          elapsed;
+    }
+  }
+  previousIdentities_.swap(identities_);
+  identitiesPrimed_ = true;
+  identitiesUptime_ = context.uptime;
 
-  unsigned long long process_memory_kb = resident_pages * page_size_kb;
+  if (events_.empty()) {
+    return;
+  }
+  // A fork storm would flood the log, so only the first events are written
+  Logger logger;
+  size_t logged = std::min(events_.size(), MAX_LOGGED_EVENTS);
+  for (size_t i = 0; i < logged; ++i) {
+    logger.logAction(ProcessEvents::describe(events_[i]));
+  }
+  if (events_.size() > logged) {
+    logger.logAction("... and " + std::to_string(events_.size() - logged) +
+                     " more process events");
+  }
+}
+
+bool ProcessListing::prefilter(ProcessInfo &info, const ScanContext &context,
+                               const char *directory) {
+  FilterMatch match = context.filter->evaluate(info, metadata_);
+  if (match == FilterMatch::Unknown &&
+      (context.filter->requiredSources() & PROC_SOURCE_OWNER) != 0) {
+    struct stat owner;
+    if (stat(directory, &owner) == 0) {
+      info.uid = static_cast<uint32_t>(owner.st_uid);
+      info.collected |= PROC_SOURCE_OWNER;
+      match = context.filter->evaluate(info, metadata_);
+    }
+  }
+  if (match == FilterMatch::False) {
+    ++filtered_;
+    return false;
+  }
+  return true;
+}
 
-  // Read total memory
-  std::ifstream meminfoFile("/proc/meminfo");
-  if (!meminfoFile.is_open()) {
+double ProcessListing::calculateCPUUsage(const ProcStat &stat,
+                                         const ProcessSample *previous,
+                                         const ScanContext &context) {
+  unsigned long long total_time =
+      stat.utime + stat.stime + stat.cutime + stat.cstime;
+  unsigned long long system_total_time = context.systemTime;
+
+  // Use the difference against the previous sample when there is one
+  if (previous != nullptr && total_time >= previous->processTime &&
+      system_total_time > previous->systemTime) {
+    total_time -= previous->processTime;
+    system_total_time -= previous->systemTime;
+  }
+
+  // Return CPU usage as percentage
+  if (system_total_time == 0)
+    return 0.0;
+  return (static_cast<double>(total_time) / system_total_time) * 100.0;
+}
+
+double ProcessListing::calculateMemoryUsage(unsigned long long rssKb,
+                                            const ScanContext &context) {
+  if (context.totalMemoryKb == 0) {
     return 0.0;
   }
 
-  std::string line;
-  unsigned long long total_memory_kb = 0;
-  while (std::getline(meminfoFile, line)) {
-    std::istringstream iss(line);
-    std::string key;
-    unsigned long long value;
-    iss >> key >> value;
-    if (key == "MemTotal:") {
-      total_memory_kb = value;
-      break;
+  return (static_cast<double>(rssKb) / context.totalMemoryKb) * 100.0;
+}
+
+double ProcessListing::calculateRate(unsigned long long current,
+                                     unsigned long long previousValue,
+                                     const ProcessSample *previous,
+                                     const ProcStat &stat,
+                                     const ScanContext &context) {
+  if (previous != nullptr) {
+    double elapsed = context.uptime - previous->uptime;
+    if (elapsed <= 0.0 || current < previousValue) {
+      return 0.0;
     }
+    return static_cast<double>(current - previousValue) / elapsed;
   }
-  meminfoFile.close();
 
-  if (total_memory_kb == 0) {
+  // Without a previous sample, average over the lifetime of the process
+  static const long CLOCK_TICKS = sysconf(_SC_CLK_TCK);
+  double age = context.uptime - static_cast<double>(stat.startTime) /
+                                    static_cast<double>(CLOCK_TICKS);
+  if (age <= 0.0) {
     return 0.0;
   }
-
-  return (static_cast<double>(process_memory_kb) / total_memory_kb) * 100.0;
+  return static_cast<double>(current) / age;
 }
@@ -2,13 +2,22 @@
 // src/process_manager.cpp
 
 #include "../include/process_manager.h"
-#include "../include/command_parser.h"
-#include "../include/logger.h"
-#include "../include/process_control.h"
-#include "../include/process_listing.h"
-#include "../include/resource_monitoring.h"
+#include "../include/collector_daemon.h"
+#include "../include/daemon_client.h"
+#include "../include/proc_parsers.h"
+#include "../include/proc_paths.h"
+#include "../include/process_columns.h"
+#include "../include/process_filter.h"
+#include "../include/process_watch.h"
+#include "../include/self_stats.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
+#include <unistd.h>
 
 // Constants for magic numbers
 constexpr const char *WELCOME_HEADER =
@@ -22,15 +31,97 @@ constexpr const char *LIST_COMMAND = "list";
 constexpr const char *MONITOR_COMMAND = "monitor";
 constexpr const char *KILL_COMMAND = "kill";
 constexpr const char *LOG_COMMAND = "log";
+constexpr const char *CGROUPS_COMMAND = "cgroups";
+constexpr const char *STATS_COMMAND = "stats";
+constexpr const char *THREADS_COMMAND = "threads";
+constexpr const char *HISTORY_COMMAND = "history";
+constexpr const char *EVENTS_COMMAND = "events";
+constexpr const char *RENICE_COMMAND = "renice";
+constexpr const char *IONICE_COMMAND = "ionice";
+constexpr const char *AFFINITY_COMMAND = "affinity";
+constexpr const char *THROTTLE_COMMAND = "throttle";
 constexpr const char *EXIT_COMMAND = "exit";
 constexpr const char *UNKNOWN_COMMAND_MSG = "Unknown command: ";
 constexpr const char *PID_REQUIRED_MSG =
     "Error: 'kill' command requires a PID.";
+constexpr const char *INVALID_PID_MSG = "Error: Invalid PID: ";
+constexpr const char *TARGETS_REQUIRED_MSG =
+    "Error: Give the target PIDs, e.g. '812,913', or '--filter <expr>'.";
+constexpr const char *NO_TARGETS_MSG = "No process matches the filter.";
+constexpr const char *NICENESS_REQUIRED_MSG =
+    "Error: 'renice' requires a nice value from -20 to 19.";
+constexpr const char *IO_CLASS_REQUIRED_MSG =
+    "Error: 'ionice' requires a class: realtime, best-effort or idle, "
+    "optionally with a level from 0 to 7, e.g. 'best-effort:7'.";
+constexpr const char *CPU_LIST_REQUIRED_MSG =
+    "Error: 'affinity' requires a CPU list, e.g. '0-3,8'.";
+constexpr const char *CPU_MAX_REQUIRED_MSG =
+    "Error: 'throttle' requires a quota in microseconds or 'max', "
+    "optionally followed by a period, e.g. '50000 100000'.";
+constexpr int MIN_NICENESS = -20; // Highest priority
+constexpr int MAX_NICENESS = 19;  // Lowest priority
+constexpr const char *THREADS_PID_REQUIRED_MSG =
+    "Error: 'threads' command requires a PID.";
+constexpr const char *NO_SUCH_PROCESS_MSG = "Error: No process with PID ";
+constexpr const char *HISTORY_PID_REQUIRED_MSG =
+    "Error: 'history' command requires a PID.";
+constexpr const char *NO_HISTORY_MSG = "No history yet for PID ";
+constexpr const char *NO_EVENTS_MSG =
+    "No process has started or exited since the first 'history' or 'events' "
+    "command.";
+constexpr const char *HISTORY_START_MSG =
+    " from the first 'history' or 'events' command on.";
 constexpr const char *EXIT_MSG = "Exiting...";
+constexpr const char *COLUMNS_OPTION = "--columns";
+constexpr const char *COLUMNS_REQUIRED_MSG =
+    "Error: '--columns' requires a comma-separated list of columns.";
+constexpr const char *SMAPS_TOP_OPTION = "--smaps-top";
+constexpr const char *SMAPS_TOP_REQUIRED_MSG =
+    "Error: '--smaps-top' requires a number of processes.";
+constexpr const char *WATCH_OPTION = "--watch";
+constexpr const char *WATCH_INTERVAL_MSG =
+    "Error: '--watch' interval must be at least 0.1 seconds.";
+constexpr const char *BUDGET_OPTION = "--budget";
+constexpr const char *BUDGET_REQUIRED_MSG =
+    "Error: '--budget' requires a positive CPU percentage of one core.";
+constexpr const char *BUDGET_WATCH_MSG =
+    "Error: '--budget' only applies to '--watch'.";
+constexpr const char *DAEMON_OPTION = "--daemon";
+constexpr const char *DAEMON_WATCH_MSG =
+    "Error: '--daemon' cannot be combined with '--watch'.";
+constexpr const char *THREADS_OPTION = "--threads";
+constexpr const char *DAEMON_THREADS_MSG =
+    "Error: '--daemon' cannot be combined with '--threads'.";
+constexpr const char *FILTER_OPTION = "--filter";
+constexpr const char *FILTER_REQUIRED_MSG =
+    "Error: '--filter' requires an expression, e.g. 'name~nginx && cpu>5'.";
+constexpr const char *DAEMON_FILTER_MSG =
+    "Error: '--daemon' cannot be combined with '--filter'.";
+constexpr double DEFAULT_WATCH_INTERVAL_SECONDS = 2.0; // Default refresh
+constexpr double MIN_WATCH_INTERVAL_SECONDS = 0.1;     // Fastest refresh
+constexpr std::chrono::milliseconds HISTORY_INTERVAL(5000); // Between samples
+constexpr size_t HISTORY_SAMPLES = 120;            // Ten minutes of samples
+constexpr size_t HISTORY_MEMORY_BYTES = 16u << 20; // Before cold evictions
 
-ProcessManager::ProcessManager() {
-  // Initialize logger or other resources if necessary
-}
+const ProcessManager::Command ProcessManager::COMMANDS[] = {
+    {LIST_COMMAND, &ProcessManager::handleListCommand},
+    {THREADS_COMMAND, &ProcessManager::handleThreadsCommand},
+    {HISTORY_COMMAND, &ProcessManager::handleHistoryCommand},
+    {EVENTS_COMMAND, &ProcessManager::handleEventsCommand},
+    {MONITOR_COMMAND, &ProcessManager::handleMonitorCommand},
+    {KILL_COMMAND, &ProcessManager::handleKillCommand},
+    {RENICE_COMMAND, &ProcessManager::handleReniceCommand},
+    {IONICE_COMMAND, &ProcessManager::handleIoniceCommand},
+    {AFFINITY_COMMAND, &ProcessManager::handleAffinityCommand},
+    {THROTTLE_COMMAND, &ProcessManager::handleThrottleCommand},
+    {CGROUPS_COMMAND, &ProcessManager::handleCgroupsCommand},
+    {LOG_COMMAND, &ProcessManager::handleLogCommand},
+    {STATS_COMMAND, &ProcessManager::handleStatsCommand},
+    {HELP_COMMAND, &ProcessManager::handleHelpCommand},
+    {EXIT_COMMAND, &ProcessManager::handleExitCommand},
+};
+
+ProcessManager::ProcessManager() {}
 
 void ProcessManager::run() {
   displayWelcomeScreen();
@@ -47,9 +138,12 @@ void ProcessManager::displayWelcomeScreen() {
 
 void ProcessManager::startInteractiveLoop() {
   std::string command;
-  while (true) {
+  while (running_) {
     std::cout << "\n> ";
-    std::getline(std::cin, command);
+    if (!std::getline(std::cin, command)) {
+      std::cout << '\n';
+      break; // End of input
+    }
 
     if (command.empty()) {
       continue;
@@ -60,48 +154,508 @@ void ProcessManager::startInteractiveLoop() {
 }
 
 void ProcessManager::handleCommand(const std::string &command) {
-  CommandParser parser;
-  auto parsedCommand = parser.parse(command);
-
-  if (parsedCommand.name == LIST_COMMAND) {
-    ProcessListing processListing;
-    processListing.listProcesses();
-  } else if (parsedCommand.name == MONITOR_COMMAND) {
-    ResourceMonitoring resourceMonitor;
-    resourceMonitor.startMonitoring();
-  } else if (parsedCommand.name == KILL_COMMAND) {
-    if (parsedCommand.args.empty()) {
-      std::cerr << PID_REQUIRED_MSG << '\n';
+  ParsedCommand parsedCommand = parser_.parse(command);
+
+  for (const Command &entry : COMMANDS) {
+    if (parsedCommand.name == entry.name) {
+      (this->*entry.handler)(parsedCommand.args);
+      return;
+    }
+  }
+  std::cerr << UNKNOWN_COMMAND_MSG << parsedCommand.name << "\n";
+  std::cout << "Type 'help' to see available commands.\n";
+}
+
+void ProcessManager::handleMonitorCommand(
+    const std::vector<std::string> & /*args*/) {
+  resourceMonitor().startMonitoring();
+}
+
+void ProcessManager::handleKillCommand(const std::vector<std::string> &args) {
+  if (args.empty()) {
+    std::cerr << PID_REQUIRED_MSG << '\n';
+    return;
+  }
+  size_t next = 0;
+  std::vector<int> pids;
+  if (!resolveTargets(args, next, pids)) {
+    return;
+  }
+  reportBatch("Terminated", processControl_.terminateProcesses(pids),
+              pids.size());
+}
+
+void ProcessManager::handleReniceCommand(
+    const std::vector<std::string> &args) {
+  size_t next = 0;
+  std::vector<int> pids;
+  if (!resolveTargets(args, next, pids)) {
+    return;
+  }
+  std::string value = next < args.size() ? args[next] : "";
+  int niceness = 0;
+  auto [end, error] =
+      std::from_chars(value.data(), value.data() + value.size(), niceness);
+  if (value.empty() || error != std::errc() ||
+      end != value.data() + value.size() || niceness < MIN_NICENESS ||
+      niceness > MAX_NICENESS) {
+    std::cerr << NICENESS_REQUIRED_MSG << '\n';
+    return;
+  }
+  size_t succeeded = 0;
+  for (int pid : pids) {
+    succeeded += processControl_.renice(pid, niceness) ? 1 : 0;
+  }
+  reportBatch("Reniced", succeeded, pids.size());
+}
+
+void ProcessManager::handleIoniceCommand(
+    const std::vector<std::string> &args) {
+  size_t next = 0;
+  std::vector<int> pids;
+  if (!resolveTargets(args, next, pids)) {
+    return;
+  }
+  IoClass ioClass = IoClass::BestEffort;
+  int level = 0;
+  if (next >= args.size() ||
+      !ProcessControl::parseIoClass(args[next], ioClass, level)) {
+    std::cerr << IO_CLASS_REQUIRED_MSG << '\n';
+    return;
+  }
+  size_t succeeded = 0;
+  for (int pid : pids) {
+    succeeded += processControl_.ionice(pid, ioClass, level) ? 1 : 0;
+  }
+  reportBatch("Changed the IO priority of", succeeded, pids.size());
+}
+
+void ProcessManager::handleAffinityCommand(
+    const std::vector<std::string> &args) {
+  size_t next = 0;
+  std::vector<int> pids;
+  if (!resolveTargets(args, next, pids)) {
+    return;
+  }
+  std::vector<int> cpus;
+  if (next >= args.size() || !ProcParsers::parseCpuList(args[next], cpus) ||
+      cpus.empty()) {
+    std::cerr << CPU_LIST_REQUIRED_MSG << '\n';
+    return;
+  }
+  size_t succeeded = 0;
+  for (int pid : pids) {
+    succeeded += processControl_.setAffinity(pid, cpus) ? 1 : 0;
+  }
+  reportBatch("Moved", succeeded, pids.size());
+}
+
+void ProcessManager::handleThrottleCommand(
+    const std::vector<std::string> &args) {
+  size_t next = 0;
+  std::vector<int> pids;
+  if (!resolveTargets(args, next, pids)) {
+    return;
+  }
+  std::string cpuMax;
+  if (next >= args.size() || args.size() > next + 2 ||
+      !ProcessControl::formatCpuMax(
+          args[next], next + 1 < args.size() ? args[next + 1] : "", cpuMax)) {
+    std::cerr << CPU_MAX_REQUIRED_MSG << '\n';
+    return;
+  }
+  // The limit belongs to the cgroup, so each group is written once
+  std::vector<std::string> written;
+  size_t succeeded = 0;
+  for (int pid : pids) {
+    std::string cgroup;
+    if (ProcessControl::cgroupOf(pid, cgroup) &&
+        std::find(written.begin(), written.end(), cgroup) != written.end()) {
+      ++succeeded;
+      continue;
+    }
+    if (processControl_.throttle(pid, cpuMax, cgroup)) {
+      written.push_back(cgroup);
+      ++succeeded;
+    }
+  }
+  reportBatch("Throttled the cgroups of", succeeded, pids.size());
+}
+
+bool ProcessManager::resolveTargets(const std::vector<std::string> &args,
+                                    size_t &next, std::vector<int> &pids) {
+  pids.clear();
+  if (args.empty()) {
+    std::cerr << TARGETS_REQUIRED_MSG << '\n';
+    return false;
+  }
+  if (args[0] != FILTER_OPTION) {
+    if (!ProcessControl::parsePids(args[0], pids)) {
+      std::cerr << INVALID_PID_MSG << args[0] << '\n';
+      return false;
+    }
+    next = 1;
+    return true;
+  }
+
+  if (args.size() < 2) {
+    std::cerr << FILTER_REQUIRED_MSG << '\n';
+    return false;
+  }
+  auto filter = std::make_shared<ProcessFilter>();
+  std::string error;
+  if (!filter->compile(args[1], error)) {
+    std::cerr << "Error: " << error << '\n';
+    return false;
+  }
+  // Only the PIDs are needed; the filter adds the sources it reads
+  ListOptions options;
+  options.columns = {ProcessColumn::Pid};
+  options.filter = std::move(filter);
+  ProcessListing &listing = processListing();
+  listing.refresh(options);
+  int self = getpid();
+  for (const ProcessInfo &process : listing.getProcesses()) {
+    if (process.pid != self) {
+      pids.push_back(process.pid);
+    }
+  }
+  if (pids.empty()) {
+    std::cout << NO_TARGETS_MSG << '\n';
+    return false;
+  }
+  next = 2;
+  return true;
+}
+
+void ProcessManager::reportBatch(const std::string &action, size_t succeeded,
+                                 size_t targets) {
+  if (targets <= 1) {
+    return;
+  }
+  std::string summary = action + " " + std::to_string(succeeded) + " of " +
+                        std::to_string(targets) + " processes.";
+  std::cout << summary << '\n';
+  logger_.logAction(summary);
+}
+
+void ProcessManager::handleCgroupsCommand(
+    const std::vector<std::string> & /*args*/) {
+  cgroupMonitor().listCgroups();
+}
+
+void ProcessManager::handleLogCommand(
+    const std::vector<std::string> & /*args*/) {
+  logger_.displayRecentLogs();
+}
+
+void ProcessManager::handleStatsCommand(
+    const std::vector<std::string> & /*args*/) {
+  SelfStats::writeTable(std::cout, SelfStats::snapshot());
+}
+
+void ProcessManager::handleHelpCommand(
+    const std::vector<std::string> & /*args*/) {
+  showHelp();
+}
+
+void ProcessManager::handleExitCommand(
+    const std::vector<std::string> & /*args*/) {
+  std::cout << EXIT_MSG << '\n';
+  running_ = false; // The services are released by the destructor
+}
+
+ProcessListing &ProcessManager::processListing() {
+  if (!processListing_) {
+    processListing_ = std::make_unique<ProcessListing>();
+  }
+  return *processListing_;
+}
+
+ProcessListing &ProcessManager::threadListing() {
+  if (!threadListing_) {
+    threadListing_ = std::make_unique<ProcessListing>();
+  }
+  return *threadListing_;
+}
+
+ResourceMonitoring &ProcessManager::resourceMonitor() {
+  if (!resourceMonitor_) {
+    resourceMonitor_ = std::make_unique<ResourceMonitoring>();
+  }
+  return *resourceMonitor_;
+}
+
+CgroupMonitoring &ProcessManager::cgroupMonitor() {
+  if (!cgroupMonitor_) {
+    cgroupMonitor_ = std::make_unique<CgroupMonitoring>();
+  }
+  return *cgroupMonitor_;
+}
+
+HistoryRecorder &ProcessManager::historyRecorder() {
+  if (!historyRecorder_) {
+    historyRecorder_ = std::make_unique<HistoryRecorder>(
+        HISTORY_INTERVAL, HISTORY_SAMPLES, HISTORY_MEMORY_BYTES);
+    historyRecorder_->start();
+  }
+  return *historyRecorder_;
+}
+
+void ProcessManager::handleListCommand(const std::vector<std::string> &args) {
+  listWithOptions(args, ListOptions());
+}
+
+void ProcessManager::handleThreadsCommand(
+    const std::vector<std::string> &args) {
+  if (args.empty()) {
+    std::cerr << THREADS_PID_REQUIRED_MSG << '\n';
+    return;
+  }
+  const std::string &value = args[0];
+  int pid = 0;
+  auto [end, error] =
+      std::from_chars(value.data(), value.data() + value.size(), pid);
+  if (error != std::errc() || end != value.data() + value.size() || pid <= 0) {
+    std::cerr << INVALID_PID_MSG << value << '\n';
+    return;
+  }
+  if (access(ProcPaths::process(pid).c_str(), F_OK) != 0) {
+    std::cerr << NO_SUCH_PROCESS_MSG << pid << '\n';
+    return;
+  }
+
+  ListOptions options;
+  options.threads = true;
+  options.pid = pid;
+  listWithOptions(std::vector<std::string>(args.begin() + 1, args.end()),
+                  options);
+}
+
+void ProcessManager::handleHistoryCommand(
+    const std::vector<std::string> &args) {
+  if (args.empty()) {
+    std::cerr << HISTORY_PID_REQUIRED_MSG << '\n';
+    return;
+  }
+  const std::string &value = args[0];
+  int pid = 0;
+  auto [end, error] =
+      std::from_chars(value.data(), value.data() + value.size(), pid);
+  if (error != std::errc() || end != value.data() + value.size() || pid <= 0) {
+    std::cerr << INVALID_PID_MSG << value << '\n';
+    return;
+  }
+
+  std::vector<HistorySample> samples;
+  bool hasIo = false;
+  if (!historyRecorder().samples(pid, samples, hasIo)) {
+    std::cout << NO_HISTORY_MSG << pid << "; processes are sampled every "
+              << HISTORY_INTERVAL.count() / 1000 << " s" << HISTORY_START_MSG
+              << '\n';
+    return;
+  }
+  ProcessHistory::printSummary(std::cout, pid, samples, hasIo);
+}
+
+void ProcessManager::handleEventsCommand(const std::vector<std::string> &) {
+  std::vector<ProcessEvent> events;
+  double churnPerSecond = 0.0;
+  historyRecorder().recentEvents(events, churnPerSecond);
+  if (events.empty()) {
+    std::cout << NO_EVENTS_MSG << '\n';
+    return;
+  }
+  ProcessEvents::printTable(std::cout, events);
+  std::cout << "Churn: " << std::fixed << std::setprecision(1)
+            << churnPerSecond << " starts and exits per second over the last "
+            << HISTORY_INTERVAL.count() / 1000 << " s\n"
+            << std::defaultfloat;
+}
+
+void ProcessManager::listWithOptions(const std::vector<std::string> &args,
+                                     ListOptions options) {
+  bool columnsGiven = false;
+  bool watch = false;
+  double intervalSeconds = DEFAULT_WATCH_INTERVAL_SECONDS;
+  double budgetPercent = 0;
+  std::string daemonSocket;
+
+  for (size_t i = 0; i < args.size(); ++i) {
+    if (args[i] == COLUMNS_OPTION) {
+      if (i + 1 >= args.size()) {
+        std::cerr << COLUMNS_REQUIRED_MSG << '\n';
+        return;
+      }
+      std::string error;
+      if (!ProcessColumns::parse(args[++i], options.columns, error)) {
+        std::cerr << "Error: " << error << '\n';
+        return;
+      }
+      columnsGiven = true;
+    } else if (args[i] == THREADS_OPTION) {
+      options.threads = true;
+    } else if (args[i] == FILTER_OPTION) {
+      if (i + 1 >= args.size()) {
+        std::cerr << FILTER_REQUIRED_MSG << '\n';
+        return;
+      }
+      auto filter = std::make_shared<ProcessFilter>();
+      std::string error;
+      if (!filter->compile(args[++i], error)) {
+        std::cerr << "Error: " << error << '\n';
+        return;
+      }
+      options.filter = std::move(filter);
+    } else if (args[i] == SMAPS_TOP_OPTION) {
+      std::string value = i + 1 < args.size() ? args[++i] : "";
+      auto [end, error] = std::from_chars(
+          value.data(), value.data() + value.size(), options.smapsTopN);
+      if (value.empty() || error != std::errc() ||
+          end != value.data() + value.size()) {
+        std::cerr << SMAPS_TOP_REQUIRED_MSG << '\n';
+        return;
+      }
+    } else if (args[i] == WATCH_OPTION) {
+      watch = true;
+      // The interval is optional: only consume a value that is not an option
+      if (i + 1 < args.size() && args[i + 1].rfind("--", 0) != 0) {
+        char *end = nullptr;
+        intervalSeconds = std::strtod(args[++i].c_str(), &end);
+        if (*end != '\0' || !std::isfinite(intervalSeconds) ||
+            intervalSeconds < MIN_WATCH_INTERVAL_SECONDS) {
+          std::cerr << WATCH_INTERVAL_MSG << '\n';
+          return;
+        }
+      }
+    } else if (args[i] == BUDGET_OPTION) {
+      char *end = nullptr;
+      if (i + 1 < args.size()) {
+        budgetPercent = std::strtod(args[++i].c_str(), &end);
+      }
+      if (end == nullptr || *end != '\0' || !std::isfinite(budgetPercent) ||
+          budgetPercent <= 0) {
+        std::cerr << BUDGET_REQUIRED_MSG << '\n';
+        return;
+      }
+    } else if (args[i] == DAEMON_OPTION) {
+      // The socket path is optional, like the watch interval
+      daemonSocket = i + 1 < args.size() && args[i + 1].rfind("--", 0) != 0
+                         ? args[++i]
+                         : CollectorDaemon::defaultSocketPath();
+    } else {
+      std::cerr << "Error: Unknown option for 'list': " << args[i] << '\n';
       return;
     }
-    int pid = std::stoi(parsedCommand.args[0]);
-    ProcessControl processControl;
-    processControl.terminateProcess(pid);
-  } else if (parsedCommand.name == LOG_COMMAND) {
-    Logger logger;
-    logger.displayRecentLogs();
-  } else if (parsedCommand.name == HELP_COMMAND) {
-    showHelp();
-  } else if (parsedCommand.name == EXIT_COMMAND) {
-    std::cout << EXIT_MSG << '\n';
-    // Perform any necessary cleanup
-    exit(0);
-  } else {
-    std::cerr << UNKNOWN_COMMAND_MSG << parsedCommand.name << "\n";
-    std::cout << "Type 'help' to see available commands.\n";
   }
+
+  if (budgetPercent > 0 && !watch) {
+    std::cerr << BUDGET_WATCH_MSG << '\n';
+    return;
+  }
+  if (!daemonSocket.empty()) {
+    if (watch) {
+      std::cerr << DAEMON_WATCH_MSG << '\n';
+      return;
+    }
+    if (options.threads) {
+      std::cerr << DAEMON_THREADS_MSG << '\n';
+      return;
+    }
+    if (options.filter) {
+      std::cerr << DAEMON_FILTER_MSG << '\n';
+      return;
+    }
+    listFromDaemon(daemonSocket);
+    return;
+  }
+  if (options.threads && !columnsGiven) {
+    options.columns = ProcessColumns::defaultThreadColumns();
+  }
+
+  // The listing is kept so that rates and caches carry over between calls;
+  // threads have their own, so alternating commands keep both samples
+  ProcessListing &listing =
+      options.threads ? threadListing() : processListing();
+  if (watch) {
+    ProcessWatch processWatch(
+        listing, options,
+        std::chrono::milliseconds(
+            static_cast<long long>(intervalSeconds * 1000)),
+        budgetPercent);
+    processWatch.run();
+    return;
+  }
+  listing.listProcesses(options);
+}
+
+void ProcessManager::listFromDaemon(const std::string &socketPath) {
+  DaemonClient client;
+  DaemonSnapshot snapshot;
+  std::string error;
+  if (!client.connect(socketPath, error) ||
+      !client.fetchSnapshot(0, snapshot, error)) {
+    std::cerr << "Error: " << error << '\n';
+    return;
+  }
+  DaemonClient::printTable(std::cout, snapshot);
 }
 
 void ProcessManager::showHelp() {
   std::cout << "\nAvailable Commands:\n";
   std::cout << "  " << LIST_COMMAND
             << "           - List all active processes.\n";
+  std::cout << "    " << COLUMNS_OPTION
+            << " <list> - Select columns from: "
+            << ProcessColumns::availableKeys() << ".\n";
+  std::cout << "    " << SMAPS_TOP_OPTION
+            << " <n>   - Read PSS/USS for the n largest processes only.\n";
+  std::cout << "    " << WATCH_OPTION
+            << " [s]     - Refresh every s seconds (default 2); arrows "
+               "scroll, < > sort, r reverses, q quits.\n";
+  std::cout << "    " << BUDGET_OPTION
+            << " <pct> - With --watch, keep the tool's CPU below pct% of one "
+               "core.\n";
+  std::cout << "    " << THREADS_OPTION
+            << "       - One row per thread; CPU% is per TID between calls.\n";
+  std::cout << "    " << FILTER_OPTION
+            << " <expr>  - Keep matching rows, e.g. "
+               "\"name~nginx && cpu>5 && user==www\".\n";
+  std::cout << "    " << DAEMON_OPTION
+            << " [path] - Show the latest sample of a running collector "
+               "daemon.\n";
+  std::cout << "  " << THREADS_COMMAND
+            << " <pid>  - List the threads of a process; takes the list "
+               "options.\n";
+  std::cout << "  " << HISTORY_COMMAND
+            << " <pid>  - Show the last 10 minutes of CPU, memory and IO of a "
+               "process.\n";
+  std::cout << "  " << EVENTS_COMMAND
+            << "         - Show the processes that recently started, exited "
+               "or called exec.\n";
   std::cout << "  " << MONITOR_COMMAND
             << "        - Monitor CPU and memory usage in real-time.\n";
   std::cout << "  " << KILL_COMMAND
-            << " <pid>     - Terminate a process by PID.\n";
+            << " <targets> - Terminate processes; targets are PIDs such as "
+               "812,913 or --filter <expr>.\n";
+  std::cout << "  " << RENICE_COMMAND
+            << " <targets> <n> - Set the nice value, -20 to 19, of every "
+               "thread.\n";
+  std::cout << "  " << IONICE_COMMAND
+            << " <targets> <class>[:level] - Set the IO class: realtime, "
+               "best-effort or idle.\n";
+  std::cout << "  " << AFFINITY_COMMAND
+            << " <targets> <cpulist> - Restrict to CPUs, e.g. 0-3,8.\n";
+  std::cout << "  " << THROTTLE_COMMAND
+            << " <targets> <quota|max> [period] - Write cpu.max of the "
+               "processes' cgroups.\n";
+  std::cout << "  " << CGROUPS_COMMAND
+            << "        - Show CPU, memory and IO usage per cgroup.\n";
   std::cout << "  " << LOG_COMMAND
             << "            - Display recent log entries.\n";
+  std::cout << "  " << STATS_COMMAND
+            << "          - Show what this session has cost: files, "
+               "syscalls, latencies.\n";
   std::cout << "  " << HELP_COMMAND << "           - Show this help message.\n";
   std::cout << "  " << EXIT_COMMAND << "           - Exit the program.\n";
 }
@@ -0,0 +1,178 @@
+// src/process_metadata.cpp
+
+#include "../include/process_metadata.h"
+#include "../include/proc_paths.h"
+#include "../include/proc_reader.h"
+
+#include <pwd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+const size_t PASSWD_BUFFER_SIZE = 4096;      // Buffer for getpwuid_r
+const size_t COMPACT_MIN_BYTES = 256 * 1024; // Pool size before compacting
+const size_t COMPACT_LIVE_RATIO = 2; // Compact when live bytes are below 1/2
+
+/**
+ * @brief Reads the command line of a process.
+ *
+ * The arguments in `/proc/<pid>/cmdline` are separated by NUL bytes, which are
+ * replaced with spaces. Kernel threads have an empty command line.
+ */
+bool readCmdline(int pid, std::string &cmdline) {
+  if (!ProcReader::readFile(ProcPaths::process(pid) + "cmdline", cmdline)) {
+    return false;
+  }
+  while (!cmdline.empty() && cmdline.back() == '\0') {
+    cmdline.pop_back();
+  }
+  std::replace(cmdline.begin(), cmdline.end(), '\0', ' ');
+  return true;
+}
+
+/**
+ * @brief Reads the effective owner of a process from its procfs directory.
+ */
+bool readUid(int pid, uint32_t &uid) {
+  struct stat info;
+  if (stat(ProcPaths::process(pid).c_str(), &info) != 0) {
+    return false;
+  }
+  uid = static_cast<uint32_t>(info.st_uid);
+  return true;
+}
+} // namespace
+
+ProcessMetadata ProcessMetadataCache::resolve(int pid,
+                                              unsigned long long startTime,
+                                              std::string_view comm,
+                                              unsigned fields,
+                                              unsigned long long generation) {
+  fields |= METADATA_NAME;
+  unsigned missing = fields;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(pid);
+    if (it != entries_.end() && it->second.startTime == startTime) {
+      Entry &entry = it->second;
+      if (pool_.get(entry.metadata.nameId) != comm) {
+        // Same process with a new name: it called exec
+        entry.metadata.nameId = pool_.intern(comm);
+        entry.metadata.fields &= ~METADATA_CMDLINE;
+      }
+      entry.generation = generation;
+      missing = fields & ~entry.metadata.fields;
+      if (missing == 0) {
+        ++hits_;
+        return entry.metadata;
+      }
+    }
+    ++misses_;
+  }
+
+  // Read the missing fields without holding the lock
+  std::string cmdline;
+  bool hasCmdline = (missing & METADATA_CMDLINE) && readCmdline(pid, cmdline);
+  uint32_t uid = 0;
+  bool hasUid = (missing & METADATA_USER) && readUid(pid, uid);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry &entry = entries_[pid];
+  if (entry.startTime != startTime || (missing & METADATA_NAME)) {
+    entry = Entry();
+    entry.startTime = startTime;
+    entry.metadata.nameId = pool_.intern(comm);
+    entry.metadata.fields = METADATA_NAME;
+  }
+  if (hasCmdline) {
+    entry.metadata.cmdlineId = pool_.intern(cmdline);
+    entry.metadata.fields |= METADATA_CMDLINE;
+  }
+  if (hasUid) {
+    entry.metadata.uid = uid;
+    entry.metadata.userId = internUser(uid);
+    entry.metadata.fields |= METADATA_USER;
+  }
+  entry.generation = generation;
+  return entry.metadata;
+}
+
+std::string_view ProcessMetadataCache::getString(uint32_t id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pool_.get(id);
+}
+
+bool ProcessMetadataCache::prune(unsigned long long generation) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t liveBytes = 0;
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (it->second.generation < generation) {
+      it = entries_.erase(it);
+      continue;
+    }
+    const ProcessMetadata &metadata = it->second.metadata;
+    liveBytes += pool_.get(metadata.nameId).size() +
+                 pool_.get(metadata.cmdlineId).size();
+    ++it;
+  }
+
+  if (pool_.bytesUsed() < COMPACT_MIN_BYTES ||
+      liveBytes * COMPACT_LIVE_RATIO >= pool_.bytesUsed()) {
+    return false;
+  }
+
+  // Most of the pool belongs to exited processes: re-intern what is left
+  StringPool compacted;
+  for (auto &[pid, entry] : entries_) {
+    ProcessMetadata &metadata = entry.metadata;
+    metadata.nameId = compacted.intern(pool_.get(metadata.nameId));
+    metadata.cmdlineId = compacted.intern(pool_.get(metadata.cmdlineId));
+    metadata.userId = compacted.intern(pool_.get(metadata.userId));
+  }
+  for (auto &[uid, nameId] : userNames_) {
+    nameId = compacted.intern(pool_.get(nameId));
+  }
+  pool_ = std::move(compacted);
+  return true;
+}
+
+uint32_t ProcessMetadataCache::nameId(int pid,
+                                      unsigned long long startTime) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(pid);
+  if (it == entries_.end() || it->second.startTime != startTime) {
+    return StringPool::EMPTY_ID;
+  }
+  return it->second.metadata.nameId;
+}
+
+void ProcessMetadataCache::getCounters(unsigned long long &hits,
+                                       unsigned long long &misses) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  hits = hits_;
+  misses = misses_;
+}
+
+uint32_t ProcessMetadataCache::internUser(uint32_t uid) {
+  auto it = userNames_.find(uid);
+  if (it != userNames_.end()) {
+    return it->second;
+  }
+
+  struct passwd entry;
+  struct passwd *result = nullptr;
+  std::vector<char> buffer(PASSWD_BUFFER_SIZE);
+  uint32_t id;
+  if (getpwuid_r(uid, &entry, buffer.data(), buffer.size(), &result) == 0 &&
+      result != nullptr) {
+    id = pool_.intern(result->pw_name);
+  } else {
+    id = pool_.intern(std::to_string(uid));
+  }
+  userNames_.emplace(uid, id);
+  return id;
+}
@@ -0,0 +1,268 @@
+// src/process_watch.cpp
+
+#include "../include/process_watch.h"
+#include "../include/logger.h"
+
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+const size_t DEFAULT_TERMINAL_ROWS = 24; // Used when the size is unknown
+const size_t TABLE_HEADER_ROWS = 2;      // Header and separator lines
+const size_t STATUS_ROWS = 1;            // Status line below the table
+const size_t SMAPS_FOOTER_ROWS = 1;      // Footer printed for PSS/USS
+const size_t INPUT_BUFFER_SIZE = 64;     // Bytes read per key press
+
+const char *ENTER_SCREEN =
+    "\033[?1049h\033[?25l\033[?7l"; // Alternate screen, no cursor, no wrap
+const char *LEAVE_SCREEN =
+    "\033[?7h\033[?25h\033[?1049l"; // Restore wrap, cursor and screen
+const char *CURSOR_HOME = "\033[H";  // Move the cursor to the top left
+const char *CLEAR_LINE = "\033[K";   // Clear to the end of line
+const char *CLEAR_BELOW = "\033[J";  // Clear to the end of screen
+const char *STATUS_FORMAT = "\033[7m"; // Reverse video for the status line
+const char *RESET_FORMAT = "\033[0m";  // Reset text formatting
+
+const char KEY_CTRL_C = 3; // Quits, since signals are disabled in raw mode
+
+/**
+ * @brief Puts the terminal in unbuffered, no-echo mode for its lifetime.
+ */
+class RawTerminal {
+public:
+  RawTerminal() : active_(tcgetattr(STDIN_FILENO, &saved_) == 0) {
+    if (active_) {
+      termios raw = saved_;
+      raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+      raw.c_cc[VMIN] = 1;
+      raw.c_cc[VTIME] = 0;
+      tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    }
+    std::cout << ENTER_SCREEN << std::flush;
+  }
+
+  ~RawTerminal() {
+    std::cout << LEAVE_SCREEN << std::flush;
+    if (active_) {
+      tcsetattr(STDIN_FILENO, TCSANOW, &saved_);
+    }
+  }
+
+  RawTerminal(const RawTerminal &) = delete;
+  RawTerminal &operator=(const RawTerminal &) = delete;
+
+private:
+  termios saved_{}; ///< Settings restored on exit
+  bool active_;     ///< Whether stdin is a terminal
+};
+} // namespace
+
+ProcessWatch::ProcessWatch(ProcessListing &listing, const ListOptions &options,
+                           std::chrono::milliseconds interval,
+                           double budgetPercent)
+    : listing_(listing), options_(options), interval_(interval),
+      columns_(options.columns), sortColumn_(options.columns.front()),
+      descending_(false),
+      scrollOffset_(0) {
+  if (budgetPercent > 0) {
+    governor_ = std::make_unique<OverheadGovernor>(budgetPercent);
+  }
+
+  // Start sorted by CPU usage like top, when that column is shown
+  if (std::find(options_.columns.begin(), options_.columns.end(),
+                ProcessColumn::Cpu) != options_.columns.end()) {
+    sortColumn_ = ProcessColumn::Cpu;
+    descending_ = true;
+  }
+}
+
+void ProcessWatch::run() {
+  Logger logger;
+  logger.logAction("Watching processes");
+
+  RawTerminal terminal;
+  auto nextRefresh = std::chrono::steady_clock::now();
+  bool running = true;
+
+  while (running) {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= nextRefresh) {
+      std::chrono::milliseconds interval = interval_;
+      if (governor_) {
+        // The sort column stays, so that the order does not change
+        ListOptions options = governor_->apply(options_, sortColumn_);
+        listing_.refresh(options);
+        columns_ = options.columns;
+        applySort();
+        governor_->update(listing_.getScanReport().workerTimeMs);
+        interval = governor_->interval(interval_);
+      } else {
+        listing_.refresh(options_);
+        applySort();
+      }
+      nextRefresh = now + interval;
+    }
+    render();
+
+    // Sleep until the next refresh unless a key is pressed first
+    auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+        nextRefresh - std::chrono::steady_clock::now());
+    pollfd input{STDIN_FILENO, POLLIN, 0};
+    int ready = poll(&input, 1, static_cast<int>(std::max<long long>(
+                                    0, timeout.count())));
+    if (ready > 0) {
+      char buffer[INPUT_BUFFER_SIZE];
+      ssize_t bytes = read(STDIN_FILENO, buffer, sizeof(buffer));
+      if (bytes <= 0) {
+        running = false; // End of input
+      } else {
+        running = handleInput(std::string(buffer, bytes));
+      }
+    }
+  }
+}
+
+bool ProcessWatch::handleInput(const std::string &input) {
+  size_t page = std::max<size_t>(visibleRows(), 1);
+  size_t rows = listing_.getProcessCount();
+  size_t maxOffset = rows > page ? rows - page : 0;
+
+  for (size_t i = 0; i < input.size(); ++i) {
+    // Escape sequences of the arrow, page and home/end keys
+    if (input[i] == '\033' && i + 2 < input.size() && input[i + 1] == '[') {
+      std::string sequence = input.substr(i + 2, 2);
+      if (sequence[0] == 'A') {
+        scrollOffset_ = scrollOffset_ > 0 ? scrollOffset_ - 1 : 0;
+      } else if (sequence[0] == 'B') {
+        scrollOffset_ = std::min(scrollOffset_ + 1, maxOffset);
+      } else if (sequence == "5~") {
+        scrollOffset_ = scrollOffset_ > page ? scrollOffset_ - page : 0;
+      } else if (sequence == "6~") {
+        scrollOffset_ = std::min(scrollOffset_ + page, maxOffset);
+      } else if (sequence[0] == 'H' || sequence == "1~") {
+        scrollOffset_ = 0;
+      } else if (sequence[0] == 'F' || sequence == "4~") {
+        scrollOffset_ = maxOffset;
+      }
+      i += sequence[0] >= 'A' && sequence[0] <= 'Z' ? 2 : 3;
+      continue;
+    }
+
+    switch (input[i]) {
+    case 'q':
+    case KEY_CTRL_C:
+      return false;
+    case 'k':
+      scrollOffset_ = scrollOffset_ > 0 ? scrollOffset_ - 1 : 0;
+      break;
+    case 'j':
+      scrollOffset_ = std::min(scrollOffset_ + 1, maxOffset);
+      break;
+    case ' ':
+      scrollOffset_ = std::min(scrollOffset_ + page, maxOffset);
+      break;
+    case 'g':
+      scrollOffset_ = 0;
+      break;
+    case 'G':
+      scrollOffset_ = maxOffset;
+      break;
+    case '<':
+    case '>': {
+      // Step through the columns on screen, fewer while optional ones are
+      // dropped for the budget
+      auto sort = std::find(columns_.begin(), columns_.end(), sortColumn_);
+      if (input[i] == '<' && sort != columns_.begin()) {
+        --sort;
+      } else if (input[i] == '>' && sort + 1 < columns_.end()) {
+        ++sort;
+      }
+      sortColumn_ = *sort;
+      applySort();
+      break;
+    }
+    case 'r':
+      descending_ = !descending_;
+      applySort();
+      break;
+    default:
+      break;
+    }
+  }
+  return true;
+}
+
+void ProcessWatch::applySort() {
+  listing_.sortProcesses(sortColumn_, descending_);
+}
+
+void ProcessWatch::render() {
+  size_t rows = visibleRows();
+  size_t count = listing_.getProcessCount();
+  scrollOffset_ = std::min(scrollOffset_, count > rows ? count - rows : 0);
+
+  std::ostringstream table;
+  listing_.printTable(table, columns_, scrollOffset_, rows);
+
+  // Clear the rest of every line, since the previous frame may be wider
+  std::string frame = CURSOR_HOME;
+  for (char c : table.str()) {
+    if (c == '\n') {
+      frame += CLEAR_LINE;
+    }
+    frame += c;
+  }
+
+  const ScanReport &report = listing_.getScanReport();
+  const ColumnSpec &sort = ProcessColumns::spec(sortColumn_);
+  std::ostringstream status;
+  status << std::fixed << std::setprecision(1) << "refresh "
+         << report.wallTimeMs << " ms (" << report.cpuTimeMs << " ms CPU) | "
+         << report.processes << " procs +" << report.added << " -"
+         << report.removed;
+  if (options_.filter) {
+    status << " (" << report.filtered << " filtered)";
+  }
+  if (governor_) {
+    status << " | budget " << governor_->budgetPercent() << "%, used "
+           << governor_->usagePercent() << "%";
+    if (governor_->isDegraded()) {
+      status << ", degraded: " << governor_->describe();
+    }
+  }
+  status << " | metadata " << report.metadataHits
+         << " cached " << report.metadataMisses << " read | sort "
+         << sort.header << (descending_ ? " desc" : " asc") << " | "
+         << std::min(scrollOffset_ + 1, count) << "-"
+         << std::min(scrollOffset_ + rows, count) << "/" << count
+         << " | q quit, arrows scroll, < > sort, r reverse";
+
+  frame += STATUS_FORMAT + status.str() + CLEAR_LINE + RESET_FORMAT;
+  frame += CLEAR_BELOW;
+  std::cout << frame << std::flush;
+}
+
+size_t ProcessWatch::visibleRows() const {
+  size_t terminalRows = DEFAULT_TERMINAL_ROWS;
+  winsize size{};
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0) {
+    terminalRows = size.ws_row;
+  }
+
+  size_t reserved = TABLE_HEADER_ROWS + STATUS_ROWS;
+  unsigned sources = ProcessColumns::requiredSources(columns_);
+  if ((sources & PROC_SOURCE_SMAPS) != 0) {
+    reserved += SMAPS_FOOTER_ROWS;
+  }
+  if ((sources & PROC_SOURCE_NUMA) != 0) {
+    reserved += SMAPS_FOOTER_ROWS; // The numa_maps footer has the same shape
+  }
+  return terminalRows > reserved ? terminalRows - reserved : 1;
+}
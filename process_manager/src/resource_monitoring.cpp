@@ -1,6 +1,7 @@
 
 #include "../include/resource_monitoring.h"
 #include "../include/data_monitoring.h"
+#include "../include/display_format.h"
 #include "../include/logger.h"
 #include <chrono>
 #include <condition_variable> // for condition_variable
@@ -9,10 +10,14 @@
 #include <mutex>
 #include <thread>
 
+#include <poll.h>
+#include <unistd.h>
+
 // Constants
-constexpr int THREAD_POOL_SIZE = 4; // Size of the thread pool
+constexpr int THREAD_POOL_SIZE = 5; // Size of the thread pool
 constexpr int MONITOR_UPDATE_INTERVAL_SECONDS =
     1; // Interval for updating CPU and Memory usage
+constexpr int INPUT_POLL_INTERVAL_MS = 100; // How often input checks stop
 constexpr const char *USER_STOP_PROMPT =
     "Press Enter to stop the monitor.\n"; // User prompt
 constexpr const char *RESOURCE_MONITORING_HEADER =
@@ -27,10 +32,30 @@ constexpr const char *CURSOR_POSITION_RESTORE =
     "\033[u";                                   // Restore cursor position
 constexpr const char *BOLD_FORMAT = "\033[1m";  // Bold text formatting
 constexpr const char *RESET_FORMAT = "\033[0m"; // Reset text formatting
+constexpr const char *CLEAR_LINE = "\033[K";    // Clear to the end of line
+
+constexpr size_t CGROUP_PANEL_ROWS = 5; // Number of cgroups in the panel
+constexpr int CGROUP_VALUE_WIDTH = 10;  // Width of the cgroup panel columns
+constexpr int CGROUP_PRESSURE_WIDTH = 8; // Width of the cgroup PSI columns
+constexpr const char *CGROUP_PANEL_HEADER =
+    "\033[1;32mTop cgroups\033[0m\n"; // Cgroup panel header
+
+constexpr size_t DEVICE_PANEL_ROWS = 3; // Disks and interfaces shown
+constexpr int DEVICE_VALUE_WIDTH = 10;  // Width of the device columns
+constexpr const char *DISK_PANEL_HEADER =
+    "\033[1;32mDisks\033[0m\n"; // Disk panel header
+constexpr const char *NETWORK_PANEL_HEADER =
+    "\033[1;32mNetwork\033[0m\n"; // Network panel header
+
+constexpr int PRESSURE_LABEL_WIDTH = 14; // Width of the resource names
+constexpr int PRESSURE_VALUE_WIDTH = 10; // Width of the PSI columns
+constexpr const char *PRESSURE_PANEL_HEADER =
+    "\033[1;32mPressure stalls\033[0m\n"; // PSI panel header
 
 // Constructor
 ResourceMonitoring::ResourceMonitoring()
-    : pool_(THREAD_POOL_SIZE), monitoring_(false) {}
+    : pool_(THREAD_POOL_SIZE), monitoring_(false),
+      pressureAvailable_(false) {}
 
 // Destructor
 ResourceMonitoring::~ResourceMonitoring() {
@@ -39,16 +64,16 @@ ResourceMonitoring::~ResourceMonitoring() {
 
 // Start the monitoring process
 void ResourceMonitoring::startMonitoring() {
-  std::unique_lock<std::mutex> lock(monitoringMutex_);
-
-  if (monitoring_) {
-    logger_.logWarning(
-        "Attempted to start monitoring, but it's already running.");
-    std::cout << "Resource monitoring is already running.\n";
-    return;
+  {
+    std::lock_guard<std::mutex> lock(monitoringMutex_);
+    if (monitoring_) {
+      logger_.logWarning(
+          "Attempted to start monitoring, but it's already running.");
+      std::cout << "Resource monitoring is already running.\n";
+      return;
+    }
+    monitoring_ = true;
   }
-
-  monitoring_ = true;
   logger_.logAction("Starting resource monitoring.");
 
   std::cout << USER_STOP_PROMPT;
@@ -58,47 +83,71 @@ void ResourceMonitoring::startMonitoring() {
   pool_.enqueue([this]() { dataMonitor.updateCPUUsage(); });
   pool_.enqueue([this]() { dataMonitor.updateMemoryUsage(); });
 
+  // The kernel wakes this task on a stall, so it costs nothing meanwhile
+  pressureAvailable_ = PressureMonitoring::isAvailable();
+  if (pressureAvailable_) {
+    pool_.enqueue([this]() { pressureMonitor_.waitForStalls(); });
+  }
+
   pool_.enqueue([this]() { monitorCPUAndMemory(); });
   // Enqueue the task to wait for user input to stop monitoring
   pool_.enqueue([this]() { waitForStopInput(); });
 
   // Wait until the stop signal is received (prevent main thread from finishing
   // prematurely)
-  stopCondition_.wait(lock, [this]() {
-    return !monitoring_;
-  }); // Wait for the monitoring to stop
+  {
+    std::unique_lock<std::mutex> lock(monitoringMutex_);
+    stopCondition_.wait(lock, [this]() { return !monitoring_; });
+  }
+
+  // The workers outlive this call; let the tasks return so that the next
+  // call starts from idle threads instead of creating new ones
+  pool_.waitForAll();
 }
 
 // Stop the monitoring process
 void ResourceMonitoring::stopMonitoring() {
-  std::unique_lock<std::mutex> lock(monitoringMutex_);
-  monitoring_ = false;
+  {
+    std::lock_guard<std::mutex> lock(monitoringMutex_);
+    if (!monitoring_) {
+      return;
+    }
+    monitoring_ = false;
+  }
+  dataMonitor.stopMonitoring();
+  if (pressureAvailable_) {
+    pressureMonitor_.stop();
+  }
   logger_.logAction("Stopping resource monitoring.");
 
-  stopCondition_.notify_all(); // Notify all waiting threads to stop
-  pool_.waitForAll();
+  stopCondition_.notify_all(); // Wake the display and `startMonitoring`
 }
 
 // Wait for user input to stop monitoring
 void ResourceMonitoring::waitForStopInput() {
-  std::string input;
-  std::getline(std::cin, input); // Wait for the user to press Enter
+  // Poll so that the task also ends when monitoring is stopped elsewhere
+  while (monitoring_) {
+    pollfd input{STDIN_FILENO, POLLIN, 0};
+    if (std::cin.rdbuf()->in_avail() <= 0 &&
+        poll(&input, 1, INPUT_POLL_INTERVAL_MS) <= 0) {
+      continue;
+    }
 
-  stopMonitoring(); // Stop the monitoring when Enter is pressed
+    std::string line;
+    if (!std::getline(std::cin, line) && !isatty(STDIN_FILENO)) {
+      // Input is exhausted and nobody can press Enter: only
+      // `stopMonitoring` ends the monitor
+      return;
+    }
+    stopMonitoring(); // Stop the monitoring when Enter is pressed
+    return;
+  }
 }
 
 void ResourceMonitoring::monitorCPUAndMemory() {
   std::cout << CURSOR_POSITION_SAVE; // Save the current cursor position
 
   while (monitoring_) {
-    {
-      // Add a scoped lock to ensure thread-safe access to monitoring_ flag
-      std::unique_lock<std::mutex> lock(monitoringMutex_);
-      if (!monitoring_) {
-        break;
-      }
-    }
-
     double cpuUsage = dataMonitor.getCPUUsage();
     double memoryUsage = dataMonitor.getMemoryUsage();
 
@@ -113,11 +162,179 @@ void ResourceMonitoring::monitorCPUAndMemory() {
     std::cout << MEMORY_USAGE_LABEL << BOLD_FORMAT << std::fixed
               << std::setprecision(2) << memoryUsage << "%" << RESET_FORMAT
               << "\n"; // Bold for Memory percentage
+    displayDevicePanels();
+    displayPressurePanel();
+    displayCgroupPanel();
     std::cout << std::flush;
 
-    // Sleep for the defined interval before updating the display
-    std::this_thread::sleep_for(
-        std::chrono::seconds(MONITOR_UPDATE_INTERVAL_SECONDS));
+    // Sleep for the defined interval, waking early when monitoring stops
+    std::unique_lock<std::mutex> lock(monitoringMutex_);
+    stopCondition_.wait_for(
+        lock, std::chrono::seconds(MONITOR_UPDATE_INTERVAL_SECONDS),
+        [this]() { return !monitoring_; });
   }
   std::cout << "\n";
 }
+
+void ResourceMonitoring::displayCgroupPanel() {
+  if (!cgroupMonitor_.isAvailable()) {
+    return;
+  }
+
+  cgroupMonitor_.refresh();
+  std::vector<CgroupStats> top =
+      cgroupMonitor_.getTopCgroups(CGROUP_PANEL_ROWS);
+
+  std::cout << "\n" << CGROUP_PANEL_HEADER;
+  std::cout << RESOURCE_MONITORING_SEPARATOR;
+  std::cout << std::left << std::setw(CGROUP_VALUE_WIDTH) << "CPU%"
+            << std::setw(CGROUP_VALUE_WIDTH) << "Memory"
+            << std::setw(CGROUP_VALUE_WIDTH) << "Read/s"
+            << std::setw(CGROUP_VALUE_WIDTH) << "Write/s"
+            << std::setw(CGROUP_PRESSURE_WIDTH) << "CPU-PSI"
+            << std::setw(CGROUP_PRESSURE_WIDTH) << "Mem-PSI"
+            << std::setw(CGROUP_PRESSURE_WIDTH) << "IO-PSI" << "Path"
+            << CLEAR_LINE << "\n";
+
+  // Always print the same number of rows so the panel is redrawn in place
+  for (size_t i = 0; i < CGROUP_PANEL_ROWS; ++i) {
+    if (i < top.size()) {
+      CgroupStats &stats = top[i];
+      std::cout << std::setw(CGROUP_VALUE_WIDTH) << std::fixed
+                << std::setprecision(2) << stats.cpuUsage
+                << std::setw(CGROUP_VALUE_WIDTH)
+                << (stats.hasMemory ? DisplayFormat::bytes(stats.memoryCurrent)
+                                    : "-")
+                << std::setw(CGROUP_VALUE_WIDTH)
+                << DisplayFormat::bytes(
+                       static_cast<unsigned long long>(stats.ioReadRate))
+                << std::setw(CGROUP_VALUE_WIDTH)
+                << DisplayFormat::bytes(
+                       static_cast<unsigned long long>(stats.ioWriteRate));
+      if (cgroupMonitor_.readPressure(stats)) {
+        std::cout << std::setw(CGROUP_PRESSURE_WIDTH) << stats.cpuPressure
+                  << std::setw(CGROUP_PRESSURE_WIDTH) << stats.memoryPressure
+                  << std::setw(CGROUP_PRESSURE_WIDTH) << stats.ioPressure;
+      } else {
+        std::cout << std::setw(CGROUP_PRESSURE_WIDTH) << "-"
+                  << std::setw(CGROUP_PRESSURE_WIDTH) << "-"
+                  << std::setw(CGROUP_PRESSURE_WIDTH) << "-";
+      }
+      std::cout << stats.path;
+    }
+    std::cout << CLEAR_LINE << "\n";
+  }
+}
+
+void ResourceMonitoring::displayPressurePanel() {
+  if (!pressureAvailable_) {
+    return;
+  }
+
+  std::cout << "\n" << PRESSURE_PANEL_HEADER;
+  std::cout << RESOURCE_MONITORING_SEPARATOR;
+  std::cout << std::left << std::setw(PRESSURE_LABEL_WIDTH) << "Resource"
+            << std::setw(PRESSURE_VALUE_WIDTH) << "Some 10s"
+            << std::setw(PRESSURE_VALUE_WIDTH) << "Some 60s"
+            << std::setw(PRESSURE_VALUE_WIDTH) << "Full 10s"
+            << std::setw(PRESSURE_VALUE_WIDTH) << "Full 60s" << CLEAR_LINE
+            << "\n";
+
+  for (size_t i = 0; i < PressureMonitoring::RESOURCE_COUNT; ++i) {
+    auto resource = static_cast<PressureResource>(i);
+    std::cout << std::setw(PRESSURE_LABEL_WIDTH)
+              << PressureMonitoring::resourceName(resource);
+    ProcPressure pressure;
+    if (PressureMonitoring::readSystem(resource, pressure)) {
+      std::cout << std::fixed << std::setprecision(2)
+                << std::setw(PRESSURE_VALUE_WIDTH) << pressure.some.avg10
+                << std::setw(PRESSURE_VALUE_WIDTH) << pressure.some.avg60;
+      if (pressure.hasFull) {
+        std::cout << std::setw(PRESSURE_VALUE_WIDTH) << pressure.full.avg10
+                  << std::setw(PRESSURE_VALUE_WIDTH) << pressure.full.avg60;
+      }
+    }
+    std::cout << CLEAR_LINE << "\n";
+  }
+
+  PressureResource last = PressureResource::Cpu;
+  std::chrono::steady_clock::time_point lastAt;
+  uint64_t stalls = pressureMonitor_.getStalls(last, lastAt);
+  std::cout << "Stall events: ";
+  if (!pressureMonitor_.isArmed()) {
+    std::cout << "no triggers (needs root)";
+  } else if (stalls == 0) {
+    std::cout << "none";
+  } else {
+    auto ago = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - lastAt);
+    std::cout << stalls << ", last " << PressureMonitoring::resourceName(last)
+              << " " << ago.count() << " s ago";
+  }
+  std::cout << CLEAR_LINE << "\n" << std::right;
+}
+
+void ResourceMonitoring::displayDevicePanels() {
+  if (!deviceMonitor_.sample()) {
+    return;
+  }
+
+  std::vector<DiskStats> disks = deviceMonitor_.getTopDisks(DEVICE_PANEL_ROWS);
+  std::cout << "\n" << DISK_PANEL_HEADER;
+  std::cout << RESOURCE_MONITORING_SEPARATOR;
+  std::cout << std::left << std::setw(DEVICE_VALUE_WIDTH) << "Device"
+            << std::setw(DEVICE_VALUE_WIDTH) << "Reads/s"
+            << std::setw(DEVICE_VALUE_WIDTH) << "Writes/s"
+            << std::setw(DEVICE_VALUE_WIDTH) << "Read/s"
+            << std::setw(DEVICE_VALUE_WIDTH) << "Write/s"
+            << std::setw(DEVICE_VALUE_WIDTH) << "Util%"
+            << std::setw(DEVICE_VALUE_WIDTH) << "Await ms" << CLEAR_LINE
+            << "\n";
+  for (size_t i = 0; i < DEVICE_PANEL_ROWS; ++i) {
+    if (i < disks.size()) {
+      const DiskStats &disk = disks[i];
+      std::cout << std::setw(DEVICE_VALUE_WIDTH) << disk.name << std::fixed
+                << std::setprecision(1) << std::setw(DEVICE_VALUE_WIDTH)
+                << disk.readIops << std::setw(DEVICE_VALUE_WIDTH)
+                << disk.writeIops << std::setw(DEVICE_VALUE_WIDTH)
+                << DisplayFormat::bytes(
+                       static_cast<unsigned long long>(disk.readRate))
+                << std::setw(DEVICE_VALUE_WIDTH)
+                << DisplayFormat::bytes(
+                       static_cast<unsigned long long>(disk.writeRate))
+                << std::setw(DEVICE_VALUE_WIDTH) << disk.utilization
+                << std::setprecision(2) << disk.awaitMs;
+    }
+    std::cout << CLEAR_LINE << "\n";
+  }
+
+  std::vector<NetStats> interfaces =
+      deviceMonitor_.getTopInterfaces(DEVICE_PANEL_ROWS);
+  std::cout << "\n" << NETWORK_PANEL_HEADER;
+  std::cout << RESOURCE_MONITORING_SEPARATOR;
+  std::cout << std::setw(DEVICE_VALUE_WIDTH) << "Interface"
+            << std::setw(DEVICE_VALUE_WIDTH) << "Rx/s"
+            << std::setw(DEVICE_VALUE_WIDTH) << "Tx/s"
+            << std::setw(DEVICE_VALUE_WIDTH) << "RxPkt/s"
+            << std::setw(DEVICE_VALUE_WIDTH) << "TxPkt/s"
+            << std::setw(DEVICE_VALUE_WIDTH) << "Drops/s" << CLEAR_LINE
+            << "\n";
+  for (size_t i = 0; i < DEVICE_PANEL_ROWS; ++i) {
+    if (i < interfaces.size()) {
+      const NetStats &interface = interfaces[i];
+      std::cout << std::setw(DEVICE_VALUE_WIDTH) << interface.name
+                << std::setw(DEVICE_VALUE_WIDTH)
+                << DisplayFormat::bytes(
+                       static_cast<unsigned long long>(interface.rxRate))
+                << std::setw(DEVICE_VALUE_WIDTH)
+                << DisplayFormat::bytes(
+                       static_cast<unsigned long long>(interface.txRate))
+                << std::fixed << std::setprecision(1)
+                << std::setw(DEVICE_VALUE_WIDTH) << interface.rxPackets
+                << std::setw(DEVICE_VALUE_WIDTH) << interface.txPackets
+                << interface.drops;
+    }
+    std::cout << CLEAR_LINE << "\n";
+  }
+  std::cout << std::right;
+}
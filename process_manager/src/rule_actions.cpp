@@ -0,0 +1,63 @@
+// src/rule_actions.cpp
+
+#include "../include/logger.h"
+#include "../include/rule_engine.h"
+
+#include <sys/resource.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+void RuleActions::execute(const Rule &rule, const RuleFiring &firing,
+                          const std::string &name, bool dryRun) {
+  Logger logger;
+  std::ostringstream subject;
+  subject << "Rule '" << rule.name << "' fired for ";
+  if (rule.scope == RuleScope::System) {
+    subject << "the system";
+  } else {
+    subject << "PID " << firing.pid << " (" << name << ")";
+  }
+  subject << ": " << RuleEngine::metricName(rule.metric) << " = "
+          << std::fixed << std::setprecision(2) << firing.value << " ["
+          << rule.text << "]";
+
+  std::cerr << subject.str() << '\n';
+  for (const RuleAction &action : rule.actions) {
+    std::string target = "PID " + std::to_string(firing.pid);
+    switch (action.type) {
+    case RuleActionType::Log:
+      logger.logWarning(subject.str());
+      break;
+    case RuleActionType::Renice:
+      if (dryRun) {
+        logger.logAction("Dry run: would renice " + target + " to " +
+                         std::to_string(action.argument));
+      } else if (setpriority(PRIO_PROCESS, static_cast<id_t>(firing.pid),
+                             action.argument) != 0) {
+        logger.logError("Rule '" + rule.name + "' failed to renice " + target +
+                        ": " + std::strerror(errno));
+      } else {
+        logger.logAction("Rule '" + rule.name + "' reniced " + target +
+                         " to " + std::to_string(action.argument));
+      }
+      break;
+    case RuleActionType::Kill:
+      if (dryRun) {
+        logger.logAction("Dry run: would send signal " +
+                         std::to_string(action.argument) + " to " + target);
+      } else if (kill(firing.pid, action.argument) != 0) {
+        logger.logError("Rule '" + rule.name + "' failed to signal " + target +
+                        ": " + std::strerror(errno));
+      } else {
+        logger.logAction("Rule '" + rule.name + "' sent signal " +
+                         std::to_string(action.argument) + " to " + target);
+      }
+      break;
+    }
+  }
+}
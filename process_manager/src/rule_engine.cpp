@@ -0,0 +1,581 @@
+// src/rule_engine.cpp
+
+#include "../include/rule_engine.h"
+
+#include <signal.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+const int DEFAULT_RENICE = 10;     // Niceness of `renice` without a value
+const int MIN_NICE = -20;          // Highest priority
+const int MAX_NICE = 19;           // Lowest priority
+const int MAX_SIGNAL = 64;         // Highest signal number accepted
+const char COMMENT = '#';          // Starts a comment
+const size_t GROUP_DIRECTIONS = 2; // Rising and falling instructions
+const double MAX_DURATION_MS = 7 * 24 * 60 * 60 * 1000.0; // A week
+
+/// Metric names as written in rules, indexed by `RuleMetric`
+const char *METRIC_NAMES[RULE_METRIC_COUNT] = {"cpu", "mem", "rss",
+                                               "threads"};
+
+/// Signals accepted by name, without the `SIG` prefix
+const struct {
+  const char *name;
+  int number;
+} SIGNALS[] = {{"HUP", SIGHUP},   {"INT", SIGINT},   {"QUIT", SIGQUIT},
+               {"KILL", SIGKILL}, {"USR1", SIGUSR1}, {"USR2", SIGUSR2},
+               {"TERM", SIGTERM}, {"CONT", SIGCONT}, {"STOP", SIGSTOP}};
+
+/**
+ * @brief Splits a rule into words, numbers and operators.
+ *
+ * Parentheses, commas and colons are tokens of their own, as are the
+ * comparison operators and `->`.
+ */
+std::vector<std::string> tokenize(const std::string &text) {
+  std::vector<std::string> tokens;
+  size_t i = 0;
+  while (i < text.size()) {
+    char c = text[i];
+    if (std::isspace(static_cast<unsigned char>(c))) {
+      ++i;
+    } else if (c == '(' || c == ')' || c == ',' || c == ':') {
+      tokens.emplace_back(1, c);
+      ++i;
+    } else if (c == '-' && i + 1 < text.size() && text[i + 1] == '>') {
+      tokens.emplace_back("->");
+      i += 2;
+    } else if (c == '<' || c == '>') {
+      bool equal = i + 1 < text.size() && text[i + 1] == '=';
+      tokens.emplace_back(text, i, equal ? 2 : 1);
+      i += equal ? 2 : 1;
+    } else {
+      size_t start = i;
+      while (i < text.size() &&
+             !std::isspace(static_cast<unsigned char>(text[i])) &&
+             std::string_view("(),:<>").find(text[i]) ==
+                 std::string_view::npos &&
+             text.compare(i, 2, "->") != 0) {
+        ++i;
+      }
+      tokens.emplace_back(text, start, i - start);
+    }
+  }
+  return tokens;
+}
+
+/**
+ * @brief Parses a number with an optional unit suffix.
+ *
+ * `%` is ignored; `K`, `M`, `G` and `T` (optionally followed by `B`) scale
+ * by powers of 1024 and are only accepted for byte values.
+ */
+bool parseValue(const std::string &text, bool bytes, double &value) {
+  // Unlike strtod, no hexadecimal; `nan` and `inf` parse but never compare
+  // as meant
+  auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc() || !std::isfinite(value)) {
+    return false;
+  }
+  std::string suffix(end, text.data() + text.size());
+  for (char &c : suffix) {
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  }
+  if (suffix.size() == 2 && suffix[1] == 'B') {
+    suffix.pop_back();
+  }
+  if (suffix.empty() || (suffix == "%" && !bytes)) {
+    return true;
+  }
+  const std::string units = "KMGT";
+  size_t power = units.find(suffix);
+  if (!bytes || suffix.size() != 1 || power == std::string::npos) {
+    return false;
+  }
+  for (size_t i = 0; i <= power; ++i) {
+    value *= 1024;
+  }
+  return std::isfinite(value);
+}
+
+/**
+ * @brief Parses a duration such as `500ms`, `30s`, `5m` or `1h`.
+ */
+bool parseDuration(const std::string &text, std::chrono::milliseconds &value) {
+  double amount = 0;
+  auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), amount);
+  if (error != std::errc() || !std::isfinite(amount) || amount < 0) {
+    return false;
+  }
+  std::string unit(end, text.data() + text.size());
+  double scale = 0;
+  if (unit == "ms") {
+    scale = 1;
+  } else if (unit == "s" || unit.empty()) {
+    scale = 1000;
+  } else if (unit == "m") {
+    scale = 60 * 1000;
+  } else if (unit == "h") {
+    scale = 60 * 60 * 1000;
+  } else {
+    return false;
+  }
+  // Bounded before the conversion, which is undefined when out of range
+  if (amount * scale > MAX_DURATION_MS) {
+    return false;
+  }
+  value = std::chrono::milliseconds(static_cast<long long>(amount * scale));
+  return true;
+}
+
+/**
+ * @brief Parses a signal name (`TERM`, `SIGTERM`) or number.
+ */
+bool parseSignal(const std::string &text, int &signal) {
+  std::string name = text;
+  for (char &c : name) {
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  }
+  if (name.rfind("SIG", 0) == 0) {
+    name.erase(0, 3);
+  }
+  for (const auto &entry : SIGNALS) {
+    if (name == entry.name) {
+      signal = entry.number;
+      return true;
+    }
+  }
+  char *end = nullptr;
+  long number = std::strtol(text.c_str(), &end, 10);
+  if (text.empty() || *end != '\0' || number < 1 || number > MAX_SIGNAL) {
+    return false;
+  }
+  signal = static_cast<int>(number);
+  return true;
+}
+
+/**
+ * @brief Parses an integer, e.g. a niceness.
+ */
+bool parseInteger(const std::string &text, int &value) {
+  char *end = nullptr;
+  long parsed = std::strtol(text.c_str(), &end, 10);
+  if (text.empty() || *end != '\0') {
+    return false;
+  }
+  value = static_cast<int>(parsed);
+  return true;
+}
+
+/**
+ * @brief Returns whether a comparison fires above its threshold.
+ */
+bool rising(RuleComparison comparison) {
+  return comparison == RuleComparison::Greater ||
+         comparison == RuleComparison::GreaterEqual;
+}
+
+/**
+ * @brief Formats a number without a trailing fraction of zeros.
+ */
+std::string formatNumber(double value) {
+  std::ostringstream out;
+  out << std::setprecision(15) << value;
+  return out.str();
+}
+} // namespace
+
+bool RuleEngine::compile(const std::string &source, std::string &error) {
+  std::vector<Rule> rules;
+  std::istringstream lines(source);
+  std::string line;
+  size_t lineNumber = 0;
+  while (std::getline(lines, line)) {
+    ++lineNumber;
+    size_t comment = line.find(COMMENT);
+    if (comment != std::string::npos) {
+      line.erase(comment);
+    }
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+      continue;
+    }
+
+    // An optional `name:` comes before the metric
+    Rule rule;
+    std::string text = line;
+    size_t colon = line.find(':');
+    size_t paren = line.find('(');
+    if (colon != std::string::npos && colon < paren) {
+      std::vector<std::string> name = tokenize(line.substr(0, colon));
+      if (name.size() != 1) {
+        error = "line " + std::to_string(lineNumber) + ": invalid rule name";
+        return false;
+      }
+      rule.name = name[0];
+      text = line.substr(colon + 1);
+    } else {
+      rule.name = "rule" + std::to_string(lineNumber);
+    }
+    if (!compileRule(text, rule, error)) {
+      error = "line " + std::to_string(lineNumber) + ": " + error;
+      return false;
+    }
+    rules.push_back(std::move(rule));
+  }
+
+  // Lay the rules out as sorted instruction groups, see the class comment
+  rules_ = std::move(rules);
+  size_t slots = 2 * RULE_METRIC_COUNT * GROUP_DIRECTIONS;
+  program_.assign(slots, {});
+  clearProgram_.assign(slots, {});
+  for (uint32_t i = 0; i < rules_.size(); ++i) {
+    const Rule &rule = rules_[i];
+    bool inclusive = rule.comparison == RuleComparison::GreaterEqual ||
+                     rule.comparison == RuleComparison::LessEqual;
+    program_[slotOf(rule)].push_back({rule.threshold, i, inclusive});
+    if (rule.clear != rule.threshold) {
+      clearProgram_[slotOf(rule)].push_back({rule.clear, i, inclusive});
+    }
+  }
+  for (size_t slot = 0; slot < slots; ++slot) {
+    bool up = slot % GROUP_DIRECTIONS == 0;
+    auto order = [up](const Instruction &a, const Instruction &b) {
+      return up ? a.threshold < b.threshold : a.threshold > b.threshold;
+    };
+    std::stable_sort(program_[slot].begin(), program_[slot].end(), order);
+    std::stable_sort(clearProgram_[slot].begin(), clearProgram_[slot].end(),
+                     order);
+  }
+  firedCounts_.assign(slots, 0);
+  states_.clear();
+  return true;
+}
+
+bool RuleEngine::load(const std::string &path, std::string &error) {
+  std::ifstream file(path);
+  if (!file) {
+    error = "Cannot read rules from " + path;
+    return false;
+  }
+  std::ostringstream source;
+  source << file.rdbuf();
+  if (!compile(source.str(), error)) {
+    error = path + ", " + error;
+    return false;
+  }
+  return true;
+}
+
+bool RuleEngine::compileRule(const std::string &text, Rule &rule,
+                             std::string &error) {
+  std::vector<std::string> tokens = tokenize(text);
+  size_t next = 0;
+  auto take = [&tokens, &next]() -> std::string {
+    return next < tokens.size() ? tokens[next++] : std::string();
+  };
+
+  // metric(scope)
+  std::string metric = take();
+  auto known = std::find(std::begin(METRIC_NAMES), std::end(METRIC_NAMES),
+                         metric);
+  if (known == std::end(METRIC_NAMES)) {
+    error = "unknown metric '" + metric + "'";
+    return false;
+  }
+  rule.metric = static_cast<RuleMetric>(known - std::begin(METRIC_NAMES));
+  std::string scope;
+  if (take() != "(" || (scope = take()).empty() || take() != ")") {
+    error = "expected '" + metric + "(pid)' or '" + metric + "(system)'";
+    return false;
+  }
+  if (scope == "pid") {
+    rule.scope = RuleScope::Process;
+  } else if (scope == "system") {
+    rule.scope = RuleScope::System;
+    if (rule.metric != RuleMetric::Cpu && rule.metric != RuleMetric::Memory) {
+      error = "'" + metric + "' is only available per process";
+      return false;
+    }
+  } else {
+    error = "unknown scope '" + scope + "'";
+    return false;
+  }
+
+  // comparison threshold
+  std::string comparison = take();
+  if (comparison == ">") {
+    rule.comparison = RuleComparison::Greater;
+  } else if (comparison == ">=") {
+    rule.comparison = RuleComparison::GreaterEqual;
+  } else if (comparison == "<") {
+    rule.comparison = RuleComparison::Less;
+  } else if (comparison == "<=") {
+    rule.comparison = RuleComparison::LessEqual;
+  } else {
+    error = "expected a comparison after '" + metric + "(" + scope + ")'";
+    return false;
+  }
+  bool bytes = rule.metric == RuleMetric::Rss;
+  std::string threshold = take();
+  if (!parseValue(threshold, bytes, rule.threshold)) {
+    error = "invalid threshold '" + threshold + "'";
+    return false;
+  }
+  rule.clear = rule.threshold;
+
+  // [for DURATION] [clear VALUE] -> actions
+  std::string word = take();
+  if (word == "for") {
+    std::string duration = take();
+    if (!parseDuration(duration, rule.duration)) {
+      error = "invalid duration '" + duration + "'";
+      return false;
+    }
+    word = take();
+  }
+  if (word == "clear") {
+    std::string clear = take();
+    if (!parseValue(clear, bytes, rule.clear)) {
+      error = "invalid clear value '" + clear + "'";
+      return false;
+    }
+    if (rising(rule.comparison) ? rule.clear > rule.threshold
+                                : rule.clear < rule.threshold) {
+      error = "the clear value must be on the other side of the threshold";
+      return false;
+    }
+    word = take();
+  }
+  if (word != "->") {
+    error = "expected '->' before the actions";
+    return false;
+  }
+
+  do {
+    RuleAction action;
+    std::string name = take();
+    if (name == "log") {
+      action.type = RuleActionType::Log;
+    } else if (name == "renice") {
+      action.type = RuleActionType::Renice;
+      action.argument = DEFAULT_RENICE;
+      if (next < tokens.size() && tokens[next] != ",") {
+        std::string value = take();
+        if (!parseInteger(value, action.argument) ||
+            action.argument < MIN_NICE || action.argument > MAX_NICE) {
+          error = "invalid niceness '" + value + "'";
+          return false;
+        }
+      }
+    } else if (name == "kill") {
+      action.type = RuleActionType::Kill;
+      action.argument = SIGTERM;
+      if (next < tokens.size() && tokens[next] != ",") {
+        std::string value = take();
+        if (!parseSignal(value, action.argument)) {
+          error = "invalid signal '" + value + "'";
+          return false;
+        }
+      }
+    } else {
+      error = name.empty() ? "expected an action"
+                           : "unknown action '" + name + "'";
+      return false;
+    }
+    if (action.type != RuleActionType::Log &&
+        rule.scope == RuleScope::System) {
+      error = "'" + name + "' needs a process; use 'log' for system rules";
+      return false;
+    }
+    rule.actions.push_back(action);
+    if (next < tokens.size() && tokens[next] != ",") {
+      error = "unexpected '" + tokens[next] + "' after the actions";
+      return false;
+    }
+  } while (!take().empty());
+
+  rule.text = describe(rule);
+  return true;
+}
+
+size_t RuleEngine::slotOf(const Rule &rule) {
+  return group(rule.scope, rule.metric, rising(rule.comparison));
+}
+
+size_t RuleEngine::group(RuleScope scope, RuleMetric metric, bool rising) {
+  return ((static_cast<size_t>(scope) * RULE_METRIC_COUNT) +
+          static_cast<size_t>(metric)) *
+             GROUP_DIRECTIONS +
+         (rising ? 0 : 1);
+}
+
+void RuleEngine::evaluate(std::chrono::steady_clock::time_point now,
+                          const std::vector<ProcessInfo> &processes,
+                          const RuleSystemSample &system,
+                          std::vector<RuleFiring> &firings) {
+  firings.clear();
+  if (rules_.empty()) {
+    return;
+  }
+  ++generation_;
+  now_ = now;
+
+  for (size_t index = 0; index < processes.size(); ++index) {
+    const ProcessInfo &info = processes[index];
+    index_ = index;
+    startTime_ = info.startTime;
+    if ((info.collected & PROC_SOURCE_STAT) != 0) {
+      runMetric(RuleScope::Process, RuleMetric::Cpu, info.cpuUsage,
+                info.pid);
+      runMetric(RuleScope::Process, RuleMetric::Threads,
+                static_cast<double>(info.threads), info.pid);
+    }
+    if ((info.collected & PROC_SOURCE_STATM) != 0) {
+      runMetric(RuleScope::Process, RuleMetric::Memory, info.memoryUsage,
+                info.pid);
+      runMetric(RuleScope::Process, RuleMetric::Rss,
+                static_cast<double>(info.rssKb) * 1024, info.pid);
+    }
+  }
+  index_ = 0;
+  startTime_ = 0;
+  runMetric(RuleScope::System, RuleMetric::Cpu, system.cpuUsage, 0);
+  runMetric(RuleScope::System, RuleMetric::Memory, system.memoryUsage, 0);
+
+  // Only pairs whose condition held or whose rule fired have a state, so
+  // this loop is as short as the list of current matches
+  for (auto it = states_.begin(); it != states_.end();) {
+    State &state = it->second;
+    auto rule = static_cast<uint32_t>(it->first >> 32);
+    if (state.matched == generation_) {
+      if (!state.fired && now - state.since >= rules_[rule].duration) {
+        state.fired = true;
+        ++firedCounts_[slotOf(rules_[rule])];
+        firings.push_back({rule, static_cast<int>(it->first & 0xffffffff),
+                           state.value, state.process});
+      }
+      ++it;
+    } else if (state.fired && state.held == generation_) {
+      ++it;
+    } else {
+      if (state.fired) {
+        --firedCounts_[slotOf(rules_[rule])];
+      }
+      it = states_.erase(it);
+    }
+  }
+}
+
+void RuleEngine::runMetric(RuleScope scope, RuleMetric metric, double value,
+                           int pid) {
+  run(group(scope, metric, true), value, pid);
+  run(group(scope, metric, false), value, pid);
+}
+
+void RuleEngine::run(size_t slot, double value, int pid) {
+  bool up = slot % GROUP_DIRECTIONS == 0;
+  for (const Instruction &instruction : program_[slot]) {
+    // Sorted by threshold, so the first miss ends the group
+    if (up ? value < instruction.threshold : value > instruction.threshold) {
+      break;
+    }
+    if (value == instruction.threshold && !instruction.inclusive) {
+      continue;
+    }
+    auto [it, added] = states_.try_emplace(key(instruction.rule, pid));
+    State &state = it->second;
+    if (added || state.startTime != startTime_) {
+      // A new process reusing the PID starts its own episode
+      if (state.fired) {
+        --firedCounts_[slot];
+      }
+      state = State{};
+      state.since = now_;
+      state.startTime = startTime_;
+    }
+    state.matched = generation_;
+    state.held = generation_;
+    state.value = value;
+    state.process = index_;
+  }
+
+  // Clear values only matter while a rule of the group has fired
+  if (firedCounts_[slot] == 0) {
+    return;
+  }
+  for (const Instruction &instruction : clearProgram_[slot]) {
+    if (up ? value < instruction.threshold : value > instruction.threshold) {
+      break;
+    }
+    if (value == instruction.threshold && !instruction.inclusive) {
+      continue;
+    }
+    auto it = states_.find(key(instruction.rule, pid));
+    if (it != states_.end() && it->second.fired &&
+        it->second.startTime == startTime_) {
+      it->second.held = generation_;
+    }
+  }
+}
+
+unsigned RuleEngine::requiredSources() const {
+  unsigned sources = PROC_SOURCE_NONE;
+  for (const Rule &rule : rules_) {
+    if (rule.scope != RuleScope::Process) {
+      continue;
+    }
+    sources |= rule.metric == RuleMetric::Cpu ||
+                       rule.metric == RuleMetric::Threads
+                   ? PROC_SOURCE_STAT
+                   : PROC_SOURCE_STATM;
+  }
+  return sources;
+}
+
+const char *RuleEngine::metricName(RuleMetric metric) {
+  return METRIC_NAMES[static_cast<size_t>(metric)];
+}
+
+std::string RuleEngine::describe(const Rule &rule) {
+  static const char *const COMPARISONS[] = {">", ">=", "<", "<="};
+  std::string text = std::string(metricName(rule.metric)) + "(" +
+                     (rule.scope == RuleScope::Process ? "pid" : "system") +
+                     ") " + COMPARISONS[static_cast<size_t>(rule.comparison)] +
+                     " " + formatNumber(rule.threshold);
+  long long milliseconds = rule.duration.count();
+  if (milliseconds > 0) {
+    text += " for " + (milliseconds % 1000 == 0
+                           ? std::to_string(milliseconds / 1000) + "s"
+                           : std::to_string(milliseconds) + "ms");
+  }
+  if (rule.clear != rule.threshold) {
+    text += " clear " + formatNumber(rule.clear);
+  }
+  text += " ->";
+  for (size_t i = 0; i < rule.actions.size(); ++i) {
+    const RuleAction &action = rule.actions[i];
+    text += i == 0 ? " " : ", ";
+    switch (action.type) {
+    case RuleActionType::Log:
+      text += "log";
+      break;
+    case RuleActionType::Renice:
+      text += "renice " + std::to_string(action.argument);
+      break;
+    case RuleActionType::Kill:
+      text += "kill " + std::to_string(action.argument);
+      break;
+    }
+  }
+  return text;
+}
@@ -0,0 +1,70 @@
+// src/scan_arena.cpp
+
+#include "../include/scan_arena.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+const size_t GROWTH_SLACK_DIVISOR = 8; // Extra 1/8 for alignment padding
+} // namespace
+
+ScanArena::ScanArena(size_t initialSize) : nextCapacity_(initialSize) {}
+
+void ScanArena::reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (arena_ && epochBytes_ > capacity_) {
+    // The epoch spilled to the heap; size the next buffer for it
+    ++overflows_;
+    nextCapacity_ = std::max(
+        nextCapacity_,
+        std::bit_ceil(epochBytes_ + epochBytes_ / GROWTH_SLACK_DIVISOR));
+  }
+  if (!arena_ || capacity_ != nextCapacity_) {
+    rebuild();
+  } else {
+    arena_->release(); // Frees any overflow and rewinds to the buffer
+  }
+  epochBytes_ = 0;
+}
+
+size_t ScanArena::epochBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return epochBytes_;
+}
+
+size_t ScanArena::capacity() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return capacity_;
+}
+
+size_t ScanArena::overflows() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return overflows_;
+}
+
+void ScanArena::rebuild() {
+  arena_.reset();
+  // Not value-initialized: the arena never reads memory it has not handed out
+  buffer_.reset(new std::byte[nextCapacity_]);
+  capacity_ = nextCapacity_;
+  arena_.emplace(buffer_.get(), capacity_, std::pmr::new_delete_resource());
+}
+
+void *ScanArena::do_allocate(size_t bytes, size_t alignment) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!arena_) {
+    rebuild();
+  }
+  epochBytes_ += bytes;
+  return arena_->allocate(bytes, alignment);
+}
+
+void ScanArena::do_deallocate(void *, size_t, size_t) {
+  // Memory is only reclaimed by `reset`
+}
+
+bool ScanArena::do_is_equal(
+    const std::pmr::memory_resource &other) const noexcept {
+  return this == &other;
+}
@@ -0,0 +1,387 @@
+// src/self_stats.cpp
+
+#include "../include/self_stats.h"
+#include "../include/display_format.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+namespace {
+const int SMALLEST_BUCKET_BITS = 7; // Bucket 0 holds values below 2^7 ns
+const int DURATION_PRECISION = 1;   // Digits after the point for durations
+const int COUNTER_WIDTH = 22;       // Width of the name columns
+const int VALUE_WIDTH = 12;         // Width of the value columns
+
+const char *COUNTER_NAMES[SELF_COUNTER_COUNT] = {
+    "scans",   "processes_scanned", "files_opened", "bytes_read",
+    "syscalls", "pool_tasks",       "log_messages"};
+const char *GAUGE_NAMES[SELF_GAUGE_COUNT] = {"pool_queue_depth",
+                                             "logger_queue_depth"};
+const char *TIMER_NAMES[SELF_TIMER_COUNT] = {
+    "enumerate", "read", "parse", "compute", "render", "pool_wait",
+    "log_write"};
+
+/**
+ * @brief The counters and histograms of one thread.
+ *
+ * Only the owning thread writes; relaxed atomics let `snapshot` read them
+ * concurrently without a data race.
+ */
+struct Shard {
+  struct Timer {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+    std::atomic<uint64_t> buckets[SELF_HISTOGRAM_BUCKETS] = {};
+  };
+
+  std::atomic<uint64_t> counters[SELF_COUNTER_COUNT] = {};
+  Timer timers[SELF_TIMER_COUNT];
+};
+
+/**
+ * @brief The live shards, the totals of exited threads and the gauges.
+ */
+struct Registry {
+  std::mutex mutex;
+  std::vector<Shard *> live;
+  Shard retired;
+  std::atomic<int64_t> gauges[SELF_GAUGE_COUNT] = {};
+  std::atomic<int64_t> peaks[SELF_GAUGE_COUNT] = {};
+  std::chrono::steady_clock::time_point started =
+      std::chrono::steady_clock::now();
+};
+
+/**
+ * @brief Returns the registry, which is never destroyed so that threads
+ * exiting during static destruction can still retire their shards.
+ */
+Registry &registry() {
+  static Registry *instance = new Registry();
+  return *instance;
+}
+
+/// Creates the registry while the program starts, so `uptimeMs` covers the
+/// whole run
+[[maybe_unused]] const Registry &startup = registry();
+
+/**
+ * @brief Adds to a value only the calling thread writes.
+ */
+void bump(std::atomic<uint64_t> &value, uint64_t amount) {
+  value.store(value.load(std::memory_order_relaxed) + amount,
+              std::memory_order_relaxed);
+}
+
+/**
+ * @brief Adds the values of one shard to another.
+ */
+void fold(const Shard &from, Shard &into) {
+  for (size_t i = 0; i < SELF_COUNTER_COUNT; ++i) {
+    bump(into.counters[i], from.counters[i].load(std::memory_order_relaxed));
+  }
+  for (size_t i = 0; i < SELF_TIMER_COUNT; ++i) {
+    const Shard::Timer &source = from.timers[i];
+    Shard::Timer &target = into.timers[i];
+    bump(target.count, source.count.load(std::memory_order_relaxed));
+    bump(target.sum, source.sum.load(std::memory_order_relaxed));
+    target.max.store(std::max(target.max.load(std::memory_order_relaxed),
+                              source.max.load(std::memory_order_relaxed)),
+                     std::memory_order_relaxed);
+    for (size_t b = 0; b < SELF_HISTOGRAM_BUCKETS; ++b) {
+      bump(target.buckets[b],
+           source.buckets[b].load(std::memory_order_relaxed));
+    }
+  }
+}
+
+/**
+ * @brief Zeroes a shard.
+ */
+void clear(Shard &shard) {
+  for (auto &counter : shard.counters) {
+    counter.store(0, std::memory_order_relaxed);
+  }
+  for (Shard::Timer &timer : shard.timers) {
+    timer.count.store(0, std::memory_order_relaxed);
+    timer.sum.store(0, std::memory_order_relaxed);
+    timer.max.store(0, std::memory_order_relaxed);
+    for (auto &bucket : timer.buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+/**
+ * @brief Registers the shard of a thread and retires it when the thread
+ * exits.
+ */
+struct ShardOwner {
+  Shard shard;
+
+  ShardOwner() {
+    Registry &shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    shared.live.push_back(&shard);
+  }
+
+  ~ShardOwner() {
+    Registry &shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    fold(shard, shared.retired);
+    shared.live.erase(
+        std::find(shared.live.begin(), shared.live.end(), &shard));
+  }
+};
+
+/**
+ * @brief Returns the shard of the calling thread.
+ */
+Shard &localShard() {
+  thread_local ShardOwner owner;
+  return owner.shard;
+}
+
+/**
+ * @brief Formats a duration with a unit, e.g. `12.5 us`.
+ */
+std::string formatDuration(uint64_t nanoseconds) {
+  static const char *UNITS[] = {"ns", "us", "ms", "s"};
+  double value = static_cast<double>(nanoseconds);
+  size_t unit = 0;
+  while (value >= 1000.0 && unit + 1 < std::size(UNITS)) {
+    value /= 1000.0;
+    ++unit;
+  }
+  std::ostringstream text;
+  text << std::fixed << std::setprecision(unit == 0 ? 0 : DURATION_PRECISION)
+       << value << ' ' << UNITS[unit];
+  return text.str();
+}
+} // namespace
+
+uint64_t SelfHistogram::quantileNs(double quantile) const {
+  if (count == 0) {
+    return 0;
+  }
+  auto target = static_cast<uint64_t>(
+      std::ceil(quantile * static_cast<double>(count)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i + 1 < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= std::max<uint64_t>(target, 1)) {
+      return std::min(uint64_t{1} << (i + SMALLEST_BUCKET_BITS), maxNs);
+    }
+  }
+  return maxNs;
+}
+
+void SelfStats::add(SelfCounter counter, uint64_t value) {
+  bump(localShard().counters[static_cast<size_t>(counter)], value);
+}
+
+void SelfStats::record(SelfTimer timer, uint64_t nanoseconds) {
+  Shard::Timer &histogram = localShard().timers[static_cast<size_t>(timer)];
+  size_t bucket = 0;
+  if (nanoseconds >> SMALLEST_BUCKET_BITS != 0) {
+    bucket = std::min<size_t>(
+        static_cast<size_t>(std::bit_width(nanoseconds)) -
+            SMALLEST_BUCKET_BITS,
+        SELF_HISTOGRAM_BUCKETS - 1);
+  }
+  bump(histogram.count, 1);
+  bump(histogram.sum, nanoseconds);
+  bump(histogram.buckets[bucket], 1);
+  if (nanoseconds > histogram.max.load(std::memory_order_relaxed)) {
+    histogram.max.store(nanoseconds, std::memory_order_relaxed);
+  }
+}
+
+void SelfStats::adjust(SelfGauge gauge, int64_t delta) {
+  Registry &shared = registry();
+  size_t index = static_cast<size_t>(gauge);
+  int64_t value =
+      shared.gauges[index].fetch_add(delta, std::memory_order_relaxed) +
+      delta;
+  int64_t peak = shared.peaks[index].load(std::memory_order_relaxed);
+  while (value > peak && !shared.peaks[index].compare_exchange_weak(
+                             peak, value, std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t SelfStats::now() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+SelfStatsSnapshot SelfStats::snapshot() {
+  Registry &shared = registry();
+  Shard total;
+  {
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    fold(shared.retired, total);
+    for (const Shard *shard : shared.live) {
+      fold(*shard, total);
+    }
+  }
+
+  SelfStatsSnapshot stats;
+  stats.uptimeMs = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - shared.started)
+          .count());
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    stats.cpuTimeUs = static_cast<uint64_t>(
+        (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL +
+        usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+    stats.maxRssKb = static_cast<uint64_t>(usage.ru_maxrss);
+  }
+
+  for (size_t i = 0; i < SELF_COUNTER_COUNT; ++i) {
+    stats.counters.emplace_back(
+        COUNTER_NAMES[i], total.counters[i].load(std::memory_order_relaxed));
+  }
+  for (size_t i = 0; i < SELF_GAUGE_COUNT; ++i) {
+    stats.gauges.push_back(
+        {GAUGE_NAMES[i], shared.gauges[i].load(std::memory_order_relaxed),
+         shared.peaks[i].load(std::memory_order_relaxed)});
+  }
+  for (size_t i = 0; i < SELF_TIMER_COUNT; ++i) {
+    const Shard::Timer &timer = total.timers[i];
+    SelfHistogram histogram;
+    histogram.name = TIMER_NAMES[i];
+    histogram.count = timer.count.load(std::memory_order_relaxed);
+    histogram.sumNs = timer.sum.load(std::memory_order_relaxed);
+    histogram.maxNs = timer.max.load(std::memory_order_relaxed);
+    for (const auto &bucket : timer.buckets) {
+      histogram.buckets.push_back(bucket.load(std::memory_order_relaxed));
+    }
+    stats.histograms.push_back(std::move(histogram));
+  }
+  return stats;
+}
+
+void SelfStats::reset() {
+  Registry &shared = registry();
+  std::lock_guard<std::mutex> lock(shared.mutex);
+  clear(shared.retired);
+  for (Shard *shard : shared.live) {
+    clear(*shard);
+  }
+  for (size_t i = 0; i < SELF_GAUGE_COUNT; ++i) {
+    shared.peaks[i].store(shared.gauges[i].load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+  }
+}
+
+void SelfStats::writeTable(std::ostream &out, const SelfStatsSnapshot &stats) {
+  out << "Uptime " << formatDuration(stats.uptimeMs * 1000000) << ", CPU time "
+      << formatDuration(stats.cpuTimeUs * 1000) << ", peak RSS "
+      << DisplayFormat::bytes(stats.maxRssKb * 1024) << "\n\n";
+
+  out << std::left << std::setw(COUNTER_WIDTH) << "Counter" << "Value\n";
+  for (const auto &[name, value] : stats.counters) {
+    out << std::setw(COUNTER_WIDTH) << name << value << '\n';
+  }
+
+  out << '\n'
+      << std::setw(COUNTER_WIDTH) << "Gauge" << std::setw(VALUE_WIDTH)
+      << "Current" << "Peak\n";
+  for (const SelfGaugeValue &gauge : stats.gauges) {
+    out << std::setw(COUNTER_WIDTH) << gauge.name << std::setw(VALUE_WIDTH)
+        << gauge.value << gauge.peak << '\n';
+  }
+
+  out << '\n' << std::setw(COUNTER_WIDTH) << "Latency";
+  for (const char *header : {"Count", "Mean", "p50", "p99", "Max"}) {
+    out << std::setw(VALUE_WIDTH) << header;
+  }
+  out << "Total\n";
+  for (const SelfHistogram &histogram : stats.histograms) {
+    uint64_t mean =
+        histogram.count == 0 ? 0 : histogram.sumNs / histogram.count;
+    out << std::setw(COUNTER_WIDTH) << histogram.name << std::setw(VALUE_WIDTH)
+        << histogram.count << std::setw(VALUE_WIDTH) << formatDuration(mean)
+        << std::setw(VALUE_WIDTH)
+        << formatDuration(histogram.quantileNs(0.5)) << std::setw(VALUE_WIDTH)
+        << formatDuration(histogram.quantileNs(0.99))
+        << std::setw(VALUE_WIDTH) << formatDuration(histogram.maxNs)
+        << formatDuration(histogram.sumNs) << '\n';
+  }
+}
+
+void SelfStats::writeJson(OutputBuffer &out, const SelfStatsSnapshot &stats) {
+  out.append("{\"uptime_ms\":");
+  out.appendNumber(static_cast<unsigned long long>(stats.uptimeMs));
+  out.append(",\"cpu_time_us\":");
+  out.appendNumber(static_cast<unsigned long long>(stats.cpuTimeUs));
+  out.append(",\"max_rss\":");
+  out.appendNumber(static_cast<unsigned long long>(stats.maxRssKb * 1024));
+  out.append(",\"counters\":{");
+  for (size_t i = 0; i < stats.counters.size(); ++i) {
+    if (i > 0) {
+      out.append(',');
+    }
+    out.appendJsonString(stats.counters[i].first);
+    out.append(':');
+    out.appendNumber(
+        static_cast<unsigned long long>(stats.counters[i].second));
+  }
+  out.append("},\"gauges\":{");
+  for (size_t i = 0; i < stats.gauges.size(); ++i) {
+    if (i > 0) {
+      out.append(',');
+    }
+    out.appendJsonString(stats.gauges[i].name);
+    out.append(":{\"value\":");
+    out.appendNumber(static_cast<long long>(stats.gauges[i].value));
+    out.append(",\"peak\":");
+    out.appendNumber(static_cast<long long>(stats.gauges[i].peak));
+    out.append('}');
+  }
+  out.append("},\"latency\":{");
+  for (size_t i = 0; i < stats.histograms.size(); ++i) {
+    const SelfHistogram &histogram = stats.histograms[i];
+    if (i > 0) {
+      out.append(',');
+    }
+    out.appendJsonString(histogram.name);
+    out.append(":{\"count\":");
+    out.appendNumber(static_cast<unsigned long long>(histogram.count));
+    out.append(",\"sum_ns\":");
+    out.appendNumber(static_cast<unsigned long long>(histogram.sumNs));
+    out.append(",\"p50_ns\":");
+    out.appendNumber(
+        static_cast<unsigned long long>(histogram.quantileNs(0.5)));
+    out.append(",\"p99_ns\":");
+    out.appendNumber(
+        static_cast<unsigned long long>(histogram.quantileNs(0.99)));
+    out.append(",\"max_ns\":");
+    out.appendNumber(static_cast<unsigned long long>(histogram.maxNs));
+    out.append('}');
+  }
+  out.append("}}");
+}
+
+const char *SelfStats::counterName(SelfCounter counter) {
+  return COUNTER_NAMES[static_cast<size_t>(counter)];
+}
+
+const char *SelfStats::gaugeName(SelfGauge gauge) {
+  return GAUGE_NAMES[static_cast<size_t>(gauge)];
+}
+
+const char *SelfStats::timerName(SelfTimer timer) {
+  return TIMER_NAMES[static_cast<size_t>(timer)];
+}
@@ -0,0 +1,230 @@
+// src/shm_snapshot.cpp
+
+#include "../include/shm_snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+namespace {
+const int MAX_COPY_ATTEMPTS = 16;  // Retries before `copy` gives up
+const uint64_t SLOT_ALIGNMENT = 64; // Slots start on a cache line
+
+/**
+ * @brief Returns the bytes of one slot, keeping slots cache-line aligned.
+ */
+uint64_t slotBytes(uint32_t capacity) {
+  uint64_t bytes =
+      sizeof(ShmSlotHeader) + uint64_t{capacity} * sizeof(ShmProcessRecord);
+  return (bytes + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+}
+
+/**
+ * @brief Returns the offset of the first slot.
+ */
+uint64_t firstSlotOffset() {
+  return (sizeof(ShmHeader) + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT *
+         SLOT_ALIGNMENT;
+}
+} // namespace
+
+ShmSnapshotWriter::ShmSnapshotWriter()
+    : mapping_(nullptr), size_(0), capacity_(0), writingSlot_(0) {}
+
+ShmSnapshotWriter::~ShmSnapshotWriter() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, size_);
+    shm_unlink(name_.c_str());
+  }
+}
+
+std::string ShmSnapshotWriter::defaultName() {
+  return "/process_manager-" + std::to_string(getuid());
+}
+
+bool ShmSnapshotWriter::create(const std::string &name, uint32_t capacity,
+                               std::string &error) {
+  if (name.size() < 2 || name[0] != '/' ||
+      name.find('/', 1) != std::string::npos) {
+    error = "Shared memory names look like '/name', got '" + name + "'";
+    return false;
+  }
+
+  // Readers of a previous segment keep their mapping; new readers get this
+  // one, which starts out with a zero magic until it is initialized
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    error = "Cannot create shared memory " + name + ": " + std::strerror(errno);
+    return false;
+  }
+  size_t size = firstSlotOffset() + SLOT_COUNT * slotBytes(capacity);
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    error = "Cannot size shared memory " + name + ": " + std::strerror(errno);
+    close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+  void *mapping =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    error = "Cannot map shared memory " + name + ": " + std::strerror(errno);
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  name_ = name;
+  mapping_ = mapping;
+  size_ = size;
+  capacity_ = capacity;
+
+  // The segment is zero-filled, so every slot starts empty with an even
+  // sequence; the header becomes visible to readers with the magic
+  auto *header = new (mapping_) ShmHeader();
+  header->version = SHM_SNAPSHOT_VERSION;
+  header->headerSize = sizeof(ShmHeader);
+  header->slotCount = SLOT_COUNT;
+  header->slotHeaderSize = sizeof(ShmSlotHeader);
+  header->recordSize = sizeof(ShmProcessRecord);
+  header->slotCapacity = capacity;
+  header->slotSize = slotBytes(capacity);
+  header->currentSlot.store(0, std::memory_order_relaxed);
+  header->writerPid.store(static_cast<uint32_t>(getpid()),
+                          std::memory_order_relaxed);
+  for (uint32_t i = 0; i < SLOT_COUNT; ++i) {
+    new (slot(i)) ShmSlotHeader();
+  }
+  header->magic.store(SHM_SNAPSHOT_MAGIC, std::memory_order_release);
+  return true;
+}
+
+ShmSlotHeader *ShmSnapshotWriter::slot(uint32_t index) const {
+  return reinterpret_cast<ShmSlotHeader *>(static_cast<char *>(mapping_) +
+                                           firstSlotOffset() +
+                                           index * slotBytes(capacity_));
+}
+
+ShmProcessRecord *ShmSnapshotWriter::beginWrite() {
+  auto *header = static_cast<ShmHeader *>(mapping_);
+  writingSlot_ =
+      (header->currentSlot.load(std::memory_order_relaxed) + 1) % SLOT_COUNT;
+  ShmSlotHeader *target = slot(writingSlot_);
+
+  // An odd sequence tells readers that the slot is being rewritten; the
+  // fence keeps the record stores below from moving above it
+  target->sequence.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  return reinterpret_cast<ShmProcessRecord *>(target + 1);
+}
+
+void ShmSnapshotWriter::commit(const ShmSystemSample &system) {
+  auto *header = static_cast<ShmHeader *>(mapping_);
+  ShmSlotHeader *target = slot(writingSlot_);
+  target->system = system;
+  if (target->system.recordCount > capacity_) {
+    target->system.recordCount = capacity_;
+  }
+  target->sequence.fetch_add(1, std::memory_order_release);
+  header->currentSlot.store(writingSlot_, std::memory_order_release);
+}
+
+ShmSnapshotReader::ShmSnapshotReader() : mapping_(nullptr), size_(0) {}
+
+ShmSnapshotReader::~ShmSnapshotReader() {
+  if (mapping_ != nullptr) {
+    munmap(const_cast<void *>(mapping_), size_);
+  }
+}
+
+bool ShmSnapshotReader::open(const std::string &name, std::string &error) {
+  int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+  if (fd < 0) {
+    error = "Cannot open shared memory " + name + ": " + std::strerror(errno);
+    return false;
+  }
+  struct stat info {};
+  if (fstat(fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < sizeof(ShmHeader)) {
+    error = "Shared memory " + name + " is not ready";
+    close(fd);
+    return false;
+  }
+  size_t size = static_cast<size_t>(info.st_size);
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    error = "Cannot map shared memory " + name + ": " + std::strerror(errno);
+    return false;
+  }
+
+  const auto *layout = static_cast<const ShmHeader *>(mapping);
+  bool compatible =
+      layout->magic.load(std::memory_order_acquire) == SHM_SNAPSHOT_MAGIC &&
+      layout->version == SHM_SNAPSHOT_VERSION &&
+      layout->headerSize == sizeof(ShmHeader) &&
+      layout->slotHeaderSize == sizeof(ShmSlotHeader) &&
+      layout->recordSize == sizeof(ShmProcessRecord) &&
+      layout->slotSize == slotBytes(layout->slotCapacity) &&
+      firstSlotOffset() + layout->slotCount * layout->slotSize <= size;
+  if (!compatible) {
+    error = "Shared memory " + name +
+            " is not ready or has an unsupported layout version";
+    munmap(mapping, size);
+    return false;
+  }
+  mapping_ = mapping;
+  size_ = size;
+  return true;
+}
+
+bool ShmSnapshotReader::acquire(ShmSnapshotView &view) const {
+  const ShmHeader *layout = header();
+  uint32_t index = layout->currentSlot.load(std::memory_order_acquire);
+  if (index >= layout->slotCount) {
+    return false;
+  }
+  const auto *slot = reinterpret_cast<const ShmSlotHeader *>(
+      static_cast<const char *>(mapping_) + firstSlotOffset() +
+      index * layout->slotSize);
+
+  view.sequence = slot->sequence.load(std::memory_order_acquire);
+  if ((view.sequence & 1) != 0) {
+    return false;
+  }
+  view.slot = slot;
+  view.system = &slot->system;
+  view.records = reinterpret_cast<const ShmProcessRecord *>(slot + 1);
+  view.recordCount = slot->system.recordCount < layout->slotCapacity
+                         ? slot->system.recordCount
+                         : layout->slotCapacity;
+  return true;
+}
+
+bool ShmSnapshotReader::validate(const ShmSnapshotView &view) const {
+  // Order every load made through the view before the sequence check
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return view.slot != nullptr &&
+         view.slot->sequence.load(std::memory_order_relaxed) == view.sequence;
+}
+
+bool ShmSnapshotReader::copy(ShmSystemSample &system,
+                             std::vector<ShmProcessRecord> &records) const {
+  for (int attempt = 0; attempt < MAX_COPY_ATTEMPTS; ++attempt) {
+    ShmSnapshotView view;
+    if (!acquire(view)) {
+      continue;
+    }
+    system = *view.system;
+    records.assign(view.records, view.records + view.recordCount);
+    if (validate(view)) {
+      return true;
+    }
+  }
+  return false;
+}
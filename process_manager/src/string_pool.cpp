@@ -0,0 +1,51 @@
+// src/string_pool.cpp
+
+#include "../include/string_pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+const size_t ARENA_BLOCK_SIZE = 64 * 1024; // Bytes per arena block
+} // namespace
+
+StringPool::StringPool() : blockUsed_(0), blockCapacity_(0), bytesUsed_(0) {
+  strings_.push_back(std::string_view());
+  ids_.emplace(std::string_view(), EMPTY_ID);
+}
+
+uint32_t StringPool::intern(std::string_view value) {
+  auto it = ids_.find(value);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+
+  std::string_view stored = store(value);
+  uint32_t id = static_cast<uint32_t>(strings_.size());
+  strings_.push_back(stored);
+  ids_.emplace(stored, id);
+  return id;
+}
+
+std::string_view StringPool::get(uint32_t id) const {
+  if (id >= strings_.size()) {
+    return std::string_view();
+  }
+  return strings_[id];
+}
+
+std::string_view StringPool::store(std::string_view value) {
+  if (blockUsed_ + value.size() > blockCapacity_) {
+    // Strings larger than a block get a block of their own
+    size_t capacity = std::max(ARENA_BLOCK_SIZE, value.size());
+    blocks_.push_back(std::make_unique<char[]>(capacity));
+    blockUsed_ = 0;
+    blockCapacity_ = capacity;
+  }
+
+  char *destination = blocks_.back().get() + blockUsed_;
+  std::memcpy(destination, value.data(), value.size());
+  blockUsed_ += value.size();
+  bytesUsed_ += value.size();
+  return std::string_view(destination, value.size());
+}
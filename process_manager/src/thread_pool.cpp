@@ -1,4 +1,5 @@
 #include "../include/thread_pool.h"
+#include "../include/worker_placement.h"
 #include <iostream>
 
 // Constructor initializes the thread pool with the given number of threads
@@ -11,11 +12,7 @@ ThreadPool::ThreadPool(size_t numThreads) : stop_(false), activeTasks_(0) {
 
 // Destructor: ensures all tasks are completed before destroying the pool
 ThreadPool::~ThreadPool() {
-  {
-    std::lock_guard<std::mutex> lock(tasksMutex_);
-    stop_ = true; // Set the stop flag to true
-  }
-  cv_.notify_all(); // Notify all threads to stop
+  stop();
 
   // Join all worker threads
   for (auto &worker : workers_) {
@@ -25,10 +22,20 @@ ThreadPool::~ThreadPool() {
   }
 }
 
+// Let the workers exit once the queue is empty
+void ThreadPool::stop() {
+  {
+    std::lock_guard<std::mutex> lock(tasksMutex_);
+    stop_ = true; // Set the stop flag to true
+  }
+  cv_.notify_all(); // Notify all threads to stop
+}
+
 // Worker thread function
 void ThreadPool::worker() {
+  WorkerPlacement::applyToCurrentThread();
   while (true) {
-    std::function<void()> task;
+    Task task;
     {
       std::unique_lock<std::mutex> lock(tasksMutex_);
 
@@ -42,20 +49,25 @@ void ThreadPool::worker() {
       task = std::move(tasks_.front()); // Get the next task
       tasks_.pop();                     // Remove the task from the queue
     }
+    SelfStats::adjust(SelfGauge::PoolQueueDepth, -1);
+    SelfStats::record(SelfTimer::PoolWait, SelfStats::now() - task.enqueuedAt);
+    SelfStats::add(SelfCounter::PoolTasks);
 
     // Execute the task outside the lock
-    task();
+    task.run();
 
     // After task completion, decrement the active task count
-    --activeTasks_;
+    {
+      std::lock_guard<std::mutex> lock(tasksMutex_);
+      if (--activeTasks_ == 0) {
+        idle_.notify_all();
+      }
+    }
   }
 }
 
 // Wait for all tasks to finish
 void ThreadPool::waitForAll() {
-  while (activeTasks_ > 0) {
-    // Wait until there are no active tasks
-    std::this_thread::sleep_for(
-        std::chrono::milliseconds(100)); // Sleep to avoid busy-waiting
-  }
+  std::unique_lock<std::mutex> lock(tasksMutex_);
+  idle_.wait(lock, [this] { return activeTasks_ == 0; });
 }
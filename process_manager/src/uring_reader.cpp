@@ -0,0 +1,325 @@
+// src/uring_reader.cpp
+
+#include "../include/uring_reader.h"
+#include "../include/self_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+const unsigned ENTRIES_PER_FILE = 3; // Open, read and close
+const uint64_t OP_OPEN = 0;          // Operation tags in `user_data`,
+const uint64_t OP_READ = 1;          // below the request index
+const uint64_t OP_CLOSE = 2;
+const unsigned OP_BITS = 2;     // Bits of the operation tag
+const unsigned PROBE_OPS = 256; // Operations the probe can list
+const int REQUIRED_OPS[] = {IORING_OP_OPENAT, IORING_OP_READ_FIXED,
+                            IORING_OP_CLOSE}; // Used by every request
+
+int ioUringSetup(unsigned entries, io_uring_params *params) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                 unsigned flags) {
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit,
+                                    minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, const void *arg,
+                    unsigned count) {
+  return static_cast<int>(
+      ::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+/**
+ * @brief Maps a part of the ring, or returns `nullptr`.
+ */
+void *mapRing(int fd, size_t size, off_t offset) {
+  void *memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, offset);
+  return memory == MAP_FAILED ? nullptr : memory;
+}
+
+/**
+ * @brief Returns a pointer into a mapped ring at a kernel-given offset.
+ */
+template <typename T> T *at(void *ring, uint32_t offset) {
+  return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+} // namespace
+
+UringReader::UringReader(unsigned capacity) {
+  if (setUp(capacity)) {
+    requests_.reserve(capacity_);
+  }
+}
+
+UringReader::~UringReader() { tearDown(); }
+
+bool UringReader::setUp(unsigned capacity) {
+  io_uring_params params{};
+  ringFd_ = ioUringSetup(capacity * ENTRIES_PER_FILE, &params);
+  if (ringFd_ == -1) {
+    error_ = std::string("io_uring_setup failed: ") + std::strerror(errno);
+    return false;
+  }
+
+  // Direct opens and registered buffers need a 5.15 kernel; the probe only
+  // tells which operations exist, so a kernel that rejects the direct open
+  // is detected by the first batch
+  size_t probeSize =
+      sizeof(io_uring_probe) + PROBE_OPS * sizeof(io_uring_probe_op);
+  std::unique_ptr<char[]> probeMemory(new char[probeSize]());
+  auto *probe = reinterpret_cast<io_uring_probe *>(probeMemory.get());
+  if (ioUringRegister(ringFd_, IORING_REGISTER_PROBE, probe, PROBE_OPS) !=
+      0) {
+    error_ = std::string("io_uring probe failed: ") + std::strerror(errno);
+    tearDown();
+    return false;
+  }
+  for (int op : REQUIRED_OPS) {
+    if (op > probe->last_op ||
+        (probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0) {
+      error_ = "io_uring lacks open, fixed read or close operations";
+      tearDown();
+      return false;
+    }
+  }
+
+  sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cqRingSize_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+    sqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    cqRingSize_ = 0;
+  }
+  sqRing_ = mapRing(ringFd_, sqRingSize_, IORING_OFF_SQ_RING);
+  cqRing_ = cqRingSize_ == 0
+                ? sqRing_
+                : mapRing(ringFd_, cqRingSize_, IORING_OFF_CQ_RING);
+  entriesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+  entries_ = static_cast<io_uring_sqe *>(
+      mapRing(ringFd_, entriesSize_, IORING_OFF_SQES));
+  if (sqRing_ == nullptr || cqRing_ == nullptr || entries_ == nullptr) {
+    error_ = std::string("Could not map the io_uring queues: ") +
+             std::strerror(errno);
+    tearDown();
+    return false;
+  }
+  sqHead_ = at<unsigned>(sqRing_, params.sq_off.head);
+  sqTail_ = at<unsigned>(sqRing_, params.sq_off.tail);
+  sqMask_ = at<unsigned>(sqRing_, params.sq_off.ring_mask);
+  sqArray_ = at<unsigned>(sqRing_, params.sq_off.array);
+  cqHead_ = at<unsigned>(cqRing_, params.cq_off.head);
+  cqTail_ = at<unsigned>(cqRing_, params.cq_off.tail);
+  cqMask_ = at<unsigned>(cqRing_, params.cq_off.ring_mask);
+  completions_ = at<io_uring_cqe>(cqRing_, params.cq_off.cqes);
+  sqLocalTail_ = *sqTail_;
+
+  // An empty file table: every request opens into and closes its own slot
+  std::vector<int> slots(capacity, -1);
+  buffers_.reset(new char[capacity * FILE_BUFFER_SIZE]);
+  paths_.reset(new char[capacity * PATH_SLOT_SIZE]);
+  iovec buffers{buffers_.get(), capacity * FILE_BUFFER_SIZE};
+  if (ioUringRegister(ringFd_, IORING_REGISTER_FILES, slots.data(),
+                      capacity) != 0 ||
+      ioUringRegister(ringFd_, IORING_REGISTER_BUFFERS, &buffers, 1) != 0) {
+    error_ = std::string("Could not register io_uring files and buffers: ") +
+             std::strerror(errno);
+    tearDown();
+    return false;
+  }
+  capacity_ = capacity;
+  return true;
+}
+
+void UringReader::tearDown() {
+  if (entries_ != nullptr) {
+    ::munmap(entries_, entriesSize_);
+    entries_ = nullptr;
+  }
+  if (cqRing_ != nullptr && cqRing_ != sqRing_) {
+    ::munmap(cqRing_, cqRingSize_);
+  }
+  cqRing_ = nullptr;
+  if (sqRing_ != nullptr) {
+    ::munmap(sqRing_, sqRingSize_);
+    sqRing_ = nullptr;
+  }
+  if (ringFd_ != -1) {
+    ::close(ringFd_);
+    ringFd_ = -1;
+  }
+  capacity_ = 0;
+}
+
+io_uring_sqe *UringReader::nextEntry() {
+  unsigned index = sqLocalTail_ & *sqMask_;
+  io_uring_sqe *entry = &entries_[index];
+  std::memset(entry, 0, sizeof(*entry));
+  sqArray_[index] = index;
+  ++sqLocalTail_;
+  return entry;
+}
+
+size_t UringReader::add(std::string_view path) {
+  if (!isAvailable() || requests_.size() >= capacity_ ||
+      path.size() >= PATH_SLOT_SIZE) {
+    return NONE;
+  }
+  size_t request = requests_.size();
+  char *slotPath = paths_.get() + request * PATH_SLOT_SIZE;
+  std::memcpy(slotPath, path.data(), path.size());
+  slotPath[path.size()] = '\0';
+  requests_.emplace_back();
+
+  // The open fills file slot `request`; the read and close use that slot,
+  // and the close runs even when the read fails so the slot is freed
+  io_uring_sqe *open = nextEntry();
+  open->opcode = IORING_OP_OPENAT;
+  open->flags = IOSQE_IO_LINK;
+  open->fd = AT_FDCWD;
+  open->addr = reinterpret_cast<uint64_t>(slotPath);
+  open->open_flags = O_RDONLY;
+  open->file_index = static_cast<uint32_t>(request + 1);
+  open->user_data = (request << OP_BITS) | OP_OPEN;
+
+  io_uring_sqe *read = nextEntry();
+  read->opcode = IORING_OP_READ_FIXED;
+  read->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+  read->fd = static_cast<int>(request);
+  read->addr = reinterpret_cast<uint64_t>(buffers_.get() +
+                                          request * FILE_BUFFER_SIZE);
+  read->len = FILE_BUFFER_SIZE;
+  read->buf_index = 0;
+  read->user_data = (request << OP_BITS) | OP_READ;
+
+  io_uring_sqe *close = nextEntry();
+  close->opcode = IORING_OP_CLOSE;
+  close->file_index = static_cast<uint32_t>(request + 1);
+  close->user_data = (request << OP_BITS) | OP_CLOSE;
+  return request;
+}
+
+unsigned UringReader::reapCompletions() {
+  unsigned head = *cqHead_;
+  unsigned tail = std::atomic_ref<unsigned>(*cqTail_).load(
+      std::memory_order_acquire);
+  unsigned count = 0;
+  for (; head != tail; ++head, ++count) {
+    const io_uring_cqe &completion = completions_[head & *cqMask_];
+    Request &request = requests_[completion.user_data >> OP_BITS];
+    switch (completion.user_data & ((1u << OP_BITS) - 1)) {
+    case OP_OPEN:
+      request.openResult = completion.res;
+      break;
+    case OP_READ:
+      request.readResult = completion.res;
+      break;
+    default:
+      break; // A failed close leaves nothing to clean up
+    }
+  }
+  std::atomic_ref<unsigned>(*cqHead_).store(head, std::memory_order_release);
+  return count;
+}
+
+bool UringReader::submit() {
+  if (requests_.empty()) {
+    return true;
+  }
+  if (!isAvailable()) {
+    for (Request &request : requests_) {
+      request.status = UringStatus::Fallback;
+    }
+    return false;
+  }
+  SelfTimerScope timer(SelfTimer::Read);
+
+  std::atomic_ref<unsigned>(*sqTail_).store(sqLocalTail_,
+                                            std::memory_order_release);
+  unsigned expected = static_cast<unsigned>(requests_.size()) *
+                      ENTRIES_PER_FILE;
+  unsigned toSubmit = expected;
+  unsigned submitted = 0;
+  unsigned reaped = 0;
+  uint64_t syscalls = 0;
+  int failure = 0;
+  while (reaped < expected) {
+    // Wait for everything submitted so far; the kernel may take the chains
+    // in several calls when it runs short of memory
+    unsigned waitFor = submitted + toSubmit - reaped;
+    int result = ioUringEnter(ringFd_, toSubmit, waitFor,
+                              IORING_ENTER_GETEVENTS);
+    ++syscalls;
+    if (result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      failure = errno;
+      break;
+    }
+    if (result > 0) {
+      submitted += static_cast<unsigned>(result);
+      toSubmit -= static_cast<unsigned>(result);
+    }
+    reaped += reapCompletions();
+  }
+  SelfStats::add(SelfCounter::Syscalls, syscalls);
+
+  uint64_t opened = 0;
+  uint64_t bytes = 0;
+  bool directOpenRejected = false;
+  for (Request &request : requests_) {
+    if (failure != 0) {
+      request.status = UringStatus::Fallback;
+    } else if (request.openResult < 0) {
+      // EINVAL means the kernel cannot open into a registered slot
+      directOpenRejected |= request.openResult == -EINVAL;
+      request.status = request.openResult == -EINVAL ? UringStatus::Fallback
+                                                     : UringStatus::Missing;
+    } else if (request.readResult < 0) {
+      ++opened;
+      request.status = request.readResult == -ECANCELED
+                           ? UringStatus::Fallback
+                           : UringStatus::Missing;
+    } else {
+      ++opened;
+      // A full buffer may hold only the start of the file
+      request.status =
+          static_cast<size_t>(request.readResult) >= FILE_BUFFER_SIZE
+              ? UringStatus::Fallback
+              : UringStatus::Complete;
+      if (request.status == UringStatus::Complete) {
+        bytes += static_cast<uint64_t>(request.readResult);
+      }
+    }
+  }
+  SelfStats::add(SelfCounter::FilesOpened, opened);
+  SelfStats::add(SelfCounter::BytesRead, bytes);
+
+  if (failure != 0 || directOpenRejected) {
+    // The ring cannot be trusted with the next batch; callers fall back
+    error_ = failure != 0 ? std::string("io_uring_enter failed: ") +
+                                std::strerror(failure)
+                          : "io_uring cannot open files into registered slots";
+    tearDown();
+    return false;
+  }
+  return true;
+}
+
+std::string_view UringReader::contents(size_t request) const {
+  const Request &entry = requests_[request];
+  if (entry.status != UringStatus::Complete) {
+    return std::string_view();
+  }
+  return std::string_view(buffers_.get() + request * FILE_BUFFER_SIZE,
+                          static_cast<size_t>(entry.readResult));
+}
@@ -0,0 +1,95 @@
+// src/worker_placement.cpp
+
+#include "../include/worker_placement.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+
+namespace {
+/**
+ * @brief The configured placement.
+ */
+struct Placement {
+  std::vector<int> cpus; ///< Allowed CPUs, ascending; empty if unrestricted
+  cpu_set_t set;         ///< The same CPUs as an affinity mask
+};
+
+/**
+ * @brief Returns the storage of the placement.
+ */
+Placement &placement() {
+  static Placement instance;
+  return instance;
+}
+
+std::atomic<bool> failureReported{false}; // The first failure was printed
+} // namespace
+
+bool WorkerPlacement::configure(const std::string &cpuList,
+                                const std::string &nodeList,
+                                const SystemTopology &topology,
+                                std::string &error) {
+  std::vector<int> cpus;
+  if (!cpuList.empty()) {
+    if (!ProcParsers::parseCpuList(cpuList, cpus)) {
+      error = "Invalid CPU list '" + cpuList + "'";
+      return false;
+    }
+    for (int cpu : cpus) {
+      if (topology.nodeOfCpu(cpu) < 0 || cpu >= CPU_SETSIZE) {
+        error = "CPU " + std::to_string(cpu) + " is not online";
+        return false;
+      }
+    }
+  }
+
+  if (!nodeList.empty()) {
+    std::vector<int> nodes;
+    if (!ProcParsers::parseCpuList(nodeList, nodes)) {
+      error = "Invalid node list '" + nodeList + "'";
+      return false;
+    }
+    for (int id : nodes) {
+      const NumaNode *node = topology.node(id);
+      if (node == nullptr || node->cpus.empty()) {
+        error = "Node " + std::to_string(id) + " has no online CPUs";
+        return false;
+      }
+      cpus.insert(cpus.end(), node->cpus.begin(), node->cpus.end());
+    }
+  }
+
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  Placement &current = placement();
+  current.cpus = std::move(cpus);
+  CPU_ZERO(&current.set);
+  for (int cpu : current.cpus) {
+    CPU_SET(cpu, &current.set);
+  }
+  return true;
+}
+
+void WorkerPlacement::clear() { placement().cpus.clear(); }
+
+bool WorkerPlacement::isConfigured() { return !placement().cpus.empty(); }
+
+const std::vector<int> &WorkerPlacement::cpus() { return placement().cpus; }
+
+void WorkerPlacement::applyToCurrentThread() {
+  const Placement &current = placement();
+  if (current.cpus.empty()) {
+    return;
+  }
+  int result =
+      pthread_setaffinity_np(pthread_self(), sizeof(current.set), &current.set);
+  if (result != 0 && !failureReported.exchange(true)) {
+    std::cerr << "Warning: Could not pin a scan worker: "
+              << std::strerror(result) << '\n';
+  }
+}
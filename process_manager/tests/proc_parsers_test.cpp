@@ -0,0 +1,1370 @@
+// In proc_parsers_test.cpp
+#include "../include/collector_daemon.h"
+#include "../include/command_parser.h"
+#include "../include/daemon_protocol.h"
+#include "../include/device_monitoring.h"
+#include "../include/display_format.h"
+#include "../include/fake_procfs.h"
+#include "../include/numa_topology.h"
+#include "../include/output_buffer.h"
+#include "../include/overhead_governor.h"
+#include "../include/pressure_monitoring.h"
+#include "../include/proc_parsers.h"
+#include "../include/proc_paths.h"
+#include "../include/process_listing.h"
+#include "../include/process_columns.h"
+#include "../include/process_control.h"
+#include "../include/process_events.h"
+#include "../include/process_filter.h"
+#include "../include/process_history.h"
+#include "../include/rule_engine.h"
+#include "../include/scan_arena.h"
+#include "../include/self_stats.h"
+#include "../include/shm_snapshot.h"
+#include "../include/string_pool.h"
+#include "../include/uring_reader.h"
+#include "../include/worker_placement.h"
+#include "gtest/gtest.h"
+
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+
+TEST(ProcParsersTest, ParsesStatWithSpacesInName) {
+  const std::string contents =
+      "1234 (my (odd) name) S 1 1234 1234 0 -1 4194560 1500 0 7 0 250 120 3 "
+      "4 20 0 6 0 98765 1000000 300 18446744073709551615\n";
+
+  ProcStat stat;
+  ASSERT_TRUE(ProcParsers::parseStat(contents, stat));
+  EXPECT_EQ(stat.comm, "my (odd) name");
+  EXPECT_EQ(stat.ppid, 1);
+  EXPECT_EQ(stat.minorFaults, 1500u);
+  EXPECT_EQ(stat.majorFaults, 7u);
+  EXPECT_EQ(stat.utime, 250u);
+  EXPECT_EQ(stat.stime, 120u);
+  EXPECT_EQ(stat.cutime, 3u);
+  EXPECT_EQ(stat.cstime, 4u);
+  EXPECT_EQ(stat.numThreads, 6);
+  EXPECT_EQ(stat.startTime, 98765u);
+}
+
+TEST(ProcParsersTest, RejectsTruncatedStat) {
+  ProcStat stat;
+  EXPECT_FALSE(ProcParsers::parseStat("1234 (name) S 1 2 3", stat));
+  EXPECT_FALSE(ProcParsers::parseStat("", stat));
+}
+
+TEST(ProcParsersTest, ParsesStatusAndIo) {
+  ProcStatus status;
+  ASSERT_TRUE(ProcParsers::parseStatus("Name:\tbash\nThreads:\t1\n"
+                                       "voluntary_ctxt_switches:\t42\n"
+                                       "nonvoluntary_ctxt_switches:\t7\n",
+                                       status));
+  EXPECT_EQ(status.voluntaryCtxSwitches, 42u);
+  EXPECT_EQ(status.involuntaryCtxSwitches, 7u);
+
+  ProcIo io;
+  ASSERT_TRUE(ProcParsers::parseIo("rchar: 10\nwchar: 20\nread_bytes: 4096\n"
+                                   "write_bytes: 8192\n",
+                                   io));
+  EXPECT_EQ(io.readBytes, 4096u);
+  EXPECT_EQ(io.writeBytes, 8192u);
+}
+
+TEST(ProcParsersTest, ParsesSmapsRollup) {
+  ProcSmaps smaps;
+  ASSERT_TRUE(ProcParsers::parseSmapsRollup(
+      "564d14cb5000-7ffc37c1b000 ---p 00000000 00:00 0   [rollup]\n"
+      "Rss:                1300 kB\nPss:                 481 kB\n"
+      "Pss_Dirty:           104 kB\nShared_Clean:       1116 kB\n"
+      "Private_Clean:        80 kB\nPrivate_Dirty:       104 kB\n",
+      smaps));
+  EXPECT_EQ(smaps.pssKb, 481u);
+  EXPECT_EQ(smaps.ussKb, 184u);
+}
+
+TEST(ProcParsersTest, ParsesSystemFiles) {
+  unsigned long long residentPages = 0;
+  ASSERT_TRUE(ProcParsers::parseStatm("2000 350 100 10 0 200 0\n",
+                                      residentPages));
+  EXPECT_EQ(residentPages, 350u);
+
+  unsigned long long totalTime = 0;
+  ASSERT_TRUE(ProcParsers::parseCpuTotal(
+      "cpu  1 2 3 4 5 6 7 8 0 0\ncpu0 1 2 3 4 5 6 7 8 0 0\n", totalTime));
+  EXPECT_EQ(totalTime, 36u);
+
+  unsigned long long idleTime = 0;
+  ASSERT_TRUE(ProcParsers::parseCpuTimes("cpu  1 2 3 4 5 6 7 8 0 0\n",
+                                         totalTime, idleTime));
+  EXPECT_EQ(idleTime, 9u);
+
+  std::vector<CpuTimes> cpus;
+  ASSERT_TRUE(ProcParsers::parseCpuLines(
+      "cpu  1 2 3 4 5 6 7 8 0 0\ncpu0 1 0 1 2 0 0 0 0 0 0\n"
+      "cpu1 0 2 2 2 5 6 7 8 0 0\nintr 12345 0\n",
+      cpus));
+  ASSERT_EQ(cpus.size(), 3u);
+  EXPECT_EQ(cpus[0].cpu, -1);
+  EXPECT_EQ(cpus[2].cpu, 1);
+  EXPECT_EQ(cpus[2].ticks[4], 5u);
+
+  unsigned long long totalKb = 0;
+  ASSERT_TRUE(ProcParsers::parseMemTotal(
+      "MemTotal:       16000000 kB\nMemFree:  100 kB\n", totalKb));
+  EXPECT_EQ(totalKb, 16000000u);
+
+  // Views into a larger buffer are not NUL-terminated
+  std::string_view uptime =
+      std::string_view("12345.67 890.12\n9999").substr(0, 7);
+  double seconds = 0.0;
+  ASSERT_TRUE(ProcParsers::parseUptime(uptime, seconds));
+  EXPECT_DOUBLE_EQ(seconds, 12345.6);
+  EXPECT_FALSE(ProcParsers::parseUptime("", seconds));
+}
+
+TEST(ProcParsersTest, ParsesCgroupFiles) {
+  unsigned long long usageUsec = 0;
+  ASSERT_TRUE(ProcParsers::parseKeyedValue(
+      "usage_usec 123456\nuser_usec 100000\n", "usage_usec ", usageUsec));
+  EXPECT_EQ(usageUsec, 123456u);
+
+  unsigned long long anon = 0;
+  ASSERT_TRUE(ProcParsers::parseKeyedValue(
+      "anon_thp 0\nanon 4096\nfile 8192\n", "anon ", anon));
+  EXPECT_EQ(anon, 4096u);
+
+  unsigned long long readBytes = 0;
+  unsigned long long writeBytes = 0;
+  ProcParsers::parseCgroupIoStat(
+      "8:0 rbytes=100 wbytes=200 rios=1 wios=2 dbytes=0 dios=0\n"
+      "8:16 rbytes=10 wbytes=20 rios=1 wios=2 dbytes=0 dios=0\n",
+      readBytes, writeBytes);
+  EXPECT_EQ(readBytes, 110u);
+  EXPECT_EQ(writeBytes, 220u);
+}
+
+TEST(ProcParsersTest, ParsesNumaFiles) {
+  std::vector<int> values;
+  ASSERT_TRUE(ProcParsers::parseCpuList("0-3,8,10-11\n", values));
+  EXPECT_EQ(values, (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+  ASSERT_TRUE(ProcParsers::parseCpuList("\n", values));
+  EXPECT_TRUE(values.empty());
+  EXPECT_FALSE(ProcParsers::parseCpuList("3-1", values));
+  EXPECT_FALSE(ProcParsers::parseCpuList("0,a", values));
+
+  NodeMemory memory;
+  ASSERT_TRUE(ProcParsers::parseNodeMeminfo(
+      "Node 1 MemTotal:       8000000 kB\n"
+      "Node 1 MemFree:        3000000 kB\n"
+      "Node 1 MemUsed:        5000000 kB\n"
+      "Node 1 FilePages:      2000000 kB\n"
+      "Node 1 AnonPages:      1500000 kB\n",
+      memory));
+  EXPECT_EQ(memory.totalKb, 8000000u);
+  EXPECT_EQ(memory.freeKb, 3000000u);
+  EXPECT_EQ(memory.usedKb, 5000000u);
+  EXPECT_EQ(memory.fileKb, 2000000u);
+  EXPECT_EQ(memory.anonKb, 1500000u);
+
+  // Pages are counted in the page size of their mapping
+  std::vector<unsigned long long> nodeKb;
+  ASSERT_TRUE(ProcParsers::parseNumaMaps(
+      "00400000 default file=/bin/a mapped=10 N0=10 kernelpagesize_kB=4\n"
+      "7f000000 default anon=300 dirty=300 N0=100 N1=200 "
+      "kernelpagesize_kB=4\n"
+      "7f800000 bind:1 huge anon=2 N1=2 kernelpagesize_kB=2048\n"
+      "7fff0000 default stack\n",
+      nodeKb));
+  ASSERT_EQ(nodeKb.size(), 2u);
+  EXPECT_EQ(nodeKb[0], 440u);
+  EXPECT_EQ(nodeKb[1], 800u + 4096u);
+}
+
+TEST(ProcessColumnsTest, ParsesColumnListAndSources) {
+  std::vector<ProcessColumn> columns;
+  std::string error;
+  ASSERT_TRUE(
+      ProcessColumns::parse("pid,cpu,rss,io_read,threads", columns, error));
+  ASSERT_EQ(columns.size(), 5u);
+  EXPECT_EQ(columns[3], ProcessColumn::IoRead);
+  EXPECT_EQ(ProcessColumns::requiredSources(columns),
+            PROC_SOURCE_STAT | PROC_SOURCE_STATM | PROC_SOURCE_IO);
+
+  EXPECT_FALSE(ProcessColumns::parse("pid,bogus", columns, error));
+  EXPECT_NE(error.find("bogus"), std::string::npos);
+}
+
+TEST(ProcessColumnsTest, DefaultColumnsOnlyReadCheapSources) {
+  EXPECT_EQ(
+      ProcessColumns::requiredSources(ProcessColumns::defaultColumns()),
+      PROC_SOURCE_STAT | PROC_SOURCE_STATM);
+}
+
+TEST(StringPoolTest, InternsEachStringOnce) {
+  StringPool pool;
+  uint32_t bash = pool.intern("bash");
+  uint32_t sshd = pool.intern("sshd");
+  EXPECT_NE(bash, sshd);
+  EXPECT_EQ(pool.intern(std::string("bash")), bash);
+  EXPECT_EQ(pool.get(bash), "bash");
+  EXPECT_EQ(pool.intern(""), StringPool::EMPTY_ID);
+  EXPECT_EQ(pool.get(12345), "");
+  EXPECT_EQ(pool.bytesUsed(), 8u);
+  EXPECT_EQ(pool.size(), 3u);
+}
+
+TEST(OutputBufferTest, EscapesJsonAndCsv) {
+  OutputBuffer out;
+  out.appendJsonString("a \"b\"\\\n\x01");
+  EXPECT_EQ(out.view(), "\"a \\\"b\\\"\\\\\\n\\u0001\"");
+
+  out.clear();
+  out.appendCsvField("plain");
+  out.append(',');
+  out.appendCsvField("x,\"y\"");
+  EXPECT_EQ(out.view(), "plain,\"x,\"\"y\"\"\"");
+
+  out.clear();
+  out.appendNumber(12.345, 2);
+  out.append(' ');
+  out.appendNumber(18446744073709551615ull);
+  EXPECT_EQ(out.view(), "12.35 18446744073709551615");
+}
+
+TEST(DaemonProtocolTest, RoundTripsFrames) {
+  DaemonSystemSample system;
+  system.timestampMs = 1700000000123ull;
+  system.generation = 7;
+  system.cpuUsage = 12.345;
+  system.memoryUsage = 50.0;
+  system.memTotalKb = 8000000;
+  system.processCount = 2;
+
+  DaemonProcess process;
+  process.pid = 42;
+  process.cpuUsage = 150.5;
+  process.rssKb = 1024;
+  process.threads = 3;
+  process.name = "Web Content";
+
+  std::string records;
+  DaemonProtocol::appendProcess(records, process);
+  std::string frame;
+  DaemonProtocol::appendSnapshotPrefix(frame, system, 1, records.size());
+  frame += records;
+
+  DaemonMessage type;
+  uint32_t length = 0;
+  ASSERT_TRUE(DaemonProtocol::parseHeader(frame, type, length));
+  EXPECT_EQ(type, DaemonMessage::SnapshotReply);
+  ASSERT_EQ(length, frame.size() - DaemonProtocol::HEADER_SIZE);
+
+  DaemonSnapshot snapshot;
+  std::string_view payload(frame);
+  payload.remove_prefix(DaemonProtocol::HEADER_SIZE);
+  ASSERT_TRUE(DaemonProtocol::decodeSnapshot(payload, snapshot));
+  EXPECT_EQ(snapshot.system.timestampMs, 1700000000123ull);
+  EXPECT_DOUBLE_EQ(snapshot.system.cpuUsage, 12.35);
+  ASSERT_EQ(snapshot.processes.size(), 1u);
+  EXPECT_EQ(snapshot.processes[0].pid, 42);
+  EXPECT_DOUBLE_EQ(snapshot.processes[0].cpuUsage, 150.5);
+  EXPECT_EQ(snapshot.processes[0].name, "Web Content");
+  EXPECT_FALSE(DaemonProtocol::decodeSnapshot(
+      payload.substr(0, payload.size() - 1), snapshot));
+
+  std::string request;
+  DaemonProtocol::appendRequest(request, DaemonMessage::History, 1234);
+  int64_t argument = 0;
+  ASSERT_TRUE(DaemonProtocol::parseHeader(request, type, length));
+  EXPECT_TRUE(DaemonProtocol::parseRequest(
+      type, std::string_view(request).substr(DaemonProtocol::HEADER_SIZE),
+      argument));
+  EXPECT_EQ(argument, 1234);
+  EXPECT_FALSE(DaemonProtocol::parseHeader(
+      std::string_view("PMD0\x01\x00\x00\x00\x00\x00", 10), type, length));
+}
+
+TEST(ShmSnapshotTest, ReaderSeesCommittedSnapshotsOnly) {
+  std::string name = "/pm_test-" + std::to_string(getpid());
+  ShmSnapshotWriter writer;
+  std::string error;
+  ASSERT_TRUE(writer.create(name, 2, error)) << error;
+
+  ShmSnapshotReader reader;
+  ASSERT_TRUE(reader.open(name, error)) << error;
+  EXPECT_EQ(reader.header()->slotCount, ShmSnapshotWriter::SLOT_COUNT);
+
+  ShmProcessRecord *records = writer.beginWrite();
+  records[0] = ShmProcessRecord{7, 2, 12.5, 1.0, 4096, "worker"};
+  ShmSnapshotView view;
+  ASSERT_TRUE(reader.acquire(view));
+  EXPECT_EQ(view.system->generation, 0u); // Nothing published yet
+
+  ShmSystemSample sample;
+  sample.generation = 1;
+  sample.processCount = 5;
+  sample.recordCount = 3; // Clamped to the capacity
+  writer.commit(sample);
+
+  ASSERT_TRUE(reader.acquire(view));
+  EXPECT_EQ(view.system->generation, 1u);
+  EXPECT_EQ(view.recordCount, 2u);
+  EXPECT_EQ(view.records[0].pid, 7);
+  EXPECT_STREQ(view.records[0].name, "worker");
+  EXPECT_TRUE(reader.validate(view));
+
+  // With three slots, the view's slot is only rewritten by the third
+  // snapshot after it
+  for (int i = 0; i < 2; ++i) {
+    writer.beginWrite();
+    writer.commit(sample);
+  }
+  EXPECT_TRUE(reader.validate(view));
+  writer.beginWrite();
+  EXPECT_FALSE(reader.validate(view));
+  writer.commit(sample);
+
+  std::vector<ShmProcessRecord> copied;
+  EXPECT_TRUE(reader.copy(sample, copied));
+  EXPECT_EQ(copied.size(), 2u);
+}
+
+TEST(RuleEngineTest, CompilesRulesAndReportsErrors) {
+  RuleEngine engine;
+  std::string error;
+  ASSERT_TRUE(engine.compile("# comment\n"
+                             "hog: cpu(pid) > 90 for 30s clear 50 -> log, "
+                             "renice 5\n"
+                             "rss(pid)>=4G->kill KILL\n"
+                             "mem(system) > 95 -> log # trailing\n",
+                             error))
+      << error;
+  ASSERT_EQ(engine.rules().size(), 3u);
+  EXPECT_EQ(engine.rules()[0].name, "hog");
+  EXPECT_EQ(engine.rules()[0].text,
+            "cpu(pid) > 90 for 30s clear 50 -> log, renice 5");
+  EXPECT_EQ(engine.rules()[1].name, "rule3");
+  EXPECT_EQ(engine.rules()[1].threshold, 4.0 * 1024 * 1024 * 1024);
+  EXPECT_EQ(engine.rules()[1].actions[0].argument, SIGKILL);
+  EXPECT_EQ(engine.requiredSources(), PROC_SOURCE_STAT | PROC_SOURCE_STATM);
+
+  EXPECT_FALSE(engine.compile("cpu(pid) > 90 -> explode", error));
+  EXPECT_EQ(error, "line 1: unknown action 'explode'");
+  EXPECT_FALSE(engine.compile("\nrss(system) > 1G -> log", error));
+  EXPECT_EQ(error, "line 2: 'rss' is only available per process");
+  EXPECT_FALSE(engine.compile("mem(system) > 90 -> kill", error));
+  EXPECT_FALSE(engine.compile("cpu(pid) > 90 clear 95 -> log", error));
+  EXPECT_FALSE(engine.compile("cpu(pid) > 90 -> log extra", error));
+  EXPECT_FALSE(engine.compile("cpu(pid) > 90 -> log,", error));
+
+  // Values that parse as numbers but cannot be compared or converted
+  EXPECT_FALSE(engine.compile("cpu(pid) > nan -> log", error));
+  EXPECT_EQ(error, "line 1: invalid threshold 'nan'");
+  EXPECT_FALSE(engine.compile("cpu(pid) > inf -> log", error));
+  EXPECT_FALSE(engine.compile("cpu(pid) > 0x10 -> log", error));
+  EXPECT_FALSE(engine.compile("rss(pid) > 1e308T -> log", error));
+  EXPECT_FALSE(engine.compile("cpu(pid) > 90 clear nan -> log", error));
+  EXPECT_FALSE(engine.compile("cpu(pid) > 90 for inf -> log", error));
+  EXPECT_EQ(error, "line 1: invalid duration 'inf'");
+  EXPECT_FALSE(engine.compile("cpu(pid) > 90 for nan s -> log", error));
+  EXPECT_FALSE(engine.compile("cpu(pid) > 90 for nans -> log", error));
+  EXPECT_FALSE(engine.compile("cpu(pid) > 90 for 1e30h -> log", error));
+  EXPECT_TRUE(engine.compile("cpu(pid) > 0.5 for 1.5m -> log", error))
+      << error;
+  EXPECT_EQ(engine.rules()[0].duration, std::chrono::milliseconds(90000));
+}
+
+TEST(RuleEngineTest, FiresOncePerEpisodeWithHysteresis) {
+  RuleEngine engine;
+  std::string error;
+  ASSERT_TRUE(engine.compile("cpu(pid) > 90 for 2s clear 50 -> log\n"
+                             "threads(pid) < 2 -> log\n"
+                             "mem(system) >= 95 -> log\n",
+                             error));
+
+  std::vector<ProcessInfo> processes(2);
+  processes[0].pid = 10;
+  processes[0].threads = 4;
+  processes[1].pid = 20;
+  processes[1].threads = 1;
+  for (ProcessInfo &info : processes) {
+    info.collected = PROC_SOURCE_STAT | PROC_SOURCE_STATM;
+  }
+  RuleSystemSample system{10.0, 95.0};
+  std::vector<RuleFiring> firings;
+  auto start = std::chrono::steady_clock::time_point();
+  auto at = [start](int seconds) {
+    return start + std::chrono::seconds(seconds);
+  };
+
+  // Busy, but not for long enough yet; the other two rules fire at once
+  processes[0].cpuUsage = 95.0;
+  engine.evaluate(at(0), processes, system, firings);
+  ASSERT_EQ(firings.size(), 2u);
+  for (const RuleFiring &firing : firings) {
+    if (firing.rule == 1) {
+      EXPECT_EQ(firing.pid, 20);
+      EXPECT_EQ(firing.process, 1u);
+    } else {
+      EXPECT_EQ(firing.rule, 2u);
+      EXPECT_EQ(firing.pid, 0);
+    }
+  }
+
+  engine.evaluate(at(1), processes, system, firings);
+  EXPECT_TRUE(firings.empty());
+  engine.evaluate(at(2), processes, system, firings);
+  ASSERT_EQ(firings.size(), 1u);
+  EXPECT_EQ(firings[0].rule, 0u);
+  EXPECT_EQ(firings[0].pid, 10);
+  EXPECT_EQ(firings[0].value, 95.0);
+
+  // Dipping below the threshold but not the clear value does not re-arm
+  processes[0].cpuUsage = 60.0;
+  engine.evaluate(at(3), processes, system, firings);
+  processes[0].cpuUsage = 95.0;
+  engine.evaluate(at(6), processes, system, firings);
+  EXPECT_TRUE(firings.empty());
+
+  // Clearing re-arms, and the duration starts over
+  processes[0].cpuUsage = 40.0;
+  engine.evaluate(at(7), processes, system, firings);
+  processes[0].cpuUsage = 95.0;
+  engine.evaluate(at(8), processes, system, firings);
+  EXPECT_TRUE(firings.empty());
+  engine.evaluate(at(10), processes, system, firings);
+  ASSERT_EQ(firings.size(), 1u);
+
+  // A process that exits drops its state; a new one with the PID starts over
+  std::vector<ProcessInfo> none;
+  engine.evaluate(at(11), none, system, firings);
+  engine.evaluate(at(12), processes, system, firings);
+  ASSERT_EQ(firings.size(), 1u);
+  EXPECT_EQ(firings[0].rule, 1u);
+  engine.evaluate(at(14), processes, system, firings);
+  ASSERT_EQ(firings.size(), 1u);
+
+  // So does one that reuses the PID between two samples
+  processes[0].startTime = 1000;
+  engine.evaluate(at(15), processes, system, firings);
+  EXPECT_TRUE(firings.empty());
+  engine.evaluate(at(17), processes, system, firings);
+  ASSERT_EQ(firings.size(), 1u);
+  EXPECT_EQ(firings[0].rule, 0u);
+  EXPECT_EQ(firings[0].pid, 10);
+}
+
+TEST(FakeProcfsTest, ScansSyntheticSystemDeterministically) {
+  char root[] = "/tmp/proc_parsers_test.XXXXXX";
+  ASSERT_NE(mkdtemp(root), nullptr);
+
+  FakeProcfsOptions options;
+  options.processes = 200;
+  options.churn = 0.1;
+  options.load = FakeLoad::Busy;
+  options.cpus = 4;
+  FakeProcfs procfs(options);
+  std::string error;
+  ASSERT_TRUE(procfs.create(root, error)) << error;
+  ASSERT_TRUE(procfs.advance(10.0, error)) << error;
+  ProcPaths::setProcRoot(root);
+
+  ProcessListing listing;
+  listing.refresh(ListOptions());
+  EXPECT_EQ(listing.getProcessCount(), 200u);
+  EXPECT_EQ(ProcessListing::getAllPIDs(), procfs.pids());
+
+  // A tenth of the processes is replaced, and the survivors keep the CPUs
+  // about 90% busy
+  ASSERT_TRUE(procfs.advance(10.0, error)) << error;
+  listing.refresh(ListOptions());
+  EXPECT_EQ(listing.getScanReport().added, 20u);
+  EXPECT_EQ(listing.getScanReport().removed, 20u);
+  double cpuUsage = 0.0;
+  for (const ProcessInfo &process : listing.getProcesses()) {
+    cpuUsage += process.cpuUsage;
+  }
+  EXPECT_GT(procfs.lastCpuUsage(), 70.0);
+  EXPECT_NEAR(cpuUsage, procfs.lastCpuUsage(), procfs.lastCpuUsage() * 0.15);
+
+  ProcPaths::setProcRoot("/proc");
+  std::filesystem::remove_all(root);
+}
+
+TEST(FakeProcfsTest, ReportsOneAddedAndOneRemovedProcess) {
+  char root[] = "/tmp/proc_parsers_test.XXXXXX";
+  ASSERT_NE(mkdtemp(root), nullptr);
+
+  // With ten processes, a churn of a tenth replaces exactly one per step
+  FakeProcfsOptions options;
+  options.processes = 10;
+  options.churn = 0.1;
+  FakeProcfs procfs(options);
+  std::string error;
+  ASSERT_TRUE(procfs.create(root, error)) << error;
+  ProcPaths::setProcRoot(root);
+
+  ProcessListing listing;
+  listing.refresh(ListOptions());
+  std::vector<int> before = procfs.pids();
+  ASSERT_EQ(listing.getProcessCount(), 10u);
+
+  ASSERT_TRUE(procfs.advance(1.0, error)) << error;
+  listing.refresh(ListOptions());
+  std::vector<int> after = procfs.pids();
+  std::vector<int> added;
+  std::vector<int> removed;
+  std::set_difference(after.begin(), after.end(), before.begin(),
+                      before.end(), std::back_inserter(added));
+  std::set_difference(before.begin(), before.end(), after.begin(),
+                      after.end(), std::back_inserter(removed));
+  ASSERT_EQ(added.size(), 1u);
+  ASSERT_EQ(removed.size(), 1u);
+  EXPECT_EQ(listing.getScanReport().added, 1u);
+  EXPECT_EQ(listing.getScanReport().removed, 1u);
+  EXPECT_EQ(listing.getScanReport().processes, 10u);
+  EXPECT_EQ(ProcessListing::getAllPIDs(), after);
+
+  // A refresh without changes reports neither
+  listing.refresh(ListOptions());
+  EXPECT_EQ(listing.getScanReport().added, 0u);
+  EXPECT_EQ(listing.getScanReport().removed, 0u);
+
+  ProcPaths::setProcRoot("/proc");
+  std::filesystem::remove_all(root);
+}
+
+TEST(ScanArenaTest, RecyclesItsBufferAndGrowsAfterOverflow) {
+  ScanArena arena(1024);
+  arena.reset();
+  EXPECT_EQ(arena.capacity(), 1024u);
+
+  // The first epoch outgrows the buffer and spills to the heap
+  {
+    std::pmr::vector<int> values(&arena);
+    values.reserve(1000);
+    values.assign(1000, 7);
+    std::pmr::string text(1000, 'x', &arena);
+    EXPECT_EQ(values.back() + static_cast<int>(text.size()), 1007);
+  }
+  EXPECT_GE(arena.epochBytes(), 5000u);
+  arena.reset();
+  EXPECT_EQ(arena.epochBytes(), 0u);
+  EXPECT_EQ(arena.overflows(), 1u);
+  EXPECT_GE(arena.capacity(), 5000u);
+
+  // The same work now fits, and the buffer is reused as is
+  size_t capacity = arena.capacity();
+  for (int epoch = 0; epoch < 3; ++epoch) {
+    {
+      std::pmr::vector<int> values(1000, epoch, &arena);
+      std::pmr::string text(1000, 'x', &arena);
+    }
+    arena.reset();
+  }
+  EXPECT_EQ(arena.overflows(), 1u);
+  EXPECT_EQ(arena.capacity(), capacity);
+}
+
+TEST(SelfStatsTest, SumsThreadsAndRoundTripsOverTheProtocol) {
+  SelfStats::reset();
+  std::thread worker([] {
+    SelfStats::add(SelfCounter::FilesOpened, 3);
+    SelfStats::record(SelfTimer::Parse, 100);
+    SelfStats::record(SelfTimer::Parse, 1000);
+  });
+  worker.join();
+  SelfStats::add(SelfCounter::FilesOpened);
+  SelfStats::record(SelfTimer::Parse, 5000);
+  SelfStats::adjust(SelfGauge::PoolQueueDepth, 2);
+  SelfStats::adjust(SelfGauge::PoolQueueDepth, -2);
+
+  // The exited thread's values are kept
+  SelfStatsSnapshot stats = SelfStats::snapshot();
+  const auto counter = static_cast<size_t>(SelfCounter::FilesOpened);
+  EXPECT_EQ(stats.counters[counter].first, "files_opened");
+  EXPECT_EQ(stats.counters[counter].second, 4u);
+  const SelfHistogram &parse =
+      stats.histograms[static_cast<size_t>(SelfTimer::Parse)];
+  EXPECT_EQ(parse.count, 3u);
+  EXPECT_EQ(parse.sumNs, 6100u);
+  EXPECT_EQ(parse.maxNs, 5000u);
+  EXPECT_EQ(parse.buckets[0], 1u); // Below 128 ns
+  EXPECT_EQ(parse.quantileNs(0.5), 1024u);
+  EXPECT_EQ(parse.quantileNs(1.0), 5000u);
+  const SelfGaugeValue &depth =
+      stats.gauges[static_cast<size_t>(SelfGauge::PoolQueueDepth)];
+  EXPECT_EQ(depth.value, 0);
+  EXPECT_EQ(depth.peak, 2);
+
+  std::string frame;
+  DaemonProtocol::appendStats(frame, stats);
+  DaemonMessage type;
+  uint32_t length = 0;
+  ASSERT_TRUE(DaemonProtocol::parseHeader(frame, type, length));
+  EXPECT_EQ(type, DaemonMessage::StatsReply);
+  SelfStatsSnapshot decoded;
+  ASSERT_TRUE(DaemonProtocol::decodeStats(
+      std::string_view(frame).substr(DaemonProtocol::HEADER_SIZE), decoded));
+  EXPECT_EQ(decoded.counters, stats.counters);
+  EXPECT_EQ(decoded.histograms[2].buckets, parse.buckets);
+  EXPECT_EQ(decoded.gauges[0].peak, 2);
+  EXPECT_FALSE(DaemonProtocol::decodeStats(
+      std::string_view(frame).substr(DaemonProtocol::HEADER_SIZE + 1),
+      decoded));
+}
+
+namespace {
+
+void writeSysFile(const std::filesystem::path &path,
+                  const std::string &contents) {
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream(path) << contents;
+}
+
+} // namespace
+
+TEST(NumaTopologyTest, DiscoversNodesAndRestrictsWorkers) {
+  char root[] = "/tmp/proc_parsers_test.XXXXXX";
+  ASSERT_NE(mkdtemp(root), nullptr);
+  std::filesystem::path sys(root);
+  writeSysFile(sys / "devices/system/cpu/online", "0-3\n");
+  for (int cpu = 0; cpu < 4; ++cpu) {
+    std::filesystem::path topology = sys / "devices/system/cpu" /
+                                     ("cpu" + std::to_string(cpu)) /
+                                     "topology";
+    writeSysFile(topology / "physical_package_id",
+                 std::to_string(cpu / 2) + "\n");
+    writeSysFile(topology / "core_id", std::to_string(cpu % 2) + "\n");
+  }
+  writeSysFile(sys / "devices/system/node/online", "0-1\n");
+  const char *distances[] = {"10 21\n", "21 10\n"};
+  for (int id = 0; id < 2; ++id) {
+    std::string prefix = "Node " + std::to_string(id) + " ";
+    std::filesystem::path node =
+        sys / "devices/system/node" / ("node" + std::to_string(id));
+    writeSysFile(node / "cpulist", id == 0 ? "0-1\n" : "2-3\n");
+    writeSysFile(node / "distance", distances[id]);
+    writeSysFile(node / "meminfo",
+                 prefix + "MemTotal: 4000 kB\n" + prefix +
+                     "MemFree: 1000 kB\n" + prefix + "MemUsed: 3000 kB\n");
+  }
+  ProcPaths::setSysRoot(root);
+
+  SystemTopology topology;
+  std::string error;
+  ASSERT_TRUE(NumaTopology::discover(topology, error)) << error;
+  EXPECT_TRUE(topology.numa);
+  ASSERT_EQ(topology.nodes.size(), 2u);
+  EXPECT_EQ(topology.nodes[1].cpus, (std::vector<int>{2, 3}));
+  EXPECT_EQ(topology.nodes[0].distances, (std::vector<int>{10, 21}));
+  EXPECT_EQ(topology.nodes[1].memory.usedKb, 3000u);
+  ASSERT_EQ(topology.cpus.size(), 4u);
+  EXPECT_EQ(topology.cpus[3].package, 1);
+  EXPECT_EQ(topology.nodeOfCpu(2), 1);
+  EXPECT_EQ(topology.nodeOfCpu(4), -1);
+  EXPECT_EQ(NumaTopology::formatList({0, 1, 2, 3, 8, 10}), "0-3,8,10");
+
+  // Lists are checked against the topology before anything changes
+  EXPECT_FALSE(WorkerPlacement::configure("4", "", topology, error));
+  EXPECT_FALSE(WorkerPlacement::configure("", "2", topology, error));
+  EXPECT_FALSE(WorkerPlacement::isConfigured());
+  ASSERT_TRUE(WorkerPlacement::configure("0", "1", topology, error)) << error;
+  EXPECT_EQ(WorkerPlacement::cpus(), (std::vector<int>{0, 2, 3}));
+  WorkerPlacement::clear();
+  EXPECT_FALSE(WorkerPlacement::isConfigured());
+
+  ProcPaths::setSysRoot("/sys");
+  std::filesystem::remove_all(root);
+}
+
+TEST(UringReaderTest, ReadsBatchesAndFallsBackForLargeFiles) {
+  UringReader reader(8);
+  if (!reader.isAvailable()) {
+    GTEST_SKIP() << reader.error();
+  }
+  char root[] = "/tmp/proc_parsers_test.XXXXXX";
+  ASSERT_NE(mkdtemp(root), nullptr);
+  std::filesystem::path directory(root);
+  writeSysFile(directory / "small", "1 (init) S 0\n");
+  writeSysFile(directory / "large",
+               std::string(UringReader::FILE_BUFFER_SIZE + 1, 'x'));
+
+  // The ring and its slots are reused by every batch
+  for (int batch = 0; batch < 3; ++batch) {
+    reader.clear();
+    size_t small = reader.add((directory / "small").string());
+    size_t missing = reader.add((directory / "missing").string());
+    size_t large = reader.add((directory / "large").string());
+    ASSERT_NE(large, UringReader::NONE);
+    ASSERT_TRUE(reader.submit()) << reader.error();
+    EXPECT_EQ(reader.status(small), UringStatus::Complete);
+    EXPECT_EQ(reader.contents(small), "1 (init) S 0\n");
+    EXPECT_EQ(reader.status(missing), UringStatus::Missing);
+    EXPECT_EQ(reader.status(large), UringStatus::Fallback);
+  }
+  EXPECT_EQ(reader.add(std::string(UringReader::PATH_SLOT_SIZE, 'p')),
+            UringReader::NONE);
+
+  // A scan with the io_uring backend collects the same values
+  FakeProcfsOptions options;
+  options.processes = 300;
+  FakeProcfs procfs(options);
+  std::string error;
+  std::string procRoot = (directory / "proc").string();
+  ASSERT_TRUE(procfs.create(procRoot, error)) << error;
+  ProcPaths::setProcRoot(procRoot);
+  ListOptions listOptions;
+  listOptions.extraSources = PROC_SOURCE_STATUS | PROC_SOURCE_IO;
+  ProcessListing sync;
+  sync.refresh(listOptions);
+  ProcessListing::setScanBackend(ScanBackend::IoUring);
+  ProcessListing batched;
+  batched.refresh(listOptions);
+  ProcessListing::setScanBackend(ScanBackend::Sync);
+  ProcPaths::setProcRoot("/proc");
+
+  ASSERT_EQ(batched.getProcessCount(), 300u);
+  ASSERT_EQ(sync.getProcessCount(), batched.getProcessCount());
+  for (size_t i = 0; i < sync.getProcessCount(); ++i) {
+    const ProcessInfo &expected = sync.getProcesses()[i];
+    const ProcessInfo &actual = batched.getProcesses()[i];
+    EXPECT_EQ(actual.pid, expected.pid);
+    EXPECT_EQ(actual.collected, expected.collected);
+    EXPECT_EQ(actual.rssKb, expected.rssKb);
+    EXPECT_EQ(actual.threads, expected.threads);
+    EXPECT_EQ(actual.voluntaryCtxSwitches, expected.voluntaryCtxSwitches);
+    EXPECT_EQ(actual.ioReadBytes, expected.ioReadBytes);
+  }
+  std::filesystem::remove_all(root);
+}
+
+namespace {
+
+/// A stat line with the fields the thread listing reads
+std::string taskStat(int tid, const std::string &name, int utime, int cutime) {
+  return std::to_string(tid) + " (" + name + ") S 1 100 100 0 -1 0 0 0 0 0 " +
+         std::to_string(utime) + " 0 " + std::to_string(cutime) +
+         " 0 20 0 3 0 500 1000 10 0\n";
+}
+
+} // namespace
+
+TEST(ProcessListingTest, ListsThreadsWithPerThreadCpuDeltas) {
+  char root[] = "/tmp/proc_parsers_test.XXXXXX";
+  ASSERT_NE(mkdtemp(root), nullptr);
+  std::filesystem::path proc(root);
+  writeSysFile(proc / "stat", "cpu  1000 0 0 0 0 0 0 0 0 0\n");
+  writeSysFile(proc / "uptime", "100.00 50.00\n");
+  writeSysFile(proc / "100/stat", taskStat(100, "server", 10, 0));
+  writeSysFile(proc / "100/task/100/stat", taskStat(100, "server", 0, 0));
+  writeSysFile(proc / "100/task/101/stat", taskStat(101, "worker-1", 10, 0));
+  writeSysFile(proc / "100/task/102/stat", taskStat(102, "gc", 0, 40));
+  writeSysFile(proc / "200/stat", taskStat(200, "other", 0, 0));
+  writeSysFile(proc / "200/task/200/stat", taskStat(200, "other", 0, 0));
+  ProcPaths::setProcRoot(proc.string());
+
+  ListOptions options;
+  options.columns = ProcessColumns::defaultThreadColumns();
+  options.threads = true;
+  options.pid = 100;
+  ProcessListing listing;
+  listing.refresh(options);
+  ASSERT_EQ(listing.getProcessCount(), 3u);
+  const std::vector<ProcessInfo> &rows = listing.getProcesses();
+  EXPECT_EQ(rows[0].pid, 100);
+  EXPECT_EQ(rows[1].tid, 101);
+  EXPECT_EQ(listing.getString(rows[1].nameId), "worker-1");
+  // Children reaped by the process are not charged to its threads
+  EXPECT_EQ(rows[2].cpuUsage, 0.0);
+
+  // The second scan measures each TID over the interval; threads come and go
+  writeSysFile(proc / "stat", "cpu  1100 0 0 0 0 0 0 0 0 0\n");
+  writeSysFile(proc / "100/task/101/stat", taskStat(101, "worker-1", 60, 0));
+  std::filesystem::remove_all(proc / "100/task/102");
+  writeSysFile(proc / "100/task/103/stat", taskStat(103, "worker-2", 0, 0));
+  listing.refresh(options);
+  ASSERT_EQ(listing.getProcessCount(), 3u);
+  EXPECT_EQ(listing.getProcesses()[1].tid, 101);
+  EXPECT_DOUBLE_EQ(listing.getProcesses()[1].cpuUsage, 50.0);
+  EXPECT_EQ(listing.getProcesses()[2].tid, 103);
+  EXPECT_EQ(listing.getScanReport().added, 1u);
+  EXPECT_EQ(listing.getScanReport().removed, 1u);
+
+  // Without a PID, every process contributes its threads, in order
+  options.pid = 0;
+  listing.refresh(options);
+  ASSERT_EQ(listing.getProcessCount(), 4u);
+  EXPECT_EQ(listing.getProcesses()[3].pid, 200);
+  EXPECT_EQ(listing.getProcesses()[3].tid, 200);
+
+  ProcPaths::setProcRoot("/proc");
+  std::filesystem::remove_all(root);
+}
+
+TEST(CommandParserTest, QuotesGroupWords) {
+  ParsedCommand cmd =
+      CommandParser().parse("list --filter 'name~a b && cpu>5' \"\" x\"y z");
+  EXPECT_EQ(cmd.name, "list");
+  ASSERT_EQ(cmd.args.size(), 4u);
+  EXPECT_EQ(cmd.args[1], "name~a b && cpu>5");
+  EXPECT_EQ(cmd.args[2], "");
+  // An unterminated quote runs to the end of the line
+  EXPECT_EQ(cmd.args[3], "xy z");
+}
+
+TEST(ProcessFilterTest, CompilesExpressionsAndEvaluatesWithUnknowns) {
+  ProcessFilter filter;
+  std::string error;
+  EXPECT_FALSE(filter.compile("cpu>", error));
+  EXPECT_FALSE(filter.compile("nosuch==1", error));
+  EXPECT_FALSE(filter.compile("(pid>1", error));
+  EXPECT_FALSE(filter.compile("name<3", error));
+  EXPECT_FALSE(filter.compile("rss>12Q", error));
+  EXPECT_FALSE(filter.compile("pid>1 pid<2", error));
+  ASSERT_TRUE(filter.compile("pid>=100 && (threads>1 || rss>=1M)", error))
+      << error;
+  EXPECT_EQ(filter.requiredSources(), PROC_SOURCE_STAT | PROC_SOURCE_STATM);
+
+  ProcessMetadataCache strings;
+  ProcessInfo process;
+  process.pid = 50;
+  // The PID alone decides a conjunction it fails
+  EXPECT_EQ(filter.evaluate(process, strings), FilterMatch::False);
+  process.pid = 150;
+  EXPECT_EQ(filter.evaluate(process, strings), FilterMatch::Unknown);
+  process.threads = 4;
+  process.collected = PROC_SOURCE_STAT;
+  EXPECT_EQ(filter.evaluate(process, strings), FilterMatch::True);
+  process.threads = 1;
+  EXPECT_EQ(filter.evaluate(process, strings), FilterMatch::Unknown);
+  // Sizes are given in bytes and compared with the RSS in kB
+  process.rssKb = 1024;
+  process.collected |= PROC_SOURCE_STATM;
+  EXPECT_EQ(filter.evaluate(process, strings), FilterMatch::True);
+
+  ASSERT_TRUE(filter.compile("!(cpu > 5%) && user == 0", error)) << error;
+  EXPECT_EQ(filter.requiredSources(), PROC_SOURCE_STAT | PROC_SOURCE_OWNER);
+  process.cpuUsage = 7.0;
+  EXPECT_EQ(filter.evaluate(process, strings), FilterMatch::False);
+  process.cpuUsage = 2.0;
+  EXPECT_EQ(filter.evaluate(process, strings), FilterMatch::Unknown);
+  process.collected |= PROC_SOURCE_OWNER;
+  EXPECT_EQ(filter.evaluate(process, strings), FilterMatch::True);
+}
+
+TEST(ProcessListingTest, FilterSkipsTheFilesOfRejectedProcesses) {
+  char root[] = "/tmp/proc_parsers_test.XXXXXX";
+  ASSERT_NE(mkdtemp(root), nullptr);
+  std::filesystem::path proc(root);
+  writeSysFile(proc / "stat", "cpu  1000 0 0 0 0 0 0 0 0 0\n");
+  writeSysFile(proc / "uptime", "100.00 50.00\n");
+  writeSysFile(proc / "meminfo", "MemTotal: 1000000 kB\n");
+  const char *names[] = {"nginx", "bash", "nginx"};
+  for (int i = 0; i < 3; ++i) {
+    std::filesystem::path directory = proc / std::to_string(100 * (i + 1));
+    writeSysFile(directory / "stat", taskStat(100 * (i + 1), names[i], 0, 0));
+    writeSysFile(directory / "statm", "1000 512 0 0 0 0 0\n");
+    writeSysFile(directory / "status", "voluntary_ctxt_switches:\t7\n"
+                                       "nonvoluntary_ctxt_switches:\t1\n");
+  }
+  ProcPaths::setProcRoot(proc.string());
+
+  std::string error;
+  auto filter = std::make_shared<ProcessFilter>();
+  ASSERT_TRUE(filter->compile("pid!=300 && name~ngin && rss>1K", error));
+  ListOptions options;
+  options.columns = {ProcessColumn::Pid, ProcessColumn::VoluntaryCtxSwitches};
+  // Both scans read the same files, so only the filter makes a difference
+  options.extraSources = filter->requiredSources();
+  const auto opened = static_cast<size_t>(SelfCounter::FilesOpened);
+  ProcessListing listing;
+  listing.refresh(options); // Reads what is cached across scans
+  SelfStats::reset();
+  listing.refresh(options);
+  uint64_t unfiltered = SelfStats::snapshot().counters[opened].second;
+
+  options.filter = filter;
+  SelfStats::reset();
+  listing.refresh(options);
+  uint64_t filtered = SelfStats::snapshot().counters[opened].second;
+  ASSERT_EQ(listing.getProcessCount(), 1u);
+  EXPECT_EQ(listing.getProcesses()[0].pid, 100);
+  EXPECT_EQ(listing.getProcesses()[0].voluntaryCtxSwitches, 7u);
+  EXPECT_EQ(listing.getScanReport().filtered, 2u);
+  // PID 300 is rejected before its files, PID 200 after its stat
+  EXPECT_EQ(unfiltered - filtered, 5u);
+
+  ProcPaths::setProcRoot("/proc");
+  std::filesystem::remove_all(root);
+}
+
+TEST(ProcessHistoryTest, CompressesRingsAndEvictsExitedAndColdProcesses) {
+  ProcessHistory history(100, 1u << 20);
+  std::vector<ProcessInfo> scan(2);
+  scan[0].pid = 10;
+  scan[1].pid = 20;
+  std::vector<HistorySample> expected;
+  uint64_t timestampMs = 1700000000000;
+  for (int i = 0; i < 150; ++i) {
+    // Jittered intervals, one long gap, changing and repeated values
+    timestampMs += i == 70 ? 3600000 : 5000 + (i % 3) * 7 - (i % 5);
+    scan[0].cpuUsage = (i % 10) * 9.75;
+    scan[0].memoryUsage = 1.5;
+    scan[0].rssKb = 4096 + static_cast<unsigned long long>(i / 4) * 12;
+    scan[0].ioReadBytes = static_cast<unsigned long long>(i) * i * 1000;
+    scan[0].collected = PROC_SOURCE_IO;
+    history.record(scan, timestampMs);
+    expected.push_back({timestampMs, scan[0].cpuUsage, scan[0].memoryUsage,
+                        scan[0].rssKb, scan[0].ioReadBytes, 0});
+  }
+
+  // The newest samples of the ring come back exactly
+  std::vector<HistorySample> samples;
+  ASSERT_TRUE(history.samples(10, samples));
+  ASSERT_EQ(samples.size(), 100u);
+  for (size_t i = 0; i < samples.size(); ++i) {
+    const HistorySample &want = expected[expected.size() - 100 + i];
+    EXPECT_EQ(samples[i].timestampMs, want.timestampMs) << i;
+    EXPECT_EQ(samples[i].cpuUsage, want.cpuUsage) << i;
+    EXPECT_EQ(samples[i].rssKb, want.rssKb) << i;
+    EXPECT_EQ(samples[i].ioReadBytes, want.ioReadBytes) << i;
+  }
+  EXPECT_TRUE(history.hasIo(10));
+  EXPECT_FALSE(history.hasIo(20));
+
+  // An idle process costs a few bits per sample instead of 48 bytes
+  size_t idleBytes = history.memoryBytes();
+  scan.pop_back();
+  history.record(scan, timestampMs + 5000);
+  EXPECT_FALSE(history.samples(20, samples));
+  EXPECT_LT(idleBytes - history.memoryBytes(), 100u * 48 / 4);
+
+  // A new process reusing the PID does not inherit the history
+  scan[0].startTime = 1000;
+  scan[0].collected = PROC_SOURCE_NONE;
+  history.record(scan, timestampMs + 10000);
+  ASSERT_TRUE(history.samples(10, samples));
+  ASSERT_EQ(samples.size(), 1u);
+  EXPECT_EQ(samples[0].timestampMs, timestampMs + 10000);
+  EXPECT_FALSE(history.hasIo(10));
+
+  std::ostringstream summary;
+  ProcessHistory::printSummary(summary, 10, expected, true);
+  EXPECT_NE(summary.str().find("CPU%"), std::string::npos);
+  EXPECT_NE(summary.str().find("IO read"), std::string::npos);
+  EXPECT_EQ(DisplayFormat::sparkline({0.0, 1.0, 8.0}, 3),
+            "\u2581\u2582\u2588");
+  // Columns keep the peak of the values they cover
+  EXPECT_EQ(DisplayFormat::sparkline({0.0, 8.0, 0.0, 0.0}, 2),
+            "\u2588\u2581");
+
+  // Over the limit, the processes idle the longest go first
+  ProcessHistory small(100, 8192);
+  std::vector<ProcessInfo> many(40);
+  for (int i = 0; i < 40; ++i) {
+    many[i].pid = 100 + i;
+  }
+  many[0].cpuUsage = 50.0;
+  for (int i = 0; i < 20; ++i) {
+    small.record(many, 1000 + static_cast<uint64_t>(i) * 5000);
+  }
+  EXPECT_LE(small.memoryBytes(), 8192u);
+  EXPECT_GT(small.evictedCount(), 0u);
+  EXPECT_TRUE(small.samples(100, samples));
+}
+
+TEST(ProcessEventsTest, MergesIdentitiesIntoStartsExitsAndExecs) {
+  ProcessMetadataCache strings;
+  auto identity = [&strings](int pid, unsigned long long startTime,
+                             std::string_view name) {
+    ProcessMetadata metadata =
+        strings.resolve(pid, startTime, name, METADATA_NAME, 1);
+    return ProcessIdentity{pid, 1, startTime, metadata.nameId};
+  };
+  // 10 stays, 20 exits, 30 is reused, 40 calls exec and 50 starts
+  std::vector<ProcessIdentity> previous = {
+      identity(10, 100, "init"), identity(20, 200, "cron"),
+      identity(30, 300, "old"), identity(40, 400, "sh")};
+  ProcessIdentity exec = identity(40, 400, "python");
+  std::vector<ProcessIdentity> current = {
+      identity(10, 100, "init"), identity(30, 350, "new"), exec,
+      identity(50, 500, "job")};
+
+  std::vector<ProcessEvent> events;
+  ProcessEvents::diff(previous, current, strings, 1234, events);
+  ASSERT_EQ(events.size(), 5u);
+  EXPECT_EQ(events[0].type, ProcessEventType::Exited);
+  EXPECT_EQ(events[0].pid, 20);
+  EXPECT_EQ(events[0].name, "cron");
+  EXPECT_EQ(events[1].type, ProcessEventType::Exited);
+  EXPECT_EQ(events[1].name, "old");
+  EXPECT_EQ(events[2].type, ProcessEventType::Started);
+  EXPECT_EQ(events[2].startTime, 350u);
+  EXPECT_EQ(events[3].type, ProcessEventType::Exec);
+  EXPECT_EQ(events[3].previousName, "sh");
+  EXPECT_EQ(events[3].name, "python");
+  EXPECT_EQ(events[4].type, ProcessEventType::Started);
+  EXPECT_EQ(events[4].timestampMs, 1234u);
+
+  OutputBuffer out;
+  ProcessEvents::writeJson(out, {events[3]});
+  EXPECT_EQ(out.view(), "[{\"type\":\"exec\",\"timestamp_ms\":1234,"
+                        "\"pid\":40,\"ppid\":1,\"start_time\":400,"
+                        "\"name\":\"python\",\"previous_name\":\"sh\"}]");
+}
+
+TEST(ProcessListingTest, EventsFollowAChildFromStartToExit) {
+  ListOptions options;
+  options.columns = {ProcessColumn::Pid};
+  options.events = true;
+  ProcessListing listing;
+  listing.refresh(options);
+  EXPECT_TRUE(listing.getEvents().empty()); // The first scan only primes
+
+  pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0) {
+    pause();
+    _exit(0);
+  }
+  auto find = [&listing](ProcessEventType type, int pid) {
+    for (const ProcessEvent &event : listing.getEvents()) {
+      if (event.type == type && event.pid == pid) {
+        return &event;
+      }
+    }
+    return static_cast<const ProcessEvent *>(nullptr);
+  };
+  listing.refresh(options);
+  const ProcessEvent *started = find(ProcessEventType::Started, child);
+  ASSERT_NE(started, nullptr);
+  EXPECT_EQ(started->ppid, getpid());
+  EXPECT_GE(listing.getScanReport().started, 1u);
+
+  kill(child, SIGKILL);
+  waitpid(child, nullptr, 0);
+  listing.refresh(options);
+  EXPECT_NE(find(ProcessEventType::Exited, child), nullptr);
+  EXPECT_GE(listing.getScanReport().exited, 1u);
+}
+
+TEST(ProcessControlTest, ParsesArgumentsAndThrottlesTheCgroupOfAProcess) {
+  std::vector<int> pids;
+  ASSERT_TRUE(ProcessControl::parsePids("812,913,812", pids));
+  EXPECT_EQ(pids, (std::vector<int>{812, 913}));
+  EXPECT_FALSE(ProcessControl::parsePids("812,", pids));
+  EXPECT_FALSE(ProcessControl::parsePids("0", pids));
+
+  IoClass ioClass = IoClass::RealTime;
+  int level = 0;
+  ASSERT_TRUE(ProcessControl::parseIoClass("best-effort:7", ioClass, level));
+  EXPECT_EQ(ioClass, IoClass::BestEffort);
+  EXPECT_EQ(level, 7);
+  ASSERT_TRUE(ProcessControl::parseIoClass("idle", ioClass, level));
+  EXPECT_EQ(ioClass, IoClass::Idle);
+  EXPECT_FALSE(ProcessControl::parseIoClass("rt:8", ioClass, level));
+
+  std::string cpuMax;
+  ASSERT_TRUE(ProcessControl::formatCpuMax("50000", "100000", cpuMax));
+  EXPECT_EQ(cpuMax, "50000 100000");
+  ASSERT_TRUE(ProcessControl::formatCpuMax("max", "", cpuMax));
+  EXPECT_EQ(cpuMax, "max");
+  EXPECT_FALSE(ProcessControl::formatCpuMax("-5", "", cpuMax));
+
+  // Keeping the current nice value needs no privilege, on every thread
+  ProcessControl control;
+  errno = 0;
+  int niceness = getpriority(PRIO_PROCESS, 0);
+  ASSERT_EQ(errno, 0);
+  EXPECT_TRUE(control.renice(getpid(), niceness));
+
+  // The limit is written to the group named by /proc/<pid>/cgroup
+  std::filesystem::path root = std::filesystem::temp_directory_path() /
+                               ("control_test_" + std::to_string(getpid()));
+  std::filesystem::path group = root / "sys/fs/cgroup/batch.slice/job";
+  std::filesystem::create_directories(root / "proc/4242");
+  std::filesystem::create_directories(group);
+  std::ofstream(root / "proc/4242/cgroup") << "1:cpu:/\n0::/batch.slice/job\n";
+  std::ofstream(group / "cpu.max") << "max 100000\n";
+  ProcPaths::setProcRoot((root / "proc").string());
+  ProcPaths::setSysRoot((root / "sys").string());
+
+  std::string cgroup;
+  EXPECT_TRUE(control.throttle(4242, "50000 100000", cgroup));
+  EXPECT_EQ(cgroup, "/batch.slice/job");
+  std::ifstream written(group / "cpu.max");
+  std::string contents((std::istreambuf_iterator<char>(written)),
+                       std::istreambuf_iterator<char>());
+  EXPECT_EQ(contents, "50000 100000");
+  EXPECT_FALSE(control.throttle(4343, "max", cgroup)); // No such process
+
+  ProcPaths::setProcRoot("/proc");
+  ProcPaths::setSysRoot("/sys");
+  std::filesystem::remove_all(root);
+}
+
+TEST(PressureMonitoringTest, ParsesPressureAndRegistersTriggers) {
+  ProcPressure pressure;
+  ASSERT_TRUE(ProcParsers::parsePressure(
+      "some avg10=1.50 avg60=0.80 avg300=0.20 total=123456\n"
+      "full avg10=0.25 avg60=0.10 avg300=0.00 total=4567\n",
+      pressure));
+  EXPECT_DOUBLE_EQ(pressure.some.avg10, 1.5);
+  EXPECT_DOUBLE_EQ(pressure.some.avg60, 0.8);
+  EXPECT_DOUBLE_EQ(pressure.some.avg300, 0.2);
+  EXPECT_EQ(pressure.some.totalUsec, 123456u);
+  ASSERT_TRUE(pressure.hasFull);
+  EXPECT_DOUBLE_EQ(pressure.full.avg10, 0.25);
+  EXPECT_EQ(pressure.full.totalUsec, 4567u);
+  ASSERT_TRUE(ProcParsers::parsePressure(
+      "some avg10=3.00 avg60=2.00 avg300=1.00 total=9\n", pressure));
+  EXPECT_FALSE(pressure.hasFull);
+  EXPECT_FALSE(ProcParsers::parsePressure("", pressure));
+
+  std::filesystem::path root = std::filesystem::temp_directory_path() /
+                               ("pressure_test_" + std::to_string(getpid()));
+  std::filesystem::create_directories(root / "proc/pressure");
+  std::filesystem::create_directories(root / "group");
+  for (const char *name : {"cpu", "memory", "io"}) {
+    std::ofstream(root / "proc/pressure" / name)
+        << "some avg10=4.00 avg60=2.00 avg300=1.00 total=100\n";
+  }
+  std::ofstream(root / "group/io.pressure")
+      << "some avg10=7.50 avg60=0.00 avg300=0.00 total=1\n"
+      << "full avg10=6.00 avg60=0.00 avg300=0.00 total=1\n";
+  ProcPaths::setProcRoot((root / "proc").string());
+
+  ASSERT_TRUE(PressureMonitoring::isAvailable());
+  ASSERT_TRUE(
+      PressureMonitoring::readSystem(PressureResource::Memory, pressure));
+  EXPECT_DOUBLE_EQ(pressure.some.avg10, 4.0);
+  ASSERT_TRUE(PressureMonitoring::readCgroup((root / "group").string(),
+                                             PressureResource::Io, pressure));
+  EXPECT_DOUBLE_EQ(pressure.full.avg10, 6.0);
+  EXPECT_FALSE(PressureMonitoring::readCgroup(
+      (root / "group").string(), PressureResource::Cpu, pressure));
+
+  // A stop requested first makes the wait return once the triggers, here
+  // written to plain files, are registered
+  PressureMonitoring monitor;
+  monitor.stop();
+  EXPECT_TRUE(monitor.waitForStalls());
+  EXPECT_FALSE(monitor.isArmed());
+  std::ifstream trigger(root / "proc/pressure/memory");
+  std::string contents;
+  std::getline(trigger, contents, '\0');
+  EXPECT_EQ(contents, "some 300000 2000000");
+  PressureResource last = PressureResource::Cpu;
+  std::chrono::steady_clock::time_point lastAt;
+  EXPECT_EQ(monitor.getStalls(last, lastAt), 0u);
+
+  ProcPaths::setProcRoot("/proc");
+  std::filesystem::remove_all(root);
+}
+
+TEST(DeviceMonitoringTest, ParsesCountersAndFollowsDeviceChanges) {
+  std::vector<DiskCounters> disks;
+  ASSERT_TRUE(ProcParsers::parseDiskstats(
+      "   8       0 sda 100 5 800 40 200 10 1600 60 0 90 100 0 0 0 0 0 0\n"
+      "   8       1 sda1 10 0 80 4 20 0 160 6 0 9 10\n"
+      "   7       0 loop0 0 0 0\n",
+      disks));
+  ASSERT_EQ(disks.size(), 2u); // The truncated line is skipped
+  EXPECT_EQ(disks[0].name, "sda");
+  EXPECT_EQ(disks[0].reads, 100u);
+  EXPECT_EQ(disks[0].readSectors, 800u);
+  EXPECT_EQ(disks[0].writeMs, 60u);
+  EXPECT_EQ(disks[0].busyMs, 90u);
+  EXPECT_EQ(disks[1].name, "sda1");
+
+  std::vector<NetCounters> interfaces;
+  ASSERT_TRUE(ProcParsers::parseNetDev(
+      "Inter-|   Receive      |  Transmit\n"
+      " face |bytes    packets|bytes    packets\n"
+      "    lo: 1000 10 0 1 0 0 0 0 2000 20 0 2 0 0 0 0\n"
+      "eth0:5 6 0 0 0 0 0 0 7 8 0 0 0 0 0 0\n",
+      interfaces));
+  ASSERT_EQ(interfaces.size(), 2u);
+  EXPECT_EQ(interfaces[0].name, "lo");
+  EXPECT_EQ(interfaces[0].rxDrops, 1u);
+  EXPECT_EQ(interfaces[0].txBytes, 2000u);
+  EXPECT_EQ(interfaces[1].name, "eth0");
+  EXPECT_EQ(interfaces[1].txPackets, 8u);
+
+  std::filesystem::path root = std::filesystem::temp_directory_path() /
+                               ("device_test_" + std::to_string(getpid()));
+  std::filesystem::create_directories(root / "proc/net");
+  std::filesystem::create_directories(root / "sys/block/sda");
+  std::filesystem::create_directories(root / "sys/block/sdb");
+  auto writeSample = [&](const std::string &diskstats,
+                         const std::string &netDev) {
+    std::ofstream(root / "proc/diskstats") << diskstats;
+    std::ofstream(root / "proc/net/dev") << netDev;
+  };
+  ProcPaths::setProcRoot((root / "proc").string());
+  ProcPaths::setSysRoot((root / "sys").string());
+
+  DeviceMonitoring monitor;
+  writeSample("8 0 sda 100 0 800 40 200 0 1600 60 0 90 100\n"
+              "8 1 sda1 100 0 800 40 200 0 1600 60 0 90 100\n",
+              "eth0: 1000 10 0 0 0 0 0 0 1000 10 0 0 0 0 0 0\n");
+  ASSERT_TRUE(monitor.sample());
+  ASSERT_EQ(monitor.getDisks().size(), 2u);
+  EXPECT_EQ(monitor.getDisks()[0].readIops, 0.0); // Only primed
+  EXPECT_TRUE(monitor.getDisks()[0].wholeDisk);
+  EXPECT_FALSE(monitor.getDisks()[1].wholeDisk);
+
+  // sdb appears before sda and sda1 disappears
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  writeSample("8 16 sdb 5 0 40 1 0 0 0 0 0 1 1\n"
+              "8 0 sda 110 0 880 50 210 0 1680 70 0 95 110\n",
+              "eth0: 5000 20 0 0 0 0 0 0 1000 10 0 3 0 0 0 0\n");
+  ASSERT_TRUE(monitor.sample());
+  const std::vector<DiskStats> &after = monitor.getDisks();
+  ASSERT_EQ(after.size(), 2u);
+  EXPECT_EQ(after[0].name, "sdb");
+  EXPECT_EQ(after[0].readIops, 0.0); // New, so only primed
+  EXPECT_EQ(after[1].name, "sda");
+  EXPECT_GT(after[1].readIops, 0.0);
+  EXPECT_GT(after[1].writeRate, 0.0);
+  EXPECT_DOUBLE_EQ(after[1].awaitMs, 1.0); // 20 ms over 20 IOs
+  std::vector<DiskStats> top = monitor.getTopDisks(1);
+  ASSERT_EQ(top.size(), 1u);
+  EXPECT_EQ(top[0].name, "sda");
+
+  ASSERT_EQ(monitor.getInterfaces().size(), 1u);
+  const NetStats &eth0 = monitor.getInterfaces()[0];
+  EXPECT_GT(eth0.rxRate, 0.0);
+  EXPECT_EQ(eth0.txRate, 0.0);
+  EXPECT_GT(eth0.drops, 0.0);
+
+  ProcPaths::setProcRoot("/proc");
+  ProcPaths::setSysRoot("/sys");
+  std::filesystem::remove_all(root);
+}
+
+TEST(OverheadGovernorTest, CountsOnlyTheRefreshingThreadAndWorkers) {
+  OverheadGovernor governor(5.0);
+  std::atomic<bool> spinning{true};
+  std::thread background([&spinning] {
+    while (spinning) {
+    }
+  });
+
+  // A busy background thread, e.g. the history recorder, does not count
+  governor.update(0.0);
+  for (int i = 0; i < 4; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_FALSE(governor.update(0.0));
+  }
+  spinning = false;
+  background.join();
+  EXPECT_FALSE(governor.isDegraded());
+  EXPECT_LT(governor.usagePercent(), 5.0);
+
+  // The time reported for the scan workers does
+  for (int i = 0; i < 2; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    governor.update(30.0);
+  }
+  EXPECT_TRUE(governor.isDegraded());
+}
+
+TEST(OverheadGovernorTest, DegradesOverBudgetAndRelaxesWithHysteresis) {
+  OverheadGovernor governor(1.0); // 1% of one core
+  ListOptions requested;
+  std::string error;
+  ASSERT_TRUE(ProcessColumns::parse("pid,cpu,pss,io_read,name",
+                                    requested.columns, error));
+  const auto interval = std::chrono::milliseconds(1000);
+
+  // One cycle over budget is tolerated, two in a row degrade
+  EXPECT_FALSE(governor.record(30.0, 1000.0));
+  EXPECT_TRUE(governor.record(30.0, 1000.0));
+  EXPECT_DOUBLE_EQ(governor.usagePercent(), 3.0);
+  EXPECT_TRUE(governor.isDegraded());
+  EXPECT_EQ(governor.interval(interval), std::chrono::milliseconds(2000));
+  EXPECT_EQ(governor.describe(), "interval x2");
+
+  // Staying over budget walks down to fewer details, then fewer columns
+  for (int i = 0; i < 6; ++i) {
+    governor.record(30.0, 1000.0);
+  }
+  ListOptions applied = governor.apply(requested, ProcessColumn::Cpu);
+  EXPECT_EQ(applied.smapsTopN, requested.smapsTopN / 4);
+  EXPECT_EQ(applied.columns,
+            (std::vector<ProcessColumn>{ProcessColumn::Pid,
+                                        ProcessColumn::Cpu,
+                                        ProcessColumn::Name}));
+  // The column being sorted by is kept
+  applied = governor.apply(requested, ProcessColumn::IoRead);
+  EXPECT_EQ(applied.columns.size(), 4u);
+  EXPECT_TRUE(OverheadGovernor::isOptional(ProcessColumn::Pss));
+  EXPECT_FALSE(OverheadGovernor::isOptional(ProcessColumn::Rss));
+
+  // Usage just under the budget does not relax: the lighter level would
+  // exceed it again
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_FALSE(governor.record(9.0, 1000.0));
+  }
+  // Enough room relaxes one level per ten cycles, back to full detail
+  size_t changes = 0;
+  for (int i = 0; i < 200 && governor.isDegraded(); ++i) {
+    changes += governor.record(0.5, 1000.0) ? 1 : 0;
+  }
+  EXPECT_FALSE(governor.isDegraded());
+  EXPECT_EQ(changes, 4u);
+  EXPECT_EQ(governor.interval(interval), interval);
+  EXPECT_EQ(governor.apply(requested, ProcessColumn::Cpu).columns,
+            requested.columns);
+}
+
+TEST(CollectorDaemonTest, OnlyReplacesStaleSockets) {
+  std::filesystem::path directory =
+      std::filesystem::temp_directory_path() /
+      ("daemon_test_" + std::to_string(getpid()));
+  std::filesystem::create_directories(directory);
+
+  // A regular file at the path is reported, not deleted
+  std::filesystem::path notes = directory / "notes.txt";
+  std::ofstream(notes) << "keep me\n";
+  std::string error;
+  {
+    CollectorDaemon daemon(std::chrono::milliseconds(1000), 1);
+    EXPECT_FALSE(daemon.listen(notes.string(), error));
+    EXPECT_NE(error.find("not a socket"), std::string::npos);
+  }
+  EXPECT_TRUE(std::filesystem::is_regular_file(notes));
+
+  // A socket file left behind without a listener is replaced
+  std::filesystem::path stalePath = directory / "stale.sock";
+  int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_GE(stale, 0);
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, stalePath.c_str(),
+               sizeof(address.sun_path) - 1);
+  ASSERT_EQ(
+      bind(stale, reinterpret_cast<sockaddr *>(&address), sizeof(address)),
+      0);
+  close(stale);
+  CollectorDaemon daemon(std::chrono::milliseconds(1000), 1);
+  EXPECT_TRUE(daemon.listen(stalePath.string(), error)) << error;
+
+  std::filesystem::remove_all(directory);
+}
@@ -95,3 +95,20 @@ TEST_F(ResourceMonitoringTest,
   resourceMonitoring.stopMonitoring();
   monitorThread.join();
 }
+
+TEST_F(ResourceMonitoringTest, CanBeRestartedWithTheSameThreads) {
+  ResourceMonitoring resourceMonitoring;
+
+  for (int session = 0; session < 2; ++session) {
+    std::thread monitorThread(&ResourceMonitoring::startMonitoring,
+                              &resourceMonitoring);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    EXPECT_TRUE(resourceMonitoring.getMonitoringBool());
+
+    // startMonitoring only returns once its tasks have finished, which
+    // leaves the pool idle for the next session
+    resourceMonitoring.stopMonitoring();
+    monitorThread.join();
+    EXPECT_FALSE(resourceMonitoring.getMonitoringBool());
+  }
+}